@@ -0,0 +1,41 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+// Benchmarks are run as `cmm_lab <name> [args...]`; argv excludes the
+// program and benchmark names. Each returns the process exit code.
+
+int bench_io(int argc, char* argv[]);
+
+int bench_rsa_layout(int argc, char* argv[]);
+
+int bench_exp_mod_batch(int argc, char* argv[]);
+
+int bench_keygen_pipeline(int argc, char* argv[]);
+
+int bench_keygen_async(int argc, char* argv[]);
+
+int bench_elgamal_pool(int argc, char* argv[]);
+
+int bench_rsa_multi(int argc, char* argv[]);
+
+int bench_rsa_verify(int argc, char* argv[]);
+
+int bench_crypto64(int argc, char* argv[]);
+
+int bench_bignum(int argc, char* argv[]);
+
+int bench_bignum_mul(int argc, char* argv[]);
+
+int bench_modint(int argc, char* argv[]);
+
+int bench_limb_core(int argc, char* argv[]);
+
+int bench_branchless(int argc, char* argv[]);
+
+int bench_ct(int argc, char* argv[]);
+
+int bench_suite(int argc, char* argv[]);
+
+int bench_profile(int argc, char* argv[]);
+
+#endif
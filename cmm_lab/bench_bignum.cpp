@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench.h"
+#include "rsa_bn.h"
+
+// Multi-precision RSA at 512, 1024 and 2048 bits: key generation, then
+// public and private operations on random messages, each round trip
+// checked.
+// Usage: cmm_lab bench-bignum [keys=1] [messages=4]
+
+static double bench_bn_ms_per_op(
+	std::chrono::steady_clock::time_point bench_bn_begin,
+	int bench_bn_count)
+{
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - bench_bn_begin).count() / bench_bn_count;
+}
+
+int bench_bignum(int argc, char* argv[])
+{
+	static int bench_bn_scratch[kBnScratchLimbs];
+	static struct RSABn bench_bn_rsa;
+	int bench_bn_keys = 1;
+	int bench_bn_messages = 4;
+	int bench_bn_bits[3] = { 512, 1024, 2048 };
+	int bench_bn_b, bench_bn_i, bench_bn_mismatches = 0;
+	int bench_bn_m[kBnMaxLimbs], bench_bn_c[kBnMaxLimbs], bench_bn_out[kBnMaxLimbs];
+	double bench_bn_keygen_ms, bench_bn_public_ms, bench_bn_private_ms;
+	std::chrono::steady_clock::time_point bench_bn_begin;
+
+	if (argc >= 1)
+	{
+		bench_bn_keys = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_bn_messages = atoi(argv[1]);
+	}
+
+	if (bench_bn_keys <= 0 || bench_bn_messages <= 0)
+	{
+		printf("counts must be positive\n");
+		return 1;
+	}
+
+	srand32(20240618);
+
+	printf("e=65537\n");
+	printf("bits  keygen ms  public op ms  private op ms\n");
+
+	for (bench_bn_b = 0; bench_bn_b < 3; bench_bn_b++)
+	{
+		// the last key is the one the operations run on
+		bench_bn_begin = std::chrono::steady_clock::now();
+		for (bench_bn_i = 0; bench_bn_i < bench_bn_keys; bench_bn_i++)
+		{
+			if (!rsa_bn_keygen(&bench_bn_rsa, bench_bn_bits[bench_bn_b], 65537, bench_bn_scratch))
+			{
+				printf("rsa_bn_keygen failed for %d bits\n", bench_bn_bits[bench_bn_b]);
+				return 1;
+			}
+		}
+		bench_bn_keygen_ms = bench_bn_ms_per_op(bench_bn_begin, bench_bn_keys);
+
+		bench_bn_public_ms = 0;
+		bench_bn_private_ms = 0;
+		for (bench_bn_i = 0; bench_bn_i < bench_bn_messages; bench_bn_i++)
+		{
+			bn_rand_range(bench_bn_m, bench_bn_rsa.n, bench_bn_rsa.limbs);
+
+			bench_bn_begin = std::chrono::steady_clock::now();
+			rsa_bn_pubkey_encryrpt(bench_bn_c, &bench_bn_rsa, bench_bn_m, bench_bn_scratch);
+			bench_bn_public_ms += bench_bn_ms_per_op(bench_bn_begin, bench_bn_messages);
+
+			bench_bn_begin = std::chrono::steady_clock::now();
+			rsa_bn_privkey_decryrpt(bench_bn_out, &bench_bn_rsa, bench_bn_c, bench_bn_scratch);
+			bench_bn_private_ms += bench_bn_ms_per_op(bench_bn_begin, bench_bn_messages);
+
+			if (bn_cmp(bench_bn_out, bench_bn_m, bench_bn_rsa.limbs) != 0)
+			{
+				bench_bn_mismatches++;
+			}
+		}
+
+		printf("%4d %10.1f %13.2f %14.1f\n",
+			bench_bn_bits[bench_bn_b],
+			bench_bn_keygen_ms,
+			bench_bn_public_ms,
+			bench_bn_private_ms);
+	}
+
+	printf("mismatches: %d\n", bench_bn_mismatches);
+
+	return bench_bn_mismatches == 0 ? 0 : 1;
+}
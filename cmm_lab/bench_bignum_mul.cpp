@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench.h"
+#include "bignum.h"
+
+// Multiplication kernels by operand length: schoolbook bn_mul, Comba,
+// Comba squaring, and one Karatsuba split over Comba (threshold = n) for
+// both. The suggested thresholds are the smallest listed lengths from
+// which a split beats Comba at every longer length; kBnMulKaratsubaThreshold
+// and kBnSqrKaratsubaThreshold in bignum.h were set from this output.
+// Usage: cmm_lab bench-bignum-mul [work=400000]
+
+static double bench_bnm_ns_per_op(
+	std::chrono::steady_clock::time_point bench_bnm_begin,
+	int bench_bnm_count)
+{
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_bnm_begin).count() / bench_bnm_count;
+}
+
+int bench_bignum_mul(int argc, char* argv[])
+{
+	static int bench_bnm_scratch[4 * kBnMaxLimbs + 128];
+	int bench_bnm_sizes[11] = { 4, 6, 8, 12, 16, 20, 24, 32, 40, 48, 64 };
+	int bench_bnm_a[kBnMaxLimbs], bench_bnm_b[kBnMaxLimbs], bench_bnm_r[2 * kBnMaxLimbs];
+	double bench_bnm_ns[11][5];
+	int bench_bnm_work = 400000;
+	int bench_bnm_s, bench_bnm_n, bench_bnm_i, bench_bnm_iters;
+	int bench_bnm_mul_threshold = 0, bench_bnm_sqr_threshold = 0;
+	std::chrono::steady_clock::time_point bench_bnm_begin;
+
+	if (argc >= 1)
+	{
+		bench_bnm_work = atoi(argv[0]);
+	}
+
+	if (bench_bnm_work <= 0)
+	{
+		printf("work must be positive\n");
+		return 1;
+	}
+
+	srand32(20240625);
+	for (bench_bnm_i = 0; bench_bnm_i < kBnMaxLimbs; bench_bnm_i++)
+	{
+		bench_bnm_a[bench_bnm_i] = rand32();
+		bench_bnm_b[bench_bnm_i] = rand32();
+	}
+
+	printf("ns per product\n");
+	printf("limbs  schoolbook      comba   comba sqr  karatsuba  kara sqr\n");
+
+	for (bench_bnm_s = 0; bench_bnm_s < 11; bench_bnm_s++)
+	{
+		bench_bnm_n = bench_bnm_sizes[bench_bnm_s];
+		// about the same number of limb products per size
+		bench_bnm_iters = bench_bnm_work / (bench_bnm_n * bench_bnm_n) + 1;
+
+		bench_bnm_begin = std::chrono::steady_clock::now();
+		for (bench_bnm_i = 0; bench_bnm_i < bench_bnm_iters; bench_bnm_i++)
+		{
+			bn_mul(bench_bnm_r, bench_bnm_a, bench_bnm_n, bench_bnm_b, bench_bnm_n);
+		}
+		bench_bnm_ns[bench_bnm_s][0] = bench_bnm_ns_per_op(bench_bnm_begin, bench_bnm_iters);
+
+		bench_bnm_begin = std::chrono::steady_clock::now();
+		for (bench_bnm_i = 0; bench_bnm_i < bench_bnm_iters; bench_bnm_i++)
+		{
+			bn_mul_comba(bench_bnm_r, bench_bnm_a, bench_bnm_b, bench_bnm_n);
+		}
+		bench_bnm_ns[bench_bnm_s][1] = bench_bnm_ns_per_op(bench_bnm_begin, bench_bnm_iters);
+
+		bench_bnm_begin = std::chrono::steady_clock::now();
+		for (bench_bnm_i = 0; bench_bnm_i < bench_bnm_iters; bench_bnm_i++)
+		{
+			bn_sqr_comba(bench_bnm_r, bench_bnm_a, bench_bnm_n);
+		}
+		bench_bnm_ns[bench_bnm_s][2] = bench_bnm_ns_per_op(bench_bnm_begin, bench_bnm_iters);
+
+		bench_bnm_begin = std::chrono::steady_clock::now();
+		for (bench_bnm_i = 0; bench_bnm_i < bench_bnm_iters; bench_bnm_i++)
+		{
+			bn_mul_karatsuba(
+				bench_bnm_r, bench_bnm_a, bench_bnm_b, bench_bnm_n, bench_bnm_n, bench_bnm_scratch);
+		}
+		bench_bnm_ns[bench_bnm_s][3] = bench_bnm_ns_per_op(bench_bnm_begin, bench_bnm_iters);
+
+		bench_bnm_begin = std::chrono::steady_clock::now();
+		for (bench_bnm_i = 0; bench_bnm_i < bench_bnm_iters; bench_bnm_i++)
+		{
+			bn_sqr_karatsuba(bench_bnm_r, bench_bnm_a, bench_bnm_n, bench_bnm_n, bench_bnm_scratch);
+		}
+		bench_bnm_ns[bench_bnm_s][4] = bench_bnm_ns_per_op(bench_bnm_begin, bench_bnm_iters);
+
+		printf("%5d %11.0f %10.0f %11.0f %10.0f %9.0f\n",
+			bench_bnm_n,
+			bench_bnm_ns[bench_bnm_s][0],
+			bench_bnm_ns[bench_bnm_s][1],
+			bench_bnm_ns[bench_bnm_s][2],
+			bench_bnm_ns[bench_bnm_s][3],
+			bench_bnm_ns[bench_bnm_s][4]);
+	}
+
+	// scan down from the longest length while the split keeps winning
+	for (bench_bnm_s = 10; bench_bnm_s >= 0 && bench_bnm_ns[bench_bnm_s][3] < bench_bnm_ns[bench_bnm_s][1]; bench_bnm_s--)
+	{
+		bench_bnm_mul_threshold = bench_bnm_sizes[bench_bnm_s];
+	}
+
+	for (bench_bnm_s = 10; bench_bnm_s >= 0 && bench_bnm_ns[bench_bnm_s][4] < bench_bnm_ns[bench_bnm_s][2]; bench_bnm_s--)
+	{
+		bench_bnm_sqr_threshold = bench_bnm_sizes[bench_bnm_s];
+	}
+
+	printf("suggested thresholds: mul %d, sqr %d (0: never split up to %d limbs)\n",
+		bench_bnm_mul_threshold,
+		bench_bnm_sqr_threshold,
+		bench_bnm_sizes[10]);
+	printf("built with: mul %d, sqr %d\n", kBnMulKaratsubaThreshold, kBnSqrKaratsubaThreshold);
+
+	return 0;
+}
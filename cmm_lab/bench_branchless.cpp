@@ -0,0 +1,238 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "crypto_core.h"
+#include "perf_counters.h"
+#include "unsigned_op.h"
+#include "unsigned_op_ref.h"
+
+// The branch-free comparison and carry primitives against the branching
+// originals in unsigned_op_ref, on uniformly random operands (for
+// cmp_uint64, the high words are equal half of the time). Reports time
+// and branch misses per call; branch misses read n/a where the hardware
+// counters are unavailable. Every result is compared with the original.
+// Usage: cmm_lab bench-branchless [count=1000000]
+
+typedef int (*BenchBranchlessCmp)(int, int);
+typedef int (*BenchBranchlessCarry)(int[1], int, int);
+typedef int (*BenchBranchlessCmp64)(int[2], int[2]);
+
+struct BenchBranchlessResult
+{
+	double ns;
+	double misses; // per call, < 0 if unavailable
+	int checksum;
+};
+
+static void bench_branchless_begin(
+	struct PerfCounters bench_branchless_pc[1],
+	std::chrono::steady_clock::time_point bench_branchless_begin_out[1])
+{
+	perf_counters_start(bench_branchless_pc);
+	bench_branchless_begin_out[0] = std::chrono::steady_clock::now();
+}
+
+static void bench_branchless_end(
+	struct PerfCounters bench_branchless_pc[1],
+	std::chrono::steady_clock::time_point bench_branchless_begin,
+	int bench_branchless_count,
+	struct BenchBranchlessResult bench_branchless_out[1])
+{
+	bench_branchless_out[0].ns = std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_branchless_begin).count() / bench_branchless_count;
+	perf_counters_stop(bench_branchless_pc);
+
+	bench_branchless_out[0].misses = perf_counters_available(bench_branchless_pc, kPerfBranchMisses)
+		? (double)bench_branchless_pc[0].values[kPerfBranchMisses] / bench_branchless_count
+		: -1.0;
+}
+
+static struct BenchBranchlessResult bench_branchless_cmp(
+	struct PerfCounters bench_branchless_pc[1],
+	BenchBranchlessCmp bench_branchless_fn,
+	std::vector<int>& bench_branchless_x,
+	std::vector<int>& bench_branchless_out)
+{
+	int bench_branchless_count = (int)bench_branchless_out.size();
+	struct BenchBranchlessResult bench_branchless_result = {};
+	std::chrono::steady_clock::time_point bench_branchless_t[1];
+
+	bench_branchless_begin(bench_branchless_pc, bench_branchless_t);
+	for (int bench_branchless_i = 0; bench_branchless_i < bench_branchless_count; bench_branchless_i++)
+	{
+		bench_branchless_out[bench_branchless_i] = bench_branchless_fn(
+			bench_branchless_x[4 * bench_branchless_i + 1], bench_branchless_x[4 * bench_branchless_i + 3]);
+	}
+	bench_branchless_end(bench_branchless_pc, bench_branchless_t[0], bench_branchless_count, &bench_branchless_result);
+
+	return bench_branchless_result;
+}
+
+static struct BenchBranchlessResult bench_branchless_carry(
+	struct PerfCounters bench_branchless_pc[1],
+	BenchBranchlessCarry bench_branchless_fn,
+	std::vector<int>& bench_branchless_x,
+	std::vector<int>& bench_branchless_out)
+{
+	int bench_branchless_count = (int)bench_branchless_out.size();
+	int bench_branchless_carry_out[1];
+	struct BenchBranchlessResult bench_branchless_result = {};
+	std::chrono::steady_clock::time_point bench_branchless_t[1];
+
+	bench_branchless_begin(bench_branchless_pc, bench_branchless_t);
+	for (int bench_branchless_i = 0; bench_branchless_i < bench_branchless_count; bench_branchless_i++)
+	{
+		int bench_branchless_r = bench_branchless_fn(
+			bench_branchless_carry_out,
+			bench_branchless_x[4 * bench_branchless_i + 1],
+			bench_branchless_x[4 * bench_branchless_i + 3]);
+
+		bench_branchless_out[bench_branchless_i] = bench_branchless_r + bench_branchless_carry_out[0];
+	}
+	bench_branchless_end(bench_branchless_pc, bench_branchless_t[0], bench_branchless_count, &bench_branchless_result);
+
+	return bench_branchless_result;
+}
+
+static struct BenchBranchlessResult bench_branchless_cmp64(
+	struct PerfCounters bench_branchless_pc[1],
+	BenchBranchlessCmp64 bench_branchless_fn,
+	std::vector<int>& bench_branchless_x,
+	std::vector<int>& bench_branchless_out)
+{
+	int bench_branchless_count = (int)bench_branchless_out.size();
+	struct BenchBranchlessResult bench_branchless_result = {};
+	std::chrono::steady_clock::time_point bench_branchless_t[1];
+
+	bench_branchless_begin(bench_branchless_pc, bench_branchless_t);
+	for (int bench_branchless_i = 0; bench_branchless_i < bench_branchless_count; bench_branchless_i++)
+	{
+		bench_branchless_out[bench_branchless_i] = bench_branchless_fn(
+			&bench_branchless_x[4 * bench_branchless_i], &bench_branchless_x[4 * bench_branchless_i + 2]);
+	}
+	bench_branchless_end(bench_branchless_pc, bench_branchless_t[0], bench_branchless_count, &bench_branchless_result);
+
+	return bench_branchless_result;
+}
+
+static void bench_branchless_print(const char* bench_branchless_name, struct BenchBranchlessResult bench_branchless_result)
+{
+	if (bench_branchless_result.misses >= 0)
+	{
+		printf("%-24s %8.2f ns  %6.3f branch-misses\n",
+			bench_branchless_name, bench_branchless_result.ns, bench_branchless_result.misses);
+	}
+	else
+	{
+		printf("%-24s %8.2f ns     n/a branch-misses\n", bench_branchless_name, bench_branchless_result.ns);
+	}
+}
+
+static int bench_branchless_mismatches(std::vector<int>& bench_branchless_a, std::vector<int>& bench_branchless_b)
+{
+	int bench_branchless_mismatches = 0;
+
+	for (size_t bench_branchless_i = 0; bench_branchless_i < bench_branchless_a.size(); bench_branchless_i++)
+	{
+		if (bench_branchless_a[bench_branchless_i] != bench_branchless_b[bench_branchless_i])
+		{
+			bench_branchless_mismatches++;
+		}
+	}
+
+	return bench_branchless_mismatches;
+}
+
+int bench_branchless(int argc, char* argv[])
+{
+	int bench_branchless_count = 1000000;
+	int bench_branchless_i, bench_branchless_mismatch_count = 0;
+	struct PerfCounters bench_branchless_pc[1];
+	// a[2], b[2] per call; the uint32 primitives take a[1] and b[1]
+	std::vector<int> bench_branchless_x;
+	std::vector<int> bench_branchless_ref, bench_branchless_out;
+
+	if (argc >= 1)
+	{
+		bench_branchless_count = atoi(argv[0]);
+	}
+
+	if (bench_branchless_count <= 0)
+	{
+		printf("count must be positive\n");
+		return 1;
+	}
+
+	bench_branchless_x.resize(4 * bench_branchless_count);
+	bench_branchless_ref.resize(bench_branchless_count);
+	bench_branchless_out.resize(bench_branchless_count);
+
+	srand32(20240704);
+	for (bench_branchless_i = 0; bench_branchless_i < bench_branchless_count; bench_branchless_i++)
+	{
+		int* bench_branchless_v = &bench_branchless_x[4 * bench_branchless_i];
+
+		bench_branchless_v[0] = rand32();
+		bench_branchless_v[1] = rand32();
+		bench_branchless_v[2] = rand_bits(1, 0, 0) ? bench_branchless_v[0] : rand32();
+		bench_branchless_v[3] = rand32();
+	}
+
+	if (perf_counters_open(bench_branchless_pc) == 0)
+	{
+		printf("hardware counters unavailable, timing only\n");
+	}
+
+	struct
+	{
+		const char* name;
+		BenchBranchlessCmp ref;
+		BenchBranchlessCmp fast;
+	} bench_branchless_cmps[] = {
+		{ "cmp_uint32", cmp_uint32_ref, cmp_uint32 }
+	};
+
+	struct
+	{
+		const char* name;
+		BenchBranchlessCarry ref;
+		BenchBranchlessCarry fast;
+	} bench_branchless_carries[] = {
+		{ "add_full_uint32", add_full_uint32_ref, add_full_uint32 },
+		{ "sub_full_uint32", sub_full_uint32_ref, sub_full_uint32 }
+	};
+
+	for (auto& bench_branchless_case : bench_branchless_cmps)
+	{
+		bench_branchless_print(bench_branchless_case.name, bench_branchless_cmp(
+			bench_branchless_pc, bench_branchless_case.ref, bench_branchless_x, bench_branchless_ref));
+		bench_branchless_print("  branch-free", bench_branchless_cmp(
+			bench_branchless_pc, bench_branchless_case.fast, bench_branchless_x, bench_branchless_out));
+		bench_branchless_mismatch_count += bench_branchless_mismatches(bench_branchless_ref, bench_branchless_out);
+	}
+
+	for (auto& bench_branchless_case : bench_branchless_carries)
+	{
+		bench_branchless_print(bench_branchless_case.name, bench_branchless_carry(
+			bench_branchless_pc, bench_branchless_case.ref, bench_branchless_x, bench_branchless_ref));
+		bench_branchless_print("  branch-free", bench_branchless_carry(
+			bench_branchless_pc, bench_branchless_case.fast, bench_branchless_x, bench_branchless_out));
+		bench_branchless_mismatch_count += bench_branchless_mismatches(bench_branchless_ref, bench_branchless_out);
+	}
+
+	bench_branchless_print("cmp_uint64", bench_branchless_cmp64(
+		bench_branchless_pc, cmp_uint64_ref, bench_branchless_x, bench_branchless_ref));
+	bench_branchless_print("  branch-free", bench_branchless_cmp64(
+		bench_branchless_pc, cmp_uint64, bench_branchless_x, bench_branchless_out));
+	bench_branchless_mismatch_count += bench_branchless_mismatches(bench_branchless_ref, bench_branchless_out);
+
+	perf_counters_close(bench_branchless_pc);
+
+	printf("mismatches: %d\n", bench_branchless_mismatch_count);
+
+	return bench_branchless_mismatch_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "dh64.h"
+#include "rsa.h"
+#include "rsa64.h"
+
+// Cost of the 64-bit modulus path by key length: RSA64 keygen and
+// private-key decryption, DH64 parameter generation and key agreement.
+// The 31-bit rows run the same operations through rsa.h for comparison.
+// Usage: cmm_lab bench-crypto64 [keys=200] [decryptions=2000]
+
+static double bench_c64_us_per_op(
+	std::chrono::steady_clock::time_point bench_c64_begin,
+	int bench_c64_count)
+{
+	return std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - bench_c64_begin).count() / bench_c64_count;
+}
+
+int bench_crypto64(int argc, char* argv[])
+{
+	int bench_c64_keys = 200;
+	int bench_c64_decryptions = 2000;
+	int bench_c64_bits[4] = { 31, 40, 50, 62 };
+	int bench_c64_b, bench_c64_i, bench_c64_mismatches = 0;
+	int bench_c64_m[2], bench_c64_c[2], bench_c64_out[2];
+	int bench_c64_m32[1], bench_c64_c32[1], bench_c64_out32[1];
+	double bench_c64_keygen_us, bench_c64_decrypt_us, bench_c64_param_us, bench_c64_agree_us;
+	std::chrono::steady_clock::time_point bench_c64_begin;
+	std::vector<struct RSA64> bench_c64_rsa;
+	std::vector<struct RSA> bench_c64_rsa32;
+	struct DH64 bench_c64_dh[2];
+
+	if (argc >= 1)
+	{
+		bench_c64_keys = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_c64_decryptions = atoi(argv[1]);
+	}
+
+	if (bench_c64_keys <= 0 || bench_c64_decryptions <= 0)
+	{
+		printf("counts must be positive\n");
+		return 1;
+	}
+
+	bench_c64_rsa.resize(bench_c64_keys);
+	bench_c64_rsa32.resize(bench_c64_keys);
+	srand32(20240611);
+
+	printf("RSA e=65537, DH g=2\n");
+	printf("bits  path     rsa keygen us  rsa decrypt us  dh params us  dh agree us\n");
+
+	// 31-bit reference through the int API
+	bench_c64_begin = std::chrono::steady_clock::now();
+	for (bench_c64_i = 0; bench_c64_i < bench_c64_keys; bench_c64_i++)
+	{
+		if (!rsa_keygen(&bench_c64_rsa32[bench_c64_i], 31, 65537))
+		{
+			printf("rsa_keygen failed\n");
+			return 1;
+		}
+	}
+	bench_c64_keygen_us = bench_c64_us_per_op(bench_c64_begin, bench_c64_keys);
+
+	bench_c64_begin = std::chrono::steady_clock::now();
+	for (bench_c64_i = 0; bench_c64_i < bench_c64_decryptions; bench_c64_i++)
+	{
+		struct RSA* bench_c64_kp = &bench_c64_rsa32[bench_c64_i % bench_c64_keys];
+
+		bench_c64_m32[0] = bench_c64_i + 2;
+		rsa_privkey_decryrpt(bench_c64_out32, bench_c64_kp, bench_c64_m32[0]);
+		rsa_pubkey_decryrpt(bench_c64_c32, bench_c64_kp, bench_c64_out32[0]);
+		if (bench_c64_c32[0] != bench_c64_m32[0])
+		{
+			bench_c64_mismatches++;
+		}
+	}
+	bench_c64_decrypt_us = bench_c64_us_per_op(bench_c64_begin, bench_c64_decryptions);
+
+	printf("%4d  int    %15.2f %15.2f %13s %12s\n", 31, bench_c64_keygen_us, bench_c64_decrypt_us, "-", "-");
+
+	for (bench_c64_b = 0; bench_c64_b < 4; bench_c64_b++)
+	{
+		bench_c64_begin = std::chrono::steady_clock::now();
+		for (bench_c64_i = 0; bench_c64_i < bench_c64_keys; bench_c64_i++)
+		{
+			if (!rsa64_keygen(&bench_c64_rsa[bench_c64_i], bench_c64_bits[bench_c64_b], 65537))
+			{
+				printf("rsa64_keygen failed for %d bits\n", bench_c64_bits[bench_c64_b]);
+				return 1;
+			}
+		}
+		bench_c64_keygen_us = bench_c64_us_per_op(bench_c64_begin, bench_c64_keys);
+
+		// decrypt then re-encrypt, so every round trip is checked
+		bench_c64_begin = std::chrono::steady_clock::now();
+		for (bench_c64_i = 0; bench_c64_i < bench_c64_decryptions; bench_c64_i++)
+		{
+			struct RSA64* bench_c64_kp = &bench_c64_rsa[bench_c64_i % bench_c64_keys];
+
+			bench_c64_m[0] = 0;
+			bench_c64_m[1] = bench_c64_i + 2;
+			rsa64_privkey_decryrpt(bench_c64_out, bench_c64_kp, bench_c64_m);
+			rsa64_pubkey_encryrpt(bench_c64_c, bench_c64_kp, bench_c64_out);
+			if (cmp_uint64(bench_c64_c, bench_c64_m) != 0)
+			{
+				bench_c64_mismatches++;
+			}
+		}
+		bench_c64_decrypt_us = bench_c64_us_per_op(bench_c64_begin, bench_c64_decryptions);
+
+		bench_c64_begin = std::chrono::steady_clock::now();
+		for (bench_c64_i = 0; bench_c64_i < 10; bench_c64_i++)
+		{
+			if (!dh64_generate_paremeters(&bench_c64_dh[0], bench_c64_bits[bench_c64_b], 2))
+			{
+				printf("dh64_generate_paremeters failed for %d bits\n", bench_c64_bits[bench_c64_b]);
+				return 1;
+			}
+		}
+		bench_c64_param_us = bench_c64_us_per_op(bench_c64_begin, 10);
+
+		bench_c64_dh[1].params = bench_c64_dh[0].params;
+		bench_c64_begin = std::chrono::steady_clock::now();
+		for (bench_c64_i = 0; bench_c64_i < bench_c64_keys; bench_c64_i++)
+		{
+			dh64_generate_key(&bench_c64_dh[0]);
+			dh64_generate_key(&bench_c64_dh[1]);
+			dh64_compute_key(bench_c64_out, &bench_c64_dh[0], bench_c64_dh[1].pubkey);
+			dh64_compute_key(bench_c64_c, &bench_c64_dh[1], bench_c64_dh[0].pubkey);
+			if (cmp_uint64(bench_c64_out, bench_c64_c) != 0)
+			{
+				bench_c64_mismatches++;
+			}
+		}
+		bench_c64_agree_us = bench_c64_us_per_op(bench_c64_begin, bench_c64_keys);
+
+		printf("%4d  uint64 %15.2f %15.2f %13.0f %12.2f\n",
+			bench_c64_bits[bench_c64_b],
+			bench_c64_keygen_us,
+			bench_c64_decrypt_us,
+			bench_c64_param_us,
+			bench_c64_agree_us);
+	}
+
+	printf("mismatches: %d\n", bench_c64_mismatches);
+
+	return bench_c64_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "ct_op.h"
+#include "crypto_core.h"
+#include "rsa.h"
+
+// Constant-time exponentiation against exp_mod.
+// Leakage: a dudect-style test. Each measurement times one call with a
+// random base and, by a coin flip, either a fixed sparse exponent (class
+// 0) or a random 31-bit one (class 1). The slowest 10% are cropped as
+// interrupts and other noise, and Welch's t statistic compares the two
+// classes' means; |t| above 4.5 means the time depends on the exponent.
+// Cost: ns per call on random exponents, and RSA private-key decryption
+// with set_constant_time off and on.
+// Usage: cmm_lab bench-ct [samples=20000]
+
+static const int kBenchCtPrime = 2147481143;
+static const int kBenchCtFixedExponent = 1073741825; // 2^30 + 1
+
+typedef int (*BenchCtExpMod)(int, int, int);
+
+// keeps the timed calls from being optimized away
+static volatile int kBenchCtSink;
+
+static double bench_ct_ns_per_op(
+	std::chrono::steady_clock::time_point bench_ct_begin,
+	int bench_ct_count)
+{
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_ct_begin).count() / bench_ct_count;
+}
+
+static double bench_ct_welch_t(
+	BenchCtExpMod bench_ct_fn,
+	std::vector<int>& bench_ct_bases,
+	std::vector<int>& bench_ct_exponents,
+	std::vector<int>& bench_ct_classes)
+{
+	int bench_ct_samples = (int)bench_ct_classes.size();
+	std::vector<double> bench_ct_times(bench_ct_samples), bench_ct_sorted;
+	double bench_ct_crop;
+	double bench_ct_n[2] = { 0, 0 }, bench_ct_mean[2] = { 0, 0 }, bench_ct_m2[2] = { 0, 0 };
+
+	for (int bench_ct_i = 0; bench_ct_i < bench_ct_samples; bench_ct_i++)
+	{
+		std::chrono::steady_clock::time_point bench_ct_begin = std::chrono::steady_clock::now();
+
+		kBenchCtSink = bench_ct_fn(bench_ct_bases[bench_ct_i], bench_ct_exponents[bench_ct_i], kBenchCtPrime);
+		bench_ct_times[bench_ct_i] = std::chrono::duration<double, std::nano>(
+			std::chrono::steady_clock::now() - bench_ct_begin).count();
+	}
+
+	bench_ct_sorted = bench_ct_times;
+	std::sort(bench_ct_sorted.begin(), bench_ct_sorted.end());
+	bench_ct_crop = bench_ct_sorted[bench_ct_samples * 9 / 10];
+
+	// Welford's running mean and variance per class
+	for (int bench_ct_i = 0; bench_ct_i < bench_ct_samples; bench_ct_i++)
+	{
+		int bench_ct_c = bench_ct_classes[bench_ct_i];
+		double bench_ct_delta;
+
+		if (bench_ct_times[bench_ct_i] > bench_ct_crop)
+		{
+			continue;
+		}
+
+		bench_ct_n[bench_ct_c] += 1;
+		bench_ct_delta = bench_ct_times[bench_ct_i] - bench_ct_mean[bench_ct_c];
+		bench_ct_mean[bench_ct_c] += bench_ct_delta / bench_ct_n[bench_ct_c];
+		bench_ct_m2[bench_ct_c] += bench_ct_delta * (bench_ct_times[bench_ct_i] - bench_ct_mean[bench_ct_c]);
+	}
+
+	if (bench_ct_n[0] < 2 || bench_ct_n[1] < 2)
+	{
+		return 0;
+	}
+
+	return (bench_ct_mean[0] - bench_ct_mean[1]) / sqrt(
+		bench_ct_m2[0] / (bench_ct_n[0] - 1) / bench_ct_n[0] +
+		bench_ct_m2[1] / (bench_ct_n[1] - 1) / bench_ct_n[1]);
+}
+
+int bench_ct(int argc, char* argv[])
+{
+	int bench_ct_samples = 20000;
+	int bench_ct_i, bench_ct_f, bench_ct_mismatches = 0;
+	int bench_ct_c[1], bench_ct_m[1];
+	double bench_ct_ns[3], bench_ct_t[3], bench_ct_decrypt_ns[2];
+	std::chrono::steady_clock::time_point bench_ct_begin;
+	std::vector<int> bench_ct_bases, bench_ct_exponents, bench_ct_classes, bench_ct_random_exponents;
+	std::vector<int> bench_ct_ref, bench_ct_out;
+	struct RSA bench_ct_rsa[1];
+
+	struct
+	{
+		const char* name;
+		BenchCtExpMod fn;
+	} bench_ct_fns[3] = {
+		{ "exp_mod", exp_mod },
+		{ "exp_mod_ct (ladder)", exp_mod_ct },
+		{ "exp_mod_ct_window", exp_mod_ct_window }
+	};
+
+	if (argc >= 1)
+	{
+		bench_ct_samples = atoi(argv[0]);
+	}
+
+	if (bench_ct_samples < 100)
+	{
+		printf("samples must be at least 100\n");
+		return 1;
+	}
+
+	bench_ct_bases.resize(bench_ct_samples);
+	bench_ct_exponents.resize(bench_ct_samples);
+	bench_ct_classes.resize(bench_ct_samples);
+	bench_ct_random_exponents.resize(bench_ct_samples);
+	bench_ct_ref.resize(bench_ct_samples);
+	bench_ct_out.resize(bench_ct_samples);
+
+	srand32(20240705);
+	for (bench_ct_i = 0; bench_ct_i < bench_ct_samples; bench_ct_i++)
+	{
+		do
+		{
+			rand_range(&bench_ct_bases[bench_ct_i], kBenchCtPrime);
+		} while (bench_ct_bases[bench_ct_i] < 2);
+
+		bench_ct_classes[bench_ct_i] = rand_bits(1, 0, 0);
+		bench_ct_random_exponents[bench_ct_i] = rand_bits(31, 1, 0);
+		bench_ct_exponents[bench_ct_i] = bench_ct_classes[bench_ct_i]
+			? bench_ct_random_exponents[bench_ct_i]
+			: kBenchCtFixedExponent;
+	}
+
+	for (bench_ct_f = 0; bench_ct_f < 3; bench_ct_f++)
+	{
+		std::vector<int>& bench_ct_results = bench_ct_f == 0 ? bench_ct_ref : bench_ct_out;
+
+		bench_ct_begin = std::chrono::steady_clock::now();
+		for (bench_ct_i = 0; bench_ct_i < bench_ct_samples; bench_ct_i++)
+		{
+			bench_ct_results[bench_ct_i] = bench_ct_fns[bench_ct_f].fn(
+				bench_ct_bases[bench_ct_i], bench_ct_random_exponents[bench_ct_i], kBenchCtPrime);
+		}
+		bench_ct_ns[bench_ct_f] = bench_ct_ns_per_op(bench_ct_begin, bench_ct_samples);
+
+		for (bench_ct_i = 0; bench_ct_f > 0 && bench_ct_i < bench_ct_samples; bench_ct_i++)
+		{
+			if (bench_ct_out[bench_ct_i] != bench_ct_ref[bench_ct_i])
+			{
+				bench_ct_mismatches++;
+			}
+		}
+
+		bench_ct_t[bench_ct_f] = bench_ct_welch_t(
+			bench_ct_fns[bench_ct_f].fn, bench_ct_bases, bench_ct_exponents, bench_ct_classes);
+	}
+
+	// RSA decryption, variable-time then constant-time
+	if (!rsa_keygen(bench_ct_rsa, 31, 65537))
+	{
+		printf("rsa_keygen failed\n");
+		return 1;
+	}
+
+	for (bench_ct_f = 0; bench_ct_f < 2; bench_ct_f++)
+	{
+		set_constant_time(bench_ct_f);
+
+		bench_ct_begin = std::chrono::steady_clock::now();
+		for (bench_ct_i = 0; bench_ct_i < bench_ct_samples; bench_ct_i++)
+		{
+			rsa_pubkey_encryrpt(bench_ct_c, bench_ct_rsa, mod_uint32(bench_ct_bases[bench_ct_i], bench_ct_rsa[0].n));
+			rsa_privkey_decryrpt(bench_ct_m, bench_ct_rsa, bench_ct_c[0]);
+			if (bench_ct_m[0] != mod_uint32(bench_ct_bases[bench_ct_i], bench_ct_rsa[0].n))
+			{
+				bench_ct_mismatches++;
+			}
+		}
+		bench_ct_decrypt_ns[bench_ct_f] = bench_ct_ns_per_op(bench_ct_begin, bench_ct_samples);
+	}
+	set_constant_time(0);
+
+	printf("p=%d, 31-bit exponents, %d samples\n", kBenchCtPrime, bench_ct_samples);
+	printf("%-22s %10s %10s %8s\n", "", "ns/op", "cost", "|t|");
+	for (bench_ct_f = 0; bench_ct_f < 3; bench_ct_f++)
+	{
+		printf("%-22s %10.1f %9.2fx %8.1f  %s\n",
+			bench_ct_fns[bench_ct_f].name,
+			bench_ct_ns[bench_ct_f],
+			bench_ct_ns[bench_ct_f] / bench_ct_ns[0],
+			fabs(bench_ct_t[bench_ct_f]),
+			fabs(bench_ct_t[bench_ct_f]) > 4.5 ? "leaks" : "no leak detected");
+	}
+	printf("rsa encrypt+decrypt    %10.1f ns variable-time, %.1f ns constant-time (%.2fx)\n",
+		bench_ct_decrypt_ns[0],
+		bench_ct_decrypt_ns[1],
+		bench_ct_decrypt_ns[1] / bench_ct_decrypt_ns[0]);
+	printf("mismatches: %d\n", bench_ct_mismatches);
+
+	return bench_ct_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "elgamal_pool.h"
+
+// ElGamal encryption under a 31-bit DH key, first inline with
+// elgamal_pubkey_encryrpt, then through a precomputed pool: the pool is
+// filled, and threads encrypt as fast as they can while the main thread
+// prints the pool's stats every 100 ms. Once the pool is drained the
+// refill thread cannot keep up, so encryptions fall back to the inline
+// path and count as misses. Every ciphertext is decrypted and compared
+// with its message.
+// Usage: cmm_lab bench-elgamal-pool [encryptions=20000] [capacity=1024] [threads=4]
+
+static double bench_egp_us_per_op(
+	std::chrono::steady_clock::time_point bench_egp_begin,
+	int bench_egp_count)
+{
+	return std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - bench_egp_begin).count() / bench_egp_count;
+}
+
+static int bench_egp_print_stats(const char* bench_egp_label, struct ElGamalPool bench_egp_pool[1])
+{
+	struct ElGamalPoolStats bench_egp_stats[1];
+
+	elgamal_pool_get_stats(bench_egp_stats, bench_egp_pool);
+	printf("%-8s %6d/%-6d %10lld %10lld %8lld %12.0f %12.0f\n",
+		bench_egp_label,
+		bench_egp_stats[0].depth,
+		bench_egp_stats[0].capacity,
+		bench_egp_stats[0].produced,
+		bench_egp_stats[0].consumed,
+		bench_egp_stats[0].misses,
+		bench_egp_stats[0].refill_rate,
+		bench_egp_stats[0].consume_rate);
+
+	return 1;
+}
+
+// ciphertexts [begin, end) with the thread's own rand32 stream for misses
+static int bench_egp_encrypt_range(
+	struct ElGamalPool bench_egp_pool[1],
+	const std::vector<int>* bench_egp_m,
+	std::vector<int>* bench_egp_c,
+	int bench_egp_begin,
+	int bench_egp_end,
+	std::atomic<int>* bench_egp_failures)
+{
+	srand32(20240713 + bench_egp_begin);
+
+	for (int bench_egp_i = bench_egp_begin; bench_egp_i < bench_egp_end; bench_egp_i++)
+	{
+		if (!elgamal_pool_encryrpt(&(*bench_egp_c)[2 * bench_egp_i], bench_egp_pool, (*bench_egp_m)[bench_egp_i]))
+		{
+			bench_egp_failures->fetch_add(1);
+		}
+	}
+
+	return 1;
+}
+
+static int bench_egp_mismatches(
+	struct DH bench_egp_dh[1],
+	std::vector<int>& bench_egp_m,
+	std::vector<int>& bench_egp_c)
+{
+	int bench_egp_i, bench_egp_p[1], bench_egp_mismatched = 0;
+
+	for (bench_egp_i = 0; bench_egp_i < (int)bench_egp_m.size(); bench_egp_i++)
+	{
+		if (!elgamal_privkey_decryrpt(bench_egp_p, bench_egp_dh, &bench_egp_c[2 * bench_egp_i]) ||
+			bench_egp_p[0] != bench_egp_m[bench_egp_i])
+		{
+			bench_egp_mismatched++;
+		}
+	}
+
+	return bench_egp_mismatched;
+}
+
+int bench_elgamal_pool(int argc, char* argv[])
+{
+	int bench_egp_count = 20000;
+	int bench_egp_capacity = 1024;
+	int bench_egp_thread_count = 4;
+	int bench_egp_i, bench_egp_r[1], bench_egp_mismatched;
+	double bench_egp_inline_us, bench_egp_pool_us;
+	struct DH bench_egp_dh[1];
+	struct ElGamalPool bench_egp_pool[1];
+	struct ElGamalPoolStats bench_egp_stats[1];
+	std::atomic<int> bench_egp_failures(0);
+	std::atomic<int> bench_egp_done(0);
+	std::chrono::steady_clock::time_point bench_egp_begin;
+	std::vector<int> bench_egp_m, bench_egp_c;
+	std::vector<std::thread> bench_egp_threads;
+
+	if (argc >= 1)
+	{
+		bench_egp_count = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_egp_capacity = atoi(argv[1]);
+	}
+
+	if (argc >= 3)
+	{
+		bench_egp_thread_count = atoi(argv[2]);
+	}
+
+	if (bench_egp_count <= 0 || bench_egp_capacity <= 0 || bench_egp_thread_count <= 0)
+	{
+		printf("counts must be positive\n");
+		return 1;
+	}
+
+	srand32(20240713);
+
+	if (!dh_generate_paremeters(bench_egp_dh, 31, 2) || !dh_generate_key(bench_egp_dh))
+	{
+		printf("DH key generation failed\n");
+		return 1;
+	}
+
+	bench_egp_m.resize(bench_egp_count);
+	bench_egp_c.resize(2 * bench_egp_count);
+	for (bench_egp_i = 0; bench_egp_i < bench_egp_count; bench_egp_i++)
+	{
+		rand_range(bench_egp_r, bench_egp_dh[0].params.p - 1);
+		bench_egp_m[bench_egp_i] = bench_egp_r[0] + 1;
+	}
+
+	printf("p=%d, %d encryptions, capacity %d, %d threads\n",
+		bench_egp_dh[0].params.p, bench_egp_count, bench_egp_capacity, bench_egp_thread_count);
+
+	bench_egp_begin = std::chrono::steady_clock::now();
+	for (bench_egp_i = 0; bench_egp_i < bench_egp_count; bench_egp_i++)
+	{
+		if (!elgamal_pubkey_encryrpt(&bench_egp_c[2 * bench_egp_i], bench_egp_dh, bench_egp_m[bench_egp_i]))
+		{
+			bench_egp_failures.fetch_add(1);
+		}
+	}
+	bench_egp_inline_us = bench_egp_us_per_op(bench_egp_begin, bench_egp_count);
+	bench_egp_mismatched = bench_egp_mismatches(bench_egp_dh, bench_egp_m, bench_egp_c);
+
+	if (!elgamal_pool_start(bench_egp_pool, bench_egp_dh, bench_egp_capacity, 20240714))
+	{
+		printf("elgamal_pool_start failed\n");
+		return 1;
+	}
+
+	printf("%-8s %13s %10s %10s %8s %12s %12s\n",
+		"", "depth/cap", "produced", "consumed", "misses", "refill/s", "consume/s");
+
+	// filled, or as far as the refill thread gets in 10 s
+	bench_egp_begin = std::chrono::steady_clock::now();
+	do
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		elgamal_pool_get_stats(bench_egp_stats, bench_egp_pool);
+	} while (bench_egp_stats[0].depth < bench_egp_capacity &&
+		std::chrono::steady_clock::now() - bench_egp_begin < std::chrono::seconds(10));
+	bench_egp_print_stats("filled", bench_egp_pool);
+
+	bench_egp_begin = std::chrono::steady_clock::now();
+	for (bench_egp_i = 0; bench_egp_i < bench_egp_thread_count; bench_egp_i++)
+	{
+		bench_egp_threads.emplace_back([&, bench_egp_i]() {
+			bench_egp_encrypt_range(
+				bench_egp_pool,
+				&bench_egp_m,
+				&bench_egp_c,
+				(int)((long long)bench_egp_count * bench_egp_i / bench_egp_thread_count),
+				(int)((long long)bench_egp_count * (bench_egp_i + 1) / bench_egp_thread_count),
+				&bench_egp_failures);
+			bench_egp_done.fetch_add(1);
+		});
+	}
+
+	while (bench_egp_done.load() < bench_egp_thread_count)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		bench_egp_print_stats("load", bench_egp_pool);
+	}
+
+	for (std::thread& bench_egp_thread : bench_egp_threads)
+	{
+		bench_egp_thread.join();
+	}
+	bench_egp_pool_us = bench_egp_us_per_op(bench_egp_begin, bench_egp_count);
+	bench_egp_print_stats("done", bench_egp_pool);
+	elgamal_pool_stop(bench_egp_pool);
+
+	bench_egp_mismatched += bench_egp_mismatches(bench_egp_dh, bench_egp_m, bench_egp_c);
+
+	elgamal_pool_get_stats(bench_egp_stats, bench_egp_pool);
+	printf("inline %.3f us/encryption, pool %.3f us/encryption (%.2fx), %.1f%% misses\n",
+		bench_egp_inline_us,
+		bench_egp_pool_us,
+		bench_egp_inline_us / bench_egp_pool_us,
+		100.0 * bench_egp_stats[0].misses / bench_egp_count);
+
+	if (bench_egp_failures.load() || bench_egp_mismatched)
+	{
+		printf("%d encryptions failed, %d ciphertexts do not decrypt to their message\n",
+			bench_egp_failures.load(), bench_egp_mismatched);
+		return 1;
+	}
+
+	return 0;
+}
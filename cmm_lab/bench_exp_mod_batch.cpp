@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "crypto_core.h"
+#include "exp_mod_batch.h"
+
+// Times count independent exponentiations with full 31-bit exponents and
+// odd 31-bit moduli, as in RSA decryption, through the scalar exp_mod loop
+// and through exp_mod_batch at every lane width the CPU supports.
+// Usage: cmm_lab bench-exp-mod-batch [count=65536]
+
+static double bench_emb_ns_per_op(
+	std::chrono::steady_clock::time_point bench_emb_begin,
+	int bench_emb_count)
+{
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_emb_begin).count() / bench_emb_count;
+}
+
+int bench_exp_mod_batch(int argc, char* argv[])
+{
+	static const int kBenchEmbWidths[3] = { 1, 8, 16 };
+	int bench_emb_count = 1 << 16;
+	int bench_emb_i, bench_emb_w, bench_emb_mismatches = 0;
+	double bench_emb_scalar_ns, bench_emb_ns;
+	std::chrono::steady_clock::time_point bench_emb_begin;
+	std::vector<int> bench_emb_a, bench_emb_b, bench_emb_p, bench_emb_ref, bench_emb_out;
+
+	if (argc >= 1)
+	{
+		bench_emb_count = atoi(argv[0]);
+	}
+
+	if (bench_emb_count <= 0)
+	{
+		printf("count must be positive\n");
+		return 1;
+	}
+
+	srand32(20240602);
+
+	bench_emb_a.resize(bench_emb_count);
+	bench_emb_b.resize(bench_emb_count);
+	bench_emb_p.resize(bench_emb_count);
+	bench_emb_ref.resize(bench_emb_count);
+	bench_emb_out.resize(bench_emb_count);
+
+	for (bench_emb_i = 0; bench_emb_i < bench_emb_count; bench_emb_i++)
+	{
+		bench_emb_p[bench_emb_i] = rand_bits(31, 0, 1);
+		bench_emb_b[bench_emb_i] = rand_bits(31, 0, 0);
+		rand_range(&bench_emb_a[bench_emb_i], bench_emb_p[bench_emb_i]);
+	}
+
+	bench_emb_begin = std::chrono::steady_clock::now();
+	for (bench_emb_i = 0; bench_emb_i < bench_emb_count; bench_emb_i++)
+	{
+		bench_emb_ref[bench_emb_i] = exp_mod(bench_emb_a[bench_emb_i], bench_emb_b[bench_emb_i], bench_emb_p[bench_emb_i]);
+	}
+	bench_emb_scalar_ns = bench_emb_ns_per_op(bench_emb_begin, bench_emb_count);
+
+	printf("%d exponentiations\n", bench_emb_count);
+	printf("exp_mod loop:       %9.1f ns/op\n", bench_emb_scalar_ns);
+
+	for (bench_emb_w = 0; bench_emb_w < 3; bench_emb_w++)
+	{
+		exp_mod_batch_set_max_lanes(kBenchEmbWidths[bench_emb_w]);
+		if (exp_mod_batch_lanes() != kBenchEmbWidths[bench_emb_w])
+		{
+			printf("exp_mod_batch x%-2d   not supported by this CPU\n", kBenchEmbWidths[bench_emb_w]);
+			continue;
+		}
+
+		bench_emb_begin = std::chrono::steady_clock::now();
+		exp_mod_batch(bench_emb_out.data(), bench_emb_a.data(), bench_emb_b.data(), bench_emb_p.data(), bench_emb_count);
+		bench_emb_ns = bench_emb_ns_per_op(bench_emb_begin, bench_emb_count);
+
+		for (bench_emb_i = 0; bench_emb_i < bench_emb_count; bench_emb_i++)
+		{
+			if (bench_emb_out[bench_emb_i] != bench_emb_ref[bench_emb_i])
+			{
+				bench_emb_mismatches++;
+			}
+		}
+
+		printf("exp_mod_batch x%-2d: %9.1f ns/op (%.1fx)\n",
+			kBenchEmbWidths[bench_emb_w], bench_emb_ns, bench_emb_scalar_ns / bench_emb_ns);
+	}
+
+	exp_mod_batch_set_max_lanes(16);
+
+	if (bench_emb_mismatches)
+	{
+		printf("%d results differ from exp_mod\n", bench_emb_mismatches);
+		return 1;
+	}
+
+	return 0;
+}
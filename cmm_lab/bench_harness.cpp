@@ -0,0 +1,414 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "bench_harness.h"
+#include "common.h"
+
+static volatile int kBenchHarnessSink;
+static int kBenchHarnessUnscheduled = 0;
+
+int bench_harness_parse(struct BenchHarnessOptions bench_harness_parse_out[1], int argc, char* argv[])
+{
+	int bench_harness_parse_arg = 0;
+
+	bench_harness_parse_out[0].warmup = 3;
+	bench_harness_parse_out[0].repetitions = 15;
+	bench_harness_parse_out[0].min_rep_ms = 2.0;
+	bench_harness_parse_out[0].seed = 20240706;
+	bench_harness_parse_out[0].filter = nullptr;
+	bench_harness_parse_out[0].json_path = nullptr;
+
+	while (bench_harness_parse_arg < argc)
+	{
+		const char* bench_harness_parse_option = argv[bench_harness_parse_arg];
+		const char* bench_harness_parse_value;
+
+		if (bench_harness_parse_arg + 1 >= argc)
+		{
+			printf("missing value for %s\n", bench_harness_parse_option);
+			return 0;
+		}
+
+		bench_harness_parse_value = argv[bench_harness_parse_arg + 1];
+
+		if (strcmp(bench_harness_parse_option, "--json") == 0)
+		{
+			bench_harness_parse_out[0].json_path = bench_harness_parse_value;
+		}
+		else if (strcmp(bench_harness_parse_option, "--filter") == 0)
+		{
+			bench_harness_parse_out[0].filter = bench_harness_parse_value;
+		}
+		else if (strcmp(bench_harness_parse_option, "--reps") == 0)
+		{
+			bench_harness_parse_out[0].repetitions = atoi(bench_harness_parse_value);
+		}
+		else if (strcmp(bench_harness_parse_option, "--warmup") == 0)
+		{
+			bench_harness_parse_out[0].warmup = atoi(bench_harness_parse_value);
+		}
+		else if (strcmp(bench_harness_parse_option, "--min-ms") == 0)
+		{
+			bench_harness_parse_out[0].min_rep_ms = atof(bench_harness_parse_value);
+		}
+		else if (strcmp(bench_harness_parse_option, "--seed") == 0)
+		{
+			bench_harness_parse_out[0].seed = (unsigned)strtoul(bench_harness_parse_value, nullptr, 10);
+		}
+		else
+		{
+			printf("unknown option: %s\n", bench_harness_parse_option);
+			return 0;
+		}
+
+		bench_harness_parse_arg = bench_harness_parse_arg + 2;
+	}
+
+	if (bench_harness_parse_out[0].repetitions <= 0 ||
+		bench_harness_parse_out[0].warmup < 0 ||
+		bench_harness_parse_out[0].min_rep_ms <= 0)
+	{
+		printf("repetitions and min-ms must be positive, warmup non-negative\n");
+		return 0;
+	}
+
+	return 1;
+}
+
+// ns per call for calls calls starting at corpus entry *next
+static double bench_harness_time(
+	struct BenchHarnessCase bench_harness_time_case[1],
+	int bench_harness_time_calls,
+	int bench_harness_time_next[1])
+{
+	int bench_harness_time_i = bench_harness_time_next[0];
+	int bench_harness_time_acc = 0;
+	std::chrono::steady_clock::time_point bench_harness_time_begin = std::chrono::steady_clock::now();
+
+	for (int bench_harness_time_n = 0; bench_harness_time_n < bench_harness_time_calls; bench_harness_time_n++)
+	{
+		bench_harness_time_acc += bench_harness_time_case[0].op(bench_harness_time_i);
+		bench_harness_time_i++;
+		if (bench_harness_time_i == bench_harness_time_case[0].corpus_size)
+		{
+			bench_harness_time_i = 0;
+		}
+	}
+
+	double bench_harness_time_ns = std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_harness_time_begin).count();
+
+	kBenchHarnessSink = kBenchHarnessSink + bench_harness_time_acc;
+	bench_harness_time_next[0] = bench_harness_time_i;
+
+	return bench_harness_time_ns / bench_harness_time_calls;
+}
+
+// nearest rank
+static double bench_harness_percentile(std::vector<double>& bench_harness_sorted, int bench_harness_percent)
+{
+	size_t bench_harness_rank = (bench_harness_sorted.size() * bench_harness_percent + 99) / 100;
+
+	return bench_harness_sorted[bench_harness_rank == 0 ? 0 : bench_harness_rank - 1];
+}
+
+int bench_harness_run(
+	struct BenchHarnessStats bench_harness_run_out[1],
+	struct BenchHarnessOptions bench_harness_run_options[1],
+	struct BenchHarnessCase bench_harness_run_case[1])
+{
+	int bench_harness_run_calls = 1;
+	int bench_harness_run_next[1] = { 0 };
+	double bench_harness_run_sum = 0;
+	std::vector<double> bench_harness_run_ns;
+	struct PerfCounters bench_harness_run_pc[1];
+
+	if (bench_harness_run_options[0].filter != nullptr &&
+		strstr(bench_harness_run_case[0].name, bench_harness_run_options[0].filter) == nullptr)
+	{
+		return 0;
+	}
+
+	srand32((int)bench_harness_run_options[0].seed);
+
+	// calibrate: the first doublings also warm caches and predictors
+	while (bench_harness_run_calls < (1 << 24) &&
+		bench_harness_time(bench_harness_run_case, bench_harness_run_calls, bench_harness_run_next) *
+			bench_harness_run_calls < bench_harness_run_options[0].min_rep_ms * 1e6)
+	{
+		bench_harness_run_calls = bench_harness_run_calls * 2;
+	}
+
+	for (int bench_harness_run_i = 0; bench_harness_run_i < bench_harness_run_options[0].warmup; bench_harness_run_i++)
+	{
+		bench_harness_time(bench_harness_run_case, bench_harness_run_calls, bench_harness_run_next);
+	}
+
+	// reserved up front so the counted loop does not allocate
+	bench_harness_run_ns.reserve(bench_harness_run_options[0].repetitions);
+	perf_counters_open(bench_harness_run_pc);
+	perf_counters_start(bench_harness_run_pc);
+
+	for (int bench_harness_run_i = 0; bench_harness_run_i < bench_harness_run_options[0].repetitions; bench_harness_run_i++)
+	{
+		bench_harness_run_ns.push_back(
+			bench_harness_time(bench_harness_run_case, bench_harness_run_calls, bench_harness_run_next));
+		bench_harness_run_sum += bench_harness_run_ns.back();
+	}
+
+	if (!perf_counters_stop(bench_harness_run_pc) && !kBenchHarnessUnscheduled)
+	{
+		// said once; the affected columns show n/a
+		fprintf(stderr, "hardware events were opened but never scheduled on the PMU\n");
+		kBenchHarnessUnscheduled = 1;
+	}
+
+	for (int bench_harness_run_e = 0; bench_harness_run_e < kPerfEventCount; bench_harness_run_e++)
+	{
+		bench_harness_run_out[0].per_op[bench_harness_run_e] =
+			perf_counters_available(bench_harness_run_pc, bench_harness_run_e)
+			? (double)bench_harness_run_pc[0].values[bench_harness_run_e] /
+				((double)bench_harness_run_calls * bench_harness_run_options[0].repetitions)
+			: -1;
+		bench_harness_run_out[0].perf_group[bench_harness_run_e] =
+			perf_counters_group(bench_harness_run_pc, bench_harness_run_e);
+	}
+
+	bench_harness_run_out[0].perf_group_count = bench_harness_run_pc[0].group_count;
+	for (int bench_harness_run_g = 0; bench_harness_run_g < kPerfGroupCount; bench_harness_run_g++)
+	{
+		bench_harness_run_out[0].running_ratio[bench_harness_run_g] = bench_harness_run_g < bench_harness_run_pc[0].group_count
+			? perf_counters_running_ratio(bench_harness_run_pc, bench_harness_run_g)
+			: -1;
+	}
+
+	perf_counters_close(bench_harness_run_pc);
+
+	std::sort(bench_harness_run_ns.begin(), bench_harness_run_ns.end());
+
+	bench_harness_run_out[0].name = bench_harness_run_case[0].name;
+	bench_harness_run_out[0].calls_per_rep = bench_harness_run_calls;
+	bench_harness_run_out[0].min = bench_harness_run_ns.front();
+	bench_harness_run_out[0].median = bench_harness_percentile(bench_harness_run_ns, 50);
+	bench_harness_run_out[0].p90 = bench_harness_percentile(bench_harness_run_ns, 90);
+	// below 100 samples the nearest rank for p99 is the max itself
+	bench_harness_run_out[0].p99 = bench_harness_run_ns.size() >= 100
+		? bench_harness_percentile(bench_harness_run_ns, 99)
+		: -1;
+	bench_harness_run_out[0].max = bench_harness_run_ns.back();
+	bench_harness_run_out[0].mean = bench_harness_run_sum / bench_harness_run_ns.size();
+
+	return 1;
+}
+
+static double bench_harness_ratio(double bench_harness_ratio_a, double bench_harness_ratio_b)
+{
+	if (bench_harness_ratio_a < 0 || bench_harness_ratio_b <= 0)
+	{
+		return -1;
+	}
+
+	return bench_harness_ratio_a / bench_harness_ratio_b;
+}
+
+double bench_harness_ipc(struct BenchHarnessStats bench_harness_ipc_stats[1])
+{
+	return bench_harness_ratio(
+		bench_harness_ipc_stats[0].per_op[kPerfInstructions],
+		bench_harness_ipc_stats[0].per_op[kPerfCycles]);
+}
+
+double bench_harness_branch_miss_rate(struct BenchHarnessStats bench_harness_bmr_stats[1])
+{
+	return bench_harness_ratio(
+		bench_harness_bmr_stats[0].per_op[kPerfBranchMisses],
+		bench_harness_bmr_stats[0].per_op[kPerfBranches]);
+}
+
+// a column of the given width holding value, or n/a if it is negative
+static int bench_harness_print_metric(
+	int bench_harness_pm_width,
+	const char* bench_harness_pm_format,
+	double bench_harness_pm_value)
+{
+	if (bench_harness_pm_value < 0)
+	{
+		printf(" %*s", bench_harness_pm_width, "n/a");
+	}
+	else
+	{
+		printf(" ");
+		printf(bench_harness_pm_format, bench_harness_pm_width, bench_harness_pm_value);
+	}
+
+	return 1;
+}
+
+int bench_harness_print_header()
+{
+	printf("%-28s %12s %12s %12s %12s %10s %10s %6s %8s %8s %8s %11s\n",
+		"ns/call", "min", "median", "p90", "p99", "calls/rep", "cycles", "IPC", "br-miss%", "L1d/op", "LLC/op", "counted%");
+	return 1;
+}
+
+// each open group's running ratio in percent, '/'-separated when the
+// events were split into pairs; n/a if none opened
+static int bench_harness_print_running(struct BenchHarnessStats bench_harness_pr_stats[1])
+{
+	char bench_harness_pr_text[32] = "";
+	int bench_harness_pr_len = 0;
+
+	for (int bench_harness_pr_g = 0; bench_harness_pr_g < bench_harness_pr_stats[0].perf_group_count; bench_harness_pr_g++)
+	{
+		double bench_harness_pr_ratio = bench_harness_pr_stats[0].running_ratio[bench_harness_pr_g];
+
+		if (bench_harness_pr_ratio < 0)
+		{
+			continue;
+		}
+
+		bench_harness_pr_len += snprintf(
+			bench_harness_pr_text + bench_harness_pr_len,
+			sizeof(bench_harness_pr_text) - bench_harness_pr_len,
+			bench_harness_pr_len == 0 ? "%.0f" : "/%.0f",
+			bench_harness_pr_ratio * 100);
+	}
+
+	printf(" %11s", bench_harness_pr_len == 0 ? "n/a" : bench_harness_pr_text);
+
+	return 1;
+}
+
+int bench_harness_print(struct BenchHarnessStats bench_harness_print_stats[1])
+{
+	double bench_harness_print_bmr = bench_harness_branch_miss_rate(bench_harness_print_stats);
+
+	printf("%-28s %12.1f %12.1f %12.1f",
+		bench_harness_print_stats[0].name.c_str(),
+		bench_harness_print_stats[0].min,
+		bench_harness_print_stats[0].median,
+		bench_harness_print_stats[0].p90);
+	bench_harness_print_metric(12, "%*.1f", bench_harness_print_stats[0].p99);
+	printf(" %10d", bench_harness_print_stats[0].calls_per_rep);
+	bench_harness_print_metric(10, "%*.0f", bench_harness_print_stats[0].per_op[kPerfCycles]);
+	bench_harness_print_metric(6, "%*.2f", bench_harness_ipc(bench_harness_print_stats));
+	bench_harness_print_metric(8, "%*.2f", bench_harness_print_bmr < 0 ? -1 : bench_harness_print_bmr * 100);
+	bench_harness_print_metric(8, "%*.3f", bench_harness_print_stats[0].per_op[kPerfL1dMisses]);
+	bench_harness_print_metric(8, "%*.3f", bench_harness_print_stats[0].per_op[kPerfLlcMisses]);
+	bench_harness_print_running(bench_harness_print_stats);
+	printf("\n");
+	fflush(stdout);
+
+	return 1;
+}
+
+// a JSON number, or null if value is negative
+static int bench_harness_json_metric(FILE* bench_harness_jm_file, double bench_harness_jm_value)
+{
+	if (bench_harness_jm_value < 0)
+	{
+		fprintf(bench_harness_jm_file, "null");
+	}
+	else
+	{
+		fprintf(bench_harness_jm_file, "%.4g", bench_harness_jm_value);
+	}
+
+	return 1;
+}
+
+int bench_harness_write_json(
+	const char* bench_harness_json_suite,
+	struct BenchHarnessOptions bench_harness_json_options[1],
+	std::vector<struct BenchHarnessStats>& bench_harness_json_results)
+{
+	FILE* bench_harness_json_file;
+
+	if (bench_harness_json_options[0].json_path == nullptr)
+	{
+		return 1;
+	}
+
+	bench_harness_json_file = fopen(bench_harness_json_options[0].json_path, "w");
+	if (bench_harness_json_file == nullptr)
+	{
+		printf("cannot write %s\n", bench_harness_json_options[0].json_path);
+		return 0;
+	}
+
+	// case names are identifiers, so they need no escaping
+	fprintf(bench_harness_json_file,
+		"{\n  \"suite\": \"%s\",\n  \"seed\": %u,\n  \"warmup\": %d,\n  \"repetitions\": %d,\n  \"results\": [",
+		bench_harness_json_suite,
+		bench_harness_json_options[0].seed,
+		bench_harness_json_options[0].warmup,
+		bench_harness_json_options[0].repetitions);
+
+	for (size_t bench_harness_json_i = 0; bench_harness_json_i < bench_harness_json_results.size(); bench_harness_json_i++)
+	{
+		struct BenchHarnessStats& bench_harness_json_s = bench_harness_json_results[bench_harness_json_i];
+
+		fprintf(bench_harness_json_file,
+			"%s\n    {\"name\": \"%s\", \"calls_per_rep\": %d, \"ns_per_op\": "
+			"{\"min\": %.2f, \"median\": %.2f, \"p90\": %.2f, \"p99\": ",
+			bench_harness_json_i == 0 ? "" : ",",
+			bench_harness_json_s.name.c_str(),
+			bench_harness_json_s.calls_per_rep,
+			bench_harness_json_s.min,
+			bench_harness_json_s.median,
+			bench_harness_json_s.p90);
+		if (bench_harness_json_s.p99 < 0)
+		{
+			fprintf(bench_harness_json_file, "null");
+		}
+		else
+		{
+			fprintf(bench_harness_json_file, "%.2f", bench_harness_json_s.p99);
+		}
+		fprintf(bench_harness_json_file,
+			", \"max\": %.2f, \"mean\": %.2f}, \"per_op\": {",
+			bench_harness_json_s.max,
+			bench_harness_json_s.mean);
+
+		for (int bench_harness_json_e = 0; bench_harness_json_e < kPerfEventCount; bench_harness_json_e++)
+		{
+			fprintf(bench_harness_json_file, "%s\"%s\": ",
+				bench_harness_json_e == 0 ? "" : ", ",
+				perf_event_name(bench_harness_json_e));
+			bench_harness_json_metric(bench_harness_json_file, bench_harness_json_s.per_op[bench_harness_json_e]);
+		}
+
+		fprintf(bench_harness_json_file, "}, \"ipc\": ");
+		bench_harness_json_metric(bench_harness_json_file, bench_harness_ipc(&bench_harness_json_s));
+		fprintf(bench_harness_json_file, ", \"branch_miss_rate\": ");
+		bench_harness_json_metric(bench_harness_json_file, bench_harness_branch_miss_rate(&bench_harness_json_s));
+		fprintf(bench_harness_json_file, ", \"perf_groups\": [");
+		for (int bench_harness_json_g = 0; bench_harness_json_g < bench_harness_json_s.perf_group_count; bench_harness_json_g++)
+		{
+			const char* bench_harness_json_separator = "";
+
+			fprintf(bench_harness_json_file, "%s{\"events\": [", bench_harness_json_g == 0 ? "" : ", ");
+			for (int bench_harness_json_e = 0; bench_harness_json_e < kPerfEventCount; bench_harness_json_e++)
+			{
+				if (bench_harness_json_s.perf_group[bench_harness_json_e] == bench_harness_json_g)
+				{
+					fprintf(bench_harness_json_file, "%s\"%s\"",
+						bench_harness_json_separator, perf_event_name(bench_harness_json_e));
+					bench_harness_json_separator = ", ";
+				}
+			}
+			fprintf(bench_harness_json_file, "], \"running_ratio\": ");
+			bench_harness_json_metric(bench_harness_json_file, bench_harness_json_s.running_ratio[bench_harness_json_g]);
+			fprintf(bench_harness_json_file, "}");
+		}
+		fprintf(bench_harness_json_file, "]}");
+	}
+
+	fprintf(bench_harness_json_file, "\n  ]\n}\n");
+	fclose(bench_harness_json_file);
+
+	return 1;
+}
@@ -0,0 +1,87 @@
+#ifndef BENCH_HARNESS_H_
+#define BENCH_HARNESS_H_
+
+#include <string>
+#include <vector>
+
+#include "perf_counters.h"
+
+// Measurement loop shared by benchmark commands. A case is one operation
+// applied to entry i of a corpus the caller built from a fixed seed. The
+// harness first doubles the number of calls per repetition until one
+// repetition takes min_rep_ms (so slow operations still get whole calls
+// and fast ones are not dominated by the clock), runs warmup repetitions
+// it discards, then records ns per call for each timed repetition.
+// Hardware events are counted over all timed repetitions together.
+
+struct BenchHarnessOptions
+{
+	int warmup;
+	int repetitions;
+	double min_rep_ms;
+	unsigned seed; // for srand32 before each case and for corpora
+	const char* filter; // only cases whose name contains it; nullptr for all
+	const char* json_path; // nullptr for no JSON output
+};
+
+// ns per call over the timed repetitions
+struct BenchHarnessStats
+{
+	std::string name;
+	int calls_per_rep;
+	double min;
+	double median;
+	double p90;
+	double p99; // -1 below 100 repetitions, where it would just be max
+	double max;
+	double mean;
+	double per_op[kPerfEventCount]; // event counts per call, -1 if unavailable
+	int perf_group_count; // 1, or kPerfGroupCount if the events were split into pairs
+	int perf_group[kPerfEventCount]; // each event's group
+	double running_ratio[kPerfGroupCount]; // share of the time each group counted, -1 if not open
+};
+
+// Apply the operation to corpus entry i; the result is kept so the call
+// cannot be optimized away.
+typedef int (*BenchHarnessOp)(int bench_harness_op_i);
+
+struct BenchHarnessCase
+{
+	const char* name;
+	BenchHarnessOp op;
+	int corpus_size;
+};
+
+// Defaults, then options from argv:
+//   --json file  --filter text  --reps n  --warmup n  --min-ms x  --seed n
+// Return 0 and print a message on a bad option.
+int bench_harness_parse(struct BenchHarnessOptions bench_harness_parse_out[1], int argc, char* argv[]);
+
+// Return 0 if the case is filtered out.
+int bench_harness_run(
+	struct BenchHarnessStats bench_harness_run_out[1],
+	struct BenchHarnessOptions bench_harness_run_options[1],
+	struct BenchHarnessCase bench_harness_run_case[1]);
+
+// instructions per cycle, or -1 if either event is unavailable
+double bench_harness_ipc(struct BenchHarnessStats bench_harness_ipc_stats[1]);
+
+// branch misses per branch, or -1
+double bench_harness_branch_miss_rate(struct BenchHarnessStats bench_harness_bmr_stats[1]);
+
+int bench_harness_print_header();
+
+int bench_harness_print(struct BenchHarnessStats bench_harness_print_stats[1]);
+
+// {"suite", "seed", "warmup", "repetitions", "results": [{"name",
+// "calls_per_rep", "ns_per_op": {min, median, p90, p99, max, mean},
+// "per_op": {one count per perf_event_name}, "ipc", "branch_miss_rate",
+// "perf_groups": [{"events", "running_ratio"}]}]}; unavailable counts, the
+// rates derived from them, the ratio of a group that did not open and p99
+// below 100 repetitions are null.
+int bench_harness_write_json(
+	const char* bench_harness_json_suite,
+	struct BenchHarnessOptions bench_harness_json_options[1],
+	std::vector<struct BenchHarnessStats>& bench_harness_json_results);
+
+#endif
@@ -0,0 +1,181 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "bench.h"
+#include "cmm_io.h"
+#include "common.h"
+
+// Compares the original iostream-based read()/write() against cmm_io,
+// and text input against a memory-mapped binary stream.
+// stdin/stdout are redirected to scratch files, so timings are reported
+// on stderr.
+// Usage: cmm_lab bench-io [count=10000000]
+
+static const char* kBenchIoInPath = "bench_io_in.txt";
+static const char* kBenchIoOutPath = "bench_io_out.txt";
+static const char* kBenchIoBinPath = "bench_io_in.bin";
+
+static double bench_io_elapsed_ms(std::chrono::steady_clock::time_point bench_io_begin)
+{
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - bench_io_begin).count();
+}
+
+int bench_io(int argc, char* argv[])
+{
+	int bench_io_count = 10000000;
+	int bench_io_i, bench_io_x;
+	long long bench_io_sum_std = 0, bench_io_sum_fast = 0, bench_io_sum_bin = 0;
+	double bench_io_write_std_ms, bench_io_write_fast_ms;
+	double bench_io_read_std_ms, bench_io_read_fast_ms, bench_io_read_bin_ms;
+	std::chrono::steady_clock::time_point bench_io_begin;
+	FILE* bench_io_in;
+
+	if (argc >= 1)
+	{
+		bench_io_count = atoi(argv[0]);
+	}
+
+	if (bench_io_count <= 0)
+	{
+		fprintf(stderr, "count must be positive\n");
+		return 1;
+	}
+
+	srand32(20240601);
+
+	bench_io_in = fopen(kBenchIoInPath, "w");
+	if (!bench_io_in)
+	{
+		fprintf(stderr, "cannot create %s\n", kBenchIoInPath);
+		return 1;
+	}
+
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		fprintf(bench_io_in, "%d\n", rand32());
+		bench_io_i = bench_io_i + 1;
+	}
+
+	fclose(bench_io_in);
+
+	// the same values as a binary stream
+	srand32(20240601);
+
+	if (!cmm_io_open_binary_output(kBenchIoBinPath))
+	{
+		fprintf(stderr, "cannot create %s\n", kBenchIoBinPath);
+		return 1;
+	}
+
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		cmm_io_write(rand32());
+		bench_io_i = bench_io_i + 1;
+	}
+
+	cmm_io_close_binary_output();
+
+	// writes
+
+	if (!freopen(kBenchIoOutPath, "w", stdout))
+	{
+		fprintf(stderr, "cannot redirect stdout\n");
+		return 1;
+	}
+
+	bench_io_begin = std::chrono::steady_clock::now();
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		std::cout << bench_io_i << std::endl;
+		bench_io_i = bench_io_i + 1;
+	}
+	bench_io_write_std_ms = bench_io_elapsed_ms(bench_io_begin);
+
+	freopen(kBenchIoOutPath, "w", stdout);
+
+	bench_io_begin = std::chrono::steady_clock::now();
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		cmm_io_write(bench_io_i);
+		bench_io_i = bench_io_i + 1;
+	}
+	cmm_io_flush();
+	bench_io_write_fast_ms = bench_io_elapsed_ms(bench_io_begin);
+
+	// reads
+
+	if (!freopen(kBenchIoInPath, "r", stdin))
+	{
+		fprintf(stderr, "cannot redirect stdin\n");
+		return 1;
+	}
+
+	bench_io_begin = std::chrono::steady_clock::now();
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		bench_io_x = 0;
+		std::cin >> bench_io_x;
+		bench_io_sum_std = bench_io_sum_std + bench_io_x;
+		bench_io_i = bench_io_i + 1;
+	}
+	bench_io_read_std_ms = bench_io_elapsed_ms(bench_io_begin);
+
+	freopen(kBenchIoInPath, "r", stdin);
+
+	bench_io_begin = std::chrono::steady_clock::now();
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		bench_io_sum_fast = bench_io_sum_fast + cmm_io_read();
+		bench_io_i = bench_io_i + 1;
+	}
+	bench_io_read_fast_ms = bench_io_elapsed_ms(bench_io_begin);
+
+	if (!cmm_io_open_binary_input(kBenchIoBinPath))
+	{
+		fprintf(stderr, "cannot map %s\n", kBenchIoBinPath);
+		return 1;
+	}
+
+	bench_io_begin = std::chrono::steady_clock::now();
+	bench_io_i = 0;
+	while (bench_io_i < bench_io_count)
+	{
+		bench_io_sum_bin = bench_io_sum_bin + cmm_io_read();
+		bench_io_i = bench_io_i + 1;
+	}
+	bench_io_read_bin_ms = bench_io_elapsed_ms(bench_io_begin);
+
+	cmm_io_close_binary_input();
+
+	remove(kBenchIoInPath);
+	remove(kBenchIoOutPath);
+	remove(kBenchIoBinPath);
+
+	fprintf(stderr, "%d writes: iostream %.1f ms, cmm_io %.1f ms (%.1fx)\n",
+		bench_io_count, bench_io_write_std_ms, bench_io_write_fast_ms,
+		bench_io_write_std_ms / bench_io_write_fast_ms);
+	fprintf(stderr, "%d reads:  iostream %.1f ms, cmm_io %.1f ms (%.1fx)\n",
+		bench_io_count, bench_io_read_std_ms, bench_io_read_fast_ms,
+		bench_io_read_std_ms / bench_io_read_fast_ms);
+	fprintf(stderr, "%d reads:  binary mmap %.1f ms (%.1fx)\n",
+		bench_io_count, bench_io_read_bin_ms,
+		bench_io_read_std_ms / bench_io_read_bin_ms);
+
+	if (bench_io_sum_std != bench_io_sum_fast || bench_io_sum_std != bench_io_sum_bin)
+	{
+		fprintf(stderr, "checksum mismatch: %lld, %lld, %lld\n",
+			bench_io_sum_std, bench_io_sum_fast, bench_io_sum_bin);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "keygen_async.h"
+
+// Exercises the async keygen API: a batch of concurrent rsa_keygen_async
+// requests, then how quickly a search that can never succeed (primes
+// congruent to 0 mod 4) stops after cancellation and after its deadline.
+// Usage: cmm_lab bench-keygen-async [requests=64]
+
+static const char* bench_kga_status_name(int bench_kga_status)
+{
+	if (bench_kga_status == kKeygenOk)
+	{
+		return "ok";
+	}
+
+	if (bench_kga_status == kKeygenCancelled)
+	{
+		return "cancelled";
+	}
+
+	if (bench_kga_status == kKeygenTimedOut)
+	{
+		return "timed out";
+	}
+
+	return "failed";
+}
+
+int bench_keygen_async(int argc, char* argv[])
+{
+	std::chrono::steady_clock::time_point bench_kga_none = std::chrono::steady_clock::time_point::max();
+	std::chrono::steady_clock::time_point bench_kga_begin, bench_kga_mark;
+	std::vector<std::future<struct RSAKeygenResult>> bench_kga_rsa;
+	std::future<struct PrimeResult> bench_kga_prime;
+	struct KeygenToken bench_kga_token[1];
+	struct PrimeResult bench_kga_prime_result;
+	int bench_kga_requests = 64;
+	int bench_kga_i, bench_kga_ok = 0;
+
+	if (argc >= 1)
+	{
+		bench_kga_requests = atoi(argv[0]);
+	}
+
+	if (bench_kga_requests <= 0)
+	{
+		printf("requests must be positive\n");
+		return 1;
+	}
+
+	bench_kga_begin = std::chrono::steady_clock::now();
+	for (bench_kga_i = 0; bench_kga_i < bench_kga_requests; bench_kga_i++)
+	{
+		bench_kga_rsa.push_back(rsa_keygen_async(31, 65537, nullptr, bench_kga_none));
+	}
+
+	for (bench_kga_i = 0; bench_kga_i < bench_kga_requests; bench_kga_i++)
+	{
+		if (bench_kga_rsa[bench_kga_i].get().status == kKeygenOk)
+		{
+			bench_kga_ok++;
+		}
+	}
+
+	printf("%d/%d rsa_keygen_async requests ok in %.3f ms\n",
+		bench_kga_ok,
+		bench_kga_requests,
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bench_kga_begin).count());
+
+	keygen_token_init(bench_kga_token);
+	bench_kga_prime = generate_prime_async(31, 0, 4, 0, bench_kga_token, bench_kga_none);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+	bench_kga_mark = std::chrono::steady_clock::now();
+	keygen_cancel(bench_kga_token);
+	bench_kga_prime_result = bench_kga_prime.get();
+	printf("cancel:   %s after %.3f ms\n",
+		bench_kga_status_name(bench_kga_prime_result.status),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bench_kga_mark).count());
+
+	bench_kga_mark = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+	bench_kga_prime = generate_prime_async(31, 0, 4, 0, nullptr, bench_kga_mark);
+	bench_kga_prime_result = bench_kga_prime.get();
+	printf("deadline: %s %.3f ms past the deadline\n",
+		bench_kga_status_name(bench_kga_prime_result.status),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bench_kga_mark).count());
+
+	return bench_kga_ok == bench_kga_requests ? 0 : 1;
+}
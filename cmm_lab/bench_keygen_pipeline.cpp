@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "rsa_pipeline.h"
+
+// Runs the RSA keygen pipeline and a serial rsa_keygen loop for the same
+// number of keys and prints keys per second and per-stage utilization. A
+// finder stage near 100% with idle pairing/output stages means more finder
+// threads will help; the reverse means the split is too wide.
+// Every key is round-tripped through encrypt/decrypt.
+// Usage: cmm_lab bench-keygen-pipeline [keys=20000] [finders=hw-2] [bits=31] [keystore]
+
+static int bench_kgp_check(struct RSA bench_kgp_check_keys[], long long bench_kgp_check_count)
+{
+	long long bench_kgp_check_i;
+	int bench_kgp_check_c[1], bench_kgp_check_m[1];
+
+	for (bench_kgp_check_i = 0; bench_kgp_check_i < bench_kgp_check_count; bench_kgp_check_i++)
+	{
+		if (!rsa_pubkey_encryrpt(bench_kgp_check_c, &bench_kgp_check_keys[bench_kgp_check_i], 12345) ||
+			!rsa_privkey_decryrpt(bench_kgp_check_m, &bench_kgp_check_keys[bench_kgp_check_i], bench_kgp_check_c[0]) ||
+			bench_kgp_check_m[0] != 12345)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void bench_kgp_print_stage(const char* bench_kgp_stage_name, struct RSAPipelineStageStats bench_kgp_stage[1])
+{
+	printf("  %-8s %2d thread(s), busy %7.3f s, utilization %5.1f%%\n",
+		bench_kgp_stage_name,
+		bench_kgp_stage[0].threads,
+		bench_kgp_stage[0].busy_s,
+		100 * bench_kgp_stage[0].utilization);
+}
+
+int bench_keygen_pipeline(int argc, char* argv[])
+{
+	struct RSAPipelineConfig bench_kgp_config[1];
+	struct RSAPipelineStats bench_kgp_stats[1];
+	struct KeyStoreWriter bench_kgp_writer[1];
+	std::vector<struct RSA> bench_kgp_keys;
+	std::chrono::steady_clock::time_point bench_kgp_begin;
+	double bench_kgp_serial_s;
+	long long bench_kgp_i;
+	int bench_kgp_hw = (int)std::thread::hardware_concurrency();
+	const char* bench_kgp_path = nullptr;
+
+	bench_kgp_config[0].keys = 20000;
+	bench_kgp_config[0].finder_threads = bench_kgp_hw > 3 ? bench_kgp_hw - 2 : 1;
+	bench_kgp_config[0].bits = 31;
+	bench_kgp_config[0].e = 65537;
+	bench_kgp_config[0].queue_capacity = 1024;
+	bench_kgp_config[0].seed = 20240603;
+	bench_kgp_config[0].writer = nullptr;
+
+	if (argc >= 1)
+	{
+		bench_kgp_config[0].keys = atoll(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_kgp_config[0].finder_threads = atoi(argv[1]);
+	}
+
+	if (argc >= 3)
+	{
+		bench_kgp_config[0].bits = atoi(argv[2]);
+	}
+
+	if (argc >= 4)
+	{
+		bench_kgp_path = argv[3];
+	}
+
+	if (bench_kgp_config[0].keys <= 0)
+	{
+		printf("keys must be positive\n");
+		return 1;
+	}
+
+	if (bench_kgp_path != nullptr)
+	{
+		if (!keystore_writer_open(bench_kgp_writer, bench_kgp_path, kKeyStoreRsa))
+		{
+			printf("cannot create %s\n", bench_kgp_path);
+			return 1;
+		}
+
+		bench_kgp_config[0].writer = bench_kgp_writer;
+	}
+
+	bench_kgp_keys.resize((size_t)bench_kgp_config[0].keys);
+	bench_kgp_config[0].keys_out = bench_kgp_keys.data();
+
+	if (!rsa_keygen_pipeline(bench_kgp_stats, bench_kgp_config))
+	{
+		printf("pipeline failed\n");
+		return 1;
+	}
+
+	if (bench_kgp_path != nullptr && !keystore_writer_close(bench_kgp_writer))
+	{
+		printf("cannot finish %s\n", bench_kgp_path);
+		return 1;
+	}
+
+	if (!bench_kgp_check(bench_kgp_keys.data(), bench_kgp_config[0].keys))
+	{
+		printf("pipeline produced a broken key\n");
+		return 1;
+	}
+
+	srand32(bench_kgp_config[0].seed);
+	bench_kgp_begin = std::chrono::steady_clock::now();
+	for (bench_kgp_i = 0; bench_kgp_i < bench_kgp_config[0].keys; bench_kgp_i++)
+	{
+		if (!rsa_keygen(&bench_kgp_keys[(size_t)bench_kgp_i], bench_kgp_config[0].bits, bench_kgp_config[0].e))
+		{
+			printf("rsa_keygen failed\n");
+			return 1;
+		}
+	}
+	bench_kgp_serial_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - bench_kgp_begin).count();
+
+	printf("%lld %d-bit keys, e=%d, %d hardware threads\n",
+		bench_kgp_config[0].keys, bench_kgp_config[0].bits, bench_kgp_config[0].e, bench_kgp_hw);
+	printf("serial rsa_keygen: %10.0f keys/s\n", bench_kgp_config[0].keys / bench_kgp_serial_s);
+	printf("pipeline:          %10.0f keys/s (%.2fx)\n",
+		bench_kgp_stats[0].keys_per_s,
+		bench_kgp_stats[0].keys_per_s * bench_kgp_serial_s / bench_kgp_config[0].keys);
+	printf("  primes %lld, rejected for e %lld, pairs rejected %lld\n",
+		bench_kgp_stats[0].primes, bench_kgp_stats[0].primes_rejected, bench_kgp_stats[0].pairs_rejected);
+	bench_kgp_print_stage("finders", &bench_kgp_stats[0].finder);
+	bench_kgp_print_stage("pairing", &bench_kgp_stats[0].pairing);
+	bench_kgp_print_stage("output", &bench_kgp_stats[0].output);
+
+	return 0;
+}
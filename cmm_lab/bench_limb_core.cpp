@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "crypto_core.h"
+#include "crypto_core64.h"
+#include "limb_core.h"
+
+// uint64 a*b mod m for 62-bit operands: mul_mod_uint64 (C--) against
+// limb_core instantiated at 16-, 32- and 64-bit limbs. Every result is
+// compared with mul_mod_uint64.
+// Usage: cmm_lab bench-limb-core [count=200000]
+
+static_assert(limb_core_self_check<uint16_t>(), "limb_core, 16-bit limbs");
+static_assert(limb_core_self_check<uint32_t>(), "limb_core, 32-bit limbs");
+static_assert(limb_core_self_check<uint64_t>(), "limb_core, 64-bit limbs");
+
+// the half-limb fallback used for 64-bit limbs without unsigned __int128
+static constexpr bool bench_limb_core_split_check()
+{
+	uint64_t bench_limb_core_hi = 0, bench_limb_core_rem = 1;
+	uint64_t bench_limb_core_lo = LimbWideOps<uint64_t, void>::mul(
+		bench_limb_core_hi, 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull);
+	// (2^64+2) / 3
+	uint64_t bench_limb_core_quot = LimbWideOps<uint64_t, void>::div(bench_limb_core_rem, 1, 2, 3);
+
+	return bench_limb_core_lo == 1 && bench_limb_core_hi == 0xFFFFFFFFFFFFFFFEull &&
+		bench_limb_core_quot == 0x5555555555555556ull && bench_limb_core_rem == 0;
+}
+
+static_assert(bench_limb_core_split_check(), "limb_core without a double-width type");
+
+static double bench_limb_core_ns_per_op(
+	std::chrono::steady_clock::time_point bench_limb_core_begin,
+	int bench_limb_core_count)
+{
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_limb_core_begin).count() / bench_limb_core_count;
+}
+
+template <typename Limb>
+static double bench_limb_core_run(
+	std::vector<int>& bench_limb_core_values,
+	std::vector<int>& bench_limb_core_ref,
+	int bench_limb_core_count,
+	int& bench_limb_core_mismatches)
+{
+	std::vector<int> bench_limb_core_out(2 * bench_limb_core_count);
+	std::chrono::steady_clock::time_point bench_limb_core_begin = std::chrono::steady_clock::now();
+	double bench_limb_core_ns;
+
+	for (int bench_limb_core_i = 0; bench_limb_core_i < bench_limb_core_count; bench_limb_core_i++)
+	{
+		int* bench_limb_core_v = &bench_limb_core_values[6 * bench_limb_core_i];
+
+		mul_mod_uint64_limbs<Limb>(
+			&bench_limb_core_out[2 * bench_limb_core_i],
+			bench_limb_core_v,
+			bench_limb_core_v + 2,
+			bench_limb_core_v + 4);
+	}
+	bench_limb_core_ns = bench_limb_core_ns_per_op(bench_limb_core_begin, bench_limb_core_count);
+
+	for (int bench_limb_core_i = 0; bench_limb_core_i < 2 * bench_limb_core_count; bench_limb_core_i++)
+	{
+		if (bench_limb_core_out[bench_limb_core_i] != bench_limb_core_ref[bench_limb_core_i])
+		{
+			bench_limb_core_mismatches++;
+		}
+	}
+
+	return bench_limb_core_ns;
+}
+
+int bench_limb_core(int argc, char* argv[])
+{
+	int bench_limb_core_count = 200000;
+	int bench_limb_core_i, bench_limb_core_mismatches = 0;
+	double bench_limb_core_ref_ns, bench_limb_core_ns16, bench_limb_core_ns32, bench_limb_core_ns64;
+	std::chrono::steady_clock::time_point bench_limb_core_begin;
+	// a, b, m per operation
+	std::vector<int> bench_limb_core_values, bench_limb_core_ref;
+
+	if (argc >= 1)
+	{
+		bench_limb_core_count = atoi(argv[0]);
+	}
+
+	if (bench_limb_core_count <= 0)
+	{
+		printf("count must be positive\n");
+		return 1;
+	}
+
+	bench_limb_core_values.resize(6 * bench_limb_core_count);
+	bench_limb_core_ref.resize(2 * bench_limb_core_count);
+
+	srand32(20240703);
+	for (bench_limb_core_i = 0; bench_limb_core_i < bench_limb_core_count; bench_limb_core_i++)
+	{
+		int* bench_limb_core_v = &bench_limb_core_values[6 * bench_limb_core_i];
+
+		bench_limb_core_v[4] = rand_bits(30, 1, 0);
+		bench_limb_core_v[5] = rand32() | 1;
+		rand_range_uint64(bench_limb_core_v, bench_limb_core_v + 4);
+		rand_range_uint64(bench_limb_core_v + 2, bench_limb_core_v + 4);
+	}
+
+	bench_limb_core_begin = std::chrono::steady_clock::now();
+	for (bench_limb_core_i = 0; bench_limb_core_i < bench_limb_core_count; bench_limb_core_i++)
+	{
+		int* bench_limb_core_v = &bench_limb_core_values[6 * bench_limb_core_i];
+
+		mul_mod_uint64(
+			&bench_limb_core_ref[2 * bench_limb_core_i],
+			bench_limb_core_v,
+			bench_limb_core_v + 2,
+			bench_limb_core_v + 4);
+	}
+	bench_limb_core_ref_ns = bench_limb_core_ns_per_op(bench_limb_core_begin, bench_limb_core_count);
+
+	bench_limb_core_ns16 = bench_limb_core_run<uint16_t>(
+		bench_limb_core_values, bench_limb_core_ref, bench_limb_core_count, bench_limb_core_mismatches);
+	bench_limb_core_ns32 = bench_limb_core_run<uint32_t>(
+		bench_limb_core_values, bench_limb_core_ref, bench_limb_core_count, bench_limb_core_mismatches);
+	bench_limb_core_ns64 = bench_limb_core_run<uint64_t>(
+		bench_limb_core_values, bench_limb_core_ref, bench_limb_core_count, bench_limb_core_mismatches);
+
+	printf("62-bit a*b mod m\n");
+	printf("mul_mod_uint64 (C--)       %10.1f ns\n", bench_limb_core_ref_ns);
+	printf("limb_core<uint16_t>        %10.1f ns\n", bench_limb_core_ns16);
+	printf("limb_core<uint32_t>        %10.1f ns\n", bench_limb_core_ns32);
+	printf("limb_core<uint64_t>        %10.1f ns  (%.1fx C--)\n",
+		bench_limb_core_ns64, bench_limb_core_ref_ns / bench_limb_core_ns64);
+	printf("mismatches: %d\n", bench_limb_core_mismatches);
+
+	return bench_limb_core_mismatches == 0 ? 0 : 1;
+}
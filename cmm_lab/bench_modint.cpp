@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "crypto_core.h"
+#include "modint.h"
+
+// exp_mod with the 31-bit safe prime below as a runtime argument (exp_mod,
+// and a native uint64 square-and-multiply dividing by p) against
+// exp_mod<P> with it fixed at compile time. Exponents are full 31-bit
+// values, as in DH key agreement. Every result is compared with exp_mod.
+// Usage: cmm_lab bench-modint [count=200000]
+
+static const uint32_t kBenchModintPrime = 2147481143u; // safe, 23 mod 24
+
+static_assert(exp_mod<kBenchModintPrime>(2, 10) == 1024, "Montgomery constants");
+static_assert(exp_mod<kBenchModintPrime>(5, (int)kBenchModintPrime - 1) == 1, "Fermat");
+
+static double bench_modint_ns_per_op(
+	std::chrono::steady_clock::time_point bench_modint_begin,
+	int bench_modint_count)
+{
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_modint_begin).count() / bench_modint_count;
+}
+
+static uint32_t bench_modint_native(uint32_t bench_modint_nat_a, uint32_t bench_modint_nat_e, uint32_t bench_modint_nat_p)
+{
+	uint64_t bench_modint_nat_x = bench_modint_nat_a % bench_modint_nat_p;
+	uint64_t bench_modint_nat_r = 1;
+
+	while (bench_modint_nat_e)
+	{
+		if (bench_modint_nat_e & 1)
+		{
+			bench_modint_nat_r = bench_modint_nat_r * bench_modint_nat_x % bench_modint_nat_p;
+		}
+
+		bench_modint_nat_e >>= 1;
+		bench_modint_nat_x = bench_modint_nat_x * bench_modint_nat_x % bench_modint_nat_p;
+	}
+
+	return (uint32_t)bench_modint_nat_r;
+}
+
+int bench_modint(int argc, char* argv[])
+{
+	int bench_modint_count = 200000;
+	int bench_modint_i, bench_modint_mismatches = 0;
+	// read from a volatile so the compiler cannot fold the runtime modulus
+	volatile uint32_t bench_modint_runtime_p = kBenchModintPrime;
+	uint32_t bench_modint_p;
+	double bench_modint_ref_ns, bench_modint_native_ns, bench_modint_fixed_ns;
+	std::chrono::steady_clock::time_point bench_modint_begin;
+	std::vector<int> bench_modint_a, bench_modint_e, bench_modint_ref, bench_modint_out;
+
+	if (argc >= 1)
+	{
+		bench_modint_count = atoi(argv[0]);
+	}
+
+	if (bench_modint_count <= 0)
+	{
+		printf("count must be positive\n");
+		return 1;
+	}
+
+	bench_modint_a.resize(bench_modint_count);
+	bench_modint_e.resize(bench_modint_count);
+	bench_modint_ref.resize(bench_modint_count);
+	bench_modint_out.resize(bench_modint_count);
+
+	srand32(20240702);
+	for (bench_modint_i = 0; bench_modint_i < bench_modint_count; bench_modint_i++)
+	{
+		bench_modint_a[bench_modint_i] = rand32();
+		bench_modint_e[bench_modint_i] = rand_bits(31, 1, 0);
+	}
+
+	bench_modint_p = bench_modint_runtime_p;
+
+	bench_modint_begin = std::chrono::steady_clock::now();
+	for (bench_modint_i = 0; bench_modint_i < bench_modint_count; bench_modint_i++)
+	{
+		bench_modint_ref[bench_modint_i] = exp_mod(
+			bench_modint_a[bench_modint_i], bench_modint_e[bench_modint_i], (int)bench_modint_p);
+	}
+	bench_modint_ref_ns = bench_modint_ns_per_op(bench_modint_begin, bench_modint_count);
+
+	bench_modint_begin = std::chrono::steady_clock::now();
+	for (bench_modint_i = 0; bench_modint_i < bench_modint_count; bench_modint_i++)
+	{
+		bench_modint_out[bench_modint_i] = (int)bench_modint_native(
+			(uint32_t)bench_modint_a[bench_modint_i], (uint32_t)bench_modint_e[bench_modint_i], bench_modint_p);
+	}
+	bench_modint_native_ns = bench_modint_ns_per_op(bench_modint_begin, bench_modint_count);
+
+	for (bench_modint_i = 0; bench_modint_i < bench_modint_count; bench_modint_i++)
+	{
+		if (bench_modint_out[bench_modint_i] != bench_modint_ref[bench_modint_i])
+		{
+			bench_modint_mismatches++;
+		}
+	}
+
+	bench_modint_begin = std::chrono::steady_clock::now();
+	for (bench_modint_i = 0; bench_modint_i < bench_modint_count; bench_modint_i++)
+	{
+		bench_modint_out[bench_modint_i] = exp_mod<kBenchModintPrime>(
+			bench_modint_a[bench_modint_i], bench_modint_e[bench_modint_i]);
+	}
+	bench_modint_fixed_ns = bench_modint_ns_per_op(bench_modint_begin, bench_modint_count);
+
+	for (bench_modint_i = 0; bench_modint_i < bench_modint_count; bench_modint_i++)
+	{
+		if (bench_modint_out[bench_modint_i] != bench_modint_ref[bench_modint_i])
+		{
+			bench_modint_mismatches++;
+		}
+	}
+
+	printf("p=%u, 31-bit exponents\n", kBenchModintPrime);
+	printf("exp_mod(a, e, p)           %10.1f ns\n", bench_modint_ref_ns);
+	printf("native, runtime p          %10.1f ns\n", bench_modint_native_ns);
+	printf("exp_mod<p>(a, e)           %10.1f ns  (%.1fx native, %.0fx exp_mod)\n",
+		bench_modint_fixed_ns,
+		bench_modint_native_ns / bench_modint_fixed_ns,
+		bench_modint_ref_ns / bench_modint_fixed_ns);
+	printf("mismatches: %d\n", bench_modint_mismatches);
+
+	return bench_modint_mismatches == 0 ? 0 : 1;
+}
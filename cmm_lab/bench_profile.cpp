@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench.h"
+#include "dh.h"
+#include "profile.h"
+#include "rsa.h"
+
+// What one call of each top-level API costs in primitive calls and loop
+// iterations, averaged over runs calls with 31-bit keys. Needs a build
+// with CMM_LAB_PROFILE defined.
+// Usage: cmm_lab bench-profile [runs=20]
+
+int bench_profile(int argc, char* argv[])
+{
+	int bench_profile_runs = 20;
+	int bench_profile_i;
+	int bench_profile_c[2], bench_profile_m[1];
+	struct RSA bench_profile_rsa[1];
+	struct DH bench_profile_dh[1], bench_profile_peer[1];
+
+	if (!profile_enabled())
+	{
+		return profile_print() ? 0 : 1;
+	}
+
+	if (argc >= 1)
+	{
+		bench_profile_runs = atoi(argv[0]);
+	}
+
+	if (bench_profile_runs <= 0)
+	{
+		printf("runs must be positive\n");
+		return 1;
+	}
+
+	srand32(20240707);
+	profile_reset();
+
+	for (bench_profile_i = 0; bench_profile_i < bench_profile_runs; bench_profile_i++)
+	{
+		if (!rsa_keygen(bench_profile_rsa, 31, 65537) ||
+			!rsa_pubkey_encryrpt(bench_profile_c, bench_profile_rsa, bench_profile_i + 2) ||
+			!rsa_privkey_decryrpt(bench_profile_m, bench_profile_rsa, bench_profile_c[0]))
+		{
+			printf("rsa failed\n");
+			return 1;
+		}
+
+		if (!dh_generate_paremeters(bench_profile_dh, 31, 2))
+		{
+			printf("dh_generate_paremeters failed\n");
+			return 1;
+		}
+
+		bench_profile_peer[0] = bench_profile_dh[0];
+		if (!dh_generate_key(bench_profile_dh) ||
+			!dh_generate_key(bench_profile_peer) ||
+			!dh_compute_key(bench_profile_m, bench_profile_dh, bench_profile_peer[0].pubkey) ||
+			!elgamal_pubkey_encryrpt(bench_profile_c, bench_profile_dh, bench_profile_i + 2) ||
+			!elgamal_privkey_decryrpt(bench_profile_m, bench_profile_dh, bench_profile_c))
+		{
+			printf("dh failed\n");
+			return 1;
+		}
+	}
+
+	profile_print();
+
+	return 0;
+}
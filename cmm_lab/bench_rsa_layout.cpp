@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "rsa_soa.h"
+
+// Compares batch RSA over an array of struct RSA (AoS) with the same keys
+// in RSAColumns (SoA). The default key count makes the AoS array (20 bytes
+// per key) larger than a typical last-level cache. Only a few distinct
+// keys are generated and then repeated, since keygen would otherwise
+// dominate the run. Keys use e=3 so encryption stays cheap enough for the
+// layout to matter; decryption exponentiates with a full-size d and runs
+// over the first decrypt_keys keys only.
+// Usage: cmm_lab bench-rsa-layout [keys=2097152] [decrypt_keys=65536] [distinct=256]
+
+static double bench_rsa_layout_ns_per_key(
+	std::chrono::steady_clock::time_point bench_rsa_layout_begin,
+	int bench_rsa_layout_count)
+{
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - bench_rsa_layout_begin).count() / bench_rsa_layout_count;
+}
+
+int bench_rsa_layout(int argc, char* argv[])
+{
+	int bench_rsa_layout_count = 1 << 21;
+	int bench_rsa_layout_dec_count = 1 << 16;
+	int bench_rsa_layout_distinct = 256;
+	int bench_rsa_layout_i, bench_rsa_layout_m, bench_rsa_layout_mismatches = 0;
+	int bench_rsa_layout_out[1];
+	double bench_rsa_layout_aos_enc, bench_rsa_layout_soa_enc;
+	double bench_rsa_layout_aos_dec, bench_rsa_layout_soa_dec;
+	std::chrono::steady_clock::time_point bench_rsa_layout_begin;
+	std::vector<struct RSA> bench_rsa_layout_keys;
+	std::vector<int> bench_rsa_layout_aos_c, bench_rsa_layout_soa_c;
+	std::vector<int> bench_rsa_layout_aos_p, bench_rsa_layout_soa_p;
+	struct RSAColumns bench_rsa_layout_cols[1];
+	struct RSAColumns bench_rsa_layout_dec_cols[1];
+
+	if (argc >= 1)
+	{
+		bench_rsa_layout_count = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_rsa_layout_dec_count = atoi(argv[1]);
+	}
+
+	if (argc >= 3)
+	{
+		bench_rsa_layout_distinct = atoi(argv[2]);
+	}
+
+	if (bench_rsa_layout_count <= 0 || bench_rsa_layout_dec_count <= 0 || bench_rsa_layout_distinct <= 0)
+	{
+		printf("counts must be positive\n");
+		return 1;
+	}
+
+	if (bench_rsa_layout_dec_count > bench_rsa_layout_count)
+	{
+		bench_rsa_layout_dec_count = bench_rsa_layout_count;
+	}
+
+	srand32(20240601);
+
+	bench_rsa_layout_keys.resize(bench_rsa_layout_count);
+	for (bench_rsa_layout_i = 0;
+		bench_rsa_layout_i < bench_rsa_layout_distinct && bench_rsa_layout_i < bench_rsa_layout_count;
+		bench_rsa_layout_i++)
+	{
+		while (!rsa_keygen(&bench_rsa_layout_keys[bench_rsa_layout_i], 31, 3))
+		{
+		}
+	}
+
+	for (; bench_rsa_layout_i < bench_rsa_layout_count; bench_rsa_layout_i++)
+	{
+		bench_rsa_layout_keys[bench_rsa_layout_i] =
+			bench_rsa_layout_keys[bench_rsa_layout_i % bench_rsa_layout_distinct];
+	}
+
+	rsa_columns_from_keys(bench_rsa_layout_cols, bench_rsa_layout_keys.data(), bench_rsa_layout_count);
+	rsa_columns_from_keys(bench_rsa_layout_dec_cols, bench_rsa_layout_keys.data(), bench_rsa_layout_dec_count);
+
+	bench_rsa_layout_aos_c.resize(bench_rsa_layout_count);
+	bench_rsa_layout_soa_c.resize(bench_rsa_layout_count);
+	bench_rsa_layout_aos_p.resize(bench_rsa_layout_dec_count);
+	bench_rsa_layout_soa_p.resize(bench_rsa_layout_dec_count);
+
+	// a message below every 31-bit n
+	bench_rsa_layout_m = 1000003;
+
+	// one message under N keys
+
+	bench_rsa_layout_begin = std::chrono::steady_clock::now();
+	for (bench_rsa_layout_i = 0; bench_rsa_layout_i < bench_rsa_layout_count; bench_rsa_layout_i++)
+	{
+		rsa_pubkey_encryrpt(bench_rsa_layout_out, &bench_rsa_layout_keys[bench_rsa_layout_i], bench_rsa_layout_m);
+		bench_rsa_layout_aos_c[bench_rsa_layout_i] = bench_rsa_layout_out[0];
+	}
+	bench_rsa_layout_aos_enc = bench_rsa_layout_ns_per_key(bench_rsa_layout_begin, bench_rsa_layout_count);
+
+	bench_rsa_layout_begin = std::chrono::steady_clock::now();
+	rsa_columns_pubkey_encryrpt(bench_rsa_layout_soa_c.data(), bench_rsa_layout_cols, bench_rsa_layout_m);
+	bench_rsa_layout_soa_enc = bench_rsa_layout_ns_per_key(bench_rsa_layout_begin, bench_rsa_layout_count);
+
+	// N ciphertexts with N keys; the SoA side reads the ciphertexts
+	// produced by its own encryption pass
+
+	bench_rsa_layout_begin = std::chrono::steady_clock::now();
+	for (bench_rsa_layout_i = 0; bench_rsa_layout_i < bench_rsa_layout_dec_count; bench_rsa_layout_i++)
+	{
+		rsa_privkey_decryrpt(
+			bench_rsa_layout_out,
+			&bench_rsa_layout_keys[bench_rsa_layout_i],
+			bench_rsa_layout_aos_c[bench_rsa_layout_i]);
+		bench_rsa_layout_aos_p[bench_rsa_layout_i] = bench_rsa_layout_out[0];
+	}
+	bench_rsa_layout_aos_dec = bench_rsa_layout_ns_per_key(bench_rsa_layout_begin, bench_rsa_layout_dec_count);
+
+	bench_rsa_layout_begin = std::chrono::steady_clock::now();
+	rsa_columns_privkey_decryrpt(
+		bench_rsa_layout_soa_p.data(), bench_rsa_layout_dec_cols, bench_rsa_layout_soa_c.data());
+	bench_rsa_layout_soa_dec = bench_rsa_layout_ns_per_key(bench_rsa_layout_begin, bench_rsa_layout_dec_count);
+
+	for (bench_rsa_layout_i = 0; bench_rsa_layout_i < bench_rsa_layout_count; bench_rsa_layout_i++)
+	{
+		if (bench_rsa_layout_aos_c[bench_rsa_layout_i] != bench_rsa_layout_soa_c[bench_rsa_layout_i])
+		{
+			bench_rsa_layout_mismatches++;
+		}
+		else if (bench_rsa_layout_i < bench_rsa_layout_dec_count &&
+			(bench_rsa_layout_aos_p[bench_rsa_layout_i] != bench_rsa_layout_m ||
+				bench_rsa_layout_soa_p[bench_rsa_layout_i] != bench_rsa_layout_m))
+		{
+			bench_rsa_layout_mismatches++;
+		}
+	}
+
+	printf("%d keys (%.1f MiB as struct RSA)\n",
+		bench_rsa_layout_count,
+		bench_rsa_layout_count * (double)sizeof(struct RSA) / (1024 * 1024));
+	printf("encrypt: AoS %.1f ns/key, SoA %.1f ns/key (%.2fx)\n",
+		bench_rsa_layout_aos_enc, bench_rsa_layout_soa_enc,
+		bench_rsa_layout_aos_enc / bench_rsa_layout_soa_enc);
+	printf("decrypt over %d keys: AoS %.1f ns/key, SoA %.1f ns/key (%.2fx)\n",
+		bench_rsa_layout_dec_count, bench_rsa_layout_aos_dec, bench_rsa_layout_soa_dec,
+		bench_rsa_layout_aos_dec / bench_rsa_layout_soa_dec);
+
+	if (bench_rsa_layout_mismatches)
+	{
+		printf("%d results differ\n", bench_rsa_layout_mismatches);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "rsa.h"
+
+// Keygen and private-key decryption with 2, 3 and 4 prime 31-bit keys.
+// Decryption is timed both as a plain c^d mod n and through the CRT, over
+// the same ciphertexts, and the two results are compared.
+// Usage: cmm_lab bench-rsa-multi [keys=500] [decryptions=20000]
+
+static double bench_rsam_us_per_op(
+	std::chrono::steady_clock::time_point bench_rsam_begin,
+	int bench_rsam_count)
+{
+	return std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - bench_rsam_begin).count() / bench_rsam_count;
+}
+
+int bench_rsa_multi(int argc, char* argv[])
+{
+	int bench_rsam_keys = 500;
+	int bench_rsam_decryptions = 20000;
+	int bench_rsam_k, bench_rsam_i, bench_rsam_mismatches = 0;
+	int bench_rsam_out[1];
+	double bench_rsam_keygen_us, bench_rsam_plain_us, bench_rsam_crt_us;
+	std::chrono::steady_clock::time_point bench_rsam_begin;
+	std::vector<struct RSAMultiPrime> bench_rsam_key;
+	std::vector<int> bench_rsam_c, bench_rsam_plain, bench_rsam_crt;
+
+	if (argc >= 1)
+	{
+		bench_rsam_keys = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_rsam_decryptions = atoi(argv[1]);
+	}
+
+	if (bench_rsam_keys <= 0 || bench_rsam_decryptions <= 0)
+	{
+		printf("counts must be positive\n");
+		return 1;
+	}
+
+	bench_rsam_key.resize(bench_rsam_keys);
+	bench_rsam_c.resize(bench_rsam_decryptions);
+	bench_rsam_plain.resize(bench_rsam_decryptions);
+	bench_rsam_crt.resize(bench_rsam_decryptions);
+
+	printf("31-bit keys, e=65537\n");
+	printf(" k    keygen us/key   decrypt c^d us   decrypt CRT us   CRT speedup\n");
+
+	for (bench_rsam_k = 2; bench_rsam_k <= 4; bench_rsam_k++)
+	{
+		srand32(20240604 + bench_rsam_k);
+
+		bench_rsam_begin = std::chrono::steady_clock::now();
+		for (bench_rsam_i = 0; bench_rsam_i < bench_rsam_keys; bench_rsam_i++)
+		{
+			if (!rsa_keygen_multi(&bench_rsam_key[bench_rsam_i], 31, 65537, bench_rsam_k))
+			{
+				printf("rsa_keygen_multi failed for k=%d\n", bench_rsam_k);
+				return 1;
+			}
+		}
+		bench_rsam_keygen_us = bench_rsam_us_per_op(bench_rsam_begin, bench_rsam_keys);
+
+		for (bench_rsam_i = 0; bench_rsam_i < bench_rsam_decryptions; bench_rsam_i++)
+		{
+			struct RSAMultiPrime* bench_rsam_kp = &bench_rsam_key[bench_rsam_i % bench_rsam_keys];
+
+			rand_range(&bench_rsam_c[bench_rsam_i], bench_rsam_kp->n);
+		}
+
+		bench_rsam_begin = std::chrono::steady_clock::now();
+		for (bench_rsam_i = 0; bench_rsam_i < bench_rsam_decryptions; bench_rsam_i++)
+		{
+			struct RSAMultiPrime* bench_rsam_kp = &bench_rsam_key[bench_rsam_i % bench_rsam_keys];
+
+			bench_rsam_plain[bench_rsam_i] = exp_mod(bench_rsam_c[bench_rsam_i], bench_rsam_kp->d, bench_rsam_kp->n);
+		}
+		bench_rsam_plain_us = bench_rsam_us_per_op(bench_rsam_begin, bench_rsam_decryptions);
+
+		bench_rsam_begin = std::chrono::steady_clock::now();
+		for (bench_rsam_i = 0; bench_rsam_i < bench_rsam_decryptions; bench_rsam_i++)
+		{
+			rsa_multi_privkey_decryrpt(
+				bench_rsam_out, &bench_rsam_key[bench_rsam_i % bench_rsam_keys], bench_rsam_c[bench_rsam_i]);
+			bench_rsam_crt[bench_rsam_i] = bench_rsam_out[0];
+		}
+		bench_rsam_crt_us = bench_rsam_us_per_op(bench_rsam_begin, bench_rsam_decryptions);
+
+		for (bench_rsam_i = 0; bench_rsam_i < bench_rsam_decryptions; bench_rsam_i++)
+		{
+			if (bench_rsam_plain[bench_rsam_i] != bench_rsam_crt[bench_rsam_i])
+			{
+				bench_rsam_mismatches++;
+			}
+		}
+
+		printf("%2d %16.2f %16.2f %16.2f %12.2fx\n",
+			bench_rsam_k,
+			bench_rsam_keygen_us,
+			bench_rsam_plain_us,
+			bench_rsam_crt_us,
+			bench_rsam_plain_us / bench_rsam_crt_us);
+	}
+
+	if (bench_rsam_mismatches)
+	{
+		printf("%d CRT results differ from c^d mod n\n", bench_rsam_mismatches);
+		return 1;
+	}
+
+	return 0;
+}
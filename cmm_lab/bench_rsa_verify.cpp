@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench.h"
+#include "rsa.h"
+#include "rsa_batch.h"
+
+// Signature verification under one 31-bit key with e=65537, over the same
+// signatures four ways: exp_mod per signature, exp_mod_chain per signature,
+// rsa_verify_batch over the whole range and rsa_verify_batch_parallel. One
+// signature in eight is tampered with (signature + 1 mod n, signature
+// replaced by n, or message bit 0 flipped) and must be rejected; every
+// other one must be accepted. Any result that disagrees is a mismatch.
+// Usage: cmm_lab bench-rsa-verify [signatures=200000] [threads=0]
+
+static double bench_rsav_us_per_op(
+	std::chrono::steady_clock::time_point bench_rsav_begin,
+	int bench_rsav_count)
+{
+	return std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - bench_rsav_begin).count() / bench_rsav_count;
+}
+
+static int bench_rsav_mismatches(
+	const char* bench_rsav_name,
+	double bench_rsav_us,
+	double bench_rsav_base_us,
+	std::vector<int>& bench_rsav_ok,
+	std::vector<int>& bench_rsav_want)
+{
+	int bench_rsav_i, bench_rsav_rejected = 0, bench_rsav_mismatched = 0;
+
+	for (bench_rsav_i = 0; bench_rsav_i < (int)bench_rsav_want.size(); bench_rsav_i++)
+	{
+		if (!bench_rsav_ok[bench_rsav_i])
+		{
+			bench_rsav_rejected++;
+		}
+
+		if (bench_rsav_ok[bench_rsav_i] != bench_rsav_want[bench_rsav_i])
+		{
+			bench_rsav_mismatched++;
+		}
+	}
+
+	printf("%-26s %10.3f %9.2fx %10d %11d\n",
+		bench_rsav_name,
+		bench_rsav_us,
+		bench_rsav_base_us / bench_rsav_us,
+		bench_rsav_rejected,
+		bench_rsav_mismatched);
+
+	return bench_rsav_mismatched;
+}
+
+int bench_rsa_verify(int argc, char* argv[])
+{
+	int bench_rsav_count = 200000;
+	int bench_rsav_threads = 0;
+	int bench_rsav_i, bench_rsav_tampered = 0, bench_rsav_mismatched = 0;
+	double bench_rsav_exp_mod_us, bench_rsav_us;
+	struct RSA bench_rsav_key[1];
+	struct RSAExpChain bench_rsav_chain[1];
+	std::chrono::steady_clock::time_point bench_rsav_begin;
+	std::vector<int> bench_rsav_m, bench_rsav_s, bench_rsav_want, bench_rsav_ok;
+
+	if (argc >= 1)
+	{
+		bench_rsav_count = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		bench_rsav_threads = atoi(argv[1]);
+	}
+
+	if (bench_rsav_count <= 0)
+	{
+		printf("signatures must be positive\n");
+		return 1;
+	}
+
+	srand32(20240712);
+
+	if (!rsa_keygen(bench_rsav_key, 31, 65537) ||
+		!rsa_compile_exp_chain(bench_rsav_chain, bench_rsav_key[0].e))
+	{
+		printf("rsa_keygen failed\n");
+		return 1;
+	}
+
+	bench_rsav_m.resize(bench_rsav_count);
+	bench_rsav_s.resize(bench_rsav_count);
+	bench_rsav_want.resize(bench_rsav_count);
+	bench_rsav_ok.resize(bench_rsav_count);
+
+	for (bench_rsav_i = 0; bench_rsav_i < bench_rsav_count; bench_rsav_i++)
+	{
+		int bench_rsav_r[1];
+
+		// messages in [2, n), away from the fixed points 0 and 1
+		rand_range(bench_rsav_r, bench_rsav_key[0].n - 2);
+		bench_rsav_m[bench_rsav_i] = bench_rsav_r[0] + 2;
+		bench_rsav_s[bench_rsav_i] = exp_mod(bench_rsav_m[bench_rsav_i], bench_rsav_key[0].d, bench_rsav_key[0].n);
+		bench_rsav_want[bench_rsav_i] = 1;
+
+		if (bench_rsav_i % 8 == 7)
+		{
+			switch ((bench_rsav_i / 8) % 3)
+			{
+			case 0:
+				bench_rsav_s[bench_rsav_i] = (bench_rsav_s[bench_rsav_i] + 1) % bench_rsav_key[0].n;
+				break;
+			case 1:
+				bench_rsav_s[bench_rsav_i] = bench_rsav_key[0].n;
+				break;
+			default:
+				bench_rsav_m[bench_rsav_i] = bench_rsav_m[bench_rsav_i] ^ 1;
+				break;
+			}
+
+			bench_rsav_want[bench_rsav_i] = 0;
+			bench_rsav_tampered++;
+		}
+	}
+
+	printf("n=%d e=%d, %d signatures, %d tampered\n",
+		bench_rsav_key[0].n, bench_rsav_key[0].e, bench_rsav_count, bench_rsav_tampered);
+	printf("path                       us/verify   speedup   rejected  mismatches\n");
+
+	bench_rsav_begin = std::chrono::steady_clock::now();
+	for (bench_rsav_i = 0; bench_rsav_i < bench_rsav_count; bench_rsav_i++)
+	{
+		bench_rsav_ok[bench_rsav_i] =
+			cmp_uint32(bench_rsav_s[bench_rsav_i], bench_rsav_key[0].n) < 0 &&
+			exp_mod(bench_rsav_s[bench_rsav_i], bench_rsav_key[0].e, bench_rsav_key[0].n) == bench_rsav_m[bench_rsav_i];
+	}
+	bench_rsav_exp_mod_us = bench_rsav_us_per_op(bench_rsav_begin, bench_rsav_count);
+	bench_rsav_mismatched += bench_rsav_mismatches(
+		"exp_mod", bench_rsav_exp_mod_us, bench_rsav_exp_mod_us, bench_rsav_ok, bench_rsav_want);
+
+	bench_rsav_begin = std::chrono::steady_clock::now();
+	for (bench_rsav_i = 0; bench_rsav_i < bench_rsav_count; bench_rsav_i++)
+	{
+		bench_rsav_ok[bench_rsav_i] =
+			cmp_uint32(bench_rsav_s[bench_rsav_i], bench_rsav_key[0].n) < 0 &&
+			exp_mod_chain(bench_rsav_s[bench_rsav_i], bench_rsav_chain, bench_rsav_key[0].n) == bench_rsav_m[bench_rsav_i];
+	}
+	bench_rsav_us = bench_rsav_us_per_op(bench_rsav_begin, bench_rsav_count);
+	bench_rsav_mismatched += bench_rsav_mismatches(
+		"exp_mod_chain", bench_rsav_us, bench_rsav_exp_mod_us, bench_rsav_ok, bench_rsav_want);
+
+	// the batch calls must write every result themselves
+	std::fill(bench_rsav_ok.begin(), bench_rsav_ok.end(), -1);
+	bench_rsav_begin = std::chrono::steady_clock::now();
+	if (!rsa_verify_batch(
+		bench_rsav_ok.data(),
+		bench_rsav_key,
+		bench_rsav_chain,
+		bench_rsav_m.data(),
+		bench_rsav_s.data(),
+		0,
+		bench_rsav_count))
+	{
+		printf("rsa_verify_batch failed\n");
+		return 1;
+	}
+	bench_rsav_us = bench_rsav_us_per_op(bench_rsav_begin, bench_rsav_count);
+	bench_rsav_mismatched += bench_rsav_mismatches(
+		"rsa_verify_batch", bench_rsav_us, bench_rsav_exp_mod_us, bench_rsav_ok, bench_rsav_want);
+
+	std::fill(bench_rsav_ok.begin(), bench_rsav_ok.end(), -1);
+	bench_rsav_begin = std::chrono::steady_clock::now();
+	if (!rsa_verify_batch_parallel(
+		bench_rsav_ok.data(),
+		bench_rsav_key,
+		bench_rsav_m.data(),
+		bench_rsav_s.data(),
+		bench_rsav_count,
+		bench_rsav_threads))
+	{
+		printf("rsa_verify_batch_parallel failed\n");
+		return 1;
+	}
+	bench_rsav_us = bench_rsav_us_per_op(bench_rsav_begin, bench_rsav_count);
+	bench_rsav_mismatched += bench_rsav_mismatches(
+		"rsa_verify_batch_parallel", bench_rsav_us, bench_rsav_exp_mod_us, bench_rsav_ok, bench_rsav_want);
+
+	if (bench_rsav_mismatched)
+	{
+		printf("%d verification results are wrong\n", bench_rsav_mismatched);
+		return 1;
+	}
+
+	return 0;
+}
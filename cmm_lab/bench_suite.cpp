@@ -0,0 +1,307 @@
+#include <cstdio>
+#include <vector>
+
+#include "bench.h"
+#include "bench_harness.h"
+#include "crypto_core.h"
+#include "dh.h"
+#include "rsa.h"
+#include "unsigned_op.h"
+
+// Every function of unsigned_op.h and crypto_core.h, then end-to-end RSA,
+// DH and ElGamal, through bench_harness. Inputs come from a corpus drawn
+// with the harness seed, so runs with the same seed time the same work.
+// Usage: cmm_lab bench-suite [--json file] [--filter text] [--reps n]
+//                            [--warmup n] [--min-ms x] [--seed n]
+
+static const int kBenchSuiteCorpus = 1024;
+
+// the 31-bit safe prime of bench-modint
+static const int kBenchSuitePrime = 2147481143;
+static const int kBenchSuiteSubgroup = 1073740571;
+
+struct BenchSuiteCorpus
+{
+	int x[kBenchSuiteCorpus]; // uniform uint32
+	int y[kBenchSuiteCorpus];
+	int divisor[kBenchSuiteCorpus]; // non-zero, uniform bit length
+	int shift[kBenchSuiteCorpus]; // 0..31
+	int shift64[kBenchSuiteCorpus]; // 0..63
+	int x64[kBenchSuiteCorpus][2];
+	int y64[kBenchSuiteCorpus][2];
+	int divisor64[kBenchSuiteCorpus][2]; // non-zero, uniform bit length
+	int below64[kBenchSuiteCorpus][2]; // below divisor64, for mod_uint128
+	int residue[kBenchSuiteCorpus]; // 1..p-1
+	int exponent[kBenchSuiteCorpus]; // 31-bit
+	int odd[kBenchSuiteCorpus]; // odd 31-bit
+	int witness[kBenchSuiteCorpus]; // 2..odd-2
+	int add;
+	int rem;
+	struct RSA rsa;
+	struct DH dh;
+	struct DH peer;
+	int rsa_plain[kBenchSuiteCorpus];
+	int rsa_cipher[kBenchSuiteCorpus];
+	int elgamal_plain[kBenchSuiteCorpus];
+	int elgamal_cipher[kBenchSuiteCorpus][2];
+	int out[2];
+	int out2[2];
+	int mods[64];
+	struct RSA rsa_out;
+	struct DH dh_out;
+};
+
+static struct BenchSuiteCorpus kBenchSuite;
+
+static int bench_suite_rand_divisor()
+{
+	int bench_suite_divisor = rand_bits(rand_bits(5, 0, 0) + 1, 1, 0);
+
+	return bench_suite_divisor == 0 ? 1 : bench_suite_divisor;
+}
+
+static int bench_suite_build_corpus()
+{
+	int bench_suite_i;
+	int bench_suite_bits;
+	int bench_suite_congruence[2];
+
+	for (bench_suite_i = 0; bench_suite_i < kBenchSuiteCorpus; bench_suite_i++)
+	{
+		kBenchSuite.x[bench_suite_i] = rand32();
+		kBenchSuite.y[bench_suite_i] = rand32();
+		kBenchSuite.divisor[bench_suite_i] = bench_suite_rand_divisor();
+		kBenchSuite.shift[bench_suite_i] = rand_bits(5, 0, 0);
+		kBenchSuite.shift64[bench_suite_i] = rand_bits(6, 0, 0);
+		kBenchSuite.x64[bench_suite_i][0] = rand32();
+		kBenchSuite.x64[bench_suite_i][1] = rand32();
+		kBenchSuite.y64[bench_suite_i][0] = rand32();
+		kBenchSuite.y64[bench_suite_i][1] = rand32();
+
+		bench_suite_bits = rand_bits(6, 0, 0) + 1;
+		kBenchSuite.divisor64[bench_suite_i][0] = bench_suite_bits > 32 ? rand_bits(bench_suite_bits - 32, 1, 0) : 0;
+		kBenchSuite.divisor64[bench_suite_i][1] = bench_suite_bits > 32 ? rand32() : rand_bits(bench_suite_bits, 1, 0);
+		mod_uint64(kBenchSuite.below64[bench_suite_i], kBenchSuite.x64[bench_suite_i], kBenchSuite.divisor64[bench_suite_i]);
+
+		rand_range(&kBenchSuite.residue[bench_suite_i], kBenchSuitePrime - 1);
+		kBenchSuite.residue[bench_suite_i] = kBenchSuite.residue[bench_suite_i] + 1;
+		kBenchSuite.exponent[bench_suite_i] = rand_bits(31, 1, 0);
+		kBenchSuite.odd[bench_suite_i] = rand_bits(31, 1, 1);
+		rand_range(&kBenchSuite.witness[bench_suite_i], kBenchSuite.odd[bench_suite_i] - 3);
+		kBenchSuite.witness[bench_suite_i] = kBenchSuite.witness[bench_suite_i] + 2;
+	}
+
+	dh_generator_congruence(bench_suite_congruence, 2);
+	kBenchSuite.add = bench_suite_congruence[0];
+	kBenchSuite.rem = bench_suite_congruence[1];
+
+	if (!rsa_keygen(&kBenchSuite.rsa, 31, 65537))
+	{
+		return 0;
+	}
+
+	kBenchSuite.dh.params.p = kBenchSuitePrime;
+	kBenchSuite.dh.params.q = kBenchSuiteSubgroup;
+	kBenchSuite.dh.params.g = 2;
+	kBenchSuite.peer = kBenchSuite.dh;
+	if (!dh_generate_key(&kBenchSuite.dh) || !dh_generate_key(&kBenchSuite.peer))
+	{
+		return 0;
+	}
+
+	for (bench_suite_i = 0; bench_suite_i < kBenchSuiteCorpus; bench_suite_i++)
+	{
+		rand_range(&kBenchSuite.rsa_plain[bench_suite_i], kBenchSuite.rsa.n);
+		rsa_pubkey_encryrpt(&kBenchSuite.rsa_cipher[bench_suite_i], &kBenchSuite.rsa, kBenchSuite.rsa_plain[bench_suite_i]);
+
+		rand_range(&kBenchSuite.elgamal_plain[bench_suite_i], kBenchSuitePrime);
+		elgamal_pubkey_encryrpt(
+			kBenchSuite.elgamal_cipher[bench_suite_i], &kBenchSuite.dh, kBenchSuite.elgamal_plain[bench_suite_i]);
+	}
+
+	return 1;
+}
+
+static struct BenchHarnessCase kBenchSuiteCases[] = {
+	// unsigned_op.h, uint32
+	{ "rshift_uint32", [](int bench_suite_i) { return rshift_uint32(kBenchSuite.x[bench_suite_i], kBenchSuite.shift[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "lshift_uint32", [](int bench_suite_i) { return lshift_uint32(kBenchSuite.x[bench_suite_i], kBenchSuite.shift[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "get_bits_uint32", [](int bench_suite_i) { return get_bits_uint32(kBenchSuite.divisor[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "lt_uint32", [](int bench_suite_i) { return lt_uint32(kBenchSuite.x[bench_suite_i], kBenchSuite.y[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "cmp_uint32", [](int bench_suite_i) { return cmp_uint32(kBenchSuite.x[bench_suite_i], kBenchSuite.y[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "neg_uint32", [](int bench_suite_i) { return neg_uint32(kBenchSuite.x[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "add_full_uint32", [](int bench_suite_i) {
+		return add_full_uint32(kBenchSuite.out, kBenchSuite.x[bench_suite_i], kBenchSuite.y[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "sub_full_uint32", [](int bench_suite_i) {
+		return sub_full_uint32(kBenchSuite.out, kBenchSuite.x[bench_suite_i], kBenchSuite.y[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "mul_uint32", [](int bench_suite_i) {
+		mul_uint32(kBenchSuite.out, kBenchSuite.x[bench_suite_i], kBenchSuite.y[bench_suite_i]);
+		return kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "div_mod_uint32", [](int bench_suite_i) {
+		return div_mod_uint32(kBenchSuite.out, kBenchSuite.x[bench_suite_i], kBenchSuite.divisor[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "div_uint32", [](int bench_suite_i) { return div_uint32(kBenchSuite.x[bench_suite_i], kBenchSuite.divisor[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "mod_uint32", [](int bench_suite_i) { return mod_uint32(kBenchSuite.x[bench_suite_i], kBenchSuite.divisor[bench_suite_i]); }, kBenchSuiteCorpus },
+
+	// unsigned_op.h, uint64 and uint128
+	{ "rshift_uint64", [](int bench_suite_i) {
+		rshift_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.shift64[bench_suite_i]);
+		return kBenchSuite.out[1];
+	}, kBenchSuiteCorpus },
+	{ "lshift_uint64", [](int bench_suite_i) {
+		lshift_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.shift64[bench_suite_i]);
+		return kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "get_bits_uint64", [](int bench_suite_i) { return get_bits_uint64(kBenchSuite.divisor64[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "cmp_uint64", [](int bench_suite_i) { return cmp_uint64(kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "add_full_uint64", [](int bench_suite_i) {
+		add_full_uint64(kBenchSuite.out, kBenchSuite.out2, kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]);
+		return kBenchSuite.out[0] + kBenchSuite.out2[0];
+	}, kBenchSuiteCorpus },
+	{ "add_uint64", [](int bench_suite_i) {
+		add_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]);
+		return kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "neg_uint64", [](int bench_suite_i) {
+		neg_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i]);
+		return kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "sub_full_uint64", [](int bench_suite_i) {
+		sub_full_uint64(kBenchSuite.out, kBenchSuite.out2, kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]);
+		return kBenchSuite.out[0] + kBenchSuite.out2[0];
+	}, kBenchSuiteCorpus },
+	{ "sub_uint64", [](int bench_suite_i) {
+		sub_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]);
+		return kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "mul_uint64", [](int bench_suite_i) {
+		mul_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]);
+		return kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "div_mod_uint64", [](int bench_suite_i) {
+		div_mod_uint64(kBenchSuite.out, kBenchSuite.out2, kBenchSuite.x64[bench_suite_i], kBenchSuite.divisor64[bench_suite_i]);
+		return kBenchSuite.out[1] + kBenchSuite.out2[1];
+	}, kBenchSuiteCorpus },
+	{ "div_uint64", [](int bench_suite_i) {
+		div_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.divisor64[bench_suite_i]);
+		return kBenchSuite.out[1];
+	}, kBenchSuiteCorpus },
+	{ "mod_uint64", [](int bench_suite_i) {
+		mod_uint64(kBenchSuite.out, kBenchSuite.x64[bench_suite_i], kBenchSuite.divisor64[bench_suite_i]);
+		return kBenchSuite.out[1];
+	}, kBenchSuiteCorpus },
+	{ "mul_full_uint64", [](int bench_suite_i) {
+		mul_full_uint64(kBenchSuite.out, kBenchSuite.out2, kBenchSuite.x64[bench_suite_i], kBenchSuite.y64[bench_suite_i]);
+		return kBenchSuite.out[0] + kBenchSuite.out2[0];
+	}, kBenchSuiteCorpus },
+	{ "mod_uint128", [](int bench_suite_i) {
+		mod_uint128(kBenchSuite.out, kBenchSuite.below64[bench_suite_i], kBenchSuite.y64[bench_suite_i], kBenchSuite.divisor64[bench_suite_i]);
+		return kBenchSuite.out[1];
+	}, kBenchSuiteCorpus },
+
+	// crypto_core.h
+	{ "is_bit_set", [](int bench_suite_i) { return is_bit_set(kBenchSuite.x[bench_suite_i], kBenchSuite.shift[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "mul_mod", [](int bench_suite_i) {
+		return mul_mod(kBenchSuite.residue[bench_suite_i], kBenchSuite.x[bench_suite_i], kBenchSuitePrime);
+	}, kBenchSuiteCorpus },
+	{ "exp_mod", [](int bench_suite_i) {
+		return exp_mod(kBenchSuite.residue[bench_suite_i], kBenchSuite.exponent[bench_suite_i], kBenchSuitePrime);
+	}, kBenchSuiteCorpus },
+	{ "nnmod", [](int bench_suite_i) { return nnmod(kBenchSuite.x[bench_suite_i], kBenchSuite.residue[bench_suite_i]); }, kBenchSuiteCorpus },
+	{ "inverse_mod", [](int bench_suite_i) {
+		return inverse_mod(kBenchSuite.out, kBenchSuite.residue[bench_suite_i], kBenchSuitePrime) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "rand_bits", [](int) { return rand_bits(31, 1, 0); }, kBenchSuiteCorpus },
+	{ "rand_range", [](int bench_suite_i) {
+		return rand_range(kBenchSuite.out, kBenchSuite.residue[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "miller_rabin_is_prime", [](int bench_suite_i) {
+		return miller_rabin_is_prime(kBenchSuite.out, kBenchSuite.odd[bench_suite_i], 5) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "is_prime", [](int bench_suite_i) {
+		return is_prime(kBenchSuite.out, 5, kBenchSuite.odd[bench_suite_i], 1) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "miller_rabin_witness", [](int bench_suite_i) {
+		return miller_rabin_witness(kBenchSuite.odd[bench_suite_i], kBenchSuite.witness[bench_suite_i]);
+	}, kBenchSuiteCorpus },
+	{ "is_prime_deterministic", [](int bench_suite_i) {
+		return is_prime_deterministic(kBenchSuite.out, kBenchSuite.odd[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "probable_prime", [](int) {
+		return probable_prime(kBenchSuite.out, 31, 0, kBenchSuite.mods) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "probable_prime_dh", [](int) {
+		return probable_prime_dh(kBenchSuite.out, 31, 1, kBenchSuite.mods, kBenchSuite.add, kBenchSuite.rem) +
+			kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "generate_prime", [](int) {
+		return generate_prime(kBenchSuite.out, 31, 0, -1, 0) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "generate_prime_safe", [](int) {
+		return generate_prime(kBenchSuite.out, 31, 1, kBenchSuite.add, kBenchSuite.rem) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "ffc_generate_privkey", [](int) {
+		return ffc_generate_privkey(kBenchSuite.out, kBenchSuiteSubgroup, -1) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+
+	// end to end, 31-bit keys
+	{ "rsa_keygen", [](int) { return rsa_keygen(&kBenchSuite.rsa_out, 31, 65537); }, kBenchSuiteCorpus },
+	{ "rsa_pubkey_encryrpt", [](int bench_suite_i) {
+		return rsa_pubkey_encryrpt(kBenchSuite.out, &kBenchSuite.rsa, kBenchSuite.rsa_plain[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "rsa_privkey_decryrpt", [](int bench_suite_i) {
+		return rsa_privkey_decryrpt(kBenchSuite.out, &kBenchSuite.rsa, kBenchSuite.rsa_cipher[bench_suite_i]) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "dh_generate_paremeters", [](int) {
+		return dh_generate_paremeters(&kBenchSuite.dh_out, 31, 2);
+	}, kBenchSuiteCorpus },
+	{ "dh_generate_key", [](int) {
+		kBenchSuite.dh_out = kBenchSuite.dh;
+		return dh_generate_key(&kBenchSuite.dh_out);
+	}, kBenchSuiteCorpus },
+	{ "dh_compute_key", [](int) {
+		return dh_compute_key(kBenchSuite.out, &kBenchSuite.dh, kBenchSuite.peer.pubkey) + kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "elgamal_pubkey_encryrpt", [](int bench_suite_i) {
+		return elgamal_pubkey_encryrpt(kBenchSuite.out, &kBenchSuite.dh, kBenchSuite.elgamal_plain[bench_suite_i]) +
+			kBenchSuite.out[0];
+	}, kBenchSuiteCorpus },
+	{ "elgamal_privkey_decryrpt", [](int bench_suite_i) {
+		return elgamal_privkey_decryrpt(kBenchSuite.out, &kBenchSuite.dh, kBenchSuite.elgamal_cipher[bench_suite_i]) +
+			kBenchSuite.out[0];
+	}, kBenchSuiteCorpus }
+};
+
+int bench_suite(int argc, char* argv[])
+{
+	struct BenchHarnessOptions bench_suite_options[1];
+	struct BenchHarnessStats bench_suite_stats[1];
+	std::vector<struct BenchHarnessStats> bench_suite_results;
+
+	if (!bench_harness_parse(bench_suite_options, argc, argv))
+	{
+		return 1;
+	}
+
+	srand32((int)bench_suite_options[0].seed);
+	if (!bench_suite_build_corpus())
+	{
+		printf("cannot build the corpus\n");
+		return 1;
+	}
+
+	bench_harness_print_header();
+	for (struct BenchHarnessCase& bench_suite_case : kBenchSuiteCases)
+	{
+		if (bench_harness_run(bench_suite_stats, bench_suite_options, &bench_suite_case))
+		{
+			bench_harness_print(bench_suite_stats);
+			bench_suite_results.push_back(bench_suite_stats[0]);
+		}
+	}
+
+	return bench_harness_write_json("bench-suite", bench_suite_options, bench_suite_results) ? 0 : 1;
+}
@@ -0,0 +1,1102 @@
+#include "bignum.h"
+
+int bn_zero(int bn_zero_r[], int bn_zero_n)
+{
+	int bn_zero_i = 0;
+	while (bn_zero_i < bn_zero_n)
+	{
+		bn_zero_r[bn_zero_i] = 0;
+		bn_zero_i = bn_zero_i + 1;
+	}
+
+	return 0;
+}
+
+int bn_copy(int bn_copy_r[], int bn_copy_a[], int bn_copy_n)
+{
+	int bn_copy_i = 0;
+	while (bn_copy_i < bn_copy_n)
+	{
+		bn_copy_r[bn_copy_i] = bn_copy_a[bn_copy_i];
+		bn_copy_i = bn_copy_i + 1;
+	}
+
+	return 0;
+}
+
+int bn_set_uint32(int bn_set_r[], int bn_set_n, int bn_set_v)
+{
+	bn_zero(bn_set_r, bn_set_n);
+	bn_set_r[0] = bn_set_v;
+
+	return 0;
+}
+
+int bn_len(int bn_len_a[], int bn_len_n)
+{
+	while (bn_len_n > 0 && bn_len_a[bn_len_n - 1] == 0)
+	{
+		bn_len_n = bn_len_n - 1;
+	}
+
+	return bn_len_n;
+}
+
+int bn_bits(int bn_bits_a[], int bn_bits_n)
+{
+	int bn_bits_len = bn_len(bn_bits_a, bn_bits_n);
+
+	if (bn_bits_len == 0)
+	{
+		return 0;
+	}
+
+	return (bn_bits_len - 1) * 32 + get_bits_uint32(bn_bits_a[bn_bits_len - 1]);
+}
+
+int bn_is_bit_set(int bn_is_bit_set_a[], int bn_is_bit_set_i)
+{
+	return mod_uint32(
+		rshift_uint32(bn_is_bit_set_a[bn_is_bit_set_i / 32], mod(bn_is_bit_set_i, 32)), 2);
+}
+
+static int bn_set_bit(int bn_set_bit_a[], int bn_set_bit_i)
+{
+	if (!bn_is_bit_set(bn_set_bit_a, bn_set_bit_i))
+	{
+		bn_set_bit_a[bn_set_bit_i / 32] =
+			bn_set_bit_a[bn_set_bit_i / 32] + kTwoPowers[mod(bn_set_bit_i, 32)];
+	}
+
+	return 0;
+}
+
+int bn_cmp(int bn_cmp_a[], int bn_cmp_b[], int bn_cmp_n)
+{
+	int bn_cmp_i = bn_cmp_n - 1;
+	int bn_cmp_result;
+
+	while (bn_cmp_i >= 0)
+	{
+		bn_cmp_result = cmp_uint32(bn_cmp_a[bn_cmp_i], bn_cmp_b[bn_cmp_i]);
+		if (bn_cmp_result != 0)
+		{
+			return bn_cmp_result;
+		}
+
+		bn_cmp_i = bn_cmp_i - 1;
+	}
+
+	return 0;
+}
+
+int bn_add(int bn_add_r[], int bn_add_a[], int bn_add_b[], int bn_add_n)
+{
+	int bn_add_i = 0;
+	int bn_add_carry = 0;
+	int bn_add_c1[1], bn_add_c2[1];
+	int bn_add_sum;
+
+	while (bn_add_i < bn_add_n)
+	{
+		bn_add_sum = add_full_uint32(bn_add_c1, bn_add_a[bn_add_i], bn_add_b[bn_add_i]);
+		bn_add_sum = add_full_uint32(bn_add_c2, bn_add_sum, bn_add_carry);
+		bn_add_r[bn_add_i] = bn_add_sum;
+		bn_add_carry = bn_add_c1[0] + bn_add_c2[0];
+
+		bn_add_i = bn_add_i + 1;
+	}
+
+	return bn_add_carry;
+}
+
+int bn_add_word(int bn_addw_r[], int bn_addw_a[], int bn_addw_n, int bn_addw_w)
+{
+	int bn_addw_i = 0;
+	int bn_addw_carry = bn_addw_w;
+	int bn_addw_c[1];
+
+	while (bn_addw_i < bn_addw_n)
+	{
+		bn_addw_r[bn_addw_i] = add_full_uint32(bn_addw_c, bn_addw_a[bn_addw_i], bn_addw_carry);
+		bn_addw_carry = bn_addw_c[0];
+
+		bn_addw_i = bn_addw_i + 1;
+	}
+
+	return bn_addw_carry;
+}
+
+int bn_sub(int bn_sub_r[], int bn_sub_a[], int bn_sub_b[], int bn_sub_n)
+{
+	int bn_sub_i = 0;
+	int bn_sub_borrow = 0;
+	int bn_sub_b1[1], bn_sub_b2[1];
+	int bn_sub_diff;
+
+	while (bn_sub_i < bn_sub_n)
+	{
+		bn_sub_diff = sub_full_uint32(bn_sub_b1, bn_sub_a[bn_sub_i], bn_sub_b[bn_sub_i]);
+		bn_sub_diff = sub_full_uint32(bn_sub_b2, bn_sub_diff, bn_sub_borrow);
+		bn_sub_r[bn_sub_i] = bn_sub_diff;
+		bn_sub_borrow = bn_sub_b1[0] + bn_sub_b2[0];
+
+		bn_sub_i = bn_sub_i + 1;
+	}
+
+	return bn_sub_borrow;
+}
+
+int bn_sub_word(int bn_subw_r[], int bn_subw_a[], int bn_subw_n, int bn_subw_w)
+{
+	int bn_subw_i = 0;
+	int bn_subw_borrow = bn_subw_w;
+	int bn_subw_b[1];
+
+	while (bn_subw_i < bn_subw_n)
+	{
+		bn_subw_r[bn_subw_i] = sub_full_uint32(bn_subw_b, bn_subw_a[bn_subw_i], bn_subw_borrow);
+		bn_subw_borrow = bn_subw_b[0];
+
+		bn_subw_i = bn_subw_i + 1;
+	}
+
+	return bn_subw_borrow;
+}
+
+int bn_mul_word_add(int bn_mwa_r[], int bn_mwa_a[], int bn_mwa_n, int bn_mwa_w)
+{
+	int bn_mwa_i = 0;
+	int bn_mwa_carry = 0;
+	int bn_mwa_prod[2];
+	int bn_mwa_c1[1], bn_mwa_c2[1];
+	int bn_mwa_lo;
+
+	while (bn_mwa_i < bn_mwa_n)
+	{
+		// a*w + r + carry <= (2^32-1)^2 + 2*(2^32-1) fits in 64 bits
+		mul_uint32(bn_mwa_prod, bn_mwa_a[bn_mwa_i], bn_mwa_w);
+		bn_mwa_lo = add_full_uint32(bn_mwa_c1, bn_mwa_prod[1], bn_mwa_r[bn_mwa_i]);
+		bn_mwa_lo = add_full_uint32(bn_mwa_c2, bn_mwa_lo, bn_mwa_carry);
+		bn_mwa_r[bn_mwa_i] = bn_mwa_lo;
+		bn_mwa_carry = bn_mwa_prod[0] + bn_mwa_c1[0] + bn_mwa_c2[0];
+
+		bn_mwa_i = bn_mwa_i + 1;
+	}
+
+	return bn_mwa_carry;
+}
+
+int bn_mul_word_sub(int bn_mws_r[], int bn_mws_a[], int bn_mws_n, int bn_mws_w)
+{
+	int bn_mws_i = 0;
+	int bn_mws_borrow = 0;
+	int bn_mws_prod[2];
+	int bn_mws_c[1], bn_mws_b[1];
+	int bn_mws_lo;
+
+	while (bn_mws_i < bn_mws_n)
+	{
+		mul_uint32(bn_mws_prod, bn_mws_a[bn_mws_i], bn_mws_w);
+		bn_mws_lo = add_full_uint32(bn_mws_c, bn_mws_prod[1], bn_mws_borrow);
+		bn_mws_r[bn_mws_i] = sub_full_uint32(bn_mws_b, bn_mws_r[bn_mws_i], bn_mws_lo);
+		bn_mws_borrow = bn_mws_prod[0] + bn_mws_c[0] + bn_mws_b[0];
+
+		bn_mws_i = bn_mws_i + 1;
+	}
+
+	return bn_mws_borrow;
+}
+
+// schoolbook: one multiply-accumulate row per limb of b
+int bn_mul(int bn_mul_r[], int bn_mul_a[], int bn_mul_an, int bn_mul_b[], int bn_mul_bn)
+{
+	int bn_mul_j = 0;
+
+	bn_zero(bn_mul_r, bn_mul_an + bn_mul_bn);
+
+	while (bn_mul_j < bn_mul_bn)
+	{
+		if (bn_mul_b[bn_mul_j] != 0)
+		{
+			bn_mul_r[bn_mul_an + bn_mul_j] = bn_mul_word_add(
+				&bn_mul_r[bn_mul_j], bn_mul_a, bn_mul_an, bn_mul_b[bn_mul_j]);
+		}
+
+		bn_mul_j = bn_mul_j + 1;
+	}
+
+	return 0;
+}
+
+// Column-wise product: every a[i]*b[j] with i+j == k is summed into a
+// three-limb accumulator before r[k] is stored, so carries are propagated
+// once per column instead of once per row and limb.
+int bn_mul_comba(int bn_comba_r[], int bn_comba_a[], int bn_comba_b[], int bn_comba_n)
+{
+	int bn_comba_c0 = 0, bn_comba_c1 = 0, bn_comba_c2 = 0;
+	int bn_comba_k = 0, bn_comba_i, bn_comba_last;
+	int bn_comba_prod[2];
+	int bn_comba_cy0[1], bn_comba_cy1[1];
+
+	while (bn_comba_k < 2 * bn_comba_n - 1)
+	{
+		bn_comba_i = 0;
+		if (bn_comba_k >= bn_comba_n)
+		{
+			bn_comba_i = bn_comba_k - bn_comba_n + 1;
+		}
+
+		bn_comba_last = bn_comba_k;
+		if (bn_comba_last > bn_comba_n - 1)
+		{
+			bn_comba_last = bn_comba_n - 1;
+		}
+
+		while (bn_comba_i <= bn_comba_last)
+		{
+			// the high half is at most 2^32-2, so adding the carry cannot wrap
+			mul_uint32(bn_comba_prod, bn_comba_a[bn_comba_i], bn_comba_b[bn_comba_k - bn_comba_i]);
+			bn_comba_c0 = add_full_uint32(bn_comba_cy0, bn_comba_c0, bn_comba_prod[1]);
+			bn_comba_c1 = add_full_uint32(bn_comba_cy1, bn_comba_c1, bn_comba_prod[0] + bn_comba_cy0[0]);
+			bn_comba_c2 = bn_comba_c2 + bn_comba_cy1[0];
+
+			bn_comba_i = bn_comba_i + 1;
+		}
+
+		bn_comba_r[bn_comba_k] = bn_comba_c0;
+		bn_comba_c0 = bn_comba_c1;
+		bn_comba_c1 = bn_comba_c2;
+		bn_comba_c2 = 0;
+
+		bn_comba_k = bn_comba_k + 1;
+	}
+
+	bn_comba_r[2 * bn_comba_n - 1] = bn_comba_c0;
+
+	return 0;
+}
+
+// Comba squaring: each column sums a[i]*a[j] for i < j once, doubles the
+// sum with two shifts, then adds a[k/2]^2, so it needs about half the
+// mul_uint32 calls of bn_mul_comba.
+int bn_sqr_comba(int bn_sqr_comba_r[], int bn_sqr_comba_a[], int bn_sqr_comba_n)
+{
+	int bn_sqr_comba_c0 = 0, bn_sqr_comba_c1 = 0, bn_sqr_comba_c2 = 0;
+	int bn_sqr_comba_d0, bn_sqr_comba_d1, bn_sqr_comba_d2;
+	int bn_sqr_comba_k = 0, bn_sqr_comba_i;
+	int bn_sqr_comba_prod[2];
+	int bn_sqr_comba_cy0[1], bn_sqr_comba_cy1[1];
+
+	while (bn_sqr_comba_k < 2 * bn_sqr_comba_n - 1)
+	{
+		bn_sqr_comba_d0 = 0;
+		bn_sqr_comba_d1 = 0;
+		bn_sqr_comba_d2 = 0;
+
+		bn_sqr_comba_i = 0;
+		if (bn_sqr_comba_k >= bn_sqr_comba_n)
+		{
+			bn_sqr_comba_i = bn_sqr_comba_k - bn_sqr_comba_n + 1;
+		}
+
+		while (2 * bn_sqr_comba_i < bn_sqr_comba_k)
+		{
+			mul_uint32(
+				bn_sqr_comba_prod,
+				bn_sqr_comba_a[bn_sqr_comba_i],
+				bn_sqr_comba_a[bn_sqr_comba_k - bn_sqr_comba_i]);
+			bn_sqr_comba_d0 = add_full_uint32(bn_sqr_comba_cy0, bn_sqr_comba_d0, bn_sqr_comba_prod[1]);
+			bn_sqr_comba_d1 = add_full_uint32(
+				bn_sqr_comba_cy1, bn_sqr_comba_d1, bn_sqr_comba_prod[0] + bn_sqr_comba_cy0[0]);
+			bn_sqr_comba_d2 = bn_sqr_comba_d2 + bn_sqr_comba_cy1[0];
+
+			bn_sqr_comba_i = bn_sqr_comba_i + 1;
+		}
+
+		// d = 2*d
+		bn_sqr_comba_d2 = lshift_uint32(bn_sqr_comba_d2, 1) + rshift_uint32(bn_sqr_comba_d1, 31);
+		bn_sqr_comba_d1 = lshift_uint32(bn_sqr_comba_d1, 1) + rshift_uint32(bn_sqr_comba_d0, 31);
+		bn_sqr_comba_d0 = lshift_uint32(bn_sqr_comba_d0, 1);
+
+		if (mod(bn_sqr_comba_k, 2) == 0)
+		{
+			mul_uint32(
+				bn_sqr_comba_prod,
+				bn_sqr_comba_a[bn_sqr_comba_k / 2],
+				bn_sqr_comba_a[bn_sqr_comba_k / 2]);
+			bn_sqr_comba_d0 = add_full_uint32(bn_sqr_comba_cy0, bn_sqr_comba_d0, bn_sqr_comba_prod[1]);
+			bn_sqr_comba_d1 = add_full_uint32(
+				bn_sqr_comba_cy1, bn_sqr_comba_d1, bn_sqr_comba_prod[0] + bn_sqr_comba_cy0[0]);
+			bn_sqr_comba_d2 = bn_sqr_comba_d2 + bn_sqr_comba_cy1[0];
+		}
+
+		// c += d
+		bn_sqr_comba_c0 = add_full_uint32(bn_sqr_comba_cy0, bn_sqr_comba_c0, bn_sqr_comba_d0);
+		bn_sqr_comba_c1 = add_full_uint32(bn_sqr_comba_cy1, bn_sqr_comba_c1, bn_sqr_comba_d1);
+		bn_sqr_comba_c2 = bn_sqr_comba_c2 + bn_sqr_comba_d2 + bn_sqr_comba_cy1[0];
+		bn_sqr_comba_c1 = add_full_uint32(bn_sqr_comba_cy1, bn_sqr_comba_c1, bn_sqr_comba_cy0[0]);
+		bn_sqr_comba_c2 = bn_sqr_comba_c2 + bn_sqr_comba_cy1[0];
+
+		bn_sqr_comba_r[bn_sqr_comba_k] = bn_sqr_comba_c0;
+		bn_sqr_comba_c0 = bn_sqr_comba_c1;
+		bn_sqr_comba_c1 = bn_sqr_comba_c2;
+		bn_sqr_comba_c2 = 0;
+
+		bn_sqr_comba_k = bn_sqr_comba_k + 1;
+	}
+
+	bn_sqr_comba_r[2 * bn_sqr_comba_n - 1] = bn_sqr_comba_c0;
+
+	return 0;
+}
+
+// Karatsuba step shared by multiplication and squaring (b == nullptr).
+// With a = a1*B^h + a0 and b = b1*B^h + b0, h = n/2:
+//   a*b = z2*B^2h + (z1 - z2 - z0)*B^h + z0
+// where z0 = a0*b0, z2 = a1*b1 and z1 = (a0+a1)*(b0+b1). z0 and z2 go
+// straight into r; the sums carry into an extra limb, so z1 is an
+// (m+1)-limb product, m = n-h.
+static int bn_karatsuba(
+	int bn_kara_r[],
+	int bn_kara_a[],
+	int bn_kara_b[],
+	int bn_kara_n,
+	int bn_kara_threshold,
+	int bn_kara_scratch[])
+{
+	int bn_kara_h = bn_kara_n / 2;
+	int bn_kara_m = bn_kara_n - bn_kara_h;
+	int* bn_kara_sa = bn_kara_scratch;
+	int* bn_kara_sb = bn_kara_scratch + bn_kara_m + 1;
+	int* bn_kara_z1 = bn_kara_scratch + 2 * bn_kara_m + 2;
+	int* bn_kara_tmp = bn_kara_scratch + 4 * bn_kara_m + 4;
+	int bn_kara_carry;
+
+	if (bn_kara_b == nullptr)
+	{
+		bn_sqr_karatsuba(bn_kara_r, bn_kara_a, bn_kara_h, bn_kara_threshold, bn_kara_tmp);
+		bn_sqr_karatsuba(
+			&bn_kara_r[2 * bn_kara_h], &bn_kara_a[bn_kara_h], bn_kara_m, bn_kara_threshold, bn_kara_tmp);
+	}
+	else
+	{
+		bn_mul_karatsuba(bn_kara_r, bn_kara_a, bn_kara_b, bn_kara_h, bn_kara_threshold, bn_kara_tmp);
+		bn_mul_karatsuba(
+			&bn_kara_r[2 * bn_kara_h],
+			&bn_kara_a[bn_kara_h],
+			&bn_kara_b[bn_kara_h],
+			bn_kara_m,
+			bn_kara_threshold,
+			bn_kara_tmp);
+	}
+
+	// sa = a0 + a1
+	bn_copy(bn_kara_sa, &bn_kara_a[bn_kara_h], bn_kara_m);
+	bn_kara_sa[bn_kara_m] = 0;
+	bn_kara_carry = bn_add(bn_kara_sa, bn_kara_sa, bn_kara_a, bn_kara_h);
+	bn_add_word(&bn_kara_sa[bn_kara_h], &bn_kara_sa[bn_kara_h], bn_kara_m + 1 - bn_kara_h, bn_kara_carry);
+
+	if (bn_kara_b == nullptr)
+	{
+		bn_sqr_karatsuba(bn_kara_z1, bn_kara_sa, bn_kara_m + 1, bn_kara_threshold, bn_kara_tmp);
+	}
+	else
+	{
+		bn_copy(bn_kara_sb, &bn_kara_b[bn_kara_h], bn_kara_m);
+		bn_kara_sb[bn_kara_m] = 0;
+		bn_kara_carry = bn_add(bn_kara_sb, bn_kara_sb, bn_kara_b, bn_kara_h);
+		bn_add_word(&bn_kara_sb[bn_kara_h], &bn_kara_sb[bn_kara_h], bn_kara_m + 1 - bn_kara_h, bn_kara_carry);
+
+		bn_mul_karatsuba(bn_kara_z1, bn_kara_sa, bn_kara_sb, bn_kara_m + 1, bn_kara_threshold, bn_kara_tmp);
+	}
+
+	// z1 -= z0 + z2
+	bn_kara_carry = bn_sub(bn_kara_z1, bn_kara_z1, bn_kara_r, 2 * bn_kara_h);
+	bn_sub_word(
+		&bn_kara_z1[2 * bn_kara_h], &bn_kara_z1[2 * bn_kara_h], 2 * bn_kara_m + 2 - 2 * bn_kara_h, bn_kara_carry);
+	bn_kara_carry = bn_sub(bn_kara_z1, bn_kara_z1, &bn_kara_r[2 * bn_kara_h], 2 * bn_kara_m);
+	bn_sub_word(&bn_kara_z1[2 * bn_kara_m], &bn_kara_z1[2 * bn_kara_m], 2, bn_kara_carry);
+
+	// r += z1 * B^h; h >= 2 keeps z1's 2m+2 limbs inside r
+	bn_kara_carry = bn_add(&bn_kara_r[bn_kara_h], &bn_kara_r[bn_kara_h], bn_kara_z1, 2 * bn_kara_m + 2);
+	bn_add_word(
+		&bn_kara_r[bn_kara_h + 2 * bn_kara_m + 2],
+		&bn_kara_r[bn_kara_h + 2 * bn_kara_m + 2],
+		bn_kara_h - 2,
+		bn_kara_carry);
+
+	return 0;
+}
+
+int bn_mul_karatsuba(
+	int bn_mul_kara_r[],
+	int bn_mul_kara_a[],
+	int bn_mul_kara_b[],
+	int bn_mul_kara_n,
+	int bn_mul_kara_threshold,
+	int bn_mul_kara_scratch[])
+{
+	if (bn_mul_kara_threshold < 4)
+	{
+		bn_mul_kara_threshold = 4;
+	}
+
+	if (bn_mul_kara_n < bn_mul_kara_threshold)
+	{
+		return bn_mul_comba(bn_mul_kara_r, bn_mul_kara_a, bn_mul_kara_b, bn_mul_kara_n);
+	}
+
+	return bn_karatsuba(
+		bn_mul_kara_r, bn_mul_kara_a, bn_mul_kara_b, bn_mul_kara_n, bn_mul_kara_threshold, bn_mul_kara_scratch);
+}
+
+int bn_sqr_karatsuba(
+	int bn_sqr_kara_r[],
+	int bn_sqr_kara_a[],
+	int bn_sqr_kara_n,
+	int bn_sqr_kara_threshold,
+	int bn_sqr_kara_scratch[])
+{
+	if (bn_sqr_kara_threshold < 4)
+	{
+		bn_sqr_kara_threshold = 4;
+	}
+
+	if (bn_sqr_kara_n < bn_sqr_kara_threshold)
+	{
+		return bn_sqr_comba(bn_sqr_kara_r, bn_sqr_kara_a, bn_sqr_kara_n);
+	}
+
+	return bn_karatsuba(
+		bn_sqr_kara_r, bn_sqr_kara_a, nullptr, bn_sqr_kara_n, bn_sqr_kara_threshold, bn_sqr_kara_scratch);
+}
+
+int bn_mul_n(int bn_mul_n_r[], int bn_mul_n_a[], int bn_mul_n_b[], int bn_mul_n_n, int bn_mul_n_scratch[])
+{
+	return bn_mul_karatsuba(
+		bn_mul_n_r, bn_mul_n_a, bn_mul_n_b, bn_mul_n_n, kBnMulKaratsubaThreshold, bn_mul_n_scratch);
+}
+
+int bn_sqr(int bn_sqr_r[], int bn_sqr_a[], int bn_sqr_n, int bn_sqr_scratch[])
+{
+	return bn_sqr_karatsuba(bn_sqr_r, bn_sqr_a, bn_sqr_n, kBnSqrKaratsubaThreshold, bn_sqr_scratch);
+}
+
+// top limb first, so r may be a
+int bn_lshift(int bn_lshift_r[], int bn_lshift_a[], int bn_lshift_n, int bn_lshift_s)
+{
+	int bn_lshift_words = bn_lshift_s / 32;
+	int bn_lshift_bits = mod(bn_lshift_s, 32);
+	int bn_lshift_i = bn_lshift_n - 1;
+	int bn_lshift_src;
+	int bn_lshift_limb;
+
+	while (bn_lshift_i >= 0)
+	{
+		bn_lshift_src = bn_lshift_i - bn_lshift_words;
+		bn_lshift_limb = 0;
+
+		if (bn_lshift_src >= 0)
+		{
+			bn_lshift_limb = lshift_uint32(bn_lshift_a[bn_lshift_src], bn_lshift_bits);
+		}
+
+		if (bn_lshift_src >= 1)
+		{
+			bn_lshift_limb = bn_lshift_limb +
+				rshift_uint32(bn_lshift_a[bn_lshift_src - 1], 32 - bn_lshift_bits);
+		}
+
+		bn_lshift_r[bn_lshift_i] = bn_lshift_limb;
+		bn_lshift_i = bn_lshift_i - 1;
+	}
+
+	return 0;
+}
+
+// bottom limb first, so r may be a
+int bn_rshift(int bn_rshift_r[], int bn_rshift_a[], int bn_rshift_n, int bn_rshift_s)
+{
+	int bn_rshift_words = bn_rshift_s / 32;
+	int bn_rshift_bits = mod(bn_rshift_s, 32);
+	int bn_rshift_i = 0;
+	int bn_rshift_src;
+	int bn_rshift_limb;
+
+	while (bn_rshift_i < bn_rshift_n)
+	{
+		bn_rshift_src = bn_rshift_i + bn_rshift_words;
+		bn_rshift_limb = 0;
+
+		if (bn_rshift_src < bn_rshift_n)
+		{
+			bn_rshift_limb = rshift_uint32(bn_rshift_a[bn_rshift_src], bn_rshift_bits);
+		}
+
+		if (bn_rshift_src + 1 < bn_rshift_n)
+		{
+			bn_rshift_limb = bn_rshift_limb +
+				lshift_uint32(bn_rshift_a[bn_rshift_src + 1], 32 - bn_rshift_bits);
+		}
+
+		bn_rshift_r[bn_rshift_i] = bn_rshift_limb;
+		bn_rshift_i = bn_rshift_i + 1;
+	}
+
+	return 0;
+}
+
+int bn_div_word(int bn_divw_q[], int bn_divw_a[], int bn_divw_n, int bn_divw_d)
+{
+	int bn_divw_i = bn_divw_n - 1;
+	int bn_divw_num[2], bn_divw_den[2], bn_divw_quot[2], bn_divw_rem[2];
+
+	bn_divw_den[0] = 0;
+	bn_divw_den[1] = bn_divw_d;
+	bn_divw_rem[1] = 0;
+
+	// (rem, a[i]) / d fits in one limb because rem < d
+	while (bn_divw_i >= 0)
+	{
+		bn_divw_num[0] = bn_divw_rem[1];
+		bn_divw_num[1] = bn_divw_a[bn_divw_i];
+		div_mod_uint64(bn_divw_quot, bn_divw_rem, bn_divw_num, bn_divw_den);
+
+		if (bn_divw_q != nullptr)
+		{
+			bn_divw_q[bn_divw_i] = bn_divw_quot[1];
+		}
+
+		bn_divw_i = bn_divw_i - 1;
+	}
+
+	return bn_divw_rem[1];
+}
+
+// TAOCP vol. 2, 4.3.1. Both operands are shifted left until the top limb
+// of b has its high bit set, which keeps each estimated quotient limb at
+// most two above the true one; the estimate is then corrected with the
+// second limb of b and, rarely, by adding b back.
+int bn_div_mod(
+	int bn_divmod_q[],
+	int bn_divmod_r[],
+	int bn_divmod_a[],
+	int bn_divmod_an,
+	int bn_divmod_b[],
+	int bn_divmod_bn,
+	int bn_divmod_scratch[])
+{
+	int* bn_divmod_u = bn_divmod_scratch;
+	int* bn_divmod_v = bn_divmod_scratch + bn_divmod_an + 1;
+	int bn_divmod_al, bn_divmod_bl, bn_divmod_s, bn_divmod_j;
+	int bn_divmod_vt, bn_divmod_vt2;
+	int bn_divmod_qhat, bn_divmod_rhat, bn_divmod_overflow, bn_divmod_refine;
+	int bn_divmod_num[2], bn_divmod_den[2], bn_divmod_quot[2], bn_divmod_rem[2];
+	int bn_divmod_prod[2], bn_divmod_cmp[2];
+	int bn_divmod_carry[1], bn_divmod_borrow[1];
+	int bn_divmod_top_borrow;
+
+	bn_divmod_bl = bn_len(bn_divmod_b, bn_divmod_bn);
+	if (bn_divmod_bl == 0)
+	{
+		return 0;
+	}
+
+	bn_divmod_al = bn_len(bn_divmod_a, bn_divmod_an);
+
+	// a and b are copied before q and r are written, so those may alias them
+	if (bn_divmod_al < bn_divmod_bl)
+	{
+		bn_copy(bn_divmod_u, bn_divmod_a, bn_divmod_al);
+
+		if (bn_divmod_q != nullptr)
+		{
+			bn_zero(bn_divmod_q, bn_divmod_an);
+		}
+
+		if (bn_divmod_r != nullptr)
+		{
+			bn_zero(bn_divmod_r, bn_divmod_bn);
+			bn_copy(bn_divmod_r, bn_divmod_u, bn_divmod_al);
+		}
+
+		return 1;
+	}
+
+	if (bn_divmod_bl == 1)
+	{
+		bn_copy(bn_divmod_u, bn_divmod_a, bn_divmod_al);
+		bn_divmod_vt = bn_div_word(bn_divmod_u, bn_divmod_u, bn_divmod_al, bn_divmod_b[0]);
+
+		if (bn_divmod_q != nullptr)
+		{
+			bn_zero(bn_divmod_q, bn_divmod_an);
+			bn_copy(bn_divmod_q, bn_divmod_u, bn_divmod_al);
+		}
+
+		if (bn_divmod_r != nullptr)
+		{
+			bn_set_uint32(bn_divmod_r, bn_divmod_bn, bn_divmod_vt);
+		}
+
+		return 1;
+	}
+
+	bn_divmod_s = 32 - get_bits_uint32(bn_divmod_b[bn_divmod_bl - 1]);
+	bn_lshift(bn_divmod_v, bn_divmod_b, bn_divmod_bl, bn_divmod_s);
+
+	bn_copy(bn_divmod_u, bn_divmod_a, bn_divmod_al);
+	bn_divmod_u[bn_divmod_al] = 0;
+	bn_lshift(bn_divmod_u, bn_divmod_u, bn_divmod_al + 1, bn_divmod_s);
+
+	if (bn_divmod_q != nullptr)
+	{
+		bn_zero(bn_divmod_q, bn_divmod_an);
+	}
+
+	bn_divmod_vt = bn_divmod_v[bn_divmod_bl - 1];
+	bn_divmod_vt2 = bn_divmod_v[bn_divmod_bl - 2];
+	bn_divmod_den[0] = 0;
+	bn_divmod_den[1] = bn_divmod_vt;
+
+	bn_divmod_j = bn_divmod_al - bn_divmod_bl;
+	while (bn_divmod_j >= 0)
+	{
+		// estimate from the top two limbs of the current remainder
+		if (bn_divmod_u[bn_divmod_j + bn_divmod_bl] == bn_divmod_vt)
+		{
+			bn_divmod_qhat = -1;
+			bn_divmod_rhat = add_full_uint32(
+				bn_divmod_carry, bn_divmod_u[bn_divmod_j + bn_divmod_bl - 1], bn_divmod_vt);
+			bn_divmod_overflow = bn_divmod_carry[0];
+		}
+		else
+		{
+			bn_divmod_num[0] = bn_divmod_u[bn_divmod_j + bn_divmod_bl];
+			bn_divmod_num[1] = bn_divmod_u[bn_divmod_j + bn_divmod_bl - 1];
+			div_mod_uint64(bn_divmod_quot, bn_divmod_rem, bn_divmod_num, bn_divmod_den);
+			bn_divmod_qhat = bn_divmod_quot[1];
+			bn_divmod_rhat = bn_divmod_rem[1];
+			bn_divmod_overflow = 0;
+		}
+
+		// while qhat*v[bl-2] > (rhat, u[j+bl-2]), qhat is too big
+		bn_divmod_refine = 1;
+		while (bn_divmod_refine && !bn_divmod_overflow)
+		{
+			mul_uint32(bn_divmod_prod, bn_divmod_qhat, bn_divmod_vt2);
+			bn_divmod_cmp[0] = bn_divmod_rhat;
+			bn_divmod_cmp[1] = bn_divmod_u[bn_divmod_j + bn_divmod_bl - 2];
+
+			if (cmp_uint64(bn_divmod_prod, bn_divmod_cmp) > 0)
+			{
+				bn_divmod_qhat = bn_divmod_qhat - 1;
+				bn_divmod_rhat = add_full_uint32(bn_divmod_carry, bn_divmod_rhat, bn_divmod_vt);
+				bn_divmod_overflow = bn_divmod_carry[0];
+			}
+			else
+			{
+				bn_divmod_refine = 0;
+			}
+		}
+
+		bn_divmod_top_borrow = bn_mul_word_sub(
+			&bn_divmod_u[bn_divmod_j], bn_divmod_v, bn_divmod_bl, bn_divmod_qhat);
+		bn_divmod_u[bn_divmod_j + bn_divmod_bl] = sub_full_uint32(
+			bn_divmod_borrow, bn_divmod_u[bn_divmod_j + bn_divmod_bl], bn_divmod_top_borrow);
+
+		if (bn_divmod_borrow[0])
+		{
+			bn_divmod_qhat = bn_divmod_qhat - 1;
+			bn_divmod_u[bn_divmod_j + bn_divmod_bl] = bn_divmod_u[bn_divmod_j + bn_divmod_bl] +
+				bn_add(&bn_divmod_u[bn_divmod_j], &bn_divmod_u[bn_divmod_j], bn_divmod_v, bn_divmod_bl);
+		}
+
+		if (bn_divmod_q != nullptr)
+		{
+			bn_divmod_q[bn_divmod_j] = bn_divmod_qhat;
+		}
+
+		bn_divmod_j = bn_divmod_j - 1;
+	}
+
+	if (bn_divmod_r != nullptr)
+	{
+		bn_rshift(bn_divmod_u, bn_divmod_u, bn_divmod_bl, bn_divmod_s);
+		bn_zero(bn_divmod_r, bn_divmod_bn);
+		bn_copy(bn_divmod_r, bn_divmod_u, bn_divmod_bl);
+	}
+
+	return 1;
+}
+
+int bn_mul_mod(
+	int bn_mul_mod_r[],
+	int bn_mul_mod_a[],
+	int bn_mul_mod_b[],
+	int bn_mul_mod_m[],
+	int bn_mul_mod_n,
+	int bn_mul_mod_scratch[])
+{
+	int* bn_mul_mod_prod = bn_mul_mod_scratch;
+
+	bn_mul_n(bn_mul_mod_prod, bn_mul_mod_a, bn_mul_mod_b, bn_mul_mod_n, bn_mul_mod_scratch + 2 * bn_mul_mod_n);
+
+	return bn_div_mod(
+		nullptr,
+		bn_mul_mod_r,
+		bn_mul_mod_prod,
+		2 * bn_mul_mod_n,
+		bn_mul_mod_m,
+		bn_mul_mod_n,
+		bn_mul_mod_scratch + 2 * bn_mul_mod_n);
+}
+
+int bn_sqr_mod(
+	int bn_sqr_mod_r[],
+	int bn_sqr_mod_a[],
+	int bn_sqr_mod_m[],
+	int bn_sqr_mod_n,
+	int bn_sqr_mod_scratch[])
+{
+	int* bn_sqr_mod_prod = bn_sqr_mod_scratch;
+
+	bn_sqr(bn_sqr_mod_prod, bn_sqr_mod_a, bn_sqr_mod_n, bn_sqr_mod_scratch + 2 * bn_sqr_mod_n);
+
+	return bn_div_mod(
+		nullptr,
+		bn_sqr_mod_r,
+		bn_sqr_mod_prod,
+		2 * bn_sqr_mod_n,
+		bn_sqr_mod_m,
+		bn_sqr_mod_n,
+		bn_sqr_mod_scratch + 2 * bn_sqr_mod_n);
+}
+
+// left to right over the bits of e
+int bn_exp_mod(
+	int bn_exp_mod_r[],
+	int bn_exp_mod_a[],
+	int bn_exp_mod_e[],
+	int bn_exp_mod_en,
+	int bn_exp_mod_m[],
+	int bn_exp_mod_n,
+	int bn_exp_mod_scratch[])
+{
+	int* bn_exp_mod_base = bn_exp_mod_scratch;
+	int* bn_exp_mod_acc = bn_exp_mod_scratch + bn_exp_mod_n;
+	int* bn_exp_mod_tmp = bn_exp_mod_scratch + 2 * bn_exp_mod_n;
+	int bn_exp_mod_i;
+
+	if (!bn_div_mod(
+			nullptr,
+			bn_exp_mod_base,
+			bn_exp_mod_a,
+			bn_exp_mod_n,
+			bn_exp_mod_m,
+			bn_exp_mod_n,
+			bn_exp_mod_tmp))
+	{
+		return 0;
+	}
+
+	// 1 mod m, which is 0 when m is 1
+	bn_set_uint32(bn_exp_mod_acc, bn_exp_mod_n, 1);
+	bn_div_mod(
+		nullptr,
+		bn_exp_mod_acc,
+		bn_exp_mod_acc,
+		bn_exp_mod_n,
+		bn_exp_mod_m,
+		bn_exp_mod_n,
+		bn_exp_mod_tmp);
+
+	bn_exp_mod_i = bn_bits(bn_exp_mod_e, bn_exp_mod_en) - 1;
+	while (bn_exp_mod_i >= 0)
+	{
+		bn_sqr_mod(bn_exp_mod_acc, bn_exp_mod_acc, bn_exp_mod_m, bn_exp_mod_n, bn_exp_mod_tmp);
+
+		if (bn_is_bit_set(bn_exp_mod_e, bn_exp_mod_i))
+		{
+			bn_mul_mod(
+				bn_exp_mod_acc, bn_exp_mod_acc, bn_exp_mod_base, bn_exp_mod_m, bn_exp_mod_n, bn_exp_mod_tmp);
+		}
+
+		bn_exp_mod_i = bn_exp_mod_i - 1;
+	}
+
+	bn_copy(bn_exp_mod_r, bn_exp_mod_acc, bn_exp_mod_n);
+
+	return 1;
+}
+
+int bn_rand_bits(int bn_rand_bits_r[], int bn_rand_bits_n, int bn_rand_bits_bits, int bn_rand_bits_top, int bn_rand_bits_bottom)
+{
+	int bn_rand_bits_i = 0;
+
+	if (bn_rand_bits_bits <= 0 || bn_rand_bits_bits > 32 * bn_rand_bits_n)
+	{
+		return 0;
+	}
+
+	bn_zero(bn_rand_bits_r, bn_rand_bits_n);
+
+	while (bn_rand_bits_i < bn_rand_bits_bits / 32)
+	{
+		bn_rand_bits_r[bn_rand_bits_i] = rand32();
+		bn_rand_bits_i = bn_rand_bits_i + 1;
+	}
+
+	if (mod(bn_rand_bits_bits, 32) != 0)
+	{
+		bn_rand_bits_r[bn_rand_bits_i] = rand_bits(mod(bn_rand_bits_bits, 32), 0, 0);
+	}
+
+	if (bn_rand_bits_top == 1 || bn_rand_bits_top == 2)
+	{
+		bn_set_bit(bn_rand_bits_r, bn_rand_bits_bits - 1);
+
+		if (bn_rand_bits_top == 2 && bn_rand_bits_bits >= 2)
+		{
+			bn_set_bit(bn_rand_bits_r, bn_rand_bits_bits - 2);
+		}
+	}
+
+	if (bn_rand_bits_bottom == 1)
+	{
+		bn_set_bit(bn_rand_bits_r, 0);
+	}
+
+	return 1;
+}
+
+// r must not alias range
+int bn_rand_range(int bn_rand_range_r[], int bn_rand_range_range[], int bn_rand_range_n)
+{
+	int bn_rand_range_bits = bn_bits(bn_rand_range_range, bn_rand_range_n);
+
+	if (bn_rand_range_bits == 0)
+	{
+		return 0;
+	}
+
+	// at least half of the draws are in range
+	while (1)
+	{
+		bn_rand_bits(bn_rand_range_r, bn_rand_range_n, bn_rand_range_bits, 0, 0);
+
+		if (bn_cmp(bn_rand_range_r, bn_rand_range_range, bn_rand_range_n) < 0)
+		{
+			return 1;
+		}
+	}
+}
+
+static int bn_mr_rounds(int bn_mr_rounds_bits)
+{
+	if (bn_mr_rounds_bits >= 1300)
+	{
+		return 2;
+	}
+	else if (bn_mr_rounds_bits >= 850)
+	{
+		return 3;
+	}
+	else if (bn_mr_rounds_bits >= 650)
+	{
+		return 4;
+	}
+	else if (bn_mr_rounds_bits >= 550)
+	{
+		return 5;
+	}
+	else if (bn_mr_rounds_bits >= 450)
+	{
+		return 6;
+	}
+	else if (bn_mr_rounds_bits >= 400)
+	{
+		return 7;
+	}
+	else if (bn_mr_rounds_bits >= 350)
+	{
+		return 8;
+	}
+	else if (bn_mr_rounds_bits >= 300)
+	{
+		return 9;
+	}
+	else if (bn_mr_rounds_bits >= 250)
+	{
+		return 12;
+	}
+	else if (bn_mr_rounds_bits >= 200)
+	{
+		return 15;
+	}
+	else if (bn_mr_rounds_bits >= 150)
+	{
+		return 18;
+	}
+
+	return 27;
+}
+
+int bn_is_prime(int bn_isp_out[1], int bn_isp_w[], int bn_isp_n, int bn_isp_scratch[])
+{
+	int* bn_isp_w1 = bn_isp_scratch;
+	int* bn_isp_d = bn_isp_scratch + bn_isp_n;
+	int* bn_isp_a = bn_isp_scratch + 2 * bn_isp_n;
+	int* bn_isp_x = bn_isp_scratch + 3 * bn_isp_n;
+	int* bn_isp_tmp = bn_isp_scratch + 4 * bn_isp_n;
+	int bn_isp_i, bn_isp_j, bn_isp_s, bn_isp_rounds;
+	int bn_isp_witness;
+
+	if (bn_len(bn_isp_w, bn_isp_n) <= 1)
+	{
+		return is_prime_deterministic(bn_isp_out, bn_isp_w[0]);
+	}
+
+	// w > 2^32, above every trial divisor
+	bn_isp_i = 0;
+	while (bn_isp_i < 64)
+	{
+		if (bn_div_word(nullptr, bn_isp_w, bn_isp_n, kPrimes[bn_isp_i]) == 0)
+		{
+			bn_isp_out[0] = 0;
+			return 1;
+		}
+
+		bn_isp_i = bn_isp_i + 1;
+	}
+
+	// w-1 = d * 2^s
+	bn_sub_word(bn_isp_w1, bn_isp_w, bn_isp_n, 1);
+	bn_isp_s = 1;
+	while (!bn_is_bit_set(bn_isp_w1, bn_isp_s))
+	{
+		bn_isp_s = bn_isp_s + 1;
+	}
+	bn_rshift(bn_isp_d, bn_isp_w1, bn_isp_n, bn_isp_s);
+
+	bn_isp_rounds = bn_mr_rounds(bn_bits(bn_isp_w, bn_isp_n));
+	bn_isp_out[0] = 1;
+
+	bn_isp_i = 0;
+	while (bn_isp_out[0] && bn_isp_i < bn_isp_rounds)
+	{
+		// a in [2, w-2]
+		bn_sub_word(bn_isp_x, bn_isp_w, bn_isp_n, 3);
+		bn_rand_range(bn_isp_a, bn_isp_x, bn_isp_n);
+		bn_add_word(bn_isp_a, bn_isp_a, bn_isp_n, 2);
+
+		bn_exp_mod(bn_isp_x, bn_isp_a, bn_isp_d, bn_isp_n, bn_isp_w, bn_isp_n, bn_isp_tmp);
+
+		if (!(bn_len(bn_isp_x, bn_isp_n) == 1 && bn_isp_x[0] == 1) &&
+			bn_cmp(bn_isp_x, bn_isp_w1, bn_isp_n) != 0)
+		{
+			bn_isp_witness = 1;
+
+			bn_isp_j = 1;
+			while (bn_isp_witness && bn_isp_j < bn_isp_s)
+			{
+				bn_sqr_mod(bn_isp_x, bn_isp_x, bn_isp_w, bn_isp_n, bn_isp_tmp);
+
+				if (bn_cmp(bn_isp_x, bn_isp_w1, bn_isp_n) == 0)
+				{
+					bn_isp_witness = 0;
+				}
+
+				bn_isp_j = bn_isp_j + 1;
+			}
+
+			if (bn_isp_witness)
+			{
+				bn_isp_out[0] = 0;
+			}
+		}
+
+		bn_isp_i = bn_isp_i + 1;
+	}
+
+	return 1;
+}
+
+// Same sieve as generate_prime_uint64: residues of the random start modulo
+// kPrimes are computed once and candidates start+delta that any small
+// prime divides never reach Miller-Rabin.
+int bn_generate_prime(int bn_genprime_out[], int bn_genprime_n, int bn_genprime_bits, int bn_genprime_scratch[])
+{
+	int* bn_genprime_rnd = bn_genprime_scratch;
+	int* bn_genprime_tmp = bn_genprime_scratch + bn_genprime_n;
+	int bn_genprime_mods[64];
+	int bn_genprime_is_prime[1];
+	int bn_genprime_i, bn_genprime_delta, bn_genprime_sieved;
+	int bn_genprime_max_delta = kTwoPowers[24];
+	int bn_genprime_goto_again = 1;
+
+	if (bn_genprime_bits < 64 || bn_genprime_bits > 32 * bn_genprime_n)
+	{
+		return 0;
+	}
+
+	// again:
+	while (bn_genprime_goto_again)
+	{
+		bn_genprime_goto_again = 0;
+
+		bn_rand_bits(bn_genprime_rnd, bn_genprime_n, bn_genprime_bits, 2, 1);
+
+		bn_genprime_i = 1;
+		while (bn_genprime_i < 64)
+		{
+			bn_genprime_mods[bn_genprime_i] =
+				bn_div_word(nullptr, bn_genprime_rnd, bn_genprime_n, kPrimes[bn_genprime_i]);
+			bn_genprime_i = bn_genprime_i + 1;
+		}
+
+		bn_genprime_delta = 0;
+		while (!bn_genprime_goto_again)
+		{
+			bn_genprime_sieved = 0;
+			bn_genprime_i = 1;
+			while (!bn_genprime_sieved && bn_genprime_i < 64)
+			{
+				if (mod(bn_genprime_mods[bn_genprime_i] + bn_genprime_delta, kPrimes[bn_genprime_i]) == 0)
+				{
+					bn_genprime_sieved = 1;
+				}
+
+				bn_genprime_i = bn_genprime_i + 1;
+			}
+
+			if (!bn_genprime_sieved)
+			{
+				bn_add_word(bn_genprime_out, bn_genprime_rnd, bn_genprime_n, bn_genprime_delta);
+
+				if (bn_bits(bn_genprime_out, bn_genprime_n) != bn_genprime_bits)
+				{
+					bn_genprime_goto_again = 1;
+				}
+				else
+				{
+					bn_is_prime(bn_genprime_is_prime, bn_genprime_out, bn_genprime_n, bn_genprime_tmp);
+
+					if (bn_genprime_is_prime[0])
+					{
+						return 1;
+					}
+				}
+			}
+
+			bn_genprime_delta = bn_genprime_delta + 2;
+			if (bn_genprime_delta > bn_genprime_max_delta)
+			{
+				bn_genprime_goto_again = 1;
+			}
+		}
+	}
+
+	return 0;
+}
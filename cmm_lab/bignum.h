@@ -0,0 +1,147 @@
+#ifndef BIGNUM_H_
+#define BIGNUM_H_
+
+#include "common.h"
+#include "unsigned_op.h"
+#include "crypto_core.h"
+
+// Multi-precision unsigned integers built on the uint32 operations.
+// A number is an int array of n limbs, least significant limb first
+// (unlike the high-word-first uint64 pairs), so carries run up the array.
+// Functions never allocate: anything needing temporaries takes a scratch
+// array from the caller, sized as documented on each function.
+// Unless stated otherwise, out may alias an input.
+
+static const int kBnMaxLimbs = 64; // 2048 bits
+
+// enough for any operation below on kBnMaxLimbs-limb operands
+static const int kBnScratchLimbs = 15 * kBnMaxLimbs + 128;
+
+// Operand lengths in limbs from which bn_mul_n and bn_sqr split with
+// Karatsuba instead of running Comba; picked with bench-bignum-mul.
+static const int kBnMulKaratsubaThreshold = 20;
+static const int kBnSqrKaratsubaThreshold = 32;
+
+int bn_zero(int bn_zero_r[], int bn_zero_n);
+
+int bn_copy(int bn_copy_r[], int bn_copy_a[], int bn_copy_n);
+
+int bn_set_uint32(int bn_set_r[], int bn_set_n, int bn_set_v);
+
+// number of limbs up to and including the highest non-zero one
+int bn_len(int bn_len_a[], int bn_len_n);
+
+int bn_bits(int bn_bits_a[], int bn_bits_n);
+
+int bn_is_bit_set(int bn_is_bit_set_a[], int bn_is_bit_set_i);
+
+int bn_cmp(int bn_cmp_a[], int bn_cmp_b[], int bn_cmp_n);
+
+// Return the carry out of the top limb
+int bn_add(int bn_add_r[], int bn_add_a[], int bn_add_b[], int bn_add_n);
+
+int bn_add_word(int bn_addw_r[], int bn_addw_a[], int bn_addw_n, int bn_addw_w);
+
+// Return the borrow out of the top limb
+int bn_sub(int bn_sub_r[], int bn_sub_a[], int bn_sub_b[], int bn_sub_n);
+
+int bn_sub_word(int bn_subw_r[], int bn_subw_a[], int bn_subw_n, int bn_subw_w);
+
+// r[0..n-1] += a * w; return the limb carried out
+int bn_mul_word_add(int bn_mwa_r[], int bn_mwa_a[], int bn_mwa_n, int bn_mwa_w);
+
+// r[0..n-1] -= a * w; return the limb borrowed out
+int bn_mul_word_sub(int bn_mws_r[], int bn_mws_a[], int bn_mws_n, int bn_mws_w);
+
+// r has an+bn limbs and must not alias a or b
+int bn_mul(int bn_mul_r[], int bn_mul_a[], int bn_mul_an, int bn_mul_b[], int bn_mul_bn);
+
+// Equal-length kernels. r has 2n limbs and must not alias a or b.
+
+int bn_mul_comba(int bn_comba_r[], int bn_comba_a[], int bn_comba_b[], int bn_comba_n);
+
+int bn_sqr_comba(int bn_sqr_comba_r[], int bn_sqr_comba_a[], int bn_sqr_comba_n);
+
+// Karatsuba down to threshold limbs (at least 4), Comba below.
+// scratch: 4n+128 limbs for n up to 4096.
+int bn_mul_karatsuba(
+	int bn_mul_kara_r[],
+	int bn_mul_kara_a[],
+	int bn_mul_kara_b[],
+	int bn_mul_kara_n,
+	int bn_mul_kara_threshold,
+	int bn_mul_kara_scratch[]);
+
+int bn_sqr_karatsuba(
+	int bn_sqr_kara_r[],
+	int bn_sqr_kara_a[],
+	int bn_sqr_kara_n,
+	int bn_sqr_kara_threshold,
+	int bn_sqr_kara_scratch[]);
+
+// The kernels above with the thresholds below. scratch: 4n+128 limbs.
+int bn_mul_n(int bn_mul_n_r[], int bn_mul_n_a[], int bn_mul_n_b[], int bn_mul_n_n, int bn_mul_n_scratch[]);
+
+int bn_sqr(int bn_sqr_r[], int bn_sqr_a[], int bn_sqr_n, int bn_sqr_scratch[]);
+
+// Shifts keep n limbs; bits shifted out are lost.
+int bn_lshift(int bn_lshift_r[], int bn_lshift_a[], int bn_lshift_n, int bn_lshift_s);
+
+int bn_rshift(int bn_rshift_r[], int bn_rshift_a[], int bn_rshift_n, int bn_rshift_s);
+
+// q = a / d (n limbs, may be nullptr); return a mod d. d must not be 0.
+int bn_div_word(int bn_divw_q[], int bn_divw_a[], int bn_divw_n, int bn_divw_d);
+
+// Knuth's algorithm D. q has an limbs and r has bn limbs; either may be
+// nullptr. scratch: an+bn+1 limbs. Return 0 if b is 0.
+int bn_div_mod(
+	int bn_divmod_q[],
+	int bn_divmod_r[],
+	int bn_divmod_a[],
+	int bn_divmod_an,
+	int bn_divmod_b[],
+	int bn_divmod_bn,
+	int bn_divmod_scratch[]);
+
+// a, b and r have n limbs. scratch: 6n+128 limbs.
+int bn_mul_mod(
+	int bn_mul_mod_r[],
+	int bn_mul_mod_a[],
+	int bn_mul_mod_b[],
+	int bn_mul_mod_m[],
+	int bn_mul_mod_n,
+	int bn_mul_mod_scratch[]);
+
+int bn_sqr_mod(
+	int bn_sqr_mod_r[],
+	int bn_sqr_mod_a[],
+	int bn_sqr_mod_m[],
+	int bn_sqr_mod_n,
+	int bn_sqr_mod_scratch[]);
+
+// a, m and r have n limbs, e has en. scratch: 8n+128 limbs.
+int bn_exp_mod(
+	int bn_exp_mod_r[],
+	int bn_exp_mod_a[],
+	int bn_exp_mod_e[],
+	int bn_exp_mod_en,
+	int bn_exp_mod_m[],
+	int bn_exp_mod_n,
+	int bn_exp_mod_scratch[]);
+
+// random number of at most bits bits in n limbs; top and bottom as for rand_bits
+int bn_rand_bits(int bn_rand_bits_r[], int bn_rand_bits_n, int bn_rand_bits_bits, int bn_rand_bits_top, int bn_rand_bits_bottom);
+
+// random number r:  0 <= r < range
+int bn_rand_range(int bn_rand_range_r[], int bn_rand_range_range[], int bn_rand_range_n);
+
+// Trial division by kPrimes, then Miller-Rabin with random bases; rounds
+// follow the size table OpenSSL used before 3.0 (error below 2^-80).
+// scratch: 12n+128 limbs.
+int bn_is_prime(int bn_isp_out[1], int bn_isp_w[], int bn_isp_n, int bn_isp_scratch[]);
+
+// bits must be >=64 and <=32n; the top two bits are set.
+// scratch: 13n+128 limbs.
+int bn_generate_prime(int bn_genprime_out[], int bn_genprime_n, int bn_genprime_bits, int bn_genprime_scratch[]);
+
+#endif
@@ -0,0 +1,334 @@
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#define cmm_io_raw_read _read
+#else
+#include <unistd.h>
+#define cmm_io_raw_read read
+#endif
+
+#include "cmm_io.h"
+#include "mapped_file.h"
+
+static const int kCmmIoBufferSize = 1 << 16;
+
+static char kCmmIoOut[kCmmIoBufferSize];
+static int kCmmIoOutLen;
+
+static char kCmmIoIn[kCmmIoBufferSize];
+static int kCmmIoInPos;
+static int kCmmIoInLen;
+static int kCmmIoInFailed;
+
+static const unsigned char kCmmIoBinaryMagic[4] = { 'C', 'M', 'M', 'I' };
+static const int kCmmIoBinaryVersion = 1;
+static const int kCmmIoBinaryHeaderSize = 16;
+
+static struct MappedFile kCmmIoBinIn;
+static int kCmmIoBinInOpen;
+static unsigned long long kCmmIoBinInPos;
+static unsigned long long kCmmIoBinInCount;
+
+static FILE* kCmmIoBinOut;
+static unsigned long long kCmmIoBinOutCount;
+
+namespace
+{
+	struct CmmIoExitFlusher
+	{
+		~CmmIoExitFlusher()
+		{
+			cmm_io_flush();
+			cmm_io_close_binary_output();
+		}
+	};
+
+	// Destroyed before the C runtime closes stdout.
+	CmmIoExitFlusher kCmmIoExitFlusher;
+}
+
+static void cmm_io_put_le(unsigned char* cmm_io_put_le_p, unsigned long long cmm_io_put_le_x, int cmm_io_put_le_bytes)
+{
+	int cmm_io_put_le_i;
+
+	for (cmm_io_put_le_i = 0; cmm_io_put_le_i < cmm_io_put_le_bytes; cmm_io_put_le_i++)
+	{
+		cmm_io_put_le_p[cmm_io_put_le_i] = (unsigned char)(cmm_io_put_le_x >> (8 * cmm_io_put_le_i));
+	}
+}
+
+static unsigned long long cmm_io_get_le(const unsigned char* cmm_io_get_le_p, int cmm_io_get_le_bytes)
+{
+	unsigned long long cmm_io_get_le_x = 0;
+	int cmm_io_get_le_i;
+
+	for (cmm_io_get_le_i = cmm_io_get_le_bytes - 1; cmm_io_get_le_i >= 0; cmm_io_get_le_i--)
+	{
+		cmm_io_get_le_x = (cmm_io_get_le_x << 8) | cmm_io_get_le_p[cmm_io_get_le_i];
+	}
+
+	return cmm_io_get_le_x;
+}
+
+int cmm_io_flush()
+{
+	FILE* cmm_io_flush_target = kCmmIoBinOut ? kCmmIoBinOut : stdout;
+
+	if (kCmmIoOutLen > 0)
+	{
+		fwrite(kCmmIoOut, 1, kCmmIoOutLen, cmm_io_flush_target);
+		kCmmIoOutLen = 0;
+	}
+
+	fflush(cmm_io_flush_target);
+
+	return 0;
+}
+
+int cmm_io_failed()
+{
+	return kCmmIoInFailed;
+}
+
+int cmm_io_open_binary_input(const char* cmm_io_bin_in_path)
+{
+	struct MappedFile cmm_io_bin_in_file[1];
+	unsigned long long cmm_io_bin_in_count;
+
+	if (kCmmIoBinInOpen || !mapped_file_open(cmm_io_bin_in_file, cmm_io_bin_in_path, 0))
+	{
+		return 0;
+	}
+
+	if (cmm_io_bin_in_file[0].size < (size_t)kCmmIoBinaryHeaderSize ||
+		memcmp(cmm_io_bin_in_file[0].data, kCmmIoBinaryMagic, 4) != 0 ||
+		cmm_io_get_le(cmm_io_bin_in_file[0].data + 4, 4) != (unsigned long long)kCmmIoBinaryVersion)
+	{
+		mapped_file_close(cmm_io_bin_in_file);
+		return 0;
+	}
+
+	cmm_io_bin_in_count = cmm_io_get_le(cmm_io_bin_in_file[0].data + 8, 8);
+	if (cmm_io_bin_in_count != (cmm_io_bin_in_file[0].size - kCmmIoBinaryHeaderSize) / 4 ||
+		(cmm_io_bin_in_file[0].size - kCmmIoBinaryHeaderSize) % 4 != 0)
+	{
+		mapped_file_close(cmm_io_bin_in_file);
+		return 0;
+	}
+
+	kCmmIoBinIn = cmm_io_bin_in_file[0];
+	kCmmIoBinInOpen = 1;
+	kCmmIoBinInPos = 0;
+	kCmmIoBinInCount = cmm_io_bin_in_count;
+
+	return 1;
+}
+
+int cmm_io_close_binary_input()
+{
+	if (!kCmmIoBinInOpen)
+	{
+		return 0;
+	}
+
+	mapped_file_close(&kCmmIoBinIn);
+	kCmmIoBinInOpen = 0;
+	kCmmIoInFailed = 0;
+
+	return 1;
+}
+
+int cmm_io_open_binary_output(const char* cmm_io_bin_out_path)
+{
+	unsigned char cmm_io_bin_out_header[16];
+
+	if (kCmmIoBinOut)
+	{
+		return 0;
+	}
+
+	// Text written so far belongs to stdout.
+	cmm_io_flush();
+
+	kCmmIoBinOut = fopen(cmm_io_bin_out_path, "wb");
+	if (!kCmmIoBinOut)
+	{
+		return 0;
+	}
+
+	memcpy(cmm_io_bin_out_header, kCmmIoBinaryMagic, 4);
+	cmm_io_put_le(cmm_io_bin_out_header + 4, kCmmIoBinaryVersion, 4);
+	cmm_io_put_le(cmm_io_bin_out_header + 8, 0, 8);
+	fwrite(cmm_io_bin_out_header, 1, kCmmIoBinaryHeaderSize, kCmmIoBinOut);
+
+	kCmmIoBinOutCount = 0;
+
+	return 1;
+}
+
+int cmm_io_close_binary_output()
+{
+	unsigned char cmm_io_bin_close_count[8];
+
+	if (!kCmmIoBinOut)
+	{
+		return 0;
+	}
+
+	cmm_io_flush();
+
+	cmm_io_put_le(cmm_io_bin_close_count, kCmmIoBinOutCount, 8);
+	fseek(kCmmIoBinOut, 8, SEEK_SET);
+	fwrite(cmm_io_bin_close_count, 1, 8, kCmmIoBinOut);
+	fclose(kCmmIoBinOut);
+
+	kCmmIoBinOut = nullptr;
+
+	return 1;
+}
+
+int cmm_io_write(int cmm_io_write_x)
+{
+	// 11 chars for INT_MIN plus the newline
+	char cmm_io_write_digits[12];
+	int cmm_io_write_n = 0;
+	unsigned int cmm_io_write_u = (unsigned int)cmm_io_write_x;
+
+	if (kCmmIoOutLen > kCmmIoBufferSize - 12)
+	{
+		fwrite(kCmmIoOut, 1, kCmmIoOutLen, kCmmIoBinOut ? kCmmIoBinOut : stdout);
+		kCmmIoOutLen = 0;
+	}
+
+	if (kCmmIoBinOut)
+	{
+		cmm_io_put_le((unsigned char*)kCmmIoOut + kCmmIoOutLen, (unsigned int)cmm_io_write_x, 4);
+		kCmmIoOutLen += 4;
+		kCmmIoBinOutCount++;
+		return 0;
+	}
+
+	if (cmm_io_write_x < 0)
+	{
+		kCmmIoOut[kCmmIoOutLen++] = '-';
+		cmm_io_write_u = 0u - cmm_io_write_u;
+	}
+
+	do
+	{
+		cmm_io_write_digits[cmm_io_write_n++] = (char)('0' + cmm_io_write_u % 10);
+		cmm_io_write_u /= 10;
+	} while (cmm_io_write_u);
+
+	while (cmm_io_write_n > 0)
+	{
+		kCmmIoOut[kCmmIoOutLen++] = cmm_io_write_digits[--cmm_io_write_n];
+	}
+
+	kCmmIoOut[kCmmIoOutLen++] = '\n';
+
+	return 0;
+}
+
+// Returns the next input char without consuming it, or EOF.
+static int cmm_io_peek()
+{
+	if (kCmmIoInPos == kCmmIoInLen)
+	{
+		// Same as std::cin being tied to std::cout: a prompt written
+		// before a read must be visible before we block.
+		cmm_io_flush();
+
+		kCmmIoInPos = 0;
+		// A raw read returns whatever is available (one line on a
+		// terminal) instead of waiting for the whole buffer like fread.
+		kCmmIoInLen = (int)cmm_io_raw_read(0, kCmmIoIn, kCmmIoBufferSize);
+
+		if (kCmmIoInLen <= 0)
+		{
+			kCmmIoInLen = 0;
+			return EOF;
+		}
+	}
+
+	return (unsigned char)kCmmIoIn[kCmmIoInPos];
+}
+
+int cmm_io_read()
+{
+	int cmm_io_read_c;
+	int cmm_io_read_negative = 0;
+	int cmm_io_read_digits = 0;
+	long long cmm_io_read_value = 0;
+
+	if (kCmmIoInFailed)
+	{
+		return 0;
+	}
+
+	if (kCmmIoBinInOpen)
+	{
+		if (kCmmIoBinInPos == kCmmIoBinInCount)
+		{
+			kCmmIoInFailed = 1;
+			return 0;
+		}
+
+		return (int)(unsigned int)cmm_io_get_le(
+			kCmmIoBinIn.data + kCmmIoBinaryHeaderSize + 4 * kCmmIoBinInPos++, 4);
+	}
+
+	cmm_io_read_c = cmm_io_peek();
+	while (cmm_io_read_c == ' ' || (cmm_io_read_c >= '\t' && cmm_io_read_c <= '\r'))
+	{
+		kCmmIoInPos++;
+		cmm_io_read_c = cmm_io_peek();
+	}
+
+	if (cmm_io_read_c == '-' || cmm_io_read_c == '+')
+	{
+		cmm_io_read_negative = cmm_io_read_c == '-';
+		kCmmIoInPos++;
+		cmm_io_read_c = cmm_io_peek();
+	}
+
+	while (cmm_io_read_c >= '0' && cmm_io_read_c <= '9')
+	{
+		// Stop accumulating once out of range but keep consuming digits.
+		if (cmm_io_read_value <= 2147483648LL)
+		{
+			cmm_io_read_value = cmm_io_read_value * 10 + (cmm_io_read_c - '0');
+		}
+
+		cmm_io_read_digits++;
+		kCmmIoInPos++;
+		cmm_io_read_c = cmm_io_peek();
+	}
+
+	if (!cmm_io_read_digits)
+	{
+		kCmmIoInFailed = 1;
+		return 0;
+	}
+
+	if (cmm_io_read_negative)
+	{
+		cmm_io_read_value = -cmm_io_read_value;
+	}
+
+	if (cmm_io_read_value > 2147483647LL)
+	{
+		kCmmIoInFailed = 1;
+		return 2147483647;
+	}
+
+	if (cmm_io_read_value < -2147483647LL - 1)
+	{
+		kCmmIoInFailed = 1;
+		return -2147483647 - 1;
+	}
+
+	return (int)cmm_io_read_value;
+}
@@ -0,0 +1,43 @@
+#ifndef CMM_IO_H_
+#define CMM_IO_H_
+
+// Buffered stdin/stdout integer I/O behind the cmm read()/write() wrappers.
+// Output is collected in a large buffer and flushed when it fills up,
+// before read() has to wait for more input, and at exit. Code that mixes
+// write() with printf/std::cout must call cmm_io_flush() first.
+// Input is parsed by hand from a large buffer with the same results as
+// std::cin >> x: leading whitespace and an optional sign are accepted,
+// out-of-range values saturate to INT_MIN/INT_MAX, and once a read fails
+// (no digits or EOF) every later read returns 0. stdin is read directly
+// from file descriptor 0, so nothing else may consume it through stdio.
+
+int cmm_io_write(int cmm_io_write_x);
+
+int cmm_io_read();
+
+int cmm_io_flush();
+
+// Nonzero once a read has failed (EOF or not a number).
+int cmm_io_failed();
+
+// Binary integer streams: a 16-byte header followed by little-endian
+// int32 values.
+//   bytes 0-3   magic "CMMI"
+//   bytes 4-7   format version (1)
+//   bytes 8-15  value count (uint64)
+// The input file is memory-mapped and read() decodes values in place;
+// reading past the last value behaves like EOF. write() appends to the
+// output file, whose count is filled in by cmm_io_close_binary_output()
+// (also run at exit). Both return 0 if the file cannot be opened or the
+// input header does not match the file. Closing the input resets the
+// read failure state, so text reads continue from stdin.
+
+int cmm_io_open_binary_input(const char* cmm_io_bin_in_path);
+
+int cmm_io_open_binary_output(const char* cmm_io_bin_out_path);
+
+int cmm_io_close_binary_input();
+
+int cmm_io_close_binary_output();
+
+#endif
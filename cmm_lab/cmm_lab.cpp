@@ -1,33 +1,45 @@
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <chrono>
 #include <bitset>
 #include <random>
 
+#include "bench.h"
 #include "cmm_wrappers.h"
 #include "common.h"
 #include "util.h"
 #include "dh.h"
+#include "dh_param_store.h"
+#include "fuzz_diff.h"
+#include "metrics.h"
 #include "rsa.h"
+#include "safe_prime_table.h"
+#include "trace.h"
 
 using namespace std;
 
-int main()
+static string kDhParamCachePath = "dh_params.cache";
+static int kRegenerateParams = 0;
+static string kTracePath;
+static string kMetricsPath;
+
+static int run_elgamal_demo()
 {
 	DH dh;
-
-	init_two_powers();
-	init_primes();
+	int cached[1];
 
 	srand32(time(nullptr));
 
-	if (!dh_generate_paremeters(&dh, 31, 2))
+	if (!dh_generate_paremeters_cached(&dh, cached, kDhParamCachePath.c_str(), 31, 2, kRegenerateParams))
 	{
 		cout << "paramgen error" << endl;
 		return 1;
 	}
 
+	printf("Params(%s): p=%d q=%d g=%d\n", cached[0] ? "cached" : "generated", dh.params.p, dh.params.q, dh.params.g);
+
 	if (!dh_generate_key(&dh))
 	{
 		cout << "keygen error" << endl;
@@ -57,4 +69,218 @@ int main()
 	printf("Decrypted=%d\n", dec[0]);
 
 	return 0;
+}
+
+// Copies integers from read() to write() until input ends; together with
+// --bin-in/--bin-out this converts between text and binary streams.
+static int run_copy_ints()
+{
+	int x = read();
+
+	while (!cmm_io_failed())
+	{
+		write(x);
+		x = read();
+	}
+
+	return 0;
+}
+
+// registered with atexit so every command's return path writes the trace
+static void write_trace()
+{
+	if (!trace_write_chrome(kTracePath.c_str()))
+	{
+		cout << "cannot write trace " << kTracePath << endl;
+	}
+}
+
+static void write_metrics()
+{
+	if (!metrics_dump(kMetricsPath.c_str()))
+	{
+		cout << "cannot write metrics " << kMetricsPath << endl;
+	}
+}
+
+// Usage: cmm_lab [options] [command [args...]]
+// Options:
+//   --bin-in file     serve read() from a binary int32 stream
+//   --bin-out file    send write() to a binary int32 stream
+//   --dh-cache file   DH parameter cache (default dh_params.cache)
+//   --regen-params    ignore cached DH parameters and regenerate them
+//   --fast-params     take DH primes from the embedded safe prime table
+//   --trace file      record spans and write them as Chrome trace JSON
+//   --metrics file    on exit, write latency percentiles of the RSA, DH and
+//                     ElGamal entry points (see metrics.h) in Prometheus
+//                     text format (- for stdout)
+int main(int argc, char* argv[])
+{
+	int arg = 1;
+
+	init_two_powers();
+	init_primes();
+
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		string option = argv[arg];
+
+		if (option == "--regen-params")
+		{
+			kRegenerateParams = 1;
+			arg = arg + 1;
+			continue;
+		}
+
+		if (option == "--fast-params")
+		{
+			dh_set_fast_paremeters(1);
+			arg = arg + 1;
+			continue;
+		}
+
+		if (arg + 1 >= argc)
+		{
+			cout << "missing value for " << option << endl;
+			return 1;
+		}
+
+		if (option == "--bin-in")
+		{
+			if (!cmm_io_open_binary_input(argv[arg + 1]))
+			{
+				cout << "cannot open binary input " << argv[arg + 1] << endl;
+				return 1;
+			}
+		}
+		else if (option == "--bin-out")
+		{
+			if (!cmm_io_open_binary_output(argv[arg + 1]))
+			{
+				cout << "cannot open binary output " << argv[arg + 1] << endl;
+				return 1;
+			}
+		}
+		else if (option == "--dh-cache")
+		{
+			kDhParamCachePath = argv[arg + 1];
+		}
+		else if (option == "--trace")
+		{
+			if (kTracePath.empty())
+			{
+				atexit(write_trace);
+			}
+
+			kTracePath = argv[arg + 1];
+			trace_enable(1);
+		}
+		else if (option == "--metrics")
+		{
+			if (kMetricsPath.empty())
+			{
+				atexit(write_metrics);
+			}
+
+			kMetricsPath = argv[arg + 1];
+		}
+		else
+		{
+			cout << "unknown option: " << option << endl;
+			return 1;
+		}
+
+		arg = arg + 2;
+	}
+
+	if (arg < argc)
+	{
+		string command = argv[arg];
+
+		if (command == "bench-io")
+		{
+			return bench_io(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-rsa-layout")
+		{
+			return bench_rsa_layout(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-exp-mod-batch")
+		{
+			return bench_exp_mod_batch(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-keygen-pipeline")
+		{
+			return bench_keygen_pipeline(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-keygen-async")
+		{
+			return bench_keygen_async(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-elgamal-pool")
+		{
+			return bench_elgamal_pool(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-rsa-multi")
+		{
+			return bench_rsa_multi(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-rsa-verify")
+		{
+			return bench_rsa_verify(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-crypto64")
+		{
+			return bench_crypto64(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-bignum")
+		{
+			return bench_bignum(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-bignum-mul")
+		{
+			return bench_bignum_mul(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-modint")
+		{
+			return bench_modint(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-limb-core")
+		{
+			return bench_limb_core(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-branchless")
+		{
+			return bench_branchless(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-ct")
+		{
+			return bench_ct(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-suite")
+		{
+			return bench_suite(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "bench-profile")
+		{
+			return bench_profile(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "fuzz-diff")
+		{
+			return fuzz_diff(argc - arg - 1, argv + arg + 1);
+		}
+		else if (command == "copy-ints")
+		{
+			return run_copy_ints();
+		}
+		else if (command == "gen-safe-prime-table")
+		{
+			return !safe_prime_table_generate(stdout);
+		}
+
+		cout << "unknown command: " << command << endl;
+		return 1;
+	}
+
+	return run_elgamal_demo();
 }
\ No newline at end of file
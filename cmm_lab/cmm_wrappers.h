@@ -1,18 +1,16 @@
 #ifndef CMM_WRAPPERS_H_
 #define CMM_WRAPPERS_H_
 
-#include <iostream>
+#include "cmm_io.h"
 
 inline void write(int x)
 {
-	std::cout << x << std::endl;
+	cmm_io_write(x);
 }
 
 inline int read()
 {
-	int x = 0;
-	std::cin >> x;
-	return x;
+	return cmm_io_read();
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -1,6 +1,8 @@
 #include "common.h"
 
-static int kNext;
+// Each thread draws from its own stream; worker threads must call srand32
+// before their first rand32.
+static thread_local int kNext;
 
 int mod(int mod_x, int mod_y)
 {
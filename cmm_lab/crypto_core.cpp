@@ -1,6 +1,11 @@
 #include "crypto_core.h"
+#include "profile.h"
+#include "trace.h"
 
-static int kPrimes[64];
+int kPrimes[64];
+
+// Polled by generate_prime before each candidate; set per thread.
+static thread_local int (*kGeneratePrimeAbort)() = nullptr;
 
 int init_primes()
 {
@@ -74,6 +79,8 @@ int init_primes()
 
 int is_bit_set(int is_bit_set_x, int is_bit_set_n)
 {
+	PROFILE_CALL("is_bit_set");
+
 	if (is_bit_set_n < 0 || is_bit_set_n >= 32)
 	{
 		return 0;
@@ -86,6 +93,8 @@ int is_bit_set(int is_bit_set_x, int is_bit_set_n)
 
 int mul_mod(int mul_mod_a, int mul_mod_b, int mul_mod_p)
 {
+	PROFILE_CALL("mul_mod");
+
 	int mul_mod_temp64[2], mul_mod_p64[2];
 
 	mul_mod_p64[0] = 0;
@@ -99,6 +108,9 @@ int mul_mod(int mul_mod_a, int mul_mod_b, int mul_mod_p)
 
 int exp_mod(int exp_mod_a, int exp_mod_b, int exp_mod_p)
 {
+	PROFILE_CALL("exp_mod");
+	TRACE_SPAN("exp_mod");
+
 	int exp_mod_i;
 	int exp_mod_prod64[2], exp_mod_a64[2], exp_mod_p64[2];
 
@@ -113,6 +125,8 @@ int exp_mod(int exp_mod_a, int exp_mod_b, int exp_mod_p)
 
 	while (exp_mod_b)
 	{
+		PROFILE_LOOP("exp_mod");
+
 		if (mod(exp_mod_b, 2))
 		{
 			mul_uint64(exp_mod_prod64, exp_mod_prod64, exp_mod_a64);
@@ -130,6 +144,8 @@ int exp_mod(int exp_mod_a, int exp_mod_b, int exp_mod_p)
 
 int nnmod(int nnmod_a, int nnmod_b)
 {
+	PROFILE_CALL("nnmod");
+
 	int nnmod_m = mod(nnmod_a, nnmod_b);
 	if (nnmod_m < 0)
 	{
@@ -151,6 +167,9 @@ int nnmod(int nnmod_a, int nnmod_b)
 // Return 0 if no inv
 int inverse_mod(int invmod_inv[1], int invmod_a, int invmod_n)
 {
+	PROFILE_CALL("inverse_mod");
+	TRACE_SPAN("inverse_mod");
+
 	int invmod_A,
 		invmod_B,
 		invmod_X,
@@ -189,6 +208,8 @@ int inverse_mod(int invmod_inv[1], int invmod_a, int invmod_n)
 
 	while (invmod_B)
 	{
+		PROFILE_LOOP("inverse_mod");
+
 		invmod_abits = get_bits_uint32(invmod_A);
 		invmod_bbits = get_bits_uint32(invmod_B);
 
@@ -288,6 +309,8 @@ int inverse_mod(int invmod_inv[1], int invmod_a, int invmod_n)
 
 int rand_bits(int rand_bits_n, int rand_bits_top, int rand_bits_bottom)
 {
+	PROFILE_CALL("rand_bits");
+
 	int rand_bits_result = rand32();
 
 	if (rand_bits_n <= 0)
@@ -327,6 +350,8 @@ int rand_bits(int rand_bits_n, int rand_bits_top, int rand_bits_bottom)
 // random number r:  0 <= r < range
 int rand_range(int rand_range_out[1], int rand_range_range)
 {
+	PROFILE_CALL("rand_range");
+
 	int rand_range_n;
 	int rand_range_count = 100;
 	int rand_range_result;
@@ -347,6 +372,8 @@ int rand_range(int rand_range_out[1], int rand_range_range)
 	{
 		while (1)
 		{
+			PROFILE_LOOP("rand_range");
+
 			rand_range_result = rand_bits(rand_range_n + 1, 0, 0);
 			if (cmp_uint32(rand_range_result, rand_range_range) >= 0)
 			{
@@ -375,6 +402,8 @@ int rand_range(int rand_range_out[1], int rand_range_range)
 	{
 		while (1)
 		{
+			PROFILE_LOOP("rand_range");
+
 			rand_range_result = rand_bits(rand_range_n, 0, 0);
 			if (cmp_uint32(rand_range_result, rand_range_range) < 0)
 			{
@@ -398,6 +427,8 @@ int rand_range(int rand_range_out[1], int rand_range_range)
 // w must be >2 and odd
 int miller_rabin_is_prime(int mr_out[1], int mr_w, int mr_iterations)
 {
+	PROFILE_CALL("miller_rabin_is_prime");
+
 	int mr_i, mr_j, mr_a;
 	int mr_w1, mr_w3, mr_x, mr_m, mr_z, mr_b;
 	int mr_temp[1];
@@ -426,6 +457,8 @@ int miller_rabin_is_prime(int mr_out[1], int mr_w, int mr_iterations)
 	mr_m = mr_w1 / 2;
 	while (mod(mr_m, 2) == 0)
 	{
+		PROFILE_LOOP("miller_rabin_is_prime");
+
 		mr_a = mr_a + 1;
 		mr_m = mr_m / 2;
 	}
@@ -434,6 +467,9 @@ int miller_rabin_is_prime(int mr_out[1], int mr_w, int mr_iterations)
 	mr_i = 0;
 	while (mr_i < mr_iterations)
 	{
+		PROFILE_LOOP("miller_rabin_is_prime");
+		TRACE_SPAN("miller-rabin round");
+
 		goto_outer_loop = 0;
 
 		// (Step 4.1) obtain a Random string of bits b where 1 < b < w-1
@@ -459,6 +495,8 @@ int miller_rabin_is_prime(int mr_out[1], int mr_w, int mr_iterations)
 			mr_j = 1;
 			while (!goto_outer_loop && mr_j < mr_a)
 			{
+				PROFILE_LOOP("miller_rabin_is_prime");
+
 				// (Step 4.7.1 - 4.7.2) x = z. z = x^2 mod w
 				mr_x = mr_z;
 				mr_z = mul_mod(mr_x, mr_x, mr_w);
@@ -520,6 +558,8 @@ int is_prime(
 	int is_prime_w,
 	int is_prime_do_trial_division)
 {
+	PROFILE_CALL("is_prime");
+
 	int is_prime_i;
 
 	// w must be bigger than 1
@@ -551,6 +591,8 @@ int is_prime(
 		is_prime_i = 1;
 		while (is_prime_i < 64)
 		{
+			PROFILE_LOOP("is_prime");
+
 			if (mod(is_prime_w, kPrimes[is_prime_i]) == 0)
 			{
 				is_prime_out[0] = (is_prime_w == kPrimes[is_prime_i]);
@@ -569,9 +611,96 @@ int is_prime(
 	return 1;
 }
 
+// Return 1 if base b proves w composite.
+// w must be odd and >3, interpreted as uint32
+int miller_rabin_witness(int mrw_w, int mrw_b)
+{
+	PROFILE_CALL("miller_rabin_witness");
+	TRACE_SPAN("miller-rabin round");
+
+	int mrw_a, mrw_m, mrw_z, mrw_w1;
+
+	mrw_b = mod_uint32(mrw_b, mrw_w);
+	if (mrw_b == 0)
+	{
+		return 0;
+	}
+
+	mrw_w1 = mrw_w - 1;
+
+	mrw_a = 1;
+	mrw_m = rshift_uint32(mrw_w1, 1);
+	while (mod_uint32(mrw_m, 2) == 0)
+	{
+		PROFILE_LOOP("miller_rabin_witness");
+
+		mrw_a = mrw_a + 1;
+		mrw_m = rshift_uint32(mrw_m, 1);
+	}
+
+	mrw_z = exp_mod(mrw_b, mrw_m, mrw_w);
+	if (mrw_z == 1 || mrw_z == mrw_w1)
+	{
+		return 0;
+	}
+
+	while (mrw_a > 1)
+	{
+		PROFILE_LOOP("miller_rabin_witness");
+
+		mrw_z = mul_mod(mrw_z, mrw_z, mrw_w);
+		if (mrw_z == mrw_w1)
+		{
+			return 0;
+		}
+
+		mrw_a = mrw_a - 1;
+	}
+
+	return 1;
+}
+
+// Deterministic for every uint32 w: bases 2, 7 and 61 have no common
+// strong pseudoprime below 4759123141.
+int is_prime_deterministic(int ispd_out[1], int ispd_w)
+{
+	PROFILE_CALL("is_prime_deterministic");
+
+	if (cmp_uint32(ispd_w, 2) < 0)
+	{
+		ispd_out[0] = 0;
+		return 1;
+	}
+
+	if (ispd_w == 2 || ispd_w == 3 || ispd_w == 7 || ispd_w == 61)
+	{
+		ispd_out[0] = 1;
+		return 1;
+	}
+
+	if (mod_uint32(ispd_w, 2) == 0)
+	{
+		ispd_out[0] = 0;
+		return 1;
+	}
+
+	ispd_out[0] = 1;
+
+	if (miller_rabin_witness(ispd_w, 2) ||
+		miller_rabin_witness(ispd_w, 7) ||
+		miller_rabin_witness(ispd_w, 61))
+	{
+		ispd_out[0] = 0;
+	}
+
+	return 1;
+}
+
 // bits must be >0 and <=31
 int probable_prime(int pp_out[1], int pp_bits, int pp_safe, int pp_mods[64])
 {
+	PROFILE_CALL("probable_prime");
+
 	int pp_i;
 
 	int pp_goto_again = 1;
@@ -616,6 +745,9 @@ int probable_prime(int pp_out[1], int pp_bits, int pp_safe, int pp_mods[64])
 	pp_goto_again = 1;
 	while (pp_goto_again)
 	{
+		PROFILE_LOOP("probable_prime");
+		TraceSpan pp_draw_span("candidate draw");
+
 		pp_goto_again = 0;
 
 		pp_rnd = rand_bits(pp_bits, 2, 1);
@@ -628,9 +760,14 @@ int probable_prime(int pp_out[1], int pp_bits, int pp_safe, int pp_mods[64])
 		pp_rnd_64[0] = 0;
 		pp_rnd_64[1] = pp_rnd;
 
+		pp_draw_span.end();
+		TraceSpan pp_sieve_span("sieve");
+
 		pp_i = 1;
 		while (pp_i < pp_trial_divisions)
 		{
+			PROFILE_LOOP("probable_prime");
+
 			pp_mods[pp_i] = mod(pp_rnd, kPrimes[pp_i]);
 
 			pp_i = pp_i + 1;
@@ -643,6 +780,8 @@ int probable_prime(int pp_out[1], int pp_bits, int pp_safe, int pp_mods[64])
 		pp_goto_loop = 1;
 		while (!pp_goto_again && pp_goto_loop)
 		{
+			PROFILE_LOOP("probable_prime");
+
 			pp_goto_loop = 0;
 
 			pp_i = 1;
@@ -650,6 +789,8 @@ int probable_prime(int pp_out[1], int pp_bits, int pp_safe, int pp_mods[64])
 			pp_loop_td = 1;
 			while (!pp_goto_loop && !pp_goto_again && pp_loop_td && pp_i < pp_trial_divisions)
 			{
+				PROFILE_LOOP("probable_prime");
+
 				/*
 				 * check that rnd is a prime and also that
 				 * gcd(rnd-1,primes) == 1 (except for 2)
@@ -737,6 +878,8 @@ int probable_prime_dh(
 	int ppdh_add,
 	int ppdh_rem)
 {
+	PROFILE_CALL("probable_prime_dh");
+
 	int ppdh_i;
 
 	int ppdh_goto_again = 1;
@@ -793,6 +936,9 @@ int probable_prime_dh(
 	ppdh_goto_again = 1;
 	while (ppdh_goto_again)
 	{
+		PROFILE_LOOP("probable_prime_dh");
+		TraceSpan ppdh_draw_span("candidate draw");
+
 		ppdh_goto_again = 0;
 
 		ppdh_rnd = rand_bits(ppdh_bits, 1, 1);
@@ -827,9 +973,14 @@ int probable_prime_dh(
 		ppdh_rnd_64[0] = 0;
 		ppdh_rnd_64[1] = ppdh_rnd;
 
+		ppdh_draw_span.end();
+		TraceSpan ppdh_sieve_span("sieve");
+
 		ppdh_i = 1;
 		while (ppdh_i < ppdh_trial_divisions)
 		{
+			PROFILE_LOOP("probable_prime_dh");
+
 			ppdh_mods[ppdh_i] = mod(ppdh_rnd, kPrimes[ppdh_i]);
 
 			ppdh_i = ppdh_i + 1;
@@ -842,12 +993,16 @@ int probable_prime_dh(
 		ppdh_goto_loop = 1;
 		while (!ppdh_goto_again && ppdh_goto_loop)
 		{
+			PROFILE_LOOP("probable_prime_dh");
+
 			ppdh_goto_loop = 0;
 
 			ppdh_i = 1;
 			ppdh_loop_td = 1;
 			while (!ppdh_goto_loop && !ppdh_goto_again && ppdh_loop_td && ppdh_i < ppdh_trial_divisions)
 			{
+				PROFILE_LOOP("probable_prime_dh");
+
 				/*
 				 * check that rnd is a prime and also that
 				 * gcd(rnd-1,primes) == 1 (except for 2)
@@ -915,6 +1070,12 @@ int probable_prime_dh(
 	return 1;
 }
 
+int set_generate_prime_abort(int (*set_genprime_abort_hook)())
+{
+	kGeneratePrimeAbort = set_genprime_abort_hook;
+	return 0;
+}
+
 // bits must be >=2 and <=31; add and rem must be either positive or -1
 int generate_prime(
 	int genprime_out[1],
@@ -923,6 +1084,9 @@ int generate_prime(
 	int genprime_add,
 	int genprime_rem)
 {
+	PROFILE_CALL("generate_prime");
+	TRACE_SPAN_ARG(genprime_safe ? "generate_prime (safe)" : "generate_prime", "bits", genprime_bits);
+
 	int genprime_found = 0;
 	int genprime_t;
 	int genprime_i;
@@ -949,8 +1113,16 @@ int generate_prime(
 	genprime_goto_loop = 1;
 	while (genprime_goto_loop)
 	{
+		PROFILE_LOOP("generate_prime");
+		TraceSpan genprime_attempt_span("prime attempt");
+
 		genprime_goto_loop = 0;
 
+		if (kGeneratePrimeAbort != nullptr && kGeneratePrimeAbort())
+		{
+			return 0;
+		}
+
 		if (genprime_add == -1)
 		{
 			if (!probable_prime(genprime_out, genprime_bits, genprime_safe, genprime_mods))
@@ -985,6 +1157,8 @@ int generate_prime(
 			genprime_i = 0;
 			while (!genprime_goto_loop && genprime_i < genprime_checks)
 			{
+				PROFILE_LOOP("generate_prime");
+
 				if (!is_prime(genprime_is_prime_out, 1, genprime_out[0], 0))
 				{
 					return 0;
@@ -1032,6 +1206,8 @@ int ffc_generate_privkey(
 	int ffc_genprivkey_q,
 	int ffc_genprivkey_n)
 {
+	PROFILE_CALL("ffc_generate_privkey");
+
 	int ffc_genprivkey_qbits = get_bits_uint32(ffc_genprivkey_q);
 	int ffc_genprivkey_two_power_n, ffc_genprivkey_m;
 
@@ -1063,6 +1239,8 @@ int ffc_generate_privkey(
 
 	while (1)
 	{
+		PROFILE_LOOP("ffc_generate_privkey");
+
 		if (!rand_range(ffc_genprivkey_privkey_out, ffc_genprivkey_two_power_n))
 		{
 			return 0;
@@ -5,6 +5,8 @@
 #include "unsigned_op.h"
 #include "common.h"
 
+extern int kPrimes[64]; // the first 64 primes
+
 struct FFCParams
 {
 	int g;
@@ -32,6 +34,8 @@ int is_prime(
 	int is_prime_checks,
 	int is_prime_w,
 	int is_prime_do_trial_division);
+int miller_rabin_witness(int mrw_w, int mrw_b);
+int is_prime_deterministic(int ispd_out[1], int ispd_w);
 int probable_prime(int pp_out[1], int pp_bits, int pp_safe, int pp_mods[64]);
 int probable_prime_dh(
 	int ppdh_out[1],
@@ -40,6 +44,9 @@ int probable_prime_dh(
 	int ppdh_mods[64],
 	int ppdh_add,
 	int ppdh_rem);
+// hook (or nullptr) for the calling thread; when it returns nonzero,
+// generate_prime gives up and returns 0
+int set_generate_prime_abort(int (*set_genprime_abort_hook)());
 int generate_prime(
 	int genprime_out[1],
 	int genprime_bits,
@@ -0,0 +1,421 @@
+#include "crypto_core64.h"
+
+// a mod p for a small positive p, one 32-bit word at a time
+static int mod_small_uint64(int mod_small64_a[2], int mod_small64_p)
+{
+	// 2^32 mod p
+	int mod_small64_r32 = mod(mod_uint32(-1, mod_small64_p) + 1, mod_small64_p);
+
+	return mod(
+		mod_uint32(mod_small64_a[0], mod_small64_p) * mod_small64_r32 +
+			mod_uint32(mod_small64_a[1], mod_small64_p),
+		mod_small64_p);
+}
+
+int mul_mod_uint64(int mul_mod64_out[2], int mul_mod64_a[2], int mul_mod64_b[2], int mul_mod64_p[2])
+{
+	int mul_mod64_hi[2], mul_mod64_lo[2];
+
+	mul_full_uint64(mul_mod64_hi, mul_mod64_lo, mul_mod64_a, mul_mod64_b);
+	mod_uint128(mul_mod64_out, mul_mod64_hi, mul_mod64_lo, mul_mod64_p);
+
+	return 0;
+}
+
+int exp_mod_uint64(int exp_mod64_out[2], int exp_mod64_a[2], int exp_mod64_b[2], int exp_mod64_p[2])
+{
+	int exp_mod64_prod[2], exp_mod64_base[2], exp_mod64_e[2];
+
+	exp_mod64_prod[0] = 0;
+	exp_mod64_prod[1] = 1;
+
+	exp_mod64_e[0] = exp_mod64_b[0];
+	exp_mod64_e[1] = exp_mod64_b[1];
+
+	// mod_uint128 needs both factors reduced
+	mod_uint64(exp_mod64_base, exp_mod64_a, exp_mod64_p);
+
+	while (exp_mod64_e[0] || exp_mod64_e[1])
+	{
+		if (mod_uint32(exp_mod64_e[1], 2))
+		{
+			mul_mod_uint64(exp_mod64_prod, exp_mod64_prod, exp_mod64_base, exp_mod64_p);
+		}
+
+		rshift_uint64(exp_mod64_e, exp_mod64_e, 1);
+
+		mul_mod_uint64(exp_mod64_base, exp_mod64_base, exp_mod64_base, exp_mod64_p);
+	}
+
+	exp_mod64_out[0] = exp_mod64_prod[0];
+	exp_mod64_out[1] = exp_mod64_prod[1];
+
+	return 0;
+}
+
+// Extended Euclid keeping only the coefficient of a, reduced mod n so it
+// never goes negative.
+int inverse_mod_uint64(int invmod64_inv[2], int invmod64_a[2], int invmod64_n[2])
+{
+	int invmod64_r0[2], invmod64_r1[2], invmod64_r2[2];
+	int invmod64_t0[2], invmod64_t1[2], invmod64_t2[2];
+	int invmod64_quot[2], invmod64_qt[2];
+
+	if (invmod64_n[0] == 0 && invmod64_n[1] == 0)
+	{
+		return 0;
+	}
+
+	invmod64_r0[0] = invmod64_n[0];
+	invmod64_r0[1] = invmod64_n[1];
+	mod_uint64(invmod64_r1, invmod64_a, invmod64_n);
+
+	invmod64_t0[0] = 0;
+	invmod64_t0[1] = 0;
+	invmod64_t1[0] = 0;
+	invmod64_t1[1] = 1;
+	mod_uint64(invmod64_t1, invmod64_t1, invmod64_n);
+
+	while (invmod64_r1[0] || invmod64_r1[1])
+	{
+		div_mod_uint64(invmod64_quot, invmod64_r2, invmod64_r0, invmod64_r1);
+
+		// t2 = t0 - quot * t1 (mod n)
+		mod_uint64(invmod64_quot, invmod64_quot, invmod64_n);
+		mul_mod_uint64(invmod64_qt, invmod64_quot, invmod64_t1, invmod64_n);
+		if (cmp_uint64(invmod64_t0, invmod64_qt) >= 0)
+		{
+			sub_uint64(invmod64_t2, invmod64_t0, invmod64_qt);
+		}
+		else
+		{
+			sub_uint64(invmod64_t2, invmod64_n, invmod64_qt);
+			add_uint64(invmod64_t2, invmod64_t2, invmod64_t0);
+		}
+
+		invmod64_r0[0] = invmod64_r1[0];
+		invmod64_r0[1] = invmod64_r1[1];
+		invmod64_r1[0] = invmod64_r2[0];
+		invmod64_r1[1] = invmod64_r2[1];
+
+		invmod64_t0[0] = invmod64_t1[0];
+		invmod64_t0[1] = invmod64_t1[1];
+		invmod64_t1[0] = invmod64_t2[0];
+		invmod64_t1[1] = invmod64_t2[1];
+	}
+
+	// gcd(a, n) must be 1
+	if (invmod64_r0[0] != 0 || invmod64_r0[1] != 1)
+	{
+		return 0;
+	}
+
+	invmod64_inv[0] = invmod64_t0[0];
+	invmod64_inv[1] = invmod64_t0[1];
+
+	return 1;
+}
+
+int rand_range_uint64(int rand_range64_out[2], int rand_range64_range[2])
+{
+	int rand_range64_n = get_bits_uint64(rand_range64_range);
+	int rand_range64_result[2];
+
+	if (rand_range64_n == 0)
+	{
+		return 0;
+	}
+
+	// draw n-bit numbers until one is in range; at least half of them are
+	while (1)
+	{
+		if (rand_range64_n > 32)
+		{
+			rand_range64_result[0] = rand_bits(rand_range64_n - 32, 0, 0);
+			rand_range64_result[1] = rand32();
+		}
+		else
+		{
+			rand_range64_result[0] = 0;
+			rand_range64_result[1] = rand_bits(rand_range64_n, 0, 0);
+		}
+
+		if (cmp_uint64(rand_range64_result, rand_range64_range) < 0)
+		{
+			rand_range64_out[0] = rand_range64_result[0];
+			rand_range64_out[1] = rand_range64_result[1];
+			return 1;
+		}
+	}
+}
+
+int is_prime_uint64(int isp64_out[1], int isp64_w[2])
+{
+	int isp64_bases[7];
+	int isp64_i, isp64_j, isp64_s;
+	int isp64_w1[2], isp64_d[2], isp64_base[2], isp64_z[2];
+	int isp64_one[2];
+	int isp64_witness;
+
+	if (isp64_w[0] == 0)
+	{
+		return is_prime_deterministic(isp64_out, isp64_w[1]);
+	}
+
+	// w > 2^32, above every trial divisor
+	isp64_i = 0;
+	while (isp64_i < 64)
+	{
+		if (mod_small_uint64(isp64_w, kPrimes[isp64_i]) == 0)
+		{
+			isp64_out[0] = 0;
+			return 1;
+		}
+
+		isp64_i = isp64_i + 1;
+	}
+
+	isp64_bases[0] = 2;
+	isp64_bases[1] = 325;
+	isp64_bases[2] = 9375;
+	isp64_bases[3] = 28178;
+	isp64_bases[4] = 450775;
+	isp64_bases[5] = 9780504;
+	isp64_bases[6] = 1795265022;
+
+	isp64_one[0] = 0;
+	isp64_one[1] = 1;
+
+	// w-1 = d * 2^s
+	sub_uint64(isp64_w1, isp64_w, isp64_one);
+	isp64_d[0] = isp64_w1[0];
+	isp64_d[1] = isp64_w1[1];
+	isp64_s = 0;
+	while (mod_uint32(isp64_d[1], 2) == 0)
+	{
+		rshift_uint64(isp64_d, isp64_d, 1);
+		isp64_s = isp64_s + 1;
+	}
+
+	isp64_out[0] = 1;
+
+	isp64_i = 0;
+	while (isp64_out[0] && isp64_i < 7)
+	{
+		isp64_base[0] = 0;
+		isp64_base[1] = isp64_bases[isp64_i];
+
+		exp_mod_uint64(isp64_z, isp64_base, isp64_d, isp64_w);
+
+		if (cmp_uint64(isp64_z, isp64_one) != 0 && cmp_uint64(isp64_z, isp64_w1) != 0)
+		{
+			isp64_witness = 1;
+
+			isp64_j = 1;
+			while (isp64_witness && isp64_j < isp64_s)
+			{
+				mul_mod_uint64(isp64_z, isp64_z, isp64_z, isp64_w);
+
+				if (cmp_uint64(isp64_z, isp64_w1) == 0)
+				{
+					isp64_witness = 0;
+				}
+
+				isp64_j = isp64_j + 1;
+			}
+
+			if (isp64_witness)
+			{
+				isp64_out[0] = 0;
+			}
+		}
+
+		isp64_i = isp64_i + 1;
+	}
+
+	return 1;
+}
+
+int generate_prime_uint64(
+	int genprime64_out[2],
+	int genprime64_bits,
+	int genprime64_safe,
+	int genprime64_add,
+	int genprime64_rem)
+{
+	int genprime64_mods[64];
+	int genprime64_rnd[2], genprime64_cand[2], genprime64_q[2], genprime64_delta64[2];
+	int genprime64_is_prime[1];
+	int genprime64_step, genprime64_delta, genprime64_max_delta;
+	int genprime64_i, genprime64_r;
+	int genprime64_sieved;
+	int genprime64_goto_again = 1;
+
+	if (genprime64_bits < 2 || genprime64_bits > 62)
+	{
+		return 0;
+	}
+
+	if (genprime64_bits <= 31)
+	{
+		genprime64_out[0] = 0;
+		return generate_prime(
+			&genprime64_out[1], genprime64_bits, genprime64_safe, genprime64_add, genprime64_rem);
+	}
+
+	if (genprime64_add == -1)
+	{
+		// safe primes are 3 mod 4 so that q is odd
+		if (genprime64_safe)
+		{
+			genprime64_step = 4;
+		}
+		else
+		{
+			genprime64_step = 2;
+		}
+	}
+	else if (genprime64_add <= 0 || genprime64_rem < 0 || genprime64_rem >= genprime64_add)
+	{
+		return 0;
+	}
+	else
+	{
+		genprime64_step = genprime64_add;
+	}
+
+	genprime64_max_delta = kTwoPowers[24];
+
+	// again:
+	while (genprime64_goto_again)
+	{
+		genprime64_goto_again = 0;
+
+		// top two bits set, odd
+		if (genprime64_bits == 32)
+		{
+			genprime64_rnd[0] = 0;
+			genprime64_rnd[1] = rand_bits(32, 2, 1);
+		}
+		else if (genprime64_bits == 33)
+		{
+			genprime64_rnd[0] = 1;
+			genprime64_rnd[1] = rand_bits(32, 1, 1);
+		}
+		else
+		{
+			genprime64_rnd[0] = rand_bits(genprime64_bits - 32, 2, 0);
+			genprime64_rnd[1] = rand_bits(32, 0, 1);
+		}
+
+		if (genprime64_add == -1)
+		{
+			if (genprime64_safe && mod_uint32(rshift_uint32(genprime64_rnd[1], 1), 2) == 0)
+			{
+				genprime64_rnd[1] = genprime64_rnd[1] + 2;
+			}
+		}
+		else
+		{
+			// rnd = rnd - (rnd mod add) + rem, which keeps the top bits
+			genprime64_delta64[0] = 0;
+			genprime64_delta64[1] = mod_small_uint64(genprime64_rnd, genprime64_add);
+			sub_uint64(genprime64_rnd, genprime64_rnd, genprime64_delta64);
+			genprime64_delta64[1] = genprime64_rem;
+			add_uint64(genprime64_rnd, genprime64_rnd, genprime64_delta64);
+		}
+
+		genprime64_i = 1;
+		while (genprime64_i < 64)
+		{
+			genprime64_mods[genprime64_i] = mod_small_uint64(genprime64_rnd, kPrimes[genprime64_i]);
+			genprime64_i = genprime64_i + 1;
+		}
+
+		genprime64_delta = 0;
+		while (!genprime64_goto_again)
+		{
+			// candidates divisible by a small prime (or, for safe primes,
+			// whose q is) never reach Miller-Rabin
+			genprime64_sieved = 0;
+			genprime64_i = 1;
+			while (!genprime64_sieved && genprime64_i < 64)
+			{
+				genprime64_r = mod(
+					genprime64_mods[genprime64_i] + mod(genprime64_delta, kPrimes[genprime64_i]),
+					kPrimes[genprime64_i]);
+
+				if (genprime64_r == 0 || (genprime64_safe && genprime64_r == 1))
+				{
+					genprime64_sieved = 1;
+				}
+
+				genprime64_i = genprime64_i + 1;
+			}
+
+			if (!genprime64_sieved)
+			{
+				genprime64_delta64[0] = 0;
+				genprime64_delta64[1] = genprime64_delta;
+				add_uint64(genprime64_cand, genprime64_rnd, genprime64_delta64);
+
+				if (get_bits_uint64(genprime64_cand) != genprime64_bits)
+				{
+					genprime64_goto_again = 1;
+				}
+				else
+				{
+					is_prime_uint64(genprime64_is_prime, genprime64_cand);
+
+					if (genprime64_is_prime[0] && genprime64_safe)
+					{
+						rshift_uint64(genprime64_q, genprime64_cand, 1);
+						is_prime_uint64(genprime64_is_prime, genprime64_q);
+					}
+
+					if (genprime64_is_prime[0])
+					{
+						genprime64_out[0] = genprime64_cand[0];
+						genprime64_out[1] = genprime64_cand[1];
+						return 1;
+					}
+				}
+			}
+
+			genprime64_delta = genprime64_delta + genprime64_step;
+			if (genprime64_delta > genprime64_max_delta)
+			{
+				genprime64_goto_again = 1;
+			}
+		}
+
+		genprime64_goto_again = 1;
+	}
+
+	return 0;
+}
+
+int ffc_generate_privkey_uint64(int ffc_genprivkey64_privkey_out[2], int ffc_genprivkey64_q[2])
+{
+	int ffc_genprivkey64_range[2];
+	int ffc_genprivkey64_one[2];
+
+	ffc_genprivkey64_one[0] = 0;
+	ffc_genprivkey64_one[1] = 1;
+
+	if (get_bits_uint64(ffc_genprivkey64_q) < 2)
+	{
+		return 0;
+	}
+
+	sub_uint64(ffc_genprivkey64_range, ffc_genprivkey64_q, ffc_genprivkey64_one);
+
+	if (!rand_range_uint64(ffc_genprivkey64_privkey_out, ffc_genprivkey64_range))
+	{
+		return 0;
+	}
+
+	add_uint64(ffc_genprivkey64_privkey_out, ffc_genprivkey64_privkey_out, ffc_genprivkey64_one);
+
+	return 1;
+}
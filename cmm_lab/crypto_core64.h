@@ -0,0 +1,44 @@
+#ifndef CRYPTO_CORE64_H_
+#define CRYPTO_CORE64_H_
+
+#include "crypto_core.h"
+
+// crypto_core for uint64 moduli of up to 62 bits, stored as int[2] with
+// the high word first like the rest of unsigned_op. Products go through
+// mul_full_uint64 and mod_uint128, so nothing is lost above 64 bits.
+
+struct FFCParams64
+{
+	int g[2];
+	int p[2];
+	int q[2];
+};
+
+// a and b must be below p
+int mul_mod_uint64(int mul_mod64_out[2], int mul_mod64_a[2], int mul_mod64_b[2], int mul_mod64_p[2]);
+
+int exp_mod_uint64(int exp_mod64_out[2], int exp_mod64_a[2], int exp_mod64_b[2], int exp_mod64_p[2]);
+
+// Return 0 if no inv
+int inverse_mod_uint64(int invmod64_inv[2], int invmod64_a[2], int invmod64_n[2]);
+
+// random number r:  0 <= r < range
+int rand_range_uint64(int rand_range64_out[2], int rand_range64_range[2]);
+
+// Deterministic for every uint64 w (Miller-Rabin with Sinclair's seven
+// bases above 2^32, is_prime_deterministic below).
+int is_prime_uint64(int isp64_out[1], int isp64_w[2]);
+
+// bits must be >=2 and <=62; add and rem must be either positive or -1.
+// Lengths up to 31 bits are handed to generate_prime.
+int generate_prime_uint64(
+	int genprime64_out[2],
+	int genprime64_bits,
+	int genprime64_safe,
+	int genprime64_add,
+	int genprime64_rem);
+
+// privkey_out in [1, q)
+int ffc_generate_privkey_uint64(int ffc_genprivkey64_privkey_out[2], int ffc_genprivkey64_q[2]);
+
+#endif
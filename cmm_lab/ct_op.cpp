@@ -0,0 +1,247 @@
+#include "ct_op.h"
+#include "crypto_core.h"
+#include "profile.h"
+#include "trace.h"
+
+static int kConstantTime;
+
+int select_ct(int select_ct_flag, int select_ct_a, int select_ct_b)
+{
+	PROFILE_CALL("select_ct");
+
+	return select_ct_b + select_ct_flag * (select_ct_a - select_ct_b);
+}
+
+int cswap_ct(int cswap_ct_flag, int cswap_ct_x[1], int cswap_ct_y[1])
+{
+	PROFILE_CALL("cswap_ct");
+
+	int cswap_ct_d = cswap_ct_flag * (cswap_ct_x[0] - cswap_ct_y[0]);
+
+	cswap_ct_x[0] = cswap_ct_x[0] - cswap_ct_d;
+	cswap_ct_y[0] = cswap_ct_y[0] + cswap_ct_d;
+
+	return 0;
+}
+
+int lookup_ct(int lookup_ct_table[], int lookup_ct_n, int lookup_ct_index)
+{
+	PROFILE_CALL("lookup_ct");
+
+	int lookup_ct_i = 0;
+	int lookup_ct_result = 0;
+
+	while (lookup_ct_i < lookup_ct_n)
+	{
+		PROFILE_LOOP("lookup_ct");
+
+		lookup_ct_result = lookup_ct_result + (lookup_ct_i == lookup_ct_index) * lookup_ct_table[lookup_ct_i];
+		lookup_ct_i = lookup_ct_i + 1;
+	}
+
+	return lookup_ct_result;
+}
+
+// the high 16 bits of x as uint32; rshift_uint32 branches on the sign
+static int ct_op_high16(int ct_op_high16_x)
+{
+	int ct_op_high16_s = ct_op_high16_x < 0;
+
+	return (ct_op_high16_x - ct_op_high16_s * kTwoPowers[31]) / 65536 + ct_op_high16_s * 32768;
+}
+
+int mul_uint32_ct(int mul_uint32_ct_out[2], int mul_uint32_ct_a, int mul_uint32_ct_b)
+{
+	PROFILE_CALL("mul_uint32_ct");
+
+	// the 16-bit split of mul_uint32
+	int mul_uint32_ct_ah = ct_op_high16(mul_uint32_ct_a);
+	int mul_uint32_ct_al = mul_uint32_ct_a - mul_uint32_ct_ah * 65536;
+
+	int mul_uint32_ct_bh = ct_op_high16(mul_uint32_ct_b);
+	int mul_uint32_ct_bl = mul_uint32_ct_b - mul_uint32_ct_bh * 65536;
+
+	int mul_uint32_ct_abh = mul_uint32_ct_ah * mul_uint32_ct_bh +
+		ct_op_high16(mul_uint32_ct_ah * mul_uint32_ct_bl) +
+		ct_op_high16(mul_uint32_ct_al * mul_uint32_ct_bh);
+
+	int mul_uint32_ct_carry[1];
+	int mul_uint32_ct_abl = add_full_uint32(
+		mul_uint32_ct_carry,
+		mul_uint32_ct_al * mul_uint32_ct_bl,
+		(mul_uint32_ct_ah * mul_uint32_ct_bl) * 65536);
+
+	mul_uint32_ct_abh = mul_uint32_ct_abh + mul_uint32_ct_carry[0];
+
+	mul_uint32_ct_abl = add_full_uint32(
+		mul_uint32_ct_carry,
+		mul_uint32_ct_abl,
+		(mul_uint32_ct_al * mul_uint32_ct_bh) * 65536);
+
+	mul_uint32_ct_abh = mul_uint32_ct_abh + mul_uint32_ct_carry[0];
+
+	mul_uint32_ct_out[0] = mul_uint32_ct_abh;
+	mul_uint32_ct_out[1] = mul_uint32_ct_abl;
+
+	return 0;
+}
+
+int mod_uint64_ct(int mod_uint64_ct_a[2], int mod_uint64_ct_m)
+{
+	PROFILE_CALL("mod_uint64_ct");
+
+	int mod_uint64_ct_i = 0;
+	int mod_uint64_ct_hi = mod_uint64_ct_a[0];
+	int mod_uint64_ct_lo = mod_uint64_ct_a[1];
+	int mod_uint64_ct_rem = 0;
+	int mod_uint64_ct_bit, mod_uint64_ct_top, mod_uint64_ct_ge, mod_uint64_ct_sub;
+
+	// rem < m throughout; 2*rem+bit < 2m may take 33 bits, the 33rd is top
+	while (mod_uint64_ct_i < 64)
+	{
+		PROFILE_LOOP("mod_uint64_ct");
+
+		mod_uint64_ct_bit = mod_uint64_ct_hi < 0;
+		mod_uint64_ct_hi = mod_uint64_ct_hi * 2 + (mod_uint64_ct_lo < 0);
+		mod_uint64_ct_lo = mod_uint64_ct_lo * 2;
+
+		mod_uint64_ct_top = mod_uint64_ct_rem < 0;
+		mod_uint64_ct_rem = mod_uint64_ct_rem * 2 + mod_uint64_ct_bit;
+
+		mod_uint64_ct_ge = 1 - lt_uint32(mod_uint64_ct_rem, mod_uint64_ct_m);
+		mod_uint64_ct_sub = mod_uint64_ct_top + mod_uint64_ct_ge - mod_uint64_ct_top * mod_uint64_ct_ge;
+		mod_uint64_ct_rem = mod_uint64_ct_rem - mod_uint64_ct_sub * mod_uint64_ct_m;
+
+		mod_uint64_ct_i = mod_uint64_ct_i + 1;
+	}
+
+	return mod_uint64_ct_rem;
+}
+
+int mul_mod_ct(int mul_mod_ct_a, int mul_mod_ct_b, int mul_mod_ct_p)
+{
+	PROFILE_CALL("mul_mod_ct");
+
+	int mul_mod_ct_prod[2];
+
+	mul_uint32_ct(mul_mod_ct_prod, mul_mod_ct_a, mul_mod_ct_b);
+
+	return mod_uint64_ct(mul_mod_ct_prod, mul_mod_ct_p);
+}
+
+int exp_mod_ct(int exp_mod_ct_a, int exp_mod_ct_b, int exp_mod_ct_p)
+{
+	PROFILE_CALL("exp_mod_ct");
+	TRACE_SPAN("exp_mod_ct");
+
+	int exp_mod_ct_i = 0;
+	int exp_mod_ct_bit;
+	int exp_mod_ct_e = select_ct(exp_mod_ct_b < 0, neg_uint32(exp_mod_ct_b), exp_mod_ct_b);
+	int exp_mod_ct_r0[1], exp_mod_ct_r1[1];
+
+	exp_mod_ct_r0[0] = 1;
+	exp_mod_ct_r1[0] = mul_mod_ct(exp_mod_ct_a, 1, exp_mod_ct_p);
+
+	// r1 = r0 * a throughout; each bit moves (r0, r1) to (r0^2, r0*r1)
+	// or to (r0*r1, r1^2), the second by swapping around the first
+	while (exp_mod_ct_i < 32)
+	{
+		PROFILE_LOOP("exp_mod_ct");
+
+		exp_mod_ct_bit = exp_mod_ct_e < 0;
+		exp_mod_ct_e = exp_mod_ct_e * 2;
+
+		cswap_ct(exp_mod_ct_bit, exp_mod_ct_r0, exp_mod_ct_r1);
+		exp_mod_ct_r1[0] = mul_mod_ct(exp_mod_ct_r0[0], exp_mod_ct_r1[0], exp_mod_ct_p);
+		exp_mod_ct_r0[0] = mul_mod_ct(exp_mod_ct_r0[0], exp_mod_ct_r0[0], exp_mod_ct_p);
+		cswap_ct(exp_mod_ct_bit, exp_mod_ct_r0, exp_mod_ct_r1);
+
+		exp_mod_ct_i = exp_mod_ct_i + 1;
+	}
+
+	return select_ct(exp_mod_ct_b == 0, 1, exp_mod_ct_r0[0]);
+}
+
+int exp_mod_ct_window(int exp_mod_ctw_a, int exp_mod_ctw_b, int exp_mod_ctw_p)
+{
+	PROFILE_CALL("exp_mod_ct_window");
+	TRACE_SPAN("exp_mod_ct_window");
+
+	int exp_mod_ctw_i, exp_mod_ctw_j;
+	int exp_mod_ctw_window;
+	int exp_mod_ctw_e = select_ct(exp_mod_ctw_b < 0, neg_uint32(exp_mod_ctw_b), exp_mod_ctw_b);
+	int exp_mod_ctw_r = 1;
+	int exp_mod_ctw_table[16];
+
+	exp_mod_ctw_table[0] = 1;
+	exp_mod_ctw_table[1] = mul_mod_ct(exp_mod_ctw_a, 1, exp_mod_ctw_p);
+	exp_mod_ctw_i = 2;
+	while (exp_mod_ctw_i < 16)
+	{
+		PROFILE_LOOP("exp_mod_ct_window");
+
+		exp_mod_ctw_table[exp_mod_ctw_i] = mul_mod_ct(
+			exp_mod_ctw_table[exp_mod_ctw_i - 1], exp_mod_ctw_table[1], exp_mod_ctw_p);
+		exp_mod_ctw_i = exp_mod_ctw_i + 1;
+	}
+
+	exp_mod_ctw_i = 0;
+	while (exp_mod_ctw_i < 8)
+	{
+		PROFILE_LOOP("exp_mod_ct_window");
+
+		exp_mod_ctw_window = 0;
+		exp_mod_ctw_j = 0;
+		while (exp_mod_ctw_j < 4)
+		{
+			PROFILE_LOOP("exp_mod_ct_window");
+
+			exp_mod_ctw_r = mul_mod_ct(exp_mod_ctw_r, exp_mod_ctw_r, exp_mod_ctw_p);
+			exp_mod_ctw_window = exp_mod_ctw_window * 2 + (exp_mod_ctw_e < 0);
+			exp_mod_ctw_e = exp_mod_ctw_e * 2;
+			exp_mod_ctw_j = exp_mod_ctw_j + 1;
+		}
+
+		exp_mod_ctw_r = mul_mod_ct(
+			exp_mod_ctw_r, lookup_ct(exp_mod_ctw_table, 16, exp_mod_ctw_window), exp_mod_ctw_p);
+
+		exp_mod_ctw_i = exp_mod_ctw_i + 1;
+	}
+
+	return select_ct(exp_mod_ctw_b == 0, 1, exp_mod_ctw_r);
+}
+
+int set_constant_time(int set_ct_enabled)
+{
+	kConstantTime = set_ct_enabled;
+	return 0;
+}
+
+int get_constant_time()
+{
+	return kConstantTime;
+}
+
+int exp_mod_secret(int exp_mod_secret_a, int exp_mod_secret_b, int exp_mod_secret_p)
+{
+	PROFILE_CALL("exp_mod_secret");
+
+	if (kConstantTime)
+	{
+		return exp_mod_ct_window(exp_mod_secret_a, exp_mod_secret_b, exp_mod_secret_p);
+	}
+
+	return exp_mod(exp_mod_secret_a, exp_mod_secret_b, exp_mod_secret_p);
+}
+
+int mul_mod_secret(int mul_mod_secret_a, int mul_mod_secret_b, int mul_mod_secret_p)
+{
+	PROFILE_CALL("mul_mod_secret");
+
+	if (kConstantTime)
+	{
+		return mul_mod_ct(mul_mod_secret_a, mul_mod_secret_b, mul_mod_secret_p);
+	}
+
+	return mul_mod(mul_mod_secret_a, mul_mod_secret_b, mul_mod_secret_p);
+}
@@ -0,0 +1,53 @@
+#ifndef CT_OP_H_
+#define CT_OP_H_
+
+#include "unsigned_op.h"
+
+// Constant-time counterparts of the exponentiation path. exp_mod squares
+// and multiplies depending on each exponent bit and div_mod_uint64 loops
+// a data-dependent number of times, so their running time follows the
+// secret exponent. Everything here runs a fixed sequence of operations
+// whatever the values: flags are 0/1 ints, selection is arithmetic, loops
+// have fixed trip counts and table lookups read every entry.
+
+// flag ? a : b for a flag of 0 or 1
+int select_ct(int select_ct_flag, int select_ct_a, int select_ct_b);
+
+// swap x and y if flag is 1
+int cswap_ct(int cswap_ct_flag, int cswap_ct_x[1], int cswap_ct_y[1]);
+
+// table[index], reading all n entries
+int lookup_ct(int lookup_ct_table[], int lookup_ct_n, int lookup_ct_index);
+
+int mul_uint32_ct(int mul_uint32_ct_out[2], int mul_uint32_ct_a, int mul_uint32_ct_b);
+
+// a mod m for a non-zero uint32 m, always 64 shift-subtract steps
+int mod_uint64_ct(int mod_uint64_ct_a[2], int mod_uint64_ct_m);
+
+int mul_mod_ct(int mul_mod_ct_a, int mul_mod_ct_b, int mul_mod_ct_p);
+
+// Montgomery ladder over all 32 exponent bits. Same results as exp_mod,
+// including |b| as the exponent and 1 for b=0.
+int exp_mod_ct(int exp_mod_ct_a, int exp_mod_ct_b, int exp_mod_ct_p);
+
+// Fixed 4-bit windows: 16-entry table of powers, then 8 windows of four
+// squarings and a multiplication by a masked table lookup (by 1 for a
+// zero window). Same results as exp_mod.
+int exp_mod_ct_window(int exp_mod_ctw_a, int exp_mod_ctw_b, int exp_mod_ctw_p);
+
+// When enabled, the private-key operations of rsa.h and dh.h (RSA
+// decryption and signing, DH key generation and agreement, ElGamal), the
+// column decryption of rsa_soa.h and the ElGamal pool go through
+// exp_mod_secret/mul_mod_secret and run in constant time. The uint64 and
+// bignum variants (rsa64, dh64, rsa_bn) are not covered.
+int set_constant_time(int set_ct_enabled);
+
+int get_constant_time();
+
+// exp_mod / mul_mod, or their constant-time versions when enabled; for
+// operands that are secret
+int exp_mod_secret(int exp_mod_secret_a, int exp_mod_secret_b, int exp_mod_secret_p);
+
+int mul_mod_secret(int mul_mod_secret_a, int mul_mod_secret_b, int mul_mod_secret_p);
+
+#endif
@@ -1,52 +1,126 @@
 #include "dh.h"
+#include "ct_op.h"
+#include "metrics.h"
+#include "profile.h"
+#include "safe_prime_table.h"
+#include "trace.h"
+
+static int kDhFastParams;
 
 int dh_q_from_p(int dh_q_from_p_p)
 {
 	return (dh_q_from_p_p - 1) / 2;
 }
 
-int dh_generate_paremeters(
-	struct DH dh_genparam_out[1],
-	int dh_genparam_prime_len,
-	int dh_genparam_generator)
+// out[0]=add, out[1]=rem of the congruence p = rem (mod add) that
+// generated safe primes satisfy for the generator.
+// generator must be >1
+int dh_generator_congruence(int dh_gencong_out[2], int dh_gencong_generator)
 {
-	int dh_genparam_t1, dh_genparam_t2;
-	int dh_genparam_p[1];
+	if (dh_gencong_generator <= 1)
+	{
+		return 0;
+	}
 
-	if (dh_genparam_prime_len < 2 || dh_genparam_prime_len > 31)
+	if (dh_gencong_generator == 2)
+	{
+		dh_gencong_out[0] = 24;
+		dh_gencong_out[1] = 23;
+	}
+	else if (dh_gencong_generator == 5)
+	{
+		dh_gencong_out[0] = 60;
+		dh_gencong_out[1] = 59;
+	}
+	else
+	{
+		dh_gencong_out[0] = 12;
+		dh_gencong_out[1] = 11;
+	}
+
+	return 1;
+}
+
+// Return 1 if params could have come from
+// dh_generate_paremeters(prime_len, generator)
+int dh_check_paremeters(
+	struct FFCParams dh_checkparam_params[1],
+	int dh_checkparam_prime_len,
+	int dh_checkparam_generator)
+{
+	PROFILE_API("dh_check_paremeters");
+	METRICS_TIME(kMetricsDhCheckParams);
+
+	int dh_checkparam_t[2];
+	int dh_checkparam_is_prime[1];
+
+	if (!dh_generator_congruence(dh_checkparam_t, dh_checkparam_generator))
 	{
 		return 0;
 	}
 
-	if (dh_genparam_generator <= 1)
+	if (dh_checkparam_params[0].g != dh_checkparam_generator ||
+		get_bits_uint32(dh_checkparam_params[0].p) != dh_checkparam_prime_len ||
+		dh_checkparam_params[0].q != dh_q_from_p(dh_checkparam_params[0].p) ||
+		mod_uint32(dh_checkparam_params[0].p, dh_checkparam_t[0]) != dh_checkparam_t[1])
 	{
 		return 0;
 	}
 
-	if (dh_genparam_generator == 2)
+	is_prime_deterministic(dh_checkparam_is_prime, dh_checkparam_params[0].p);
+	if (!dh_checkparam_is_prime[0])
 	{
-		dh_genparam_t1 = 24;
-		dh_genparam_t2 = 23;
-		dh_genparam_out[0].params.g = 2;
+		return 0;
 	}
-	else if (dh_genparam_generator == 5)
+
+	is_prime_deterministic(dh_checkparam_is_prime, dh_checkparam_params[0].q);
+	if (!dh_checkparam_is_prime[0])
 	{
-		dh_genparam_t1 = 60;
-		dh_genparam_t2 = 59;
-		dh_genparam_out[0].params.g = 5;
+		return 0;
 	}
-	else
+
+	return 1;
+}
+
+int dh_set_fast_paremeters(int dh_setfast_enabled)
+{
+	kDhFastParams = dh_setfast_enabled;
+	return 0;
+}
+
+int dh_generate_paremeters(
+	struct DH dh_genparam_out[1],
+	int dh_genparam_prime_len,
+	int dh_genparam_generator)
+{
+	PROFILE_API("dh_generate_paremeters");
+	METRICS_TIME(kMetricsDhGenerateParams);
+	TRACE_SPAN_ARG("dh_generate_paremeters", "bits", dh_genparam_prime_len);
+
+	int dh_genparam_t[2];
+	int dh_genparam_p[1];
+
+	if (dh_genparam_prime_len < 2 || dh_genparam_prime_len > 31)
 	{
-		dh_genparam_t1 = 12;
-		dh_genparam_t2 = 11;
-		dh_genparam_out[0].params.g = dh_genparam_generator;
+		return 0;
 	}
 
-	if (!generate_prime(dh_genparam_p, dh_genparam_prime_len, 1, dh_genparam_t1, dh_genparam_t2))
+	if (!dh_generator_congruence(dh_genparam_t, dh_genparam_generator))
 	{
 		return 0;
 	}
 
+	dh_genparam_out[0].params.g = dh_genparam_generator;
+
+	if (!kDhFastParams ||
+		!safe_prime_table_pick(dh_genparam_p, dh_genparam_prime_len, dh_genparam_t[0], dh_genparam_t[1]))
+	{
+		if (!generate_prime(dh_genparam_p, dh_genparam_prime_len, 1, dh_genparam_t[0], dh_genparam_t[1]))
+		{
+			return 0;
+		}
+	}
+
 	dh_genparam_out[0].params.p = dh_genparam_p[0];
 	dh_genparam_out[0].params.q = dh_q_from_p(dh_genparam_p[0]);
 
@@ -55,6 +129,9 @@ int dh_generate_paremeters(
 
 int dh_generate_key(struct DH dh_genkey_out[1])
 {
+	PROFILE_API("dh_generate_key");
+	METRICS_TIME(kMetricsDhGenerateKey);
+
 	int dh_genkey_privkey[1];
 	if (!ffc_generate_privkey(dh_genkey_privkey, dh_genkey_out[0].params.q, -1))
 	{
@@ -63,7 +140,7 @@ int dh_generate_key(struct DH dh_genkey_out[1])
 
 	dh_genkey_out[0].privkey = dh_genkey_privkey[0];
 
-	dh_genkey_out[0].pubkey = exp_mod(
+	dh_genkey_out[0].pubkey = exp_mod_secret(
 		dh_genkey_out[0].params.g, dh_genkey_privkey[0], dh_genkey_out[0].params.p);
 
 	return 1;
@@ -74,7 +151,10 @@ int dh_compute_key(
 	struct DH dh_compute_key_dh[1],
 	int dh_compute_key_pubkey)
 {
-	int dh_compute_key_shared_key = exp_mod(
+	PROFILE_API("dh_compute_key");
+	METRICS_TIME(kMetricsDhComputeKey);
+
+	int dh_compute_key_shared_key = exp_mod_secret(
 		dh_compute_key_pubkey,
 		dh_compute_key_dh[0].privkey,
 		dh_compute_key_dh[0].params.p);
@@ -95,6 +175,9 @@ int elgamal_pubkey_encryrpt(
 	struct DH elgamal_pubkenc_dh[1],
 	int elgamal_pubkenc_p)
 {
+	PROFILE_API("elgamal_pubkey_encryrpt");
+	METRICS_TIME(kMetricsElGamalEncrypt);
+
 	int elgamal_pubkenc_y[1];
 
 	if (cmp_uint32(elgamal_pubkenc_p, elgamal_pubkenc_dh[0].params.p) >= 0)
@@ -107,13 +190,13 @@ int elgamal_pubkey_encryrpt(
 		return 0;
 	}
 
-	elgamal_pubkenc_c_out[0] = exp_mod(
+	elgamal_pubkenc_c_out[0] = exp_mod_secret(
 		elgamal_pubkenc_dh[0].params.g,
 		elgamal_pubkenc_y[0],
 		elgamal_pubkenc_dh[0].params.p);
 
-	elgamal_pubkenc_c_out[1] = mul_mod(
-		exp_mod(
+	elgamal_pubkenc_c_out[1] = mul_mod_secret(
+		exp_mod_secret(
 			elgamal_pubkenc_dh[0].pubkey,
 			elgamal_pubkenc_y[0],
 			elgamal_pubkenc_dh[0].params.p),
@@ -128,9 +211,25 @@ int elgamal_privkey_decryrpt(
 	struct DH elgamal_privkdec_dh[1],
 	int elgamal_privkdec_c[2])
 {
+	PROFILE_API("elgamal_privkey_decryrpt");
+	METRICS_TIME(kMetricsElGamalDecrypt);
+
 	int elgamal_privkdec_inv[1];
 
-	if (!inverse_mod(
+	if (get_constant_time())
+	{
+		// c0^-x = c0^(p-1-x): inverse_mod's Euclid steps depend on its input
+		if (mod_uint32(elgamal_privkdec_c[0], elgamal_privkdec_dh[0].params.p) == 0)
+		{
+			return 0;
+		}
+
+		elgamal_privkdec_inv[0] = exp_mod_secret(
+			elgamal_privkdec_c[0],
+			elgamal_privkdec_dh[0].params.p - 1 - elgamal_privkdec_dh[0].privkey,
+			elgamal_privkdec_dh[0].params.p);
+	}
+	else if (!inverse_mod(
 			elgamal_privkdec_inv,
 			exp_mod(
 				elgamal_privkdec_c[0],
@@ -141,7 +240,7 @@ int elgamal_privkey_decryrpt(
 		return 0;
 	}
 
-	elgamal_privkdec_p_out[0] = mul_mod(
+	elgamal_privkdec_p_out[0] = mul_mod_secret(
 		elgamal_privkdec_c[1],
 		elgamal_privkdec_inv[0],
 		elgamal_privkdec_dh[0].params.p);
@@ -16,6 +16,18 @@ struct DH
 
 int dh_q_from_p(int dh_q_from_p_p);
 
+int dh_generator_congruence(int dh_gencong_out[2], int dh_gencong_generator);
+
+int dh_check_paremeters(
+	struct FFCParams dh_checkparam_params[1],
+	int dh_checkparam_prime_len,
+	int dh_checkparam_generator);
+
+// When enabled, dh_generate_paremeters picks p from the embedded
+// safe_prime_table instead of searching, falling back to the search for
+// lengths the table does not cover.
+int dh_set_fast_paremeters(int dh_setfast_enabled);
+
 int dh_generate_paremeters(
 	struct DH dh_genparam_out[1],
 	int dh_genparam_prime_len,
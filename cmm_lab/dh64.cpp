@@ -0,0 +1,172 @@
+#include "dh.h"
+#include "dh64.h"
+#include "metrics.h"
+
+int dh64_generate_paremeters(
+	struct DH64 dh64_genparam_out[1],
+	int dh64_genparam_prime_len,
+	int dh64_genparam_generator)
+{
+	METRICS_TIME(kMetricsDh64GenerateParams);
+
+	int dh64_genparam_t[2];
+
+	if (dh64_genparam_prime_len < 2 || dh64_genparam_prime_len > 62)
+	{
+		return 0;
+	}
+
+	if (!dh_generator_congruence(dh64_genparam_t, dh64_genparam_generator))
+	{
+		return 0;
+	}
+
+	dh64_genparam_out[0].params.g[0] = 0;
+	dh64_genparam_out[0].params.g[1] = dh64_genparam_generator;
+
+	if (!generate_prime_uint64(
+			dh64_genparam_out[0].params.p,
+			dh64_genparam_prime_len,
+			1,
+			dh64_genparam_t[0],
+			dh64_genparam_t[1]))
+	{
+		return 0;
+	}
+
+	// q = (p-1)/2; p is odd
+	rshift_uint64(dh64_genparam_out[0].params.q, dh64_genparam_out[0].params.p, 1);
+
+	return 1;
+}
+
+int dh64_generate_key(struct DH64 dh64_genkey_out[1])
+{
+	METRICS_TIME(kMetricsDh64GenerateKey);
+
+	if (!ffc_generate_privkey_uint64(dh64_genkey_out[0].privkey, dh64_genkey_out[0].params.q))
+	{
+		return 0;
+	}
+
+	exp_mod_uint64(
+		dh64_genkey_out[0].pubkey,
+		dh64_genkey_out[0].params.g,
+		dh64_genkey_out[0].privkey,
+		dh64_genkey_out[0].params.p);
+
+	return 1;
+}
+
+int dh64_compute_key(
+	int dh64_compute_key_key_out[2],
+	struct DH64 dh64_compute_key_dh[1],
+	int dh64_compute_key_pubkey[2])
+{
+	METRICS_TIME(kMetricsDh64ComputeKey);
+
+	int dh64_compute_key_shared_key[2];
+	int dh64_compute_key_p1[2];
+	int dh64_compute_key_one[2];
+
+	dh64_compute_key_one[0] = 0;
+	dh64_compute_key_one[1] = 1;
+
+	exp_mod_uint64(
+		dh64_compute_key_shared_key,
+		dh64_compute_key_pubkey,
+		dh64_compute_key_dh[0].privkey,
+		dh64_compute_key_dh[0].params.p);
+
+	sub_uint64(dh64_compute_key_p1, dh64_compute_key_dh[0].params.p, dh64_compute_key_one);
+
+	if (cmp_uint64(dh64_compute_key_shared_key, dh64_compute_key_one) <= 0 ||
+		cmp_uint64(dh64_compute_key_shared_key, dh64_compute_key_p1) == 0)
+	{
+		return 0;
+	}
+
+	dh64_compute_key_key_out[0] = dh64_compute_key_shared_key[0];
+	dh64_compute_key_key_out[1] = dh64_compute_key_shared_key[1];
+
+	return 1;
+}
+
+int elgamal64_pubkey_encryrpt(
+	int elgamal64_pubkenc_c_out[4],
+	struct DH64 elgamal64_pubkenc_dh[1],
+	int elgamal64_pubkenc_p[2])
+{
+	METRICS_TIME(kMetricsElGamal64Encrypt);
+
+	int elgamal64_pubkenc_y[2];
+	int elgamal64_pubkenc_c1[2], elgamal64_pubkenc_c2[2];
+
+	if (cmp_uint64(elgamal64_pubkenc_p, elgamal64_pubkenc_dh[0].params.p) >= 0)
+	{
+		return 0;
+	}
+
+	if (!ffc_generate_privkey_uint64(elgamal64_pubkenc_y, elgamal64_pubkenc_dh[0].params.q))
+	{
+		return 0;
+	}
+
+	exp_mod_uint64(
+		elgamal64_pubkenc_c1,
+		elgamal64_pubkenc_dh[0].params.g,
+		elgamal64_pubkenc_y,
+		elgamal64_pubkenc_dh[0].params.p);
+
+	exp_mod_uint64(
+		elgamal64_pubkenc_c2,
+		elgamal64_pubkenc_dh[0].pubkey,
+		elgamal64_pubkenc_y,
+		elgamal64_pubkenc_dh[0].params.p);
+	mul_mod_uint64(
+		elgamal64_pubkenc_c2,
+		elgamal64_pubkenc_c2,
+		elgamal64_pubkenc_p,
+		elgamal64_pubkenc_dh[0].params.p);
+
+	elgamal64_pubkenc_c_out[0] = elgamal64_pubkenc_c1[0];
+	elgamal64_pubkenc_c_out[1] = elgamal64_pubkenc_c1[1];
+	elgamal64_pubkenc_c_out[2] = elgamal64_pubkenc_c2[0];
+	elgamal64_pubkenc_c_out[3] = elgamal64_pubkenc_c2[1];
+
+	return 1;
+}
+
+int elgamal64_privkey_decryrpt(
+	int elgamal64_privkdec_p_out[2],
+	struct DH64 elgamal64_privkdec_dh[1],
+	int elgamal64_privkdec_c[4])
+{
+	METRICS_TIME(kMetricsElGamal64Decrypt);
+
+	int elgamal64_privkdec_c1[2], elgamal64_privkdec_c2[2];
+	int elgamal64_privkdec_s[2], elgamal64_privkdec_inv[2];
+
+	elgamal64_privkdec_c1[0] = elgamal64_privkdec_c[0];
+	elgamal64_privkdec_c1[1] = elgamal64_privkdec_c[1];
+	mod_uint64(elgamal64_privkdec_c2, &elgamal64_privkdec_c[2], elgamal64_privkdec_dh[0].params.p);
+
+	exp_mod_uint64(
+		elgamal64_privkdec_s,
+		elgamal64_privkdec_c1,
+		elgamal64_privkdec_dh[0].privkey,
+		elgamal64_privkdec_dh[0].params.p);
+
+	if (!inverse_mod_uint64(elgamal64_privkdec_inv, elgamal64_privkdec_s, elgamal64_privkdec_dh[0].params.p))
+	{
+		return 0;
+	}
+
+	mul_mod_uint64(
+		elgamal64_privkdec_p_out,
+		elgamal64_privkdec_c2,
+		elgamal64_privkdec_inv,
+		elgamal64_privkdec_dh[0].params.p);
+
+	return 1;
+}
@@ -0,0 +1,42 @@
+#ifndef DH64_H_
+#define DH64_H_
+
+#include "common.h"
+#include "unsigned_op.h"
+#include "crypto_core64.h"
+
+// Diffie-Hellman and ElGamal over safe primes of up to 62 bits. Values are
+// uint64 stored as int[2], high word first.
+struct DH64
+{
+	struct FFCParams64 params;
+
+	int pubkey[2];
+	int privkey[2];
+};
+
+// prime_len must be >=2 and <=62; generators as for dh_generate_paremeters
+int dh64_generate_paremeters(
+	struct DH64 dh64_genparam_out[1],
+	int dh64_genparam_prime_len,
+	int dh64_genparam_generator);
+
+int dh64_generate_key(struct DH64 dh64_genkey_out[1]);
+
+int dh64_compute_key(
+	int dh64_compute_key_key_out[2],
+	struct DH64 dh64_compute_key_dh[1],
+	int dh64_compute_key_pubkey[2]);
+
+// c_out[0..1] = g^y, c_out[2..3] = pubkey^y * p
+int elgamal64_pubkey_encryrpt(
+	int elgamal64_pubkenc_c_out[4],
+	struct DH64 elgamal64_pubkenc_dh[1],
+	int elgamal64_pubkenc_p[2]);
+
+int elgamal64_privkey_decryrpt(
+	int elgamal64_privkdec_p_out[2],
+	struct DH64 elgamal64_privkdec_dh[1],
+	int elgamal64_privkdec_c[4]);
+
+#endif
@@ -0,0 +1,231 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "dh_param_store.h"
+#include "mapped_file.h"
+#include "metrics.h"
+
+static const unsigned char kDhParamStoreMagic[4] = { 'C', 'M', 'M', 'D' };
+static const int kDhParamStoreVersion = 1;
+static const int kDhParamStoreHeaderSize = 16;
+static const int kDhParamStoreRecordInts = 5;
+static const int kDhParamStoreRecordSize = 4 * kDhParamStoreRecordInts;
+
+static int dh_param_store_get_int(const unsigned char* dh_pstore_get_p)
+{
+	return (int)((unsigned int)dh_pstore_get_p[0] |
+		((unsigned int)dh_pstore_get_p[1] << 8) |
+		((unsigned int)dh_pstore_get_p[2] << 16) |
+		((unsigned int)dh_pstore_get_p[3] << 24));
+}
+
+static void dh_param_store_put_int(unsigned char* dh_pstore_put_p, int dh_pstore_put_x)
+{
+	dh_pstore_put_p[0] = (unsigned char)((unsigned int)dh_pstore_put_x);
+	dh_pstore_put_p[1] = (unsigned char)((unsigned int)dh_pstore_put_x >> 8);
+	dh_pstore_put_p[2] = (unsigned char)((unsigned int)dh_pstore_put_x >> 16);
+	dh_pstore_put_p[3] = (unsigned char)((unsigned int)dh_pstore_put_x >> 24);
+}
+
+// Return the record count, or -1 if the mapping is not a store.
+static int dh_param_store_records(struct MappedFile dh_pstore_records_file[1])
+{
+	int dh_pstore_records_count;
+
+	if (dh_pstore_records_file[0].size < (size_t)kDhParamStoreHeaderSize ||
+		memcmp(dh_pstore_records_file[0].data, kDhParamStoreMagic, 4) != 0 ||
+		dh_param_store_get_int(dh_pstore_records_file[0].data + 4) != kDhParamStoreVersion)
+	{
+		return -1;
+	}
+
+	dh_pstore_records_count = dh_param_store_get_int(dh_pstore_records_file[0].data + 8);
+	if (dh_pstore_records_count < 0 ||
+		dh_pstore_records_file[0].size != (size_t)kDhParamStoreHeaderSize +
+			(size_t)dh_pstore_records_count * kDhParamStoreRecordSize)
+	{
+		return -1;
+	}
+
+	return dh_pstore_records_count;
+}
+
+int dh_param_store_lookup(
+	struct FFCParams dh_pstore_lookup_out[1],
+	const char* dh_pstore_lookup_path,
+	int dh_pstore_lookup_prime_len,
+	int dh_pstore_lookup_generator)
+{
+	struct MappedFile dh_pstore_lookup_file[1];
+	struct FFCParams dh_pstore_lookup_params[1];
+	const unsigned char* dh_pstore_lookup_record;
+	int dh_pstore_lookup_count, dh_pstore_lookup_i;
+	int dh_pstore_lookup_found = 0;
+
+	if (!mapped_file_open(dh_pstore_lookup_file, dh_pstore_lookup_path, 0))
+	{
+		return 0;
+	}
+
+	dh_pstore_lookup_count = dh_param_store_records(dh_pstore_lookup_file);
+
+	dh_pstore_lookup_i = 0;
+	while (!dh_pstore_lookup_found && dh_pstore_lookup_i < dh_pstore_lookup_count)
+	{
+		dh_pstore_lookup_record = dh_pstore_lookup_file[0].data + kDhParamStoreHeaderSize +
+			(size_t)dh_pstore_lookup_i * kDhParamStoreRecordSize;
+
+		if (dh_param_store_get_int(dh_pstore_lookup_record) == dh_pstore_lookup_prime_len &&
+			dh_param_store_get_int(dh_pstore_lookup_record + 4) == dh_pstore_lookup_generator)
+		{
+			dh_pstore_lookup_params[0].p = dh_param_store_get_int(dh_pstore_lookup_record + 8);
+			dh_pstore_lookup_params[0].q = dh_param_store_get_int(dh_pstore_lookup_record + 12);
+			dh_pstore_lookup_params[0].g = dh_param_store_get_int(dh_pstore_lookup_record + 16);
+
+			if (dh_check_paremeters(
+					dh_pstore_lookup_params,
+					dh_pstore_lookup_prime_len,
+					dh_pstore_lookup_generator))
+			{
+				dh_pstore_lookup_out[0] = dh_pstore_lookup_params[0];
+				dh_pstore_lookup_found = 1;
+			}
+		}
+
+		dh_pstore_lookup_i = dh_pstore_lookup_i + 1;
+	}
+
+	mapped_file_close(dh_pstore_lookup_file);
+
+	return dh_pstore_lookup_found;
+}
+
+int dh_param_store_put(
+	const char* dh_pstore_put_path,
+	int dh_pstore_put_prime_len,
+	int dh_pstore_put_generator,
+	struct FFCParams dh_pstore_put_params[1])
+{
+	struct MappedFile dh_pstore_put_file[1];
+	std::vector<unsigned char> dh_pstore_put_bytes(kDhParamStoreHeaderSize);
+	std::string dh_pstore_put_tmp_path = std::string(dh_pstore_put_path) + ".tmp";
+	const unsigned char* dh_pstore_put_record;
+	unsigned char dh_pstore_put_new_record[kDhParamStoreRecordSize];
+	int dh_pstore_put_count = 0, dh_pstore_put_old_count, dh_pstore_put_i;
+	FILE* dh_pstore_put_out;
+
+	// keep the other keys of an existing, well-formed store
+	if (mapped_file_open(dh_pstore_put_file, dh_pstore_put_path, 0))
+	{
+		dh_pstore_put_old_count = dh_param_store_records(dh_pstore_put_file);
+
+		dh_pstore_put_i = 0;
+		while (dh_pstore_put_i < dh_pstore_put_old_count)
+		{
+			dh_pstore_put_record = dh_pstore_put_file[0].data + kDhParamStoreHeaderSize +
+				(size_t)dh_pstore_put_i * kDhParamStoreRecordSize;
+
+			if (dh_param_store_get_int(dh_pstore_put_record) != dh_pstore_put_prime_len ||
+				dh_param_store_get_int(dh_pstore_put_record + 4) != dh_pstore_put_generator)
+			{
+				dh_pstore_put_bytes.insert(
+					dh_pstore_put_bytes.end(),
+					dh_pstore_put_record,
+					dh_pstore_put_record + kDhParamStoreRecordSize);
+				dh_pstore_put_count = dh_pstore_put_count + 1;
+			}
+
+			dh_pstore_put_i = dh_pstore_put_i + 1;
+		}
+
+		mapped_file_close(dh_pstore_put_file);
+	}
+
+	dh_param_store_put_int(dh_pstore_put_new_record, dh_pstore_put_prime_len);
+	dh_param_store_put_int(dh_pstore_put_new_record + 4, dh_pstore_put_generator);
+	dh_param_store_put_int(dh_pstore_put_new_record + 8, dh_pstore_put_params[0].p);
+	dh_param_store_put_int(dh_pstore_put_new_record + 12, dh_pstore_put_params[0].q);
+	dh_param_store_put_int(dh_pstore_put_new_record + 16, dh_pstore_put_params[0].g);
+	dh_pstore_put_bytes.insert(
+		dh_pstore_put_bytes.end(),
+		dh_pstore_put_new_record,
+		dh_pstore_put_new_record + kDhParamStoreRecordSize);
+	dh_pstore_put_count = dh_pstore_put_count + 1;
+
+	memcpy(&dh_pstore_put_bytes[0], kDhParamStoreMagic, 4);
+	dh_param_store_put_int(&dh_pstore_put_bytes[4], kDhParamStoreVersion);
+	dh_param_store_put_int(&dh_pstore_put_bytes[8], dh_pstore_put_count);
+	dh_param_store_put_int(&dh_pstore_put_bytes[12], 0);
+
+	dh_pstore_put_out = fopen(dh_pstore_put_tmp_path.c_str(), "wb");
+	if (!dh_pstore_put_out)
+	{
+		return 0;
+	}
+
+	if (fwrite(dh_pstore_put_bytes.data(), 1, dh_pstore_put_bytes.size(), dh_pstore_put_out) !=
+		dh_pstore_put_bytes.size())
+	{
+		fclose(dh_pstore_put_out);
+		remove(dh_pstore_put_tmp_path.c_str());
+		return 0;
+	}
+
+	fclose(dh_pstore_put_out);
+
+#ifdef _WIN32
+	// rename() does not replace an existing file on Windows
+	remove(dh_pstore_put_path);
+#endif
+	if (rename(dh_pstore_put_tmp_path.c_str(), dh_pstore_put_path) != 0)
+	{
+		remove(dh_pstore_put_tmp_path.c_str());
+		return 0;
+	}
+
+	return 1;
+}
+
+int dh_generate_paremeters_cached(
+	struct DH dh_genparamc_out[1],
+	int dh_genparamc_cached_out[1],
+	const char* dh_genparamc_path,
+	int dh_genparamc_prime_len,
+	int dh_genparamc_generator,
+	int dh_genparamc_force_regenerate)
+{
+	METRICS_TIME(kMetricsDhGenerateParamsCached);
+
+	dh_genparamc_cached_out[0] = 0;
+
+	if (!dh_genparamc_force_regenerate &&
+		dh_param_store_lookup(
+			&dh_genparamc_out[0].params,
+			dh_genparamc_path,
+			dh_genparamc_prime_len,
+			dh_genparamc_generator))
+	{
+		dh_genparamc_cached_out[0] = 1;
+		return 1;
+	}
+
+	if (!dh_generate_paremeters(dh_genparamc_out, dh_genparamc_prime_len, dh_genparamc_generator))
+	{
+		return 0;
+	}
+
+	// Only persist what a later lookup would accept. A failed write is
+	// not an error; the next run simply regenerates.
+	if (dh_check_paremeters(&dh_genparamc_out[0].params, dh_genparamc_prime_len, dh_genparamc_generator))
+	{
+		dh_param_store_put(
+			dh_genparamc_path,
+			dh_genparamc_prime_len,
+			dh_genparamc_generator,
+			&dh_genparamc_out[0].params);
+	}
+
+	return 1;
+}
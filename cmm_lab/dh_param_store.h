@@ -0,0 +1,39 @@
+#ifndef DH_PARAM_STORE_H_
+#define DH_PARAM_STORE_H_
+
+#include "dh.h"
+
+// On-disk cache of DH parameters keyed by (prime length, generator), so a
+// run can skip the safe-prime search. The file is a 16-byte header
+// ("CMMD", version, record count, reserved) followed by little-endian
+// int32 records of (prime_len, generator, p, q, g). Records are
+// memory-mapped on lookup and accepted only if dh_check_paremeters passes,
+// so a stale or corrupted file just causes regeneration.
+
+// Return 1 and fill params if the store has valid parameters for the key.
+int dh_param_store_lookup(
+	struct FFCParams dh_pstore_lookup_out[1],
+	const char* dh_pstore_lookup_path,
+	int dh_pstore_lookup_prime_len,
+	int dh_pstore_lookup_generator);
+
+// Insert or replace the record for the key. The file is rewritten
+// through a temporary file.
+int dh_param_store_put(
+	const char* dh_pstore_put_path,
+	int dh_pstore_put_prime_len,
+	int dh_pstore_put_generator,
+	struct FFCParams dh_pstore_put_params[1]);
+
+// dh_generate_paremeters backed by the store: cached parameters are used
+// unless force_regenerate is set; freshly generated ones are persisted.
+// cached_out[0] tells whether the store was hit.
+int dh_generate_paremeters_cached(
+	struct DH dh_genparamc_out[1],
+	int dh_genparamc_cached_out[1],
+	const char* dh_genparamc_path,
+	int dh_genparamc_prime_len,
+	int dh_genparamc_generator,
+	int dh_genparamc_force_regenerate);
+
+#endif
@@ -0,0 +1,214 @@
+#include "elgamal_pool.h"
+#include "ct_op.h"
+#include "metrics.h"
+
+static int elgamal_pool_compute_pair(
+	struct ElGamalPair elgamal_pool_pair_out[1],
+	struct DH elgamal_pool_pair_dh[1])
+{
+	int elgamal_pool_pair_y[1];
+
+	if (!ffc_generate_privkey(elgamal_pool_pair_y, elgamal_pool_pair_dh[0].params.q, -1))
+	{
+		return 0;
+	}
+
+	elgamal_pool_pair_out[0].gy = exp_mod_secret(
+		elgamal_pool_pair_dh[0].params.g,
+		elgamal_pool_pair_y[0],
+		elgamal_pool_pair_dh[0].params.p);
+
+	elgamal_pool_pair_out[0].puby = exp_mod_secret(
+		elgamal_pool_pair_dh[0].pubkey,
+		elgamal_pool_pair_y[0],
+		elgamal_pool_pair_dh[0].params.p);
+
+	return 1;
+}
+
+static void elgamal_pool_refill(struct ElGamalPool* elgamal_pool_refill_pool, int elgamal_pool_refill_seed)
+{
+	struct ElGamalPair elgamal_pool_refill_pair[1];
+	std::chrono::steady_clock::time_point elgamal_pool_refill_begin;
+	int elgamal_pool_refill_capacity = (int)elgamal_pool_refill_pool->ring.size();
+
+	srand32(elgamal_pool_refill_seed);
+
+	while (1)
+	{
+		{
+			std::unique_lock<std::mutex> elgamal_pool_refill_guard(elgamal_pool_refill_pool->lock);
+			elgamal_pool_refill_pool->not_full.wait(elgamal_pool_refill_guard, [=] {
+				return elgamal_pool_refill_pool->stopping ||
+					elgamal_pool_refill_pool->depth < elgamal_pool_refill_capacity;
+			});
+
+			if (elgamal_pool_refill_pool->stopping)
+			{
+				return;
+			}
+		}
+
+		// The expensive part runs unlocked so encryptions never wait on it.
+		elgamal_pool_refill_begin = std::chrono::steady_clock::now();
+		if (!elgamal_pool_compute_pair(elgamal_pool_refill_pair, &elgamal_pool_refill_pool->dh))
+		{
+			// only bad parameters fail, and they would fail every time;
+			// encryptions fall back to the inline path, which reports it
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> elgamal_pool_refill_guard(elgamal_pool_refill_pool->lock);
+			elgamal_pool_refill_pool->busy +=
+				std::chrono::steady_clock::now() - elgamal_pool_refill_begin;
+			elgamal_pool_refill_pool->ring[
+				(elgamal_pool_refill_pool->head + elgamal_pool_refill_pool->depth) %
+					elgamal_pool_refill_capacity] = elgamal_pool_refill_pair[0];
+			elgamal_pool_refill_pool->depth = elgamal_pool_refill_pool->depth + 1;
+			elgamal_pool_refill_pool->produced = elgamal_pool_refill_pool->produced + 1;
+		}
+	}
+}
+
+int elgamal_pool_start(
+	struct ElGamalPool elgamal_pool_start_pool[1],
+	struct DH elgamal_pool_start_dh[1],
+	int elgamal_pool_start_capacity,
+	int elgamal_pool_start_seed)
+{
+	if (elgamal_pool_start_capacity <= 0 || elgamal_pool_start_pool[0].refill_thread.joinable())
+	{
+		return 0;
+	}
+
+	// what compute_pair needs: a q ffc_generate_privkey accepts, and g and
+	// the public key in [2, p) and [1, p)
+	if (get_bits_uint32(elgamal_pool_start_dh[0].params.q) < 2 ||
+		get_bits_uint32(elgamal_pool_start_dh[0].params.q) > 31 ||
+		cmp_uint32(elgamal_pool_start_dh[0].params.p, 3) < 0 ||
+		cmp_uint32(elgamal_pool_start_dh[0].params.g, 2) < 0 ||
+		cmp_uint32(elgamal_pool_start_dh[0].params.g, elgamal_pool_start_dh[0].params.p) >= 0 ||
+		cmp_uint32(elgamal_pool_start_dh[0].pubkey, 1) < 0 ||
+		cmp_uint32(elgamal_pool_start_dh[0].pubkey, elgamal_pool_start_dh[0].params.p) >= 0)
+	{
+		return 0;
+	}
+
+	elgamal_pool_start_pool[0].dh = elgamal_pool_start_dh[0];
+	elgamal_pool_start_pool[0].ring.assign(elgamal_pool_start_capacity, ElGamalPair());
+	elgamal_pool_start_pool[0].head = 0;
+	elgamal_pool_start_pool[0].depth = 0;
+	elgamal_pool_start_pool[0].produced = 0;
+	elgamal_pool_start_pool[0].consumed = 0;
+	elgamal_pool_start_pool[0].misses = 0;
+	elgamal_pool_start_pool[0].busy = std::chrono::steady_clock::duration::zero();
+	elgamal_pool_start_pool[0].started = std::chrono::steady_clock::now();
+	elgamal_pool_start_pool[0].stopping = false;
+
+	elgamal_pool_start_pool[0].refill_thread = std::thread(
+		elgamal_pool_refill, &elgamal_pool_start_pool[0], elgamal_pool_start_seed);
+
+	return 1;
+}
+
+int elgamal_pool_stop(struct ElGamalPool elgamal_pool_stop_pool[1])
+{
+	if (!elgamal_pool_stop_pool[0].refill_thread.joinable())
+	{
+		return 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> elgamal_pool_stop_guard(elgamal_pool_stop_pool[0].lock);
+		elgamal_pool_stop_pool[0].stopping = true;
+	}
+
+	elgamal_pool_stop_pool[0].not_full.notify_all();
+	elgamal_pool_stop_pool[0].refill_thread.join();
+
+	return 1;
+}
+
+ElGamalPool::~ElGamalPool()
+{
+	elgamal_pool_stop(this);
+}
+
+int elgamal_pool_encryrpt(
+	int elgamal_poolenc_c_out[2],
+	struct ElGamalPool elgamal_poolenc_pool[1],
+	int elgamal_poolenc_p)
+{
+	METRICS_TIME(kMetricsElGamalPoolEncrypt);
+
+	struct ElGamalPair elgamal_poolenc_pair[1];
+	int elgamal_poolenc_hit = 0;
+
+	if (cmp_uint32(elgamal_poolenc_p, elgamal_poolenc_pool[0].dh.params.p) >= 0)
+	{
+		return 0;
+	}
+
+	{
+		std::lock_guard<std::mutex> elgamal_poolenc_guard(elgamal_poolenc_pool[0].lock);
+		if (elgamal_poolenc_pool[0].depth > 0)
+		{
+			elgamal_poolenc_pair[0] = elgamal_poolenc_pool[0].ring[elgamal_poolenc_pool[0].head];
+			elgamal_poolenc_pool[0].head =
+				(elgamal_poolenc_pool[0].head + 1) % (int)elgamal_poolenc_pool[0].ring.size();
+			elgamal_poolenc_pool[0].depth = elgamal_poolenc_pool[0].depth - 1;
+			elgamal_poolenc_pool[0].consumed = elgamal_poolenc_pool[0].consumed + 1;
+			elgamal_poolenc_hit = 1;
+		}
+		else
+		{
+			elgamal_poolenc_pool[0].misses = elgamal_poolenc_pool[0].misses + 1;
+		}
+	}
+
+	if (elgamal_poolenc_hit)
+	{
+		elgamal_poolenc_pool[0].not_full.notify_one();
+	}
+	else if (!elgamal_pool_compute_pair(elgamal_poolenc_pair, &elgamal_poolenc_pool[0].dh))
+	{
+		return 0;
+	}
+
+	elgamal_poolenc_c_out[0] = elgamal_poolenc_pair[0].gy;
+	elgamal_poolenc_c_out[1] = mul_mod_secret(
+		elgamal_poolenc_pair[0].puby,
+		elgamal_poolenc_p,
+		elgamal_poolenc_pool[0].dh.params.p);
+
+	return 1;
+}
+
+int elgamal_pool_get_stats(
+	struct ElGamalPoolStats elgamal_pool_stats_out[1],
+	struct ElGamalPool elgamal_pool_stats_pool[1])
+{
+	double elgamal_pool_stats_busy_s, elgamal_pool_stats_alive_s;
+
+	std::lock_guard<std::mutex> elgamal_pool_stats_guard(elgamal_pool_stats_pool[0].lock);
+
+	elgamal_pool_stats_busy_s = std::chrono::duration<double>(
+		elgamal_pool_stats_pool[0].busy).count();
+	elgamal_pool_stats_alive_s = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - elgamal_pool_stats_pool[0].started).count();
+
+	elgamal_pool_stats_out[0].capacity = (int)elgamal_pool_stats_pool[0].ring.size();
+	elgamal_pool_stats_out[0].depth = elgamal_pool_stats_pool[0].depth;
+	elgamal_pool_stats_out[0].produced = elgamal_pool_stats_pool[0].produced;
+	elgamal_pool_stats_out[0].consumed = elgamal_pool_stats_pool[0].consumed;
+	elgamal_pool_stats_out[0].misses = elgamal_pool_stats_pool[0].misses;
+	elgamal_pool_stats_out[0].refill_rate = elgamal_pool_stats_busy_s > 0
+		? elgamal_pool_stats_pool[0].produced / elgamal_pool_stats_busy_s
+		: 0;
+	elgamal_pool_stats_out[0].consume_rate = elgamal_pool_stats_alive_s > 0
+		? elgamal_pool_stats_pool[0].consumed / elgamal_pool_stats_alive_s
+		: 0;
+
+	return 1;
+}
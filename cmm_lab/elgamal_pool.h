@@ -0,0 +1,79 @@
+#ifndef ELGAMAL_POOL_H_
+#define ELGAMAL_POOL_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dh.h"
+
+// Offline/online split for ElGamal encryption.
+// A background thread draws ephemeral keys y and stores (g^y, pub^y) pairs
+// in a ring buffer, so the online encryption is a single mul_mod.
+// When the pool runs dry the encryption falls back to the inline path and
+// counts a miss.
+
+struct ElGamalPair
+{
+	int gy;
+	int puby;
+};
+
+struct ElGamalPoolStats
+{
+	int capacity;
+	int depth;
+	long long produced;
+	long long consumed;
+	long long misses;
+	// pairs per second while the refill thread was busy computing
+	double refill_rate;
+	// pairs per second handed out since the pool was started
+	double consume_rate;
+};
+
+struct ElGamalPool
+{
+	struct DH dh;
+
+	std::vector<struct ElGamalPair> ring;
+	int head;
+	int depth;
+
+	long long produced;
+	long long consumed;
+	long long misses;
+	std::chrono::steady_clock::duration busy;
+	std::chrono::steady_clock::time_point started;
+
+	bool stopping;
+	std::mutex lock;
+	std::condition_variable not_full;
+	std::thread refill_thread;
+
+	~ElGamalPool();
+};
+
+// capacity must be >0; seed seeds the refill thread's rand32 stream.
+// Return 0 if the DH parameters or public key are out of range.
+int elgamal_pool_start(
+	struct ElGamalPool elgamal_pool_start_pool[1],
+	struct DH elgamal_pool_start_dh[1],
+	int elgamal_pool_start_capacity,
+	int elgamal_pool_start_seed);
+
+// Also run when a started pool is destroyed
+int elgamal_pool_stop(struct ElGamalPool elgamal_pool_stop_pool[1]);
+
+int elgamal_pool_encryrpt(
+	int elgamal_poolenc_c_out[2],
+	struct ElGamalPool elgamal_poolenc_pool[1],
+	int elgamal_poolenc_p);
+
+int elgamal_pool_get_stats(
+	struct ElGamalPoolStats elgamal_pool_stats_out[1],
+	struct ElGamalPool elgamal_pool_stats_pool[1]);
+
+#endif
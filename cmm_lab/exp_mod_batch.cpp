@@ -0,0 +1,451 @@
+#include <cstdint>
+
+#include "crypto_core.h"
+#include "exp_mod_batch.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define EXP_MOD_BATCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define EXP_MOD_BATCH_TARGET(isa)
+#else
+#define EXP_MOD_BATCH_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+static int kExpModBatchMaxLanes = 16;
+
+static uint32_t emb_abs(int emb_abs_b)
+{
+	return emb_abs_b < 0 ? 0u - (uint32_t)emb_abs_b : (uint32_t)emb_abs_b;
+}
+
+// Same square-and-multiply as exp_mod; a is not reduced first, which is
+// fine because a^2 < 2^64 and every later operand is below p.
+static uint32_t emb_native(uint32_t emb_native_a, uint32_t emb_native_e, uint32_t emb_native_p)
+{
+	uint64_t emb_native_x = emb_native_a;
+	uint64_t emb_native_r = 1;
+
+	while (emb_native_e)
+	{
+		if (emb_native_e & 1)
+		{
+			emb_native_r = emb_native_r * emb_native_x % emb_native_p;
+		}
+
+		emb_native_e >>= 1;
+		emb_native_x = emb_native_x * emb_native_x % emb_native_p;
+	}
+
+	return (uint32_t)emb_native_r;
+}
+
+// Everything exp_mod_batch does not hand to the SIMD lanes.
+static int emb_scalar(int emb_scalar_a, int emb_scalar_b, int emb_scalar_p)
+{
+	if (emb_scalar_b == 0)
+	{
+		return 1;
+	}
+
+	// exp_mod's own behaviour for a zero modulus
+	if (emb_scalar_p == 0)
+	{
+		return exp_mod(emb_scalar_a, emb_scalar_b, emb_scalar_p);
+	}
+
+	return (int)emb_native((uint32_t)emb_scalar_a, emb_abs(emb_scalar_b), (uint32_t)emb_scalar_p);
+}
+
+#ifdef EXP_MOD_BATCH_X86
+
+// Per-lane Montgomery constants: np = -p^-1 mod 2^32, r2 = 2^64 mod p.
+// Operands sit in the low half of 64-bit lanes, as _mm*_mul_epu32 expects.
+struct EmbGroup
+{
+	int index[16];
+	int size;
+	uint64_t a[16];
+	uint64_t e[16];
+	uint64_t p[16];
+	uint64_t np[16];
+	uint64_t r2[16];
+	uint64_t e_or;
+	uint32_t out[16];
+};
+
+static void emb_group_set(struct EmbGroup* emb_set_group, int emb_set_lane, uint32_t emb_set_a, uint32_t emb_set_e, uint32_t emb_set_p)
+{
+	uint32_t emb_set_inv = emb_set_p;
+	uint64_t emb_set_r;
+	int emb_set_i;
+
+	// Newton's iteration doubles the correct low bits: 3 -> 6 -> 12 -> 24 -> 48.
+	for (emb_set_i = 0; emb_set_i < 4; emb_set_i++)
+	{
+		emb_set_inv *= 2 - emb_set_p * emb_set_inv;
+	}
+
+	emb_set_r = (1ull << 32) % emb_set_p;
+
+	emb_set_group->a[emb_set_lane] = emb_set_a;
+	emb_set_group->e[emb_set_lane] = emb_set_e;
+	emb_set_group->p[emb_set_lane] = emb_set_p;
+	emb_set_group->np[emb_set_lane] = 0u - emb_set_inv;
+	emb_set_group->r2[emb_set_lane] = emb_set_r * emb_set_r % emb_set_p;
+}
+
+// REDC(x*y) for x*y < 2^32*p. t + m*p can exceed 64 bits when p is close
+// to 2^32, so the high halves are added separately; the low halves sum to
+// 0 mod 2^32 and carry exactly when t's low half is nonzero. The result is
+// below 2p before the final subtraction.
+EXP_MOD_BATCH_TARGET("avx2")
+static inline __m256i emb_montmul_avx2(__m256i emb_mm2_x, __m256i emb_mm2_y, __m256i emb_mm2_p, __m256i emb_mm2_np, __m256i emb_mm2_pm1)
+{
+	__m256i emb_mm2_t = _mm256_mul_epu32(emb_mm2_x, emb_mm2_y);
+	__m256i emb_mm2_mp = _mm256_mul_epu32(_mm256_mul_epu32(emb_mm2_t, emb_mm2_np), emb_mm2_p);
+	__m256i emb_mm2_lo_zero = _mm256_cmpeq_epi64(_mm256_slli_epi64(emb_mm2_t, 32), _mm256_setzero_si256());
+	__m256i emb_mm2_u = _mm256_add_epi64(
+		_mm256_add_epi64(_mm256_srli_epi64(emb_mm2_t, 32), _mm256_srli_epi64(emb_mm2_mp, 32)),
+		_mm256_add_epi64(emb_mm2_lo_zero, _mm256_set1_epi64x(1)));
+
+	return _mm256_sub_epi64(emb_mm2_u, _mm256_and_si256(emb_mm2_p, _mm256_cmpgt_epi64(emb_mm2_u, emb_mm2_pm1)));
+}
+
+// Two independent 4-lane vectors per step so one multiply chain can issue
+// while the other waits on latency.
+EXP_MOD_BATCH_TARGET("avx2")
+static void emb_kernel_avx2(struct EmbGroup* emb_k2_group, int emb_k2_bits)
+{
+	__m256i emb_k2_one = _mm256_set1_epi64x(1);
+	__m256i emb_k2_p[2], emb_k2_np[2], emb_k2_pm1[2], emb_k2_e[2], emb_k2_am[2], emb_k2_x[2], emb_k2_y[2], emb_k2_bit[2];
+	__m128i emb_k2_shift;
+	uint64_t emb_k2_res[8];
+	int emb_k2_v, emb_k2_i;
+
+	for (emb_k2_v = 0; emb_k2_v < 2; emb_k2_v++)
+	{
+		__m256i emb_k2_a = _mm256_loadu_si256((const __m256i*)(emb_k2_group->a + 4 * emb_k2_v));
+		__m256i emb_k2_r2 = _mm256_loadu_si256((const __m256i*)(emb_k2_group->r2 + 4 * emb_k2_v));
+
+		emb_k2_p[emb_k2_v] = _mm256_loadu_si256((const __m256i*)(emb_k2_group->p + 4 * emb_k2_v));
+		emb_k2_np[emb_k2_v] = _mm256_loadu_si256((const __m256i*)(emb_k2_group->np + 4 * emb_k2_v));
+		emb_k2_e[emb_k2_v] = _mm256_loadu_si256((const __m256i*)(emb_k2_group->e + 4 * emb_k2_v));
+		emb_k2_pm1[emb_k2_v] = _mm256_sub_epi64(emb_k2_p[emb_k2_v], emb_k2_one);
+
+		emb_k2_am[emb_k2_v] = emb_montmul_avx2(emb_k2_a, emb_k2_r2, emb_k2_p[emb_k2_v], emb_k2_np[emb_k2_v], emb_k2_pm1[emb_k2_v]);
+		emb_k2_x[emb_k2_v] = emb_montmul_avx2(emb_k2_one, emb_k2_r2, emb_k2_p[emb_k2_v], emb_k2_np[emb_k2_v], emb_k2_pm1[emb_k2_v]);
+	}
+
+	for (emb_k2_i = emb_k2_bits - 1; emb_k2_i >= 0; emb_k2_i--)
+	{
+		emb_k2_shift = _mm_cvtsi32_si128(emb_k2_i);
+
+		for (emb_k2_v = 0; emb_k2_v < 2; emb_k2_v++)
+		{
+			emb_k2_x[emb_k2_v] = emb_montmul_avx2(emb_k2_x[emb_k2_v], emb_k2_x[emb_k2_v], emb_k2_p[emb_k2_v], emb_k2_np[emb_k2_v], emb_k2_pm1[emb_k2_v]);
+		}
+
+		for (emb_k2_v = 0; emb_k2_v < 2; emb_k2_v++)
+		{
+			emb_k2_y[emb_k2_v] = emb_montmul_avx2(emb_k2_x[emb_k2_v], emb_k2_am[emb_k2_v], emb_k2_p[emb_k2_v], emb_k2_np[emb_k2_v], emb_k2_pm1[emb_k2_v]);
+			emb_k2_bit[emb_k2_v] = _mm256_sub_epi64(
+				_mm256_setzero_si256(),
+				_mm256_and_si256(_mm256_srl_epi64(emb_k2_e[emb_k2_v], emb_k2_shift), emb_k2_one));
+			emb_k2_x[emb_k2_v] = _mm256_blendv_epi8(emb_k2_x[emb_k2_v], emb_k2_y[emb_k2_v], emb_k2_bit[emb_k2_v]);
+		}
+	}
+
+	for (emb_k2_v = 0; emb_k2_v < 2; emb_k2_v++)
+	{
+		emb_k2_x[emb_k2_v] = emb_montmul_avx2(emb_k2_x[emb_k2_v], emb_k2_one, emb_k2_p[emb_k2_v], emb_k2_np[emb_k2_v], emb_k2_pm1[emb_k2_v]);
+		_mm256_storeu_si256((__m256i*)(emb_k2_res + 4 * emb_k2_v), emb_k2_x[emb_k2_v]);
+	}
+
+	for (emb_k2_i = 0; emb_k2_i < 8; emb_k2_i++)
+	{
+		emb_k2_group->out[emb_k2_i] = (uint32_t)emb_k2_res[emb_k2_i];
+	}
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC 12's AVX-512 intrinsics start from an uninitialized placeholder
+// vector and warn at every inlined use
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+EXP_MOD_BATCH_TARGET("avx512f")
+static inline __m512i emb_montmul_avx512(__m512i emb_mm5_x, __m512i emb_mm5_y, __m512i emb_mm5_p, __m512i emb_mm5_np)
+{
+	__m512i emb_mm5_t = _mm512_mul_epu32(emb_mm5_x, emb_mm5_y);
+	__m512i emb_mm5_mp = _mm512_mul_epu32(_mm512_mul_epu32(emb_mm5_t, emb_mm5_np), emb_mm5_p);
+	__mmask8 emb_mm5_lo_nonzero = _mm512_test_epi64_mask(emb_mm5_t, _mm512_set1_epi64(0xFFFFFFFFll));
+	__m512i emb_mm5_u = _mm512_add_epi64(_mm512_srli_epi64(emb_mm5_t, 32), _mm512_srli_epi64(emb_mm5_mp, 32));
+
+	emb_mm5_u = _mm512_mask_add_epi64(emb_mm5_u, emb_mm5_lo_nonzero, emb_mm5_u, _mm512_set1_epi64(1));
+
+	return _mm512_mask_sub_epi64(emb_mm5_u, _mm512_cmpge_epu64_mask(emb_mm5_u, emb_mm5_p), emb_mm5_u, emb_mm5_p);
+}
+
+EXP_MOD_BATCH_TARGET("avx512f")
+static void emb_kernel_avx512(struct EmbGroup* emb_k5_group, int emb_k5_bits)
+{
+	__m512i emb_k5_one = _mm512_set1_epi64(1);
+	__m512i emb_k5_p[2], emb_k5_np[2], emb_k5_e[2], emb_k5_am[2], emb_k5_x[2], emb_k5_y[2];
+	__m128i emb_k5_shift;
+	uint64_t emb_k5_res[16];
+	int emb_k5_v, emb_k5_i;
+
+	for (emb_k5_v = 0; emb_k5_v < 2; emb_k5_v++)
+	{
+		__m512i emb_k5_a = _mm512_loadu_si512((const void*)(emb_k5_group->a + 8 * emb_k5_v));
+		__m512i emb_k5_r2 = _mm512_loadu_si512((const void*)(emb_k5_group->r2 + 8 * emb_k5_v));
+
+		emb_k5_p[emb_k5_v] = _mm512_loadu_si512((const void*)(emb_k5_group->p + 8 * emb_k5_v));
+		emb_k5_np[emb_k5_v] = _mm512_loadu_si512((const void*)(emb_k5_group->np + 8 * emb_k5_v));
+		emb_k5_e[emb_k5_v] = _mm512_loadu_si512((const void*)(emb_k5_group->e + 8 * emb_k5_v));
+
+		emb_k5_am[emb_k5_v] = emb_montmul_avx512(emb_k5_a, emb_k5_r2, emb_k5_p[emb_k5_v], emb_k5_np[emb_k5_v]);
+		emb_k5_x[emb_k5_v] = emb_montmul_avx512(emb_k5_one, emb_k5_r2, emb_k5_p[emb_k5_v], emb_k5_np[emb_k5_v]);
+	}
+
+	for (emb_k5_i = emb_k5_bits - 1; emb_k5_i >= 0; emb_k5_i--)
+	{
+		emb_k5_shift = _mm_cvtsi32_si128(emb_k5_i);
+
+		for (emb_k5_v = 0; emb_k5_v < 2; emb_k5_v++)
+		{
+			emb_k5_x[emb_k5_v] = emb_montmul_avx512(emb_k5_x[emb_k5_v], emb_k5_x[emb_k5_v], emb_k5_p[emb_k5_v], emb_k5_np[emb_k5_v]);
+		}
+
+		for (emb_k5_v = 0; emb_k5_v < 2; emb_k5_v++)
+		{
+			emb_k5_y[emb_k5_v] = emb_montmul_avx512(emb_k5_x[emb_k5_v], emb_k5_am[emb_k5_v], emb_k5_p[emb_k5_v], emb_k5_np[emb_k5_v]);
+			emb_k5_x[emb_k5_v] = _mm512_mask_blend_epi64(
+				_mm512_test_epi64_mask(_mm512_srl_epi64(emb_k5_e[emb_k5_v], emb_k5_shift), emb_k5_one),
+				emb_k5_x[emb_k5_v],
+				emb_k5_y[emb_k5_v]);
+		}
+	}
+
+	for (emb_k5_v = 0; emb_k5_v < 2; emb_k5_v++)
+	{
+		emb_k5_x[emb_k5_v] = emb_montmul_avx512(emb_k5_x[emb_k5_v], emb_k5_one, emb_k5_p[emb_k5_v], emb_k5_np[emb_k5_v]);
+		_mm512_storeu_si512((void*)(emb_k5_res + 8 * emb_k5_v), emb_k5_x[emb_k5_v]);
+	}
+
+	for (emb_k5_i = 0; emb_k5_i < 16; emb_k5_i++)
+	{
+		emb_k5_group->out[emb_k5_i] = (uint32_t)emb_k5_res[emb_k5_i];
+	}
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static int emb_detect_lanes()
+{
+#ifdef _MSC_VER
+	int emb_detect_regs[4];
+	unsigned long long emb_detect_xcr0;
+	int emb_detect_lanes = 1;
+
+	__cpuid(emb_detect_regs, 0);
+	if (emb_detect_regs[0] < 7)
+	{
+		return 1;
+	}
+
+	// OSXSAVE and AVX, then the OS must save the YMM (and ZMM) state
+	__cpuid(emb_detect_regs, 1);
+	if ((emb_detect_regs[2] & (1 << 27)) == 0 || (emb_detect_regs[2] & (1 << 28)) == 0)
+	{
+		return 1;
+	}
+
+	emb_detect_xcr0 = _xgetbv(0);
+	__cpuidex(emb_detect_regs, 7, 0);
+
+	if ((emb_detect_xcr0 & 0x6) == 0x6 && (emb_detect_regs[1] & (1 << 5)))
+	{
+		emb_detect_lanes = 8;
+	}
+
+	if ((emb_detect_xcr0 & 0xE6) == 0xE6 && (emb_detect_regs[1] & (1 << 16)))
+	{
+		emb_detect_lanes = 16;
+	}
+
+	return emb_detect_lanes;
+#else
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return 16;
+	}
+
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return 8;
+	}
+
+	return 1;
+#endif
+}
+
+static int emb_cpu_lanes()
+{
+	static const int emb_cpu_lanes_detected = emb_detect_lanes();
+	return emb_cpu_lanes_detected;
+}
+
+#else
+
+static int emb_cpu_lanes()
+{
+	return 1;
+}
+
+#endif
+
+int exp_mod_batch_set_max_lanes(int exp_mod_batch_maxl_lanes)
+{
+	if (exp_mod_batch_maxl_lanes != 1 && exp_mod_batch_maxl_lanes != 8 && exp_mod_batch_maxl_lanes != 16)
+	{
+		return 0;
+	}
+
+	kExpModBatchMaxLanes = exp_mod_batch_maxl_lanes;
+	return 1;
+}
+
+int exp_mod_batch_lanes()
+{
+	int exp_mod_batch_lanes_cpu = emb_cpu_lanes();
+
+	if (kExpModBatchMaxLanes >= 16 && exp_mod_batch_lanes_cpu >= 16)
+	{
+		return 16;
+	}
+
+	if (kExpModBatchMaxLanes >= 8 && exp_mod_batch_lanes_cpu >= 8)
+	{
+		return 8;
+	}
+
+	return 1;
+}
+
+#ifdef EXP_MOD_BATCH_X86
+
+// Runs the filled lanes of a group and scatters the results. Unused lanes
+// compute 0^0 mod 1.
+static void emb_group_run(struct EmbGroup* emb_run_group, int emb_run_lanes, int emb_run_out[])
+{
+	int emb_run_i, emb_run_bits = 0;
+
+	for (emb_run_i = emb_run_group->size; emb_run_i < emb_run_lanes; emb_run_i++)
+	{
+		emb_group_set(emb_run_group, emb_run_i, 0, 0, 1);
+	}
+
+	while (emb_run_bits < 32 && (emb_run_group->e_or >> emb_run_bits))
+	{
+		emb_run_bits++;
+	}
+
+	if (emb_run_lanes == 16)
+	{
+		emb_kernel_avx512(emb_run_group, emb_run_bits);
+	}
+	else
+	{
+		emb_kernel_avx2(emb_run_group, emb_run_bits);
+	}
+
+	for (emb_run_i = 0; emb_run_i < emb_run_group->size; emb_run_i++)
+	{
+		emb_run_out[emb_run_group->index[emb_run_i]] = (int)emb_run_group->out[emb_run_i];
+	}
+
+	emb_run_group->size = 0;
+	emb_run_group->e_or = 0;
+}
+
+#endif
+
+int exp_mod_batch(
+	int exp_mod_batch_out[],
+	int exp_mod_batch_a[],
+	int exp_mod_batch_b[],
+	int exp_mod_batch_p[],
+	int exp_mod_batch_count)
+{
+	int exp_mod_batch_lanes_used = exp_mod_batch_lanes();
+	int exp_mod_batch_i;
+
+	if (exp_mod_batch_count < 0)
+	{
+		return 0;
+	}
+
+#ifdef EXP_MOD_BATCH_X86
+	if (exp_mod_batch_lanes_used > 1)
+	{
+		struct EmbGroup exp_mod_batch_group;
+
+		exp_mod_batch_group.size = 0;
+		exp_mod_batch_group.e_or = 0;
+
+		// Odd moduli with a nonzero exponent are packed into the lanes in
+		// input order; the rest are answered on the spot.
+		for (exp_mod_batch_i = 0; exp_mod_batch_i < exp_mod_batch_count; exp_mod_batch_i++)
+		{
+			if ((exp_mod_batch_p[exp_mod_batch_i] & 1) == 0 || exp_mod_batch_b[exp_mod_batch_i] == 0)
+			{
+				exp_mod_batch_out[exp_mod_batch_i] = emb_scalar(
+					exp_mod_batch_a[exp_mod_batch_i],
+					exp_mod_batch_b[exp_mod_batch_i],
+					exp_mod_batch_p[exp_mod_batch_i]);
+				continue;
+			}
+
+			emb_group_set(
+				&exp_mod_batch_group,
+				exp_mod_batch_group.size,
+				(uint32_t)exp_mod_batch_a[exp_mod_batch_i],
+				emb_abs(exp_mod_batch_b[exp_mod_batch_i]),
+				(uint32_t)exp_mod_batch_p[exp_mod_batch_i]);
+			exp_mod_batch_group.index[exp_mod_batch_group.size] = exp_mod_batch_i;
+			exp_mod_batch_group.e_or |= emb_abs(exp_mod_batch_b[exp_mod_batch_i]);
+			exp_mod_batch_group.size++;
+
+			if (exp_mod_batch_group.size == exp_mod_batch_lanes_used)
+			{
+				emb_group_run(&exp_mod_batch_group, exp_mod_batch_lanes_used, exp_mod_batch_out);
+			}
+		}
+
+		if (exp_mod_batch_group.size > 0)
+		{
+			emb_group_run(&exp_mod_batch_group, exp_mod_batch_lanes_used, exp_mod_batch_out);
+		}
+
+		return 1;
+	}
+#endif
+
+	for (exp_mod_batch_i = 0; exp_mod_batch_i < exp_mod_batch_count; exp_mod_batch_i++)
+	{
+		exp_mod_batch_out[exp_mod_batch_i] = emb_scalar(
+			exp_mod_batch_a[exp_mod_batch_i],
+			exp_mod_batch_b[exp_mod_batch_i],
+			exp_mod_batch_p[exp_mod_batch_i]);
+	}
+
+	return 1;
+}
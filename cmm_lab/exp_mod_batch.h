@@ -0,0 +1,24 @@
+#ifndef EXP_MOD_BATCH_H_
+#define EXP_MOD_BATCH_H_
+
+// out[i] = exp_mod(a[i], b[i], p[i]) for i in [0, count), bit-for-bit equal
+// to the scalar exp_mod (values are uint32, the exponent is |b|, b=0 gives 1).
+// Odd moduli run through Montgomery multiplication (R=2^32) in SIMD lanes:
+// 16 with AVX-512F, 8 with AVX2 (two interleaved 4-lane vectors), picked at
+// runtime. Even moduli and CPUs without either extension take a native
+// 64-bit scalar path.
+int exp_mod_batch(
+	int exp_mod_batch_out[],
+	int exp_mod_batch_a[],
+	int exp_mod_batch_b[],
+	int exp_mod_batch_p[],
+	int exp_mod_batch_count);
+
+// Caps the lane count exp_mod_batch may use (1, 8 or 16); mainly for
+// benchmarks. The CPU still has to support the chosen width.
+int exp_mod_batch_set_max_lanes(int exp_mod_batch_maxl_lanes);
+
+// Lane count exp_mod_batch currently runs with
+int exp_mod_batch_lanes();
+
+#endif
@@ -0,0 +1,1021 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "fuzz_diff.h"
+#include "bignum.h"
+#include "common.h"
+#include "crypto_core.h"
+#include "crypto_core64.h"
+#include "ct_op.h"
+#include "exp_mod_batch.h"
+#include "limb_core.h"
+#include "modint.h"
+#include "rsa.h"
+#include "rsa_soa.h"
+#include "unsigned_op.h"
+#include "unsigned_op_ref.h"
+
+#if defined(__SIZEOF_INT128__)
+typedef unsigned __int128 fuzz_diff_u128;
+typedef __int128 fuzz_diff_i128;
+#endif
+
+static const int kFuzzDiffReportLimit = 20;
+
+static const int kFuzzDiffEdges[] = {
+	0, 1, 2, 3, -1, -2, (int)0x80000000, (int)0x80000001,
+	0x7FFFFFFF, 0x7FFFFFFE, 0x7FFF, 0x8000, 0xFFFF, 0x10000, 0x10001, (int)0xFFFF0000
+};
+static const int kFuzzDiffEdgeCount = sizeof(kFuzzDiffEdges) / sizeof(kFuzzDiffEdges[0]);
+
+static const int kFuzzDiffShifts[] = { 0, 1, 31, 32, 33, 63, 64, 65 };
+static const int kFuzzDiffShiftCount = sizeof(kFuzzDiffShifts) / sizeof(kFuzzDiffShifts[0]);
+
+static const uint64_t kFuzzDiff62 = ((uint64_t)1 << 62) - 1;
+
+// Inputs random words practically never produce: one that takes
+// bn_div_mod's add-back step (qhat still one too large after refining),
+// from the divmnu tests in Hacker's Delight. a is words 0-7, b words
+// 8-15; words 12 and 13 pick 4 and 3 limbs.
+static const int kFuzzDiffFixed[][kFuzzDiffWords] = {
+	{ 0, 0, (int)0x80000000u, 0x7FFFFFFF, 0, 0, 0, 0, 1, 0, (int)0x80000000u, 0, 3, 2, 0, 0 },
+};
+static const int kFuzzDiffFixedCount = sizeof(kFuzzDiffFixed) / sizeof(kFuzzDiffFixed[0]);
+
+static int kFuzzDiffChecks = 0;
+static int kFuzzDiffReported = 0;
+
+static uint64_t fuzz_diff_u32(int fuzz_diff_u32_x)
+{
+	return (uint32_t)fuzz_diff_u32_x;
+}
+
+static uint64_t fuzz_diff_u64(const int fuzz_diff_u64_x[2])
+{
+	return (uint64_t)(uint32_t)fuzz_diff_u64_x[0] << 32 | (uint32_t)fuzz_diff_u64_x[1];
+}
+
+static int fuzz_diff_set(int fuzz_diff_set_out[2], uint64_t fuzz_diff_set_v)
+{
+	fuzz_diff_set_out[0] = (int)(uint32_t)(fuzz_diff_set_v >> 32);
+	fuzz_diff_set_out[1] = (int)(uint32_t)fuzz_diff_set_v;
+
+	return 1;
+}
+
+static int fuzz_diff_sign(uint64_t fuzz_diff_sign_a, uint64_t fuzz_diff_sign_b)
+{
+	return (fuzz_diff_sign_a > fuzz_diff_sign_b) - (fuzz_diff_sign_a < fuzz_diff_sign_b);
+}
+
+static int fuzz_diff_bits(uint64_t fuzz_diff_bits_x)
+{
+	int fuzz_diff_bits_n = 0;
+
+	while (fuzz_diff_bits_x)
+	{
+		fuzz_diff_bits_x >>= 1;
+		fuzz_diff_bits_n++;
+	}
+
+	return fuzz_diff_bits_n;
+}
+
+// Return 1 on a mismatch, printing the operands for the first few
+static int fuzz_diff_check(
+	const char* fuzz_diff_check_name,
+	uint64_t fuzz_diff_check_got,
+	uint64_t fuzz_diff_check_want,
+	uint64_t fuzz_diff_check_x,
+	uint64_t fuzz_diff_check_y,
+	uint64_t fuzz_diff_check_z)
+{
+	kFuzzDiffChecks++;
+
+	if (fuzz_diff_check_got == fuzz_diff_check_want)
+	{
+		return 0;
+	}
+
+	if (kFuzzDiffReported < kFuzzDiffReportLimit)
+	{
+		printf("%s(0x%llx, 0x%llx, 0x%llx): got 0x%llx, want 0x%llx\n",
+			fuzz_diff_check_name,
+			(unsigned long long)fuzz_diff_check_x,
+			(unsigned long long)fuzz_diff_check_y,
+			(unsigned long long)fuzz_diff_check_z,
+			(unsigned long long)fuzz_diff_check_got,
+			(unsigned long long)fuzz_diff_check_want);
+		kFuzzDiffReported++;
+	}
+
+	return 1;
+}
+
+// first differing limb of two n-limb numbers
+static int fuzz_diff_check_limbs(
+	const char* fuzz_diff_limbs_name,
+	const int fuzz_diff_limbs_got[],
+	const int fuzz_diff_limbs_want[],
+	int fuzz_diff_limbs_n,
+	int fuzz_diff_limbs_size)
+{
+	for (int fuzz_diff_limbs_i = 0; fuzz_diff_limbs_i < fuzz_diff_limbs_n; fuzz_diff_limbs_i++)
+	{
+		if (fuzz_diff_limbs_got[fuzz_diff_limbs_i] != fuzz_diff_limbs_want[fuzz_diff_limbs_i])
+		{
+			return fuzz_diff_check(
+				fuzz_diff_limbs_name,
+				fuzz_diff_u32(fuzz_diff_limbs_got[fuzz_diff_limbs_i]),
+				fuzz_diff_u32(fuzz_diff_limbs_want[fuzz_diff_limbs_i]),
+				fuzz_diff_limbs_size,
+				fuzz_diff_limbs_i,
+				0);
+		}
+	}
+
+	return fuzz_diff_check(fuzz_diff_limbs_name, 0, 0, 0, 0, 0);
+}
+
+// exp_mod's semantics: uint32 values, the exponent is |b| and b=0 gives 1
+static uint64_t fuzz_diff_exp_mod32(int fuzz_diff_em_a, int fuzz_diff_em_b, int fuzz_diff_em_p)
+{
+	uint64_t fuzz_diff_em_p64 = (uint32_t)fuzz_diff_em_p;
+	uint64_t fuzz_diff_em_x = (uint32_t)fuzz_diff_em_a % fuzz_diff_em_p64;
+	uint64_t fuzz_diff_em_r = 1;
+	uint32_t fuzz_diff_em_e = fuzz_diff_em_b < 0 ? 0u - (uint32_t)fuzz_diff_em_b : (uint32_t)fuzz_diff_em_b;
+
+	while (fuzz_diff_em_e)
+	{
+		if (fuzz_diff_em_e & 1)
+		{
+			fuzz_diff_em_r = fuzz_diff_em_r * fuzz_diff_em_x % fuzz_diff_em_p64;
+		}
+
+		fuzz_diff_em_e >>= 1;
+		fuzz_diff_em_x = fuzz_diff_em_x * fuzz_diff_em_x % fuzz_diff_em_p64;
+	}
+
+	return fuzz_diff_em_r;
+}
+
+// a^-1 mod n by the extended Euclidean algorithm; 0 if gcd(a, n) != 1
+static uint64_t fuzz_diff_inverse32(uint64_t fuzz_diff_inv_a, uint64_t fuzz_diff_inv_n)
+{
+	int64_t fuzz_diff_inv_r0 = (int64_t)fuzz_diff_inv_n, fuzz_diff_inv_r1 = (int64_t)(fuzz_diff_inv_a % fuzz_diff_inv_n);
+	int64_t fuzz_diff_inv_t0 = 0, fuzz_diff_inv_t1 = 1;
+
+	while (fuzz_diff_inv_r1 != 0)
+	{
+		int64_t fuzz_diff_inv_q = fuzz_diff_inv_r0 / fuzz_diff_inv_r1;
+		int64_t fuzz_diff_inv_r2 = fuzz_diff_inv_r0 - fuzz_diff_inv_q * fuzz_diff_inv_r1;
+		int64_t fuzz_diff_inv_t2 = fuzz_diff_inv_t0 - fuzz_diff_inv_q * fuzz_diff_inv_t1;
+
+		fuzz_diff_inv_r0 = fuzz_diff_inv_r1;
+		fuzz_diff_inv_r1 = fuzz_diff_inv_r2;
+		fuzz_diff_inv_t0 = fuzz_diff_inv_t1;
+		fuzz_diff_inv_t1 = fuzz_diff_inv_t2;
+	}
+
+	if (fuzz_diff_inv_r0 != 1)
+	{
+		return 0;
+	}
+
+	return (uint64_t)(fuzz_diff_inv_t0 < 0 ? fuzz_diff_inv_t0 + (int64_t)fuzz_diff_inv_n : fuzz_diff_inv_t0);
+}
+
+#if defined(__SIZEOF_INT128__)
+static uint64_t fuzz_diff_mul_mod64(uint64_t fuzz_diff_mm_a, uint64_t fuzz_diff_mm_b, uint64_t fuzz_diff_mm_m)
+{
+	return (uint64_t)((fuzz_diff_u128)fuzz_diff_mm_a * fuzz_diff_mm_b % fuzz_diff_mm_m);
+}
+
+static uint64_t fuzz_diff_exp_mod64(uint64_t fuzz_diff_em64_a, uint64_t fuzz_diff_em64_e, uint64_t fuzz_diff_em64_m)
+{
+	uint64_t fuzz_diff_em64_r = 1 % fuzz_diff_em64_m;
+
+	fuzz_diff_em64_a %= fuzz_diff_em64_m;
+	while (fuzz_diff_em64_e)
+	{
+		if (fuzz_diff_em64_e & 1)
+		{
+			fuzz_diff_em64_r = fuzz_diff_mul_mod64(fuzz_diff_em64_r, fuzz_diff_em64_a, fuzz_diff_em64_m);
+		}
+
+		fuzz_diff_em64_e >>= 1;
+		fuzz_diff_em64_a = fuzz_diff_mul_mod64(fuzz_diff_em64_a, fuzz_diff_em64_a, fuzz_diff_em64_m);
+	}
+
+	return fuzz_diff_em64_r;
+}
+
+static uint64_t fuzz_diff_inverse64(uint64_t fuzz_diff_inv64_a, uint64_t fuzz_diff_inv64_n)
+{
+	fuzz_diff_i128 fuzz_diff_inv64_r0 = fuzz_diff_inv64_n, fuzz_diff_inv64_r1 = fuzz_diff_inv64_a % fuzz_diff_inv64_n;
+	fuzz_diff_i128 fuzz_diff_inv64_t0 = 0, fuzz_diff_inv64_t1 = 1;
+
+	while (fuzz_diff_inv64_r1 != 0)
+	{
+		fuzz_diff_i128 fuzz_diff_inv64_q = fuzz_diff_inv64_r0 / fuzz_diff_inv64_r1;
+		fuzz_diff_i128 fuzz_diff_inv64_r2 = fuzz_diff_inv64_r0 - fuzz_diff_inv64_q * fuzz_diff_inv64_r1;
+		fuzz_diff_i128 fuzz_diff_inv64_t2 = fuzz_diff_inv64_t0 - fuzz_diff_inv64_q * fuzz_diff_inv64_t1;
+
+		fuzz_diff_inv64_r0 = fuzz_diff_inv64_r1;
+		fuzz_diff_inv64_r1 = fuzz_diff_inv64_r2;
+		fuzz_diff_inv64_t0 = fuzz_diff_inv64_t1;
+		fuzz_diff_inv64_t1 = fuzz_diff_inv64_t2;
+	}
+
+	if (fuzz_diff_inv64_r0 != 1)
+	{
+		return 0;
+	}
+
+	return (uint64_t)(fuzz_diff_inv64_t0 < 0 ? fuzz_diff_inv64_t0 + fuzz_diff_inv64_n : fuzz_diff_inv64_t0);
+}
+#endif
+
+static int fuzz_diff_unsigned_op32(int fd32_w[kFuzzDiffWords])
+{
+	int fd32_x = fd32_w[0], fd32_y = fd32_w[1];
+	uint64_t fd32_ux = fuzz_diff_u32(fd32_x), fd32_uy = fuzz_diff_u32(fd32_y);
+	int fd32_d = fd32_y == 0 ? 1 : fd32_y;
+	uint64_t fd32_ud = fuzz_diff_u32(fd32_d);
+	int fd32_carry[1], fd32_ref_carry[1], fd32_out[2], fd32_rem[1];
+	int fd32_r, fd32_ref;
+	int fd32_mismatches = 0;
+
+	for (int fd32_k = 14; fd32_k < 16; fd32_k++)
+	{
+		int fd32_s = (int)(fuzz_diff_u32(fd32_w[fd32_k]) % 72);
+
+		fd32_mismatches += fuzz_diff_check("rshift_uint32",
+			fuzz_diff_u32(rshift_uint32(fd32_x, fd32_s)),
+			fd32_s >= 32 ? 0 : fd32_ux >> fd32_s,
+			fd32_ux, fd32_s, 0);
+		fd32_mismatches += fuzz_diff_check("lshift_uint32",
+			fuzz_diff_u32(lshift_uint32(fd32_x, fd32_s)),
+			fd32_s >= 32 ? 0 : (uint32_t)(fd32_ux << fd32_s),
+			fd32_ux, fd32_s, 0);
+	}
+
+	fd32_mismatches += fuzz_diff_check("get_bits_uint32",
+		get_bits_uint32(fd32_x), fuzz_diff_bits(fd32_ux), fd32_ux, 0, 0);
+	fd32_mismatches += fuzz_diff_check("lt_uint32",
+		lt_uint32(fd32_x, fd32_y), fd32_ux < fd32_uy, fd32_ux, fd32_uy, 0);
+	fd32_mismatches += fuzz_diff_check("cmp_uint32",
+		(uint64_t)(int64_t)cmp_uint32(fd32_x, fd32_y), (uint64_t)(int64_t)fuzz_diff_sign(fd32_ux, fd32_uy),
+		fd32_ux, fd32_uy, 0);
+	fd32_mismatches += fuzz_diff_check("cmp_uint32 vs ref",
+		(uint64_t)(int64_t)cmp_uint32(fd32_x, fd32_y), (uint64_t)(int64_t)cmp_uint32_ref(fd32_x, fd32_y),
+		fd32_ux, fd32_uy, 0);
+	fd32_mismatches += fuzz_diff_check("neg_uint32",
+		fuzz_diff_u32(neg_uint32(fd32_x)), (uint32_t)(0 - fd32_ux), fd32_ux, 0, 0);
+
+	fd32_r = add_full_uint32(fd32_carry, fd32_x, fd32_y);
+	fd32_ref = add_full_uint32_ref(fd32_ref_carry, fd32_x, fd32_y);
+	fd32_mismatches += fuzz_diff_check("add_full_uint32",
+		fuzz_diff_u32(fd32_carry[0]) << 32 | fuzz_diff_u32(fd32_r), fd32_ux + fd32_uy, fd32_ux, fd32_uy, 0);
+	fd32_mismatches += fuzz_diff_check("add_full_uint32 vs ref",
+		fuzz_diff_u32(fd32_carry[0]) << 32 | fuzz_diff_u32(fd32_r),
+		fuzz_diff_u32(fd32_ref_carry[0]) << 32 | fuzz_diff_u32(fd32_ref),
+		fd32_ux, fd32_uy, 0);
+
+	fd32_r = sub_full_uint32(fd32_carry, fd32_x, fd32_y);
+	fd32_ref = sub_full_uint32_ref(fd32_ref_carry, fd32_x, fd32_y);
+	fd32_mismatches += fuzz_diff_check("sub_full_uint32",
+		fuzz_diff_u32(fd32_carry[0]) << 32 | fuzz_diff_u32(fd32_r),
+		(uint64_t)(fd32_ux < fd32_uy) << 32 | (uint32_t)(fd32_ux - fd32_uy),
+		fd32_ux, fd32_uy, 0);
+	fd32_mismatches += fuzz_diff_check("sub_full_uint32 vs ref",
+		fuzz_diff_u32(fd32_carry[0]) << 32 | fuzz_diff_u32(fd32_r),
+		fuzz_diff_u32(fd32_ref_carry[0]) << 32 | fuzz_diff_u32(fd32_ref),
+		fd32_ux, fd32_uy, 0);
+
+	mul_uint32(fd32_out, fd32_x, fd32_y);
+	fd32_mismatches += fuzz_diff_check("mul_uint32",
+		fuzz_diff_u64(fd32_out), fd32_ux * fd32_uy, fd32_ux, fd32_uy, 0);
+
+	fd32_r = div_mod_uint32(fd32_rem, fd32_x, fd32_d);
+	fd32_mismatches += fuzz_diff_check("div_mod_uint32",
+		fuzz_diff_u32(fd32_r) << 32 | fuzz_diff_u32(fd32_rem[0]),
+		fd32_ux / fd32_ud << 32 | fd32_ux % fd32_ud,
+		fd32_ux, fd32_ud, 0);
+	fd32_mismatches += fuzz_diff_check("div_uint32",
+		fuzz_diff_u32(div_uint32(fd32_x, fd32_d)), fd32_ux / fd32_ud, fd32_ux, fd32_ud, 0);
+	fd32_mismatches += fuzz_diff_check("mod_uint32",
+		fuzz_diff_u32(mod_uint32(fd32_x, fd32_d)), fd32_ux % fd32_ud, fd32_ux, fd32_ud, 0);
+
+	return fd32_mismatches;
+}
+
+static int fuzz_diff_unsigned_op64(int fd64_w[kFuzzDiffWords])
+{
+	int fd64_a[2] = { fd64_w[3], fd64_w[4] };
+	int fd64_b[2] = { fd64_w[5], fd64_w[6] };
+	uint64_t fd64_ua = fuzz_diff_u64(fd64_a), fd64_ub = fuzz_diff_u64(fd64_b);
+	int fd64_out[2], fd64_rem[2], fd64_carry[1], fd64_d[2];
+	uint64_t fd64_ud;
+	int fd64_mismatches = 0;
+
+	for (int fd64_k = 14; fd64_k < 16; fd64_k++)
+	{
+		int fd64_s = (int)(fuzz_diff_u32(fd64_w[fd64_k]) % 72);
+
+		rshift_uint64(fd64_out, fd64_a, fd64_s);
+		fd64_mismatches += fuzz_diff_check("rshift_uint64",
+			fuzz_diff_u64(fd64_out), fd64_s >= 64 ? 0 : fd64_ua >> fd64_s, fd64_ua, fd64_s, 0);
+		lshift_uint64(fd64_out, fd64_a, fd64_s);
+		fd64_mismatches += fuzz_diff_check("lshift_uint64",
+			fuzz_diff_u64(fd64_out), fd64_s >= 64 ? 0 : fd64_ua << fd64_s, fd64_ua, fd64_s, 0);
+	}
+
+	fd64_mismatches += fuzz_diff_check("get_bits_uint64",
+		get_bits_uint64(fd64_a), fuzz_diff_bits(fd64_ua), fd64_ua, 0, 0);
+	fd64_mismatches += fuzz_diff_check("cmp_uint64",
+		(uint64_t)(int64_t)cmp_uint64(fd64_a, fd64_b), (uint64_t)(int64_t)fuzz_diff_sign(fd64_ua, fd64_ub),
+		fd64_ua, fd64_ub, 0);
+	fd64_mismatches += fuzz_diff_check("cmp_uint64 vs ref",
+		(uint64_t)(int64_t)cmp_uint64(fd64_a, fd64_b), (uint64_t)(int64_t)cmp_uint64_ref(fd64_a, fd64_b),
+		fd64_ua, fd64_ub, 0);
+
+	add_full_uint64(fd64_out, fd64_carry, fd64_a, fd64_b);
+	fd64_mismatches += fuzz_diff_check("add_full_uint64",
+		fuzz_diff_u64(fd64_out), fd64_ua + fd64_ub, fd64_ua, fd64_ub, 0);
+	fd64_mismatches += fuzz_diff_check("add_full_uint64 carry",
+		fuzz_diff_u32(fd64_carry[0]), fd64_ua + fd64_ub < fd64_ua, fd64_ua, fd64_ub, 0);
+	add_uint64(fd64_out, fd64_a, fd64_b);
+	fd64_mismatches += fuzz_diff_check("add_uint64",
+		fuzz_diff_u64(fd64_out), fd64_ua + fd64_ub, fd64_ua, fd64_ub, 0);
+	neg_uint64(fd64_out, fd64_a);
+	fd64_mismatches += fuzz_diff_check("neg_uint64",
+		fuzz_diff_u64(fd64_out), 0 - fd64_ua, fd64_ua, 0, 0);
+
+	sub_full_uint64(fd64_out, fd64_carry, fd64_a, fd64_b);
+	fd64_mismatches += fuzz_diff_check("sub_full_uint64",
+		fuzz_diff_u64(fd64_out), fd64_ua - fd64_ub, fd64_ua, fd64_ub, 0);
+	fd64_mismatches += fuzz_diff_check("sub_full_uint64 borrow",
+		fuzz_diff_u32(fd64_carry[0]), fd64_ua < fd64_ub, fd64_ua, fd64_ub, 0);
+	sub_uint64(fd64_out, fd64_a, fd64_b);
+	fd64_mismatches += fuzz_diff_check("sub_uint64",
+		fuzz_diff_u64(fd64_out), fd64_ua - fd64_ub, fd64_ua, fd64_ub, 0);
+	mul_uint64(fd64_out, fd64_a, fd64_b);
+	fd64_mismatches += fuzz_diff_check("mul_uint64",
+		fuzz_diff_u64(fd64_out), fd64_ua * fd64_ub, fd64_ua, fd64_ub, 0);
+
+	// a full 64-bit divisor, then one that fits the low word
+	for (int fd64_k = 0; fd64_k < 2; fd64_k++)
+	{
+		fd64_ud = fd64_k == 0 ? fd64_ub : fuzz_diff_u32(fd64_b[1]);
+		fd64_ud = fd64_ud == 0 ? 1 : fd64_ud;
+		fuzz_diff_set(fd64_d, fd64_ud);
+
+		div_mod_uint64(fd64_out, fd64_rem, fd64_a, fd64_d);
+		fd64_mismatches += fuzz_diff_check("div_mod_uint64",
+			fuzz_diff_u64(fd64_out), fd64_ua / fd64_ud, fd64_ua, fd64_ud, 0);
+		fd64_mismatches += fuzz_diff_check("div_mod_uint64 rem",
+			fuzz_diff_u64(fd64_rem), fd64_ua % fd64_ud, fd64_ua, fd64_ud, 0);
+		div_uint64(fd64_out, fd64_a, fd64_d);
+		fd64_mismatches += fuzz_diff_check("div_uint64",
+			fuzz_diff_u64(fd64_out), fd64_ua / fd64_ud, fd64_ua, fd64_ud, 0);
+		mod_uint64(fd64_out, fd64_a, fd64_d);
+		fd64_mismatches += fuzz_diff_check("mod_uint64",
+			fuzz_diff_u64(fd64_out), fd64_ua % fd64_ud, fd64_ua, fd64_ud, 0);
+	}
+
+#if defined(__SIZEOF_INT128__)
+	int fd64_hi[2], fd64_lo[2], fd64_m[2] = { fd64_w[7], fd64_w[8] };
+	uint64_t fd64_um = fuzz_diff_u64(fd64_m);
+	fuzz_diff_u128 fd64_prod = (fuzz_diff_u128)fd64_ua * fd64_ub;
+
+	mul_full_uint64(fd64_hi, fd64_lo, fd64_a, fd64_b);
+	fd64_mismatches += fuzz_diff_check("mul_full_uint64 hi",
+		fuzz_diff_u64(fd64_hi), (uint64_t)(fd64_prod >> 64), fd64_ua, fd64_ub, 0);
+	fd64_mismatches += fuzz_diff_check("mul_full_uint64 lo",
+		fuzz_diff_u64(fd64_lo), (uint64_t)fd64_prod, fd64_ua, fd64_ub, 0);
+
+	// hi must be below m
+	fd64_um = fd64_um == 0 ? 1 : fd64_um;
+	fuzz_diff_set(fd64_m, fd64_um);
+	fuzz_diff_set(fd64_hi, fd64_ua % fd64_um);
+	mod_uint128(fd64_out, fd64_hi, fd64_b, fd64_m);
+	fd64_mismatches += fuzz_diff_check("mod_uint128",
+		fuzz_diff_u64(fd64_out),
+		(uint64_t)(((fuzz_diff_u128)(fd64_ua % fd64_um) << 64 | fd64_ub) % fd64_um),
+		fd64_ua % fd64_um, fd64_ub, fd64_um);
+#endif
+
+	return fd64_mismatches;
+}
+
+// crypto_core and its constant-time counterparts in ct_op
+static int fuzz_diff_crypto_core(int fdcc_w[kFuzzDiffWords])
+{
+	int fdcc_x = fdcc_w[0], fdcc_y = fdcc_w[1], fdcc_e = fdcc_w[2];
+	int fdcc_p = fdcc_w[7] == 0 ? 1 : fdcc_w[7];
+	uint64_t fdcc_ux = fuzz_diff_u32(fdcc_x), fdcc_uy = fuzz_diff_u32(fdcc_y), fdcc_up = fuzz_diff_u32(fdcc_p);
+	int fdcc_a64[2] = { fdcc_w[3], fdcc_w[4] };
+	int fdcc_prod[2];
+	int fdcc_table[kFuzzDiffWords];
+	int fdcc_index = (int)(fuzz_diff_u32(fdcc_w[9]) % kFuzzDiffWords);
+	int fdcc_flag = fdcc_w[10] & 1;
+	int fdcc_sx[1] = { fdcc_x }, fdcc_sy[1] = { fdcc_y };
+	uint64_t fdcc_n = fuzz_diff_u32(fdcc_w[8]) & 0x7FFFFFFF;
+	uint64_t fdcc_inv_a, fdcc_inv_want;
+	int fdcc_inv[1], fdcc_inv_ok;
+	uint64_t fdcc_want;
+	int fdcc_ref;
+	int fdcc_mismatches = 0;
+
+	fdcc_want = fdcc_ux * fdcc_uy % fdcc_up;
+	fdcc_ref = mul_mod(fdcc_x, fdcc_y, fdcc_p);
+	fdcc_mismatches += fuzz_diff_check("mul_mod",
+		fuzz_diff_u32(fdcc_ref), fdcc_want, fdcc_ux, fdcc_uy, fdcc_up);
+	fdcc_mismatches += fuzz_diff_check("mul_mod_ct",
+		fuzz_diff_u32(mul_mod_ct(fdcc_x, fdcc_y, fdcc_p)), fuzz_diff_u32(fdcc_ref), fdcc_ux, fdcc_uy, fdcc_up);
+
+	fdcc_want = fuzz_diff_exp_mod32(fdcc_x, fdcc_e, fdcc_p);
+	fdcc_ref = exp_mod(fdcc_x, fdcc_e, fdcc_p);
+	fdcc_mismatches += fuzz_diff_check("exp_mod",
+		fuzz_diff_u32(fdcc_ref), fdcc_want, fdcc_ux, fuzz_diff_u32(fdcc_e), fdcc_up);
+	fdcc_mismatches += fuzz_diff_check("exp_mod_ct",
+		fuzz_diff_u32(exp_mod_ct(fdcc_x, fdcc_e, fdcc_p)), fuzz_diff_u32(fdcc_ref),
+		fdcc_ux, fuzz_diff_u32(fdcc_e), fdcc_up);
+	fdcc_mismatches += fuzz_diff_check("exp_mod_ct_window",
+		fuzz_diff_u32(exp_mod_ct_window(fdcc_x, fdcc_e, fdcc_p)), fuzz_diff_u32(fdcc_ref),
+		fdcc_ux, fuzz_diff_u32(fdcc_e), fdcc_up);
+
+	mul_uint32_ct(fdcc_prod, fdcc_x, fdcc_y);
+	fdcc_mismatches += fuzz_diff_check("mul_uint32_ct",
+		fuzz_diff_u64(fdcc_prod), fdcc_ux * fdcc_uy, fdcc_ux, fdcc_uy, 0);
+	fdcc_mismatches += fuzz_diff_check("mod_uint64_ct",
+		fuzz_diff_u32(mod_uint64_ct(fdcc_a64, fdcc_p)), fuzz_diff_u64(fdcc_a64) % fdcc_up,
+		fuzz_diff_u64(fdcc_a64), fdcc_up, 0);
+
+	fdcc_mismatches += fuzz_diff_check("select_ct",
+		fuzz_diff_u32(select_ct(fdcc_flag, fdcc_x, fdcc_y)), fdcc_flag ? fdcc_ux : fdcc_uy, fdcc_flag, fdcc_ux, fdcc_uy);
+	cswap_ct(fdcc_flag, fdcc_sx, fdcc_sy);
+	fdcc_mismatches += fuzz_diff_check("cswap_ct",
+		fuzz_diff_u32(fdcc_sx[0]) << 32 | fuzz_diff_u32(fdcc_sy[0]),
+		fdcc_flag ? fdcc_uy << 32 | fdcc_ux : fdcc_ux << 32 | fdcc_uy,
+		fdcc_flag, fdcc_ux, fdcc_uy);
+	for (int fdcc_i = 0; fdcc_i < kFuzzDiffWords; fdcc_i++)
+	{
+		fdcc_table[fdcc_i] = fdcc_w[fdcc_i];
+	}
+	fdcc_mismatches += fuzz_diff_check("lookup_ct",
+		fuzz_diff_u32(lookup_ct(fdcc_table, kFuzzDiffWords, fdcc_index)), fuzz_diff_u32(fdcc_w[fdcc_index]),
+		fdcc_index, 0, 0);
+
+	// inverse_mod takes a positive int modulus above 1 and a in [1, n)
+	fdcc_n = fdcc_n < 2 ? fdcc_n + 2 : fdcc_n;
+	fdcc_inv_a = fdcc_ux % fdcc_n == 0 ? 1 : fdcc_ux % fdcc_n;
+	fdcc_inv_want = fuzz_diff_inverse32(fdcc_inv_a, fdcc_n);
+	fdcc_inv[0] = 0;
+	fdcc_inv_ok = inverse_mod(fdcc_inv, (int)fdcc_inv_a, (int)fdcc_n);
+	fdcc_mismatches += fuzz_diff_check("inverse_mod",
+		fdcc_inv_ok ? fuzz_diff_u32(fdcc_inv[0]) : 0, fdcc_inv_want, fdcc_inv_a, fdcc_n, 0);
+	fdcc_mismatches += fuzz_diff_check("inverse_mod ret",
+		fdcc_inv_ok, fdcc_inv_want != 0, fdcc_inv_a, fdcc_n, 0);
+
+	return fdcc_mismatches;
+}
+
+// between 1 and 16 lanes, so the vector paths' tails are covered too, at
+// every lane width the CPU supports (the scalar path is 1)
+static int fuzz_diff_exp_mod_batch(int fdb_w[kFuzzDiffWords])
+{
+	static const int kFdbWidths[3] = { 1, 8, 16 };
+	static const char* const kFdbNames[3] = { "exp_mod_batch x1", "exp_mod_batch x8", "exp_mod_batch x16" };
+	int fdb_a[kFuzzDiffWords], fdb_b[kFuzzDiffWords], fdb_p[kFuzzDiffWords], fdb_out[kFuzzDiffWords];
+	int fdb_count = 1 + (int)(fuzz_diff_u32(fdb_w[13]) % kFuzzDiffWords);
+	int fdb_mismatches = 0;
+
+	for (int fdb_i = 0; fdb_i < kFuzzDiffWords; fdb_i++)
+	{
+		fdb_a[fdb_i] = fdb_w[fdb_i];
+		fdb_b[fdb_i] = fdb_w[(fdb_i + 5) % kFuzzDiffWords];
+		fdb_p[fdb_i] = fdb_w[(fdb_i + 11) % kFuzzDiffWords] == 0 ? 1 : fdb_w[(fdb_i + 11) % kFuzzDiffWords];
+	}
+
+	for (int fdb_width = 0; fdb_width < 3; fdb_width++)
+	{
+		exp_mod_batch_set_max_lanes(kFdbWidths[fdb_width]);
+		if (exp_mod_batch_lanes() != kFdbWidths[fdb_width])
+		{
+			continue;
+		}
+
+		for (int fdb_i = 0; fdb_i < kFuzzDiffWords; fdb_i++)
+		{
+			fdb_out[fdb_i] = 0;
+		}
+
+		exp_mod_batch(fdb_out, fdb_a, fdb_b, fdb_p, fdb_count);
+		for (int fdb_i = 0; fdb_i < fdb_count; fdb_i++)
+		{
+			fdb_mismatches += fuzz_diff_check(kFdbNames[fdb_width],
+				fuzz_diff_u32(fdb_out[fdb_i]),
+				fuzz_diff_exp_mod32(fdb_a[fdb_i], fdb_b[fdb_i], fdb_p[fdb_i]),
+				fuzz_diff_u32(fdb_a[fdb_i]), fuzz_diff_u32(fdb_b[fdb_i]), fuzz_diff_u32(fdb_p[fdb_i]));
+		}
+	}
+
+	exp_mod_batch_set_max_lanes(16);
+
+	return fdb_mismatches;
+}
+
+// The public-exponent chain against exp_mod's oracle; compiling takes e
+// above 1, and bit 31 set gives the longest chain. The column kernels
+// against rsa_pubkey_encryrpt and rsa_privkey_decryrpt key by key, with
+// keys made straight from the input words so rejected keys and
+// out-of-range messages come up too.
+static int fuzz_diff_rsa(int fdr_w[kFuzzDiffWords])
+{
+	static const int kFdrKeys = 4;
+	struct RSAExpChain fdr_chain[1];
+	struct RSA fdr_keys[kFdrKeys];
+	struct RSAColumns fdr_cols[1];
+	int fdr_a = fdr_w[0], fdr_p = fdr_w[7] == 0 ? 1 : fdr_w[7];
+	int fdr_e = fdr_w[2] & 0x7FFFFFFF;
+	int fdr_c[kFdrKeys], fdr_out[kFdrKeys], fdr_ref[1], fdr_ok;
+	int fdr_rejected, fdr_rejected_want;
+	int fdr_mismatches = 0;
+
+	fdr_mismatches += fuzz_diff_check("rsa_compile_exp_chain ret",
+		rsa_compile_exp_chain(fdr_chain, fdr_e), fdr_e > 1, fuzz_diff_u32(fdr_e), 0, 0);
+
+	fdr_e = fdr_e > 1 ? fdr_e : fdr_e + 2;
+	rsa_compile_exp_chain(fdr_chain, fdr_e);
+	fdr_mismatches += fuzz_diff_check("exp_mod_chain",
+		fuzz_diff_u32(exp_mod_chain(fdr_a, fdr_chain, fdr_p)),
+		fuzz_diff_exp_mod32(fdr_a, fdr_e, fdr_p),
+		fuzz_diff_u32(fdr_a), fuzz_diff_u32(fdr_e), fuzz_diff_u32(fdr_p));
+
+	for (int fdr_i = 0; fdr_i < kFdrKeys; fdr_i++)
+	{
+		fdr_keys[fdr_i].n = fdr_w[4 + fdr_i];
+		fdr_keys[fdr_i].e = fdr_w[8 + fdr_i];
+		fdr_keys[fdr_i].d = fdr_w[12 + fdr_i];
+		fdr_keys[fdr_i].p = 0;
+		fdr_keys[fdr_i].q = 0;
+		fdr_c[fdr_i] = fdr_w[fdr_i];
+	}
+	rsa_columns_from_keys(fdr_cols, fdr_keys, kFdrKeys);
+
+	fdr_rejected = rsa_columns_pubkey_encryrpt(fdr_out, fdr_cols, fdr_a);
+	fdr_rejected_want = 0;
+	for (int fdr_i = 0; fdr_i < kFdrKeys; fdr_i++)
+	{
+		fdr_ref[0] = 0;
+		fdr_ok = rsa_pubkey_encryrpt(fdr_ref, &fdr_keys[fdr_i], fdr_a);
+		fdr_rejected_want += !fdr_ok;
+		fdr_mismatches += fuzz_diff_check("rsa_columns_pubkey_encryrpt",
+			fuzz_diff_u32(fdr_out[fdr_i]), fuzz_diff_u32(fdr_ref[0]),
+			fuzz_diff_u32(fdr_a), fuzz_diff_u32(fdr_keys[fdr_i].e), fuzz_diff_u32(fdr_keys[fdr_i].n));
+		if (fdr_ok)
+		{
+			fdr_mismatches += fuzz_diff_check("rsa_pubkey_encryrpt",
+				fuzz_diff_u32(fdr_ref[0]),
+				fuzz_diff_exp_mod32(fdr_a, fdr_keys[fdr_i].e, fdr_keys[fdr_i].n),
+				fuzz_diff_u32(fdr_a), fuzz_diff_u32(fdr_keys[fdr_i].e), fuzz_diff_u32(fdr_keys[fdr_i].n));
+		}
+	}
+	fdr_mismatches += fuzz_diff_check("rsa_columns_pubkey_encryrpt rejected",
+		fdr_rejected, fdr_rejected_want, fuzz_diff_u32(fdr_a), 0, 0);
+
+	fdr_rejected = rsa_columns_privkey_decryrpt(fdr_out, fdr_cols, fdr_c);
+	fdr_rejected_want = 0;
+	for (int fdr_i = 0; fdr_i < kFdrKeys; fdr_i++)
+	{
+		fdr_ref[0] = 0;
+		fdr_ok = rsa_privkey_decryrpt(fdr_ref, &fdr_keys[fdr_i], fdr_c[fdr_i]);
+		fdr_rejected_want += !fdr_ok;
+		fdr_mismatches += fuzz_diff_check("rsa_columns_privkey_decryrpt",
+			fuzz_diff_u32(fdr_out[fdr_i]), fuzz_diff_u32(fdr_ref[0]),
+			fuzz_diff_u32(fdr_c[fdr_i]), fuzz_diff_u32(fdr_keys[fdr_i].d), fuzz_diff_u32(fdr_keys[fdr_i].n));
+		if (fdr_ok)
+		{
+			fdr_mismatches += fuzz_diff_check("rsa_privkey_decryrpt",
+				fuzz_diff_u32(fdr_ref[0]),
+				fuzz_diff_exp_mod32(fdr_c[fdr_i], fdr_keys[fdr_i].d, fdr_keys[fdr_i].n),
+				fuzz_diff_u32(fdr_c[fdr_i]), fuzz_diff_u32(fdr_keys[fdr_i].d), fuzz_diff_u32(fdr_keys[fdr_i].n));
+		}
+	}
+	fdr_mismatches += fuzz_diff_check("rsa_columns_privkey_decryrpt rejected",
+		fdr_rejected, fdr_rejected_want, 0, 0, 0);
+
+	return fdr_mismatches;
+}
+
+template <uint32_t P>
+static int fuzz_diff_modint_at(int fdmi_w[kFuzzDiffWords])
+{
+	int fdmi_x = fdmi_w[0], fdmi_y = fdmi_w[1], fdmi_e = fdmi_w[2];
+	uint64_t fdmi_ux = fuzz_diff_u32(fdmi_x), fdmi_uy = fuzz_diff_u32(fdmi_y);
+	ModInt<P> fdmi_a = modint_from<P>((uint32_t)fdmi_x), fdmi_b = modint_from<P>((uint32_t)fdmi_y);
+	int fdmi_mismatches = 0;
+
+	fdmi_mismatches += fuzz_diff_check("modint exp_mod",
+		fuzz_diff_u32(exp_mod<P>(fdmi_x, fdmi_e)), fuzz_diff_exp_mod32(fdmi_x, fdmi_e, (int)P),
+		fdmi_ux, fuzz_diff_u32(fdmi_e), P);
+	fdmi_mismatches += fuzz_diff_check("modint exp_mod vs exp_mod",
+		fuzz_diff_u32(exp_mod<P>(fdmi_x, fdmi_e)), fuzz_diff_u32(exp_mod(fdmi_x, fdmi_e, (int)P)),
+		fdmi_ux, fuzz_diff_u32(fdmi_e), P);
+	fdmi_mismatches += fuzz_diff_check("modint_mul",
+		modint_value<P>(modint_mul<P>(fdmi_a, fdmi_b)), fdmi_ux * fdmi_uy % P, fdmi_ux, fdmi_uy, P);
+	fdmi_mismatches += fuzz_diff_check("modint_add",
+		modint_value<P>(modint_add<P>(fdmi_a, fdmi_b)), (fdmi_ux % P + fdmi_uy % P) % P, fdmi_ux, fdmi_uy, P);
+	fdmi_mismatches += fuzz_diff_check("modint_sub",
+		modint_value<P>(modint_sub<P>(fdmi_a, fdmi_b)), (fdmi_ux % P + P - fdmi_uy % P) % P, fdmi_ux, fdmi_uy, P);
+
+	return fdmi_mismatches;
+}
+
+static int fuzz_diff_modint(int fdm_w[kFuzzDiffWords])
+{
+	return fuzz_diff_modint_at<3>(fdm_w) +
+		fuzz_diff_modint_at<2147481143>(fdm_w) +
+		fuzz_diff_modint_at<4294967291u>(fdm_w);
+}
+
+// limb_core at one limb width: against the __int128 oracle on every
+// uint64 (m non-zero), and against crypto_core64 below 2^62
+template <typename Limb>
+static int fuzz_diff_limb_core_at(int fdlc_w[kFuzzDiffWords], const char* fdlc_name)
+{
+	int fdlc_a[2] = { fdlc_w[3], fdlc_w[4] };
+	int fdlc_b[2] = { fdlc_w[5], fdlc_w[6] };
+	int fdlc_m[2] = { fdlc_w[7], fdlc_w[8] };
+	int fdlc_out[2], fdlc_ref[2];
+	uint64_t fdlc_ua = fuzz_diff_u64(fdlc_a), fdlc_ub = fuzz_diff_u64(fdlc_b), fdlc_um = fuzz_diff_u64(fdlc_m);
+	uint64_t fdlc_p = fdlc_um & kFuzzDiff62;
+	int fdlc_mismatches = 0;
+
+	fdlc_um = fdlc_um == 0 ? 1 : fdlc_um;
+	fuzz_diff_set(fdlc_m, fdlc_um);
+
+#if defined(__SIZEOF_INT128__)
+	mul_mod_uint64_limbs<Limb>(fdlc_out, fdlc_a, fdlc_b, fdlc_m);
+	fdlc_mismatches += fuzz_diff_check(fdlc_name,
+		fuzz_diff_u64(fdlc_out), fuzz_diff_mul_mod64(fdlc_ua, fdlc_ub, fdlc_um), fdlc_ua, fdlc_ub, fdlc_um);
+	fdlc_mismatches += fuzz_diff_check("limb_core_exp_mod",
+		limb_core_exp_mod<Limb>(fdlc_ua, fdlc_ub, fdlc_um), fuzz_diff_exp_mod64(fdlc_ua, fdlc_ub, fdlc_um),
+		fdlc_ua, fdlc_ub, fdlc_um);
+#endif
+
+	// mul_mod_uint64 wants both factors below p
+	fdlc_p = fdlc_p < 2 ? fdlc_p + 2 : fdlc_p;
+	fuzz_diff_set(fdlc_m, fdlc_p);
+	fuzz_diff_set(fdlc_a, fdlc_ua % fdlc_p);
+	fuzz_diff_set(fdlc_b, fdlc_ub % fdlc_p);
+	mul_mod_uint64_limbs<Limb>(fdlc_out, fdlc_a, fdlc_b, fdlc_m);
+	mul_mod_uint64(fdlc_ref, fdlc_a, fdlc_b, fdlc_m);
+	fdlc_mismatches += fuzz_diff_check(fdlc_name,
+		fuzz_diff_u64(fdlc_out), fuzz_diff_u64(fdlc_ref), fdlc_ua % fdlc_p, fdlc_ub % fdlc_p, fdlc_p);
+
+	return fdlc_mismatches;
+}
+
+static int fuzz_diff_limb_core(int fdl_w[kFuzzDiffWords])
+{
+	return fuzz_diff_limb_core_at<uint16_t>(fdl_w, "mul_mod_uint64_limbs<uint16_t>") +
+		fuzz_diff_limb_core_at<uint32_t>(fdl_w, "mul_mod_uint64_limbs<uint32_t>") +
+		fuzz_diff_limb_core_at<uint64_t>(fdl_w, "mul_mod_uint64_limbs<uint64_t>");
+}
+
+// crypto_core64 for moduli below 2^62, with a and b reduced
+static int fuzz_diff_crypto_core64(int fd6_w[kFuzzDiffWords])
+{
+	int fd6_a[2], fd6_b[2], fd6_e[2] = { fd6_w[11], fd6_w[12] }, fd6_p[2] = { fd6_w[7], fd6_w[8] };
+	int fd6_out[2], fd6_inv[2], fd6_ok;
+	uint64_t fd6_up = fuzz_diff_u64(fd6_p) & kFuzzDiff62;
+	uint64_t fd6_ua, fd6_ub, fd6_ue = fuzz_diff_u64(fd6_e);
+	int fd6_mismatches = 0;
+
+	fd6_up = fd6_up < 2 ? fd6_up + 2 : fd6_up;
+	fd6_ua = (fuzz_diff_u32(fd6_w[3]) << 32 | fuzz_diff_u32(fd6_w[4])) % fd6_up;
+	fd6_ub = (fuzz_diff_u32(fd6_w[5]) << 32 | fuzz_diff_u32(fd6_w[6])) % fd6_up;
+	fuzz_diff_set(fd6_p, fd6_up);
+	fuzz_diff_set(fd6_a, fd6_ua);
+	fuzz_diff_set(fd6_b, fd6_ub);
+
+	exp_mod_uint64(fd6_out, fd6_a, fd6_e, fd6_p);
+	fd6_mismatches += fuzz_diff_check("exp_mod_uint64 vs limb_core",
+		fuzz_diff_u64(fd6_out), limb_core_exp_mod<uint32_t>(fd6_ua, fd6_ue, fd6_up), fd6_ua, fd6_ue, fd6_up);
+
+	fd6_inv[0] = 0;
+	fd6_inv[1] = 0;
+	fd6_ok = inverse_mod_uint64(fd6_inv, fd6_a, fd6_p);
+
+#if defined(__SIZEOF_INT128__)
+	uint64_t fd6_inv_want = fuzz_diff_inverse64(fd6_ua, fd6_up);
+
+	mul_mod_uint64(fd6_out, fd6_a, fd6_b, fd6_p);
+	fd6_mismatches += fuzz_diff_check("mul_mod_uint64",
+		fuzz_diff_u64(fd6_out), fuzz_diff_mul_mod64(fd6_ua, fd6_ub, fd6_up), fd6_ua, fd6_ub, fd6_up);
+	exp_mod_uint64(fd6_out, fd6_a, fd6_e, fd6_p);
+	fd6_mismatches += fuzz_diff_check("exp_mod_uint64",
+		fuzz_diff_u64(fd6_out), fuzz_diff_exp_mod64(fd6_ua, fd6_ue, fd6_up), fd6_ua, fd6_ue, fd6_up);
+	fd6_mismatches += fuzz_diff_check("inverse_mod_uint64",
+		fd6_ok ? fuzz_diff_u64(fd6_inv) : 0, fd6_inv_want, fd6_ua, fd6_up, 0);
+	fd6_mismatches += fuzz_diff_check("inverse_mod_uint64 ret",
+		fd6_ok, fd6_inv_want != 0, fd6_ua, fd6_up, 0);
+#else
+	// without the oracle, check that a returned inverse is one
+	if (fd6_ok)
+	{
+		fd6_out[0] = 0;
+		fd6_out[1] = 1;
+		mul_mod_uint64(fd6_b, fd6_a, fd6_inv, fd6_p);
+		mod_uint64(fd6_out, fd6_out, fd6_p);
+		fd6_mismatches += fuzz_diff_check("inverse_mod_uint64",
+			fuzz_diff_u64(fd6_b), fuzz_diff_u64(fd6_out), fd6_ua, fd6_up, fuzz_diff_u64(fd6_inv));
+	}
+#endif
+
+	return fd6_mismatches;
+}
+
+// the Comba and Karatsuba kernels against bn_mul's schoolbook product,
+// on a = w[0..n-1] and b = w[8..8+n-1] for n in [1, 8]
+static int fuzz_diff_bignum(int fdbn_w[kFuzzDiffWords])
+{
+	static const int kFdbnLimbs = kFuzzDiffWords / 2;
+	int fdbn_n = 1 + (int)(fuzz_diff_u32(fdbn_w[12]) % kFdbnLimbs);
+	int fdbn_a[kFdbnLimbs], fdbn_b[kFdbnLimbs];
+	int fdbn_ref[2 * kFdbnLimbs], fdbn_sqr_ref[2 * kFdbnLimbs], fdbn_r[2 * kFdbnLimbs];
+	int fdbn_scratch[4 * kFdbnLimbs + 128];
+	int fdbn_mismatches = 0;
+
+	for (int fdbn_i = 0; fdbn_i < kFdbnLimbs; fdbn_i++)
+	{
+		fdbn_a[fdbn_i] = fdbn_w[fdbn_i];
+		fdbn_b[fdbn_i] = fdbn_w[kFdbnLimbs + fdbn_i];
+	}
+
+	bn_mul(fdbn_ref, fdbn_a, fdbn_n, fdbn_b, fdbn_n);
+	bn_mul(fdbn_sqr_ref, fdbn_a, fdbn_n, fdbn_a, fdbn_n);
+
+#if defined(__SIZEOF_INT128__)
+	if (fdbn_n == 2)
+	{
+		fuzz_diff_u128 fdbn_prod = (fuzz_diff_u128)(fuzz_diff_u32(fdbn_a[1]) << 32 | fuzz_diff_u32(fdbn_a[0])) *
+			(fuzz_diff_u32(fdbn_b[1]) << 32 | fuzz_diff_u32(fdbn_b[0]));
+
+		for (int fdbn_i = 0; fdbn_i < 4; fdbn_i++)
+		{
+			fdbn_r[fdbn_i] = (int)(uint32_t)(fdbn_prod >> (32 * fdbn_i));
+		}
+
+		fdbn_mismatches += fuzz_diff_check_limbs("bn_mul", fdbn_ref, fdbn_r, 4, 2);
+	}
+#endif
+
+	bn_mul_comba(fdbn_r, fdbn_a, fdbn_b, fdbn_n);
+	fdbn_mismatches += fuzz_diff_check_limbs("bn_mul_comba", fdbn_r, fdbn_ref, 2 * fdbn_n, fdbn_n);
+	bn_mul_n(fdbn_r, fdbn_a, fdbn_b, fdbn_n, fdbn_scratch);
+	fdbn_mismatches += fuzz_diff_check_limbs("bn_mul_n", fdbn_r, fdbn_ref, 2 * fdbn_n, fdbn_n);
+	bn_sqr_comba(fdbn_r, fdbn_a, fdbn_n);
+	fdbn_mismatches += fuzz_diff_check_limbs("bn_sqr_comba", fdbn_r, fdbn_sqr_ref, 2 * fdbn_n, fdbn_n);
+	bn_sqr(fdbn_r, fdbn_a, fdbn_n, fdbn_scratch);
+	fdbn_mismatches += fuzz_diff_check_limbs("bn_sqr", fdbn_r, fdbn_sqr_ref, 2 * fdbn_n, fdbn_n);
+
+	// Karatsuba's threshold is at least 4 limbs
+	if (fdbn_n >= 4)
+	{
+		bn_mul_karatsuba(fdbn_r, fdbn_a, fdbn_b, fdbn_n, 4, fdbn_scratch);
+		fdbn_mismatches += fuzz_diff_check_limbs("bn_mul_karatsuba", fdbn_r, fdbn_ref, 2 * fdbn_n, fdbn_n);
+		bn_sqr_karatsuba(fdbn_r, fdbn_a, fdbn_n, 4, fdbn_scratch);
+		fdbn_mismatches += fuzz_diff_check_limbs("bn_sqr_karatsuba", fdbn_r, fdbn_sqr_ref, 2 * fdbn_n, fdbn_n);
+	}
+
+	return fdbn_mismatches;
+}
+
+// bn_div_mod: q*b + r == a and r < b for any lengths, and against __int128
+// while both fit; b of 0 must be refused
+static int fuzz_diff_bn_div_mod(int fddm_w[kFuzzDiffWords])
+{
+	static const int kFddmLimbs = kFuzzDiffWords / 2;
+	int fddm_an = 1 + (int)(fuzz_diff_u32(fddm_w[12]) % kFddmLimbs);
+	int fddm_bn = 1 + (int)(fuzz_diff_u32(fddm_w[13]) % kFddmLimbs);
+	int fddm_a[kFddmLimbs], fddm_b[kFddmLimbs], fddm_q[kFddmLimbs], fddm_r[kFddmLimbs];
+	int fddm_sum[2 * kFddmLimbs], fddm_rpad[2 * kFddmLimbs], fddm_apad[2 * kFddmLimbs];
+	int fddm_scratch[2 * kFddmLimbs + 1];
+	int fddm_ok, fddm_b_zero = 1;
+	int fddm_mismatches = 0;
+
+	for (int fddm_i = 0; fddm_i < kFddmLimbs; fddm_i++)
+	{
+		fddm_a[fddm_i] = fddm_w[fddm_i];
+		fddm_b[fddm_i] = fddm_w[kFddmLimbs + fddm_i];
+		fddm_q[fddm_i] = 0;
+		fddm_r[fddm_i] = 0;
+	}
+
+	for (int fddm_i = 0; fddm_i < fddm_bn; fddm_i++)
+	{
+		fddm_b_zero = fddm_b_zero && fddm_b[fddm_i] == 0;
+	}
+
+	fddm_ok = bn_div_mod(fddm_q, fddm_r, fddm_a, fddm_an, fddm_b, fddm_bn, fddm_scratch);
+	fddm_mismatches += fuzz_diff_check("bn_div_mod ret", fddm_ok, !fddm_b_zero, fddm_an, fddm_bn, 0);
+	if (!fddm_ok || fddm_b_zero)
+	{
+		return fddm_mismatches;
+	}
+
+	fddm_mismatches += fuzz_diff_check("bn_div_mod r < b",
+		bn_cmp(fddm_r, fddm_b, fddm_bn) < 0, 1, fddm_an, fddm_bn, 0);
+
+	for (int fddm_i = 0; fddm_i < fddm_an + fddm_bn; fddm_i++)
+	{
+		fddm_rpad[fddm_i] = fddm_i < fddm_bn ? fddm_r[fddm_i] : 0;
+		fddm_apad[fddm_i] = fddm_i < fddm_an ? fddm_a[fddm_i] : 0;
+	}
+	bn_mul(fddm_sum, fddm_q, fddm_an, fddm_b, fddm_bn);
+	bn_add(fddm_sum, fddm_sum, fddm_rpad, fddm_an + fddm_bn);
+	fddm_mismatches += fuzz_diff_check_limbs("bn_div_mod q*b+r", fddm_sum, fddm_apad, fddm_an + fddm_bn, fddm_an);
+
+#if defined(__SIZEOF_INT128__)
+	if (fddm_an <= 4 && fddm_bn <= 4)
+	{
+		fuzz_diff_u128 fddm_ua = 0, fddm_ub = 0, fddm_uq, fddm_ur;
+		int fddm_q_want[4], fddm_r_want[4];
+
+		for (int fddm_i = fddm_an - 1; fddm_i >= 0; fddm_i--)
+		{
+			fddm_ua = fddm_ua << 32 | fuzz_diff_u32(fddm_a[fddm_i]);
+		}
+
+		for (int fddm_i = fddm_bn - 1; fddm_i >= 0; fddm_i--)
+		{
+			fddm_ub = fddm_ub << 32 | fuzz_diff_u32(fddm_b[fddm_i]);
+		}
+
+		fddm_uq = fddm_ua / fddm_ub;
+		fddm_ur = fddm_ua % fddm_ub;
+		for (int fddm_i = 0; fddm_i < 4; fddm_i++)
+		{
+			fddm_q_want[fddm_i] = (int)(uint32_t)(fddm_uq >> (32 * fddm_i));
+			fddm_r_want[fddm_i] = (int)(uint32_t)(fddm_ur >> (32 * fddm_i));
+		}
+
+		fddm_mismatches += fuzz_diff_check_limbs("bn_div_mod q", fddm_q, fddm_q_want, fddm_an, fddm_bn);
+		fddm_mismatches += fuzz_diff_check_limbs("bn_div_mod r", fddm_r, fddm_r_want, fddm_bn, fddm_an);
+	}
+#endif
+
+	return fddm_mismatches;
+}
+
+int fuzz_diff_run(int fuzz_diff_run_w[kFuzzDiffWords])
+{
+	return fuzz_diff_unsigned_op32(fuzz_diff_run_w) +
+		fuzz_diff_unsigned_op64(fuzz_diff_run_w) +
+		fuzz_diff_crypto_core(fuzz_diff_run_w) +
+		fuzz_diff_exp_mod_batch(fuzz_diff_run_w) +
+		fuzz_diff_rsa(fuzz_diff_run_w) +
+		fuzz_diff_modint(fuzz_diff_run_w) +
+		fuzz_diff_limb_core(fuzz_diff_run_w) +
+		fuzz_diff_crypto_core64(fuzz_diff_run_w) +
+		fuzz_diff_bignum(fuzz_diff_run_w) +
+		fuzz_diff_bn_div_mod(fuzz_diff_run_w);
+}
+
+// a quarter edge values, a quarter short ones, the rest all 32 bits
+static int fuzz_diff_word()
+{
+	uint32_t fuzz_diff_word_r = (uint32_t)rand32() << 16 ^ (uint32_t)rand32();
+
+	switch ((uint32_t)rand32() % 4)
+	{
+	case 0:
+		return kFuzzDiffEdges[fuzz_diff_word_r % kFuzzDiffEdgeCount];
+	case 1:
+		return (int)(fuzz_diff_word_r >> ((uint32_t)rand32() % 32));
+	default:
+		return (int)fuzz_diff_word_r;
+	}
+}
+
+int fuzz_diff(int argc, char* argv[])
+{
+	int fuzz_diff_cases = 20000;
+	int fuzz_diff_seed = 20240708;
+	int fuzz_diff_grid = 0;
+	int fuzz_diff_mismatches = 0;
+	int fuzz_diff_w[kFuzzDiffWords];
+
+	if (argc >= 1)
+	{
+		fuzz_diff_cases = atoi(argv[0]);
+	}
+
+	if (argc >= 2)
+	{
+		fuzz_diff_seed = atoi(argv[1]);
+	}
+
+	if (fuzz_diff_cases < 0)
+	{
+		printf("cases must not be negative\n");
+		return 1;
+	}
+
+	kFuzzDiffChecks = 0;
+	kFuzzDiffReported = 0;
+
+	// word t is edge i + j*t, so the operand pairs (t, t+1) meet every pair
+	// of edges as i and j run; the two shifts run over every edge pair too
+	for (int fuzz_diff_i = 0; fuzz_diff_i < kFuzzDiffEdgeCount; fuzz_diff_i++)
+	{
+		for (int fuzz_diff_j = 0; fuzz_diff_j < kFuzzDiffEdgeCount; fuzz_diff_j++)
+		{
+			for (int fuzz_diff_k = 0; fuzz_diff_k < kFuzzDiffShiftCount; fuzz_diff_k++)
+			{
+				for (int fuzz_diff_t = 0; fuzz_diff_t < kFuzzDiffWords - 2; fuzz_diff_t++)
+				{
+					fuzz_diff_w[fuzz_diff_t] = kFuzzDiffEdges[(fuzz_diff_i + fuzz_diff_j * fuzz_diff_t) % kFuzzDiffEdgeCount];
+				}
+
+				fuzz_diff_w[kFuzzDiffWords - 2] = kFuzzDiffShifts[fuzz_diff_k];
+				fuzz_diff_w[kFuzzDiffWords - 1] = kFuzzDiffShifts[(fuzz_diff_k + fuzz_diff_j) % kFuzzDiffShiftCount];
+				fuzz_diff_mismatches += fuzz_diff_run(fuzz_diff_w);
+				fuzz_diff_grid++;
+			}
+		}
+	}
+
+	for (int fuzz_diff_f = 0; fuzz_diff_f < kFuzzDiffFixedCount; fuzz_diff_f++)
+	{
+		for (int fuzz_diff_t = 0; fuzz_diff_t < kFuzzDiffWords; fuzz_diff_t++)
+		{
+			fuzz_diff_w[fuzz_diff_t] = kFuzzDiffFixed[fuzz_diff_f][fuzz_diff_t];
+		}
+
+		fuzz_diff_mismatches += fuzz_diff_run(fuzz_diff_w);
+		fuzz_diff_grid++;
+	}
+
+	srand32(fuzz_diff_seed);
+	for (int fuzz_diff_c = 0; fuzz_diff_c < fuzz_diff_cases; fuzz_diff_c++)
+	{
+		for (int fuzz_diff_t = 0; fuzz_diff_t < kFuzzDiffWords; fuzz_diff_t++)
+		{
+			fuzz_diff_w[fuzz_diff_t] = fuzz_diff_word();
+		}
+
+		fuzz_diff_mismatches += fuzz_diff_run(fuzz_diff_w);
+	}
+
+	printf("%d edge cases, %d random cases (seed %d): %d checks, %d mismatches\n",
+		fuzz_diff_grid, fuzz_diff_cases, fuzz_diff_seed, kFuzzDiffChecks, fuzz_diff_mismatches);
+
+#if !defined(__SIZEOF_INT128__)
+	printf("no unsigned __int128: the 128-bit oracle checks were skipped\n");
+#endif
+
+	return fuzz_diff_mismatches == 0 ? 0 : 1;
+}
+
+#ifdef CMM_LAB_LIBFUZZER
+extern "C" int LLVMFuzzerInitialize(int* fuzz_diff_init_argc, char*** fuzz_diff_init_argv)
+{
+	init_two_powers();
+	init_primes();
+
+	return 0;
+}
+
+// little-endian words from the input, zero past its end
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* fuzz_diff_data, size_t fuzz_diff_size)
+{
+	int fuzz_diff_w[kFuzzDiffWords];
+
+	for (int fuzz_diff_t = 0; fuzz_diff_t < kFuzzDiffWords; fuzz_diff_t++)
+	{
+		uint32_t fuzz_diff_word = 0;
+
+		for (int fuzz_diff_b = 3; fuzz_diff_b >= 0; fuzz_diff_b--)
+		{
+			size_t fuzz_diff_at = (size_t)fuzz_diff_t * 4 + fuzz_diff_b;
+
+			fuzz_diff_word = fuzz_diff_word << 8 | (fuzz_diff_at < fuzz_diff_size ? fuzz_diff_data[fuzz_diff_at] : 0);
+		}
+
+		fuzz_diff_w[fuzz_diff_t] = (int)fuzz_diff_word;
+	}
+
+	if (fuzz_diff_run(fuzz_diff_w) != 0)
+	{
+		abort();
+	}
+
+	return 0;
+}
+#endif
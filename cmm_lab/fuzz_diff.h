@@ -0,0 +1,43 @@
+#ifndef FUZZ_DIFF_H_
+#define FUZZ_DIFF_H_
+
+// Differential checks of every fast path against the int-only reference
+// code and a native oracle (uint64_t, and unsigned __int128 where the
+// compiler has it):
+//   unsigned_op        uint64/__int128 arithmetic; the branch-free
+//                      comparisons and carries also against unsigned_op_ref
+//   crypto_core        mul_mod, exp_mod, inverse_mod
+//   ct_op              against mul_mod/exp_mod and the oracle
+//   exp_mod_batch      every lane against the oracle, at 1, 8 and 16 lanes
+//                      where the CPU has them
+//   rsa                exp_mod_chain against the oracle; the rsa_columns_*
+//                      kernels against the per-key calls
+//   modint             fixed moduli 3, 2147481143 and 4294967291
+//   limb_core          16-, 32- and 64-bit limbs
+//   crypto_core64      mul_mod_uint64, exp_mod_uint64, inverse_mod_uint64
+//   bignum             Comba and Karatsuba kernels against bn_mul;
+//                      bn_div_mod by q*b + r == a and against __int128
+// Operands come from kFuzzDiffWords input words, bent into each
+// function's documented domain (non-zero divisors, hi below m for
+// mod_uint128, ...); shift counts run to 71 so 31, 32, 63 and 64 are in
+// range.
+//
+// With CMM_LAB_LIBFUZZER defined, fuzz_diff.cpp also provides
+// LLVMFuzzerTestOneInput, which aborts on a mismatch; build it without
+// cmm_lab.cpp, e.g.
+//   clang++ -std=c++14 -O1 -g -pthread -fsanitize=fuzzer,address -DCMM_LAB_LIBFUZZER
+//       $(ls *.cpp | grep -v -e cmm_lab.cpp -e '^bench') -o fuzz_diff
+
+static const int kFuzzDiffWords = 16;
+
+// Run every check on one input; print the first mismatches and return
+// how many checks failed
+int fuzz_diff_run(int fuzz_diff_run_w[kFuzzDiffWords]);
+
+// Usage: cmm_lab fuzz-diff [cases=20000] [seed=20240708]
+// An exhaustive grid of edge values (0, 1, -1, INT_MIN, INT_MAX, ...) and
+// edge shifts, a few fixed inputs for rare branches, then random cases
+// biased towards edge and short values.
+int fuzz_diff(int argc, char* argv[]);
+
+#endif
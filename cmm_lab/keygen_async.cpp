@@ -0,0 +1,278 @@
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "keygen_async.h"
+
+struct KeygenJob
+{
+	// nullptr when the request has no token
+	std::shared_ptr<std::atomic<int>> cancelled;
+	std::chrono::steady_clock::time_point deadline;
+	// runs the request with kKeygenOk, otherwise only resolves its future
+	// with the given status
+	std::function<void(int)> run;
+};
+
+struct KeygenExecutor
+{
+	std::mutex lock;
+	std::condition_variable not_empty;
+	std::deque<struct KeygenJob> jobs;
+	std::vector<std::thread> workers;
+	// also read without the lock by the abort hook
+	std::atomic<bool> stopping;
+
+	KeygenExecutor();
+	~KeygenExecutor();
+};
+
+static thread_local const struct KeygenJob* kKeygenCurrentJob = nullptr;
+static thread_local const struct KeygenExecutor* kKeygenCurrentExecutor = nullptr;
+
+static int keygen_async_job_status(const struct KeygenJob* keygen_job_status_job)
+{
+	// a shutting-down executor cancels the request it is running
+	if (kKeygenCurrentExecutor != nullptr && kKeygenCurrentExecutor->stopping.load(std::memory_order_relaxed))
+	{
+		return kKeygenCancelled;
+	}
+
+	if (keygen_job_status_job->cancelled != nullptr && keygen_job_status_job->cancelled->load(std::memory_order_relaxed))
+	{
+		return kKeygenCancelled;
+	}
+
+	if (std::chrono::steady_clock::now() >= keygen_job_status_job->deadline)
+	{
+		return kKeygenTimedOut;
+	}
+
+	return kKeygenOk;
+}
+
+// generate_prime's abort hook on worker threads
+static int keygen_async_abort()
+{
+	return kKeygenCurrentJob != nullptr && keygen_async_job_status(kKeygenCurrentJob) != kKeygenOk;
+}
+
+// Why the running request's generator returned 0: stopped by the hook, or
+// a genuine failure.
+static int keygen_async_failure_status()
+{
+	int keygen_failure_status = kKeygenCurrentJob != nullptr
+		? keygen_async_job_status(kKeygenCurrentJob)
+		: kKeygenOk;
+
+	return keygen_failure_status != kKeygenOk ? keygen_failure_status : kKeygenFailed;
+}
+
+static void keygen_async_worker(struct KeygenExecutor* keygen_worker_executor, int keygen_worker_index)
+{
+	struct KeygenJob keygen_worker_job;
+	int keygen_worker_status;
+
+	srand32((int)time(nullptr) + keygen_worker_index * 7919);
+	set_generate_prime_abort(keygen_async_abort);
+	kKeygenCurrentExecutor = keygen_worker_executor;
+
+	while (1)
+	{
+		{
+			std::unique_lock<std::mutex> keygen_worker_guard(keygen_worker_executor->lock);
+			keygen_worker_executor->not_empty.wait(keygen_worker_guard, [=] {
+				return keygen_worker_executor->stopping || !keygen_worker_executor->jobs.empty();
+			});
+
+			if (keygen_worker_executor->stopping)
+			{
+				return;
+			}
+
+			keygen_worker_job = std::move(keygen_worker_executor->jobs.front());
+			keygen_worker_executor->jobs.pop_front();
+		}
+
+		// requests cancelled or expired while queued never start
+		keygen_worker_status = keygen_async_job_status(&keygen_worker_job);
+
+		kKeygenCurrentJob = &keygen_worker_job;
+		keygen_worker_job.run(keygen_worker_status);
+		kKeygenCurrentJob = nullptr;
+	}
+}
+
+KeygenExecutor::KeygenExecutor()
+{
+	int keygen_executor_threads = (int)std::thread::hardware_concurrency();
+	int keygen_executor_i;
+
+	stopping = false;
+
+	if (keygen_executor_threads < 1)
+	{
+		keygen_executor_threads = 1;
+	}
+
+	for (keygen_executor_i = 0; keygen_executor_i < keygen_executor_threads; keygen_executor_i++)
+	{
+		workers.emplace_back(keygen_async_worker, this, keygen_executor_i);
+	}
+}
+
+// Running requests stop at their next prime candidate and, like queued
+// ones, resolve as cancelled.
+KeygenExecutor::~KeygenExecutor()
+{
+	size_t keygen_executor_i;
+
+	{
+		std::lock_guard<std::mutex> keygen_executor_guard(lock);
+		stopping = true;
+	}
+
+	not_empty.notify_all();
+	for (keygen_executor_i = 0; keygen_executor_i < workers.size(); keygen_executor_i++)
+	{
+		workers[keygen_executor_i].join();
+	}
+
+	for (keygen_executor_i = 0; keygen_executor_i < jobs.size(); keygen_executor_i++)
+	{
+		jobs[keygen_executor_i].run(kKeygenCancelled);
+	}
+}
+
+static void keygen_async_submit(
+	struct KeygenToken keygen_submit_token[1],
+	std::chrono::steady_clock::time_point keygen_submit_deadline,
+	std::function<void(int)> keygen_submit_run)
+{
+	static struct KeygenExecutor keygen_submit_executor;
+	struct KeygenJob keygen_submit_job;
+
+	if (keygen_submit_token != nullptr)
+	{
+		keygen_submit_job.cancelled = keygen_submit_token[0].cancelled;
+	}
+
+	keygen_submit_job.deadline = keygen_submit_deadline;
+	keygen_submit_job.run = std::move(keygen_submit_run);
+
+	{
+		std::lock_guard<std::mutex> keygen_submit_guard(keygen_submit_executor.lock);
+		keygen_submit_executor.jobs.push_back(std::move(keygen_submit_job));
+	}
+
+	keygen_submit_executor.not_empty.notify_one();
+}
+
+int keygen_token_init(struct KeygenToken keygen_token_init_token[1])
+{
+	keygen_token_init_token[0].cancelled = std::make_shared<std::atomic<int>>(0);
+	return 1;
+}
+
+int keygen_cancel(struct KeygenToken keygen_cancel_token[1])
+{
+	if (keygen_cancel_token[0].cancelled == nullptr)
+	{
+		return 0;
+	}
+
+	keygen_cancel_token[0].cancelled->store(1);
+	return 1;
+}
+
+std::future<struct RSAKeygenResult> rsa_keygen_async(
+	int rsa_keygen_async_bits,
+	int rsa_keygen_async_e,
+	struct KeygenToken rsa_keygen_async_token[1],
+	std::chrono::steady_clock::time_point rsa_keygen_async_deadline)
+{
+	std::shared_ptr<std::promise<struct RSAKeygenResult>> rsa_keygen_async_promise =
+		std::make_shared<std::promise<struct RSAKeygenResult>>();
+	std::future<struct RSAKeygenResult> rsa_keygen_async_future = rsa_keygen_async_promise->get_future();
+
+	keygen_async_submit(rsa_keygen_async_token, rsa_keygen_async_deadline, [=](int rsa_keygen_async_status) {
+		struct RSAKeygenResult rsa_keygen_async_result = {};
+
+		rsa_keygen_async_result.status = rsa_keygen_async_status;
+		if (rsa_keygen_async_status == kKeygenOk &&
+			!rsa_keygen(&rsa_keygen_async_result.key, rsa_keygen_async_bits, rsa_keygen_async_e))
+		{
+			rsa_keygen_async_result.status = keygen_async_failure_status();
+		}
+
+		rsa_keygen_async_promise->set_value(rsa_keygen_async_result);
+	});
+
+	return rsa_keygen_async_future;
+}
+
+std::future<struct DHParamsResult> dh_generate_paremeters_async(
+	int dh_genparam_async_prime_len,
+	int dh_genparam_async_generator,
+	struct KeygenToken dh_genparam_async_token[1],
+	std::chrono::steady_clock::time_point dh_genparam_async_deadline)
+{
+	std::shared_ptr<std::promise<struct DHParamsResult>> dh_genparam_async_promise =
+		std::make_shared<std::promise<struct DHParamsResult>>();
+	std::future<struct DHParamsResult> dh_genparam_async_future = dh_genparam_async_promise->get_future();
+
+	keygen_async_submit(dh_genparam_async_token, dh_genparam_async_deadline, [=](int dh_genparam_async_status) {
+		struct DHParamsResult dh_genparam_async_result = {};
+
+		dh_genparam_async_result.status = dh_genparam_async_status;
+		if (dh_genparam_async_status == kKeygenOk &&
+			!dh_generate_paremeters(
+				&dh_genparam_async_result.dh,
+				dh_genparam_async_prime_len,
+				dh_genparam_async_generator))
+		{
+			dh_genparam_async_result.status = keygen_async_failure_status();
+		}
+
+		dh_genparam_async_promise->set_value(dh_genparam_async_result);
+	});
+
+	return dh_genparam_async_future;
+}
+
+std::future<struct PrimeResult> generate_prime_async(
+	int genprime_async_bits,
+	int genprime_async_safe,
+	int genprime_async_add,
+	int genprime_async_rem,
+	struct KeygenToken genprime_async_token[1],
+	std::chrono::steady_clock::time_point genprime_async_deadline)
+{
+	std::shared_ptr<std::promise<struct PrimeResult>> genprime_async_promise =
+		std::make_shared<std::promise<struct PrimeResult>>();
+	std::future<struct PrimeResult> genprime_async_future = genprime_async_promise->get_future();
+
+	keygen_async_submit(genprime_async_token, genprime_async_deadline, [=](int genprime_async_status) {
+		struct PrimeResult genprime_async_result = {};
+
+		genprime_async_result.status = genprime_async_status;
+		if (genprime_async_status == kKeygenOk &&
+			!generate_prime(
+				&genprime_async_result.prime,
+				genprime_async_bits,
+				genprime_async_safe,
+				genprime_async_add,
+				genprime_async_rem))
+		{
+			genprime_async_result.status = keygen_async_failure_status();
+		}
+
+		genprime_async_promise->set_value(genprime_async_result);
+	});
+
+	return genprime_async_future;
+}
@@ -0,0 +1,75 @@
+#ifndef KEYGEN_ASYNC_H_
+#define KEYGEN_ASYNC_H_
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+
+#include "dh.h"
+#include "rsa.h"
+
+// Asynchronous rsa_keygen, dh_generate_paremeters and generate_prime.
+// Requests run on an internal pool of hardware_concurrency threads, each
+// with its own rand32 stream, and resolve a std::future. A request can be
+// cancelled through its KeygenToken or given a deadline; both are checked
+// before the request starts and before every prime candidate, so an
+// abandoned search stops within one candidate test. At program exit the
+// pool shuts down the same way: running requests are stopped at their
+// next candidate and resolve, like queued ones, as kKeygenCancelled.
+
+static const int kKeygenOk = 0;
+static const int kKeygenFailed = 1;
+static const int kKeygenCancelled = 2;
+static const int kKeygenTimedOut = 3;
+
+struct KeygenToken
+{
+	std::shared_ptr<std::atomic<int>> cancelled;
+};
+
+struct RSAKeygenResult
+{
+	int status;
+	struct RSA key;
+};
+
+struct DHParamsResult
+{
+	int status;
+	struct DH dh;
+};
+
+struct PrimeResult
+{
+	int status;
+	int prime;
+};
+
+int keygen_token_init(struct KeygenToken keygen_token_init_token[1]);
+
+// Cancels every request started with this token.
+int keygen_cancel(struct KeygenToken keygen_cancel_token[1]);
+
+// token may be nullptr; a deadline of time_point::max() means none
+std::future<struct RSAKeygenResult> rsa_keygen_async(
+	int rsa_keygen_async_bits,
+	int rsa_keygen_async_e,
+	struct KeygenToken rsa_keygen_async_token[1],
+	std::chrono::steady_clock::time_point rsa_keygen_async_deadline);
+
+std::future<struct DHParamsResult> dh_generate_paremeters_async(
+	int dh_genparam_async_prime_len,
+	int dh_genparam_async_generator,
+	struct KeygenToken dh_genparam_async_token[1],
+	std::chrono::steady_clock::time_point dh_genparam_async_deadline);
+
+std::future<struct PrimeResult> generate_prime_async(
+	int genprime_async_bits,
+	int genprime_async_safe,
+	int genprime_async_add,
+	int genprime_async_rem,
+	struct KeygenToken genprime_async_token[1],
+	std::chrono::steady_clock::time_point genprime_async_deadline);
+
+#endif
@@ -0,0 +1,299 @@
+#include <cstring>
+
+#include "keystore.h"
+
+static const unsigned char kKeyStoreMagic[4] = { 'C', 'M', 'M', 'K' };
+static const int kKeyStoreVersion = 1;
+static const int kKeyStoreHeaderSize = 32;
+static const int kKeyStoreRecordSize = 24;
+static const int kKeyStoreKeySize = 20;
+
+// Records are used in place, so the structs must be exactly the five
+// int32 fields of the on-disk layout.
+static_assert(sizeof(struct RSA) == kKeyStoreKeySize, "struct RSA must match the keystore record layout");
+static_assert(sizeof(struct DH) == kKeyStoreKeySize, "struct DH must match the keystore record layout");
+
+static unsigned int keystore_fnv1a(const unsigned char* keystore_fnv1a_p, int keystore_fnv1a_n)
+{
+	unsigned int keystore_fnv1a_h = 2166136261u;
+	int keystore_fnv1a_i;
+
+	for (keystore_fnv1a_i = 0; keystore_fnv1a_i < keystore_fnv1a_n; keystore_fnv1a_i++)
+	{
+		keystore_fnv1a_h = (keystore_fnv1a_h ^ keystore_fnv1a_p[keystore_fnv1a_i]) * 16777619u;
+	}
+
+	return keystore_fnv1a_h;
+}
+
+static unsigned long long keystore_get_le(const unsigned char* keystore_get_le_p, int keystore_get_le_bytes)
+{
+	unsigned long long keystore_get_le_x = 0;
+	int keystore_get_le_i;
+
+	for (keystore_get_le_i = keystore_get_le_bytes - 1; keystore_get_le_i >= 0; keystore_get_le_i--)
+	{
+		keystore_get_le_x = (keystore_get_le_x << 8) | keystore_get_le_p[keystore_get_le_i];
+	}
+
+	return keystore_get_le_x;
+}
+
+static void keystore_put_le(unsigned char* keystore_put_le_p, unsigned long long keystore_put_le_x, int keystore_put_le_bytes)
+{
+	int keystore_put_le_i;
+
+	for (keystore_put_le_i = 0; keystore_put_le_i < keystore_put_le_bytes; keystore_put_le_i++)
+	{
+		keystore_put_le_p[keystore_put_le_i] = (unsigned char)(keystore_put_le_x >> (8 * keystore_put_le_i));
+	}
+}
+
+static int keystore_host_is_little_endian()
+{
+	unsigned int keystore_hle_x = 1;
+	unsigned char keystore_hle_first;
+
+	memcpy(&keystore_hle_first, &keystore_hle_x, 1);
+
+	return keystore_hle_first == 1;
+}
+
+int keystore_open(struct KeyStore keystore_open_ks[1], const char* keystore_open_path, int keystore_open_kind)
+{
+	struct MappedFile keystore_open_file[1];
+	const unsigned char* keystore_open_header;
+	unsigned long long keystore_open_count;
+	size_t keystore_open_words;
+
+	// In-place use reinterprets little-endian records as native ints.
+	if (!keystore_host_is_little_endian() ||
+		!mapped_file_open(keystore_open_file, keystore_open_path, 1))
+	{
+		return 0;
+	}
+
+	keystore_open_header = keystore_open_file[0].data;
+
+	if (keystore_open_file[0].size < (size_t)kKeyStoreHeaderSize ||
+		memcmp(keystore_open_header, kKeyStoreMagic, 4) != 0 ||
+		keystore_get_le(keystore_open_header + 4, 4) != (unsigned long long)kKeyStoreVersion ||
+		keystore_get_le(keystore_open_header + 8, 4) != (unsigned long long)keystore_open_kind ||
+		keystore_get_le(keystore_open_header + 12, 4) != (unsigned long long)kKeyStoreRecordSize ||
+		keystore_get_le(keystore_open_header + 24, 4) != keystore_fnv1a(keystore_open_header, 24))
+	{
+		mapped_file_close(keystore_open_file);
+		return 0;
+	}
+
+	keystore_open_count = keystore_get_le(keystore_open_header + 16, 8);
+	if (keystore_open_count > (keystore_open_file[0].size - kKeyStoreHeaderSize) / kKeyStoreRecordSize ||
+		keystore_open_file[0].size != kKeyStoreHeaderSize + keystore_open_count * kKeyStoreRecordSize)
+	{
+		mapped_file_close(keystore_open_file);
+		return 0;
+	}
+
+	keystore_open_words = (size_t)(keystore_open_count + 31) / 32;
+
+	keystore_open_ks[0].file = keystore_open_file[0];
+	keystore_open_ks[0].kind = keystore_open_kind;
+	keystore_open_ks[0].count = (long long)keystore_open_count;
+	keystore_open_ks[0].checked.reset(new std::atomic<unsigned int>[keystore_open_words]());
+	keystore_open_ks[0].valid.reset(new std::atomic<unsigned int>[keystore_open_words]());
+
+	return 1;
+}
+
+int keystore_close(struct KeyStore keystore_close_ks[1])
+{
+	mapped_file_close(&keystore_close_ks[0].file);
+	keystore_close_ks[0].count = 0;
+	keystore_close_ks[0].checked.reset();
+	keystore_close_ks[0].valid.reset();
+
+	return 1;
+}
+
+// Return the record's key bytes, validating the record on first use.
+static unsigned char* keystore_record(struct KeyStore keystore_record_ks[1], long long keystore_record_index)
+{
+	unsigned char* keystore_record_p;
+	unsigned int keystore_record_bit;
+	size_t keystore_record_word;
+
+	if (keystore_record_index < 0 || keystore_record_index >= keystore_record_ks[0].count)
+	{
+		return nullptr;
+	}
+
+	keystore_record_p = keystore_record_ks[0].file.data + kKeyStoreHeaderSize +
+		(size_t)keystore_record_index * kKeyStoreRecordSize;
+	keystore_record_word = (size_t)keystore_record_index / 32;
+	keystore_record_bit = 1u << (keystore_record_index % 32);
+
+	if (!(keystore_record_ks[0].checked[keystore_record_word].load(std::memory_order_acquire) &
+		keystore_record_bit))
+	{
+		// Racing threads compute the same answer, so both may store it.
+		if (keystore_get_le(keystore_record_p + kKeyStoreKeySize, 4) ==
+			keystore_fnv1a(keystore_record_p, kKeyStoreKeySize))
+		{
+			keystore_record_ks[0].valid[keystore_record_word].fetch_or(
+				keystore_record_bit, std::memory_order_relaxed);
+		}
+
+		keystore_record_ks[0].checked[keystore_record_word].fetch_or(
+			keystore_record_bit, std::memory_order_release);
+	}
+
+	if (!(keystore_record_ks[0].valid[keystore_record_word].load(std::memory_order_relaxed) &
+		keystore_record_bit))
+	{
+		return nullptr;
+	}
+
+	return keystore_record_p;
+}
+
+struct RSA* keystore_rsa(struct KeyStore keystore_rsa_ks[1], long long keystore_rsa_index)
+{
+	if (keystore_rsa_ks[0].kind != kKeyStoreRsa)
+	{
+		return nullptr;
+	}
+
+	return (struct RSA*)keystore_record(keystore_rsa_ks, keystore_rsa_index);
+}
+
+struct DH* keystore_dh(struct KeyStore keystore_dh_ks[1], long long keystore_dh_index)
+{
+	if (keystore_dh_ks[0].kind != kKeyStoreDh)
+	{
+		return nullptr;
+	}
+
+	return (struct DH*)keystore_record(keystore_dh_ks, keystore_dh_index);
+}
+
+int keystore_writer_open(
+	struct KeyStoreWriter keystore_writer_open_w[1],
+	const char* keystore_writer_open_path,
+	int keystore_writer_open_kind)
+{
+	unsigned char keystore_writer_open_header[kKeyStoreHeaderSize] = { 0 };
+
+	if (keystore_writer_open_kind != kKeyStoreRsa && keystore_writer_open_kind != kKeyStoreDh)
+	{
+		return 0;
+	}
+
+	keystore_writer_open_w[0].file = fopen(keystore_writer_open_path, "wb");
+	if (!keystore_writer_open_w[0].file)
+	{
+		return 0;
+	}
+
+	keystore_writer_open_w[0].kind = keystore_writer_open_kind;
+	keystore_writer_open_w[0].count = 0;
+
+	// a placeholder until close knows the count
+	fwrite(keystore_writer_open_header, 1, kKeyStoreHeaderSize, keystore_writer_open_w[0].file);
+
+	return 1;
+}
+
+static int keystore_writer_append(struct KeyStoreWriter keystore_append_w[1], const int keystore_append_fields[5])
+{
+	unsigned char keystore_append_record[kKeyStoreRecordSize];
+	int keystore_append_i;
+
+	for (keystore_append_i = 0; keystore_append_i < 5; keystore_append_i++)
+	{
+		keystore_put_le(
+			keystore_append_record + 4 * keystore_append_i,
+			(unsigned int)keystore_append_fields[keystore_append_i],
+			4);
+	}
+
+	keystore_put_le(
+		keystore_append_record + kKeyStoreKeySize,
+		keystore_fnv1a(keystore_append_record, kKeyStoreKeySize),
+		4);
+
+	if (fwrite(keystore_append_record, 1, kKeyStoreRecordSize, keystore_append_w[0].file) !=
+		(size_t)kKeyStoreRecordSize)
+	{
+		return 0;
+	}
+
+	keystore_append_w[0].count = keystore_append_w[0].count + 1;
+
+	return 1;
+}
+
+int keystore_writer_append_rsa(struct KeyStoreWriter keystore_append_rsa_w[1], struct RSA keystore_append_rsa_key[1])
+{
+	int keystore_append_rsa_fields[5];
+
+	if (keystore_append_rsa_w[0].kind != kKeyStoreRsa)
+	{
+		return 0;
+	}
+
+	keystore_append_rsa_fields[0] = keystore_append_rsa_key[0].n;
+	keystore_append_rsa_fields[1] = keystore_append_rsa_key[0].e;
+	keystore_append_rsa_fields[2] = keystore_append_rsa_key[0].d;
+	keystore_append_rsa_fields[3] = keystore_append_rsa_key[0].p;
+	keystore_append_rsa_fields[4] = keystore_append_rsa_key[0].q;
+
+	return keystore_writer_append(keystore_append_rsa_w, keystore_append_rsa_fields);
+}
+
+int keystore_writer_append_dh(struct KeyStoreWriter keystore_append_dh_w[1], struct DH keystore_append_dh_key[1])
+{
+	int keystore_append_dh_fields[5];
+
+	if (keystore_append_dh_w[0].kind != kKeyStoreDh)
+	{
+		return 0;
+	}
+
+	keystore_append_dh_fields[0] = keystore_append_dh_key[0].params.g;
+	keystore_append_dh_fields[1] = keystore_append_dh_key[0].params.p;
+	keystore_append_dh_fields[2] = keystore_append_dh_key[0].params.q;
+	keystore_append_dh_fields[3] = keystore_append_dh_key[0].pubkey;
+	keystore_append_dh_fields[4] = keystore_append_dh_key[0].privkey;
+
+	return keystore_writer_append(keystore_append_dh_w, keystore_append_dh_fields);
+}
+
+int keystore_writer_close(struct KeyStoreWriter keystore_writer_close_w[1])
+{
+	unsigned char keystore_writer_close_header[kKeyStoreHeaderSize] = { 0 };
+	int keystore_writer_close_ok;
+
+	memcpy(keystore_writer_close_header, kKeyStoreMagic, 4);
+	keystore_put_le(keystore_writer_close_header + 4, kKeyStoreVersion, 4);
+	keystore_put_le(keystore_writer_close_header + 8, keystore_writer_close_w[0].kind, 4);
+	keystore_put_le(keystore_writer_close_header + 12, kKeyStoreRecordSize, 4);
+	keystore_put_le(keystore_writer_close_header + 16, keystore_writer_close_w[0].count, 8);
+	keystore_put_le(
+		keystore_writer_close_header + 24,
+		keystore_fnv1a(keystore_writer_close_header, 24),
+		4);
+
+	keystore_writer_close_ok =
+		fseek(keystore_writer_close_w[0].file, 0, SEEK_SET) == 0 &&
+		fwrite(keystore_writer_close_header, 1, kKeyStoreHeaderSize, keystore_writer_close_w[0].file) ==
+			(size_t)kKeyStoreHeaderSize;
+
+	if (fclose(keystore_writer_close_w[0].file) != 0)
+	{
+		keystore_writer_close_ok = 0;
+	}
+
+	keystore_writer_close_w[0].file = nullptr;
+
+	return keystore_writer_close_ok;
+}
@@ -0,0 +1,76 @@
+#ifndef KEYSTORE_H_
+#define KEYSTORE_H_
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+#include "dh.h"
+#include "mapped_file.h"
+#include "rsa.h"
+
+// Fixed-layout binary files of RSA or DH keys that are memory-mapped and
+// used in place.
+//
+// Header (32 bytes, little-endian):
+//   bytes 0-3    magic "CMMK"
+//   bytes 4-7    format version (1)
+//   bytes 8-11   key kind (kKeyStoreRsa or kKeyStoreDh)
+//   bytes 12-15  record size (24)
+//   bytes 16-23  record count (uint64)
+//   bytes 24-27  FNV-1a checksum of bytes 0-23
+//   bytes 28-31  reserved, 0
+// Record (24 bytes): the five int32 fields of struct RSA (n, e, d, p, q)
+// or struct DH (g, p, q, pubkey, privkey) in declaration order, followed
+// by the FNV-1a checksum of those 20 bytes.
+//
+// Opening checks only the header, so opening a store of millions of keys
+// costs the same as opening an empty one. Each record's checksum is
+// checked the first time the record is fetched and the result remembered.
+
+static const int kKeyStoreRsa = 1;
+static const int kKeyStoreDh = 2;
+
+struct KeyStore
+{
+	struct MappedFile file;
+	int kind;
+	long long count;
+
+	// one bit per record in each: checksum already checked / record valid
+	std::unique_ptr<std::atomic<unsigned int>[]> checked;
+	std::unique_ptr<std::atomic<unsigned int>[]> valid;
+};
+
+struct KeyStoreWriter
+{
+	FILE* file;
+	int kind;
+	long long count;
+};
+
+int keystore_open(struct KeyStore keystore_open_ks[1], const char* keystore_open_path, int keystore_open_kind);
+
+int keystore_close(struct KeyStore keystore_close_ks[1]);
+
+// Return the key in place, or nullptr if index is out of range or the
+// record fails its checksum. The mapping is private copy-on-write, so the
+// key can be handed to APIs taking struct RSA[1]/struct DH[1]; changes
+// never reach the file.
+struct RSA* keystore_rsa(struct KeyStore keystore_rsa_ks[1], long long keystore_rsa_index);
+
+struct DH* keystore_dh(struct KeyStore keystore_dh_ks[1], long long keystore_dh_index);
+
+int keystore_writer_open(
+	struct KeyStoreWriter keystore_writer_open_w[1],
+	const char* keystore_writer_open_path,
+	int keystore_writer_open_kind);
+
+int keystore_writer_append_rsa(struct KeyStoreWriter keystore_append_rsa_w[1], struct RSA keystore_append_rsa_key[1]);
+
+int keystore_writer_append_dh(struct KeyStoreWriter keystore_append_dh_w[1], struct DH keystore_append_dh_key[1]);
+
+// Fill in the count and header checksum and close the file.
+int keystore_writer_close(struct KeyStoreWriter keystore_writer_close_w[1]);
+
+#endif
@@ -0,0 +1,581 @@
+#ifndef LIMB_CORE_H_
+#define LIMB_CORE_H_
+
+#include <cstdint>
+
+// The multi-precision core of unsigned_op/bignum written once over the
+// limb type:
+//   uint16_t  products fit in 32 bits, the same split mul_uint32 does, so
+//             this instance emulates the C-- path natively
+//   uint32_t  64-bit products, like bignum's limbs
+//   uint64_t  128-bit products through unsigned __int128 where the
+//             compiler has it, otherwise through 32-bit half limbs
+// Numbers are little-endian limb arrays. Everything is constexpr (C++14),
+// so results can be pinned with static_assert; see limb_core_self_check.
+
+template <typename Limb>
+struct LimbTraits;
+
+template <>
+struct LimbTraits<uint16_t>
+{
+	typedef uint32_t Wide;
+	static constexpr int kBits = 16;
+};
+
+template <>
+struct LimbTraits<uint32_t>
+{
+	typedef uint64_t Wide;
+	static constexpr int kBits = 32;
+};
+
+template <>
+struct LimbTraits<uint64_t>
+{
+#if defined(__SIZEOF_INT128__)
+	typedef unsigned __int128 Wide;
+#else
+	// no double-width type; LimbWideOps<Limb, void> splits into halves
+	typedef void Wide;
+#endif
+	static constexpr int kBits = 64;
+};
+
+// limb x limb -> two limbs, and two limbs / limb, through the double-width
+// type
+template <typename Limb, typename Wide>
+struct LimbWideOps
+{
+	static constexpr Limb mul(Limb& limb_mul_hi_out, Limb limb_mul_a, Limb limb_mul_b)
+	{
+		Wide limb_mul_prod = (Wide)limb_mul_a * limb_mul_b;
+
+		limb_mul_hi_out = (Limb)(limb_mul_prod >> LimbTraits<Limb>::kBits);
+		return (Limb)limb_mul_prod;
+	}
+
+	// hi must be below d
+	static constexpr Limb div(Limb& limb_div_rem_out, Limb limb_div_hi, Limb limb_div_lo, Limb limb_div_d)
+	{
+		Wide limb_div_num = ((Wide)limb_div_hi << LimbTraits<Limb>::kBits) | limb_div_lo;
+
+		limb_div_rem_out = (Limb)(limb_div_num % limb_div_d);
+		return (Limb)(limb_div_num / limb_div_d);
+	}
+};
+
+// Without a double-width type: the four half-limb products of mul_uint32,
+// and restoring division one bit at a time.
+template <typename Limb>
+struct LimbWideOps<Limb, void>
+{
+	static constexpr Limb mul(Limb& limb_mul_hi_out, Limb limb_mul_a, Limb limb_mul_b)
+	{
+		const int limb_mul_half = LimbTraits<Limb>::kBits / 2;
+		const Limb limb_mul_mask = (Limb)(((Limb)1 << limb_mul_half) - 1);
+		Limb limb_mul_al = limb_mul_a & limb_mul_mask, limb_mul_ah = limb_mul_a >> limb_mul_half;
+		Limb limb_mul_bl = limb_mul_b & limb_mul_mask, limb_mul_bh = limb_mul_b >> limb_mul_half;
+		Limb limb_mul_ll = limb_mul_al * limb_mul_bl;
+		Limb limb_mul_lh = limb_mul_al * limb_mul_bh;
+		Limb limb_mul_hl = limb_mul_ah * limb_mul_bl;
+		Limb limb_mul_hh = limb_mul_ah * limb_mul_bh;
+		Limb limb_mul_mid = (limb_mul_ll >> limb_mul_half) + (limb_mul_lh & limb_mul_mask) + (limb_mul_hl & limb_mul_mask);
+
+		limb_mul_hi_out = limb_mul_hh + (limb_mul_lh >> limb_mul_half) + (limb_mul_hl >> limb_mul_half) +
+			(limb_mul_mid >> limb_mul_half);
+		return (limb_mul_ll & limb_mul_mask) | (Limb)(limb_mul_mid << limb_mul_half);
+	}
+
+	static constexpr Limb div(Limb& limb_div_rem_out, Limb limb_div_hi, Limb limb_div_lo, Limb limb_div_d)
+	{
+		const int limb_div_bits = LimbTraits<Limb>::kBits;
+		Limb limb_div_rem = limb_div_hi;
+		Limb limb_div_quot = 0;
+
+		for (int limb_div_i = limb_div_bits - 1; limb_div_i >= 0; limb_div_i--)
+		{
+			// the bit shifted out of rem makes it larger than any d
+			Limb limb_div_top = limb_div_rem >> (limb_div_bits - 1);
+
+			limb_div_rem = (Limb)(limb_div_rem << 1) | ((limb_div_lo >> limb_div_i) & 1);
+			limb_div_quot = (Limb)(limb_div_quot << 1);
+			if (limb_div_top || limb_div_rem >= limb_div_d)
+			{
+				limb_div_rem = limb_div_rem - limb_div_d;
+				limb_div_quot = limb_div_quot | 1;
+			}
+		}
+
+		limb_div_rem_out = limb_div_rem;
+		return limb_div_quot;
+	}
+};
+
+// limb operations
+
+template <typename Limb>
+constexpr Limb limb_add(Limb& limb_add_carry_out, Limb limb_add_a, Limb limb_add_b, Limb limb_add_carry_in)
+{
+	Limb limb_add_sum = (Limb)(limb_add_a + limb_add_b);
+	Limb limb_add_r = (Limb)(limb_add_sum + limb_add_carry_in);
+
+	limb_add_carry_out = (Limb)((limb_add_sum < limb_add_a) + (limb_add_r < limb_add_sum));
+	return limb_add_r;
+}
+
+template <typename Limb>
+constexpr Limb limb_sub(Limb& limb_sub_borrow_out, Limb limb_sub_a, Limb limb_sub_b, Limb limb_sub_borrow_in)
+{
+	Limb limb_sub_diff = (Limb)(limb_sub_a - limb_sub_b);
+	Limb limb_sub_r = (Limb)(limb_sub_diff - limb_sub_borrow_in);
+
+	limb_sub_borrow_out = (Limb)((limb_sub_a < limb_sub_b) + (limb_sub_diff < limb_sub_borrow_in));
+	return limb_sub_r;
+}
+
+// Return the low limb of a*b
+template <typename Limb>
+constexpr Limb limb_mul(Limb& limb_mul_hi_out, Limb limb_mul_a, Limb limb_mul_b)
+{
+	return LimbWideOps<Limb, typename LimbTraits<Limb>::Wide>::mul(limb_mul_hi_out, limb_mul_a, limb_mul_b);
+}
+
+// Return (hi, lo) / d; hi must be below d
+template <typename Limb>
+constexpr Limb limb_div(Limb& limb_div_rem_out, Limb limb_div_hi, Limb limb_div_lo, Limb limb_div_d)
+{
+	return LimbWideOps<Limb, typename LimbTraits<Limb>::Wide>::div(
+		limb_div_rem_out, limb_div_hi, limb_div_lo, limb_div_d);
+}
+
+// a must not be 0
+template <typename Limb>
+constexpr int limb_clz(Limb limb_clz_a)
+{
+	int limb_clz_n = 0;
+
+	while (!(limb_clz_a >> (LimbTraits<Limb>::kBits - 1)))
+	{
+		limb_clz_a = (Limb)(limb_clz_a << 1);
+		limb_clz_n++;
+	}
+
+	return limb_clz_n;
+}
+
+// limb array operations, as in bignum
+
+template <typename Limb>
+constexpr int limbs_len(const Limb limbs_len_a[], int limbs_len_n)
+{
+	while (limbs_len_n > 0 && limbs_len_a[limbs_len_n - 1] == 0)
+	{
+		limbs_len_n--;
+	}
+
+	return limbs_len_n;
+}
+
+template <typename Limb>
+constexpr int limbs_cmp(const Limb limbs_cmp_a[], const Limb limbs_cmp_b[], int limbs_cmp_n)
+{
+	for (int limbs_cmp_i = limbs_cmp_n - 1; limbs_cmp_i >= 0; limbs_cmp_i--)
+	{
+		if (limbs_cmp_a[limbs_cmp_i] != limbs_cmp_b[limbs_cmp_i])
+		{
+			return limbs_cmp_a[limbs_cmp_i] > limbs_cmp_b[limbs_cmp_i] ? 1 : -1;
+		}
+	}
+
+	return 0;
+}
+
+// Return the carry out of the top limb
+template <typename Limb>
+constexpr Limb limbs_add(Limb limbs_add_r[], const Limb limbs_add_a[], const Limb limbs_add_b[], int limbs_add_n)
+{
+	Limb limbs_add_carry = 0;
+
+	for (int limbs_add_i = 0; limbs_add_i < limbs_add_n; limbs_add_i++)
+	{
+		limbs_add_r[limbs_add_i] = limb_add(
+			limbs_add_carry, limbs_add_a[limbs_add_i], limbs_add_b[limbs_add_i], limbs_add_carry);
+	}
+
+	return limbs_add_carry;
+}
+
+// Return the borrow out of the top limb
+template <typename Limb>
+constexpr Limb limbs_sub(Limb limbs_sub_r[], const Limb limbs_sub_a[], const Limb limbs_sub_b[], int limbs_sub_n)
+{
+	Limb limbs_sub_borrow = 0;
+
+	for (int limbs_sub_i = 0; limbs_sub_i < limbs_sub_n; limbs_sub_i++)
+	{
+		limbs_sub_r[limbs_sub_i] = limb_sub(
+			limbs_sub_borrow, limbs_sub_a[limbs_sub_i], limbs_sub_b[limbs_sub_i], limbs_sub_borrow);
+	}
+
+	return limbs_sub_borrow;
+}
+
+// r[0..n-1] += a * w; return the limb carried out
+template <typename Limb>
+constexpr Limb limbs_mul_limb_add(Limb limbs_mla_r[], const Limb limbs_mla_a[], int limbs_mla_n, Limb limbs_mla_w)
+{
+	Limb limbs_mla_carry = 0;
+
+	for (int limbs_mla_i = 0; limbs_mla_i < limbs_mla_n; limbs_mla_i++)
+	{
+		Limb limbs_mla_hi = 0, limbs_mla_c1 = 0, limbs_mla_c2 = 0;
+		Limb limbs_mla_lo = limb_mul(limbs_mla_hi, limbs_mla_a[limbs_mla_i], limbs_mla_w);
+
+		limbs_mla_lo = limb_add(limbs_mla_c1, limbs_mla_lo, limbs_mla_r[limbs_mla_i], (Limb)0);
+		limbs_mla_r[limbs_mla_i] = limb_add(limbs_mla_c2, limbs_mla_lo, limbs_mla_carry, (Limb)0);
+		limbs_mla_carry = (Limb)(limbs_mla_hi + limbs_mla_c1 + limbs_mla_c2);
+	}
+
+	return limbs_mla_carry;
+}
+
+// r[0..n-1] -= a * w; return the limb borrowed out
+template <typename Limb>
+constexpr Limb limbs_mul_limb_sub(Limb limbs_mls_r[], const Limb limbs_mls_a[], int limbs_mls_n, Limb limbs_mls_w)
+{
+	Limb limbs_mls_borrow = 0;
+
+	for (int limbs_mls_i = 0; limbs_mls_i < limbs_mls_n; limbs_mls_i++)
+	{
+		Limb limbs_mls_hi = 0, limbs_mls_c = 0, limbs_mls_b = 0;
+		Limb limbs_mls_lo = limb_mul(limbs_mls_hi, limbs_mls_a[limbs_mls_i], limbs_mls_w);
+
+		limbs_mls_lo = limb_add(limbs_mls_c, limbs_mls_lo, limbs_mls_borrow, (Limb)0);
+		limbs_mls_r[limbs_mls_i] = limb_sub(limbs_mls_b, limbs_mls_r[limbs_mls_i], limbs_mls_lo, (Limb)0);
+		limbs_mls_borrow = (Limb)(limbs_mls_hi + limbs_mls_c + limbs_mls_b);
+	}
+
+	return limbs_mls_borrow;
+}
+
+// schoolbook; r has an+bn limbs and must not alias a or b
+template <typename Limb>
+constexpr void limbs_mul(Limb limbs_mul_r[], const Limb limbs_mul_a[], int limbs_mul_an, const Limb limbs_mul_b[], int limbs_mul_bn)
+{
+	for (int limbs_mul_i = 0; limbs_mul_i < limbs_mul_an + limbs_mul_bn; limbs_mul_i++)
+	{
+		limbs_mul_r[limbs_mul_i] = 0;
+	}
+
+	for (int limbs_mul_j = 0; limbs_mul_j < limbs_mul_bn; limbs_mul_j++)
+	{
+		limbs_mul_r[limbs_mul_an + limbs_mul_j] = limbs_mul_limb_add(
+			limbs_mul_r + limbs_mul_j, limbs_mul_a, limbs_mul_an, limbs_mul_b[limbs_mul_j]);
+	}
+}
+
+// s < kBits; return the bits shifted out of the top limb
+template <typename Limb>
+constexpr Limb limbs_lshift(Limb limbs_lshift_r[], const Limb limbs_lshift_a[], int limbs_lshift_n, int limbs_lshift_s)
+{
+	const int limbs_lshift_bits = LimbTraits<Limb>::kBits;
+	Limb limbs_lshift_out = 0;
+
+	if (limbs_lshift_s == 0)
+	{
+		for (int limbs_lshift_i = 0; limbs_lshift_i < limbs_lshift_n; limbs_lshift_i++)
+		{
+			limbs_lshift_r[limbs_lshift_i] = limbs_lshift_a[limbs_lshift_i];
+		}
+
+		return 0;
+	}
+
+	limbs_lshift_out = (Limb)(limbs_lshift_a[limbs_lshift_n - 1] >> (limbs_lshift_bits - limbs_lshift_s));
+	for (int limbs_lshift_i = limbs_lshift_n - 1; limbs_lshift_i > 0; limbs_lshift_i--)
+	{
+		limbs_lshift_r[limbs_lshift_i] = (Limb)((Limb)(limbs_lshift_a[limbs_lshift_i] << limbs_lshift_s) |
+			(limbs_lshift_a[limbs_lshift_i - 1] >> (limbs_lshift_bits - limbs_lshift_s)));
+	}
+	limbs_lshift_r[0] = (Limb)(limbs_lshift_a[0] << limbs_lshift_s);
+
+	return limbs_lshift_out;
+}
+
+// s < kBits
+template <typename Limb>
+constexpr void limbs_rshift(Limb limbs_rshift_r[], const Limb limbs_rshift_a[], int limbs_rshift_n, int limbs_rshift_s)
+{
+	const int limbs_rshift_bits = LimbTraits<Limb>::kBits;
+
+	for (int limbs_rshift_i = 0; limbs_rshift_i < limbs_rshift_n; limbs_rshift_i++)
+	{
+		Limb limbs_rshift_limb = (Limb)(limbs_rshift_a[limbs_rshift_i] >> limbs_rshift_s);
+
+		if (limbs_rshift_s != 0 && limbs_rshift_i + 1 < limbs_rshift_n)
+		{
+			limbs_rshift_limb = limbs_rshift_limb |
+				(Limb)(limbs_rshift_a[limbs_rshift_i + 1] << (limbs_rshift_bits - limbs_rshift_s));
+		}
+
+		limbs_rshift_r[limbs_rshift_i] = limbs_rshift_limb;
+	}
+}
+
+// q = a / d (n limbs, may be nullptr); return a mod d. d must not be 0.
+template <typename Limb>
+constexpr Limb limbs_div_limb(Limb limbs_divl_q[], const Limb limbs_divl_a[], int limbs_divl_n, Limb limbs_divl_d)
+{
+	Limb limbs_divl_rem = 0;
+
+	for (int limbs_divl_i = limbs_divl_n - 1; limbs_divl_i >= 0; limbs_divl_i--)
+	{
+		Limb limbs_divl_quot = limb_div(limbs_divl_rem, limbs_divl_rem, limbs_divl_a[limbs_divl_i], limbs_divl_d);
+
+		if (limbs_divl_q != nullptr)
+		{
+			limbs_divl_q[limbs_divl_i] = limbs_divl_quot;
+		}
+	}
+
+	return limbs_divl_rem;
+}
+
+// Knuth's algorithm D, as bn_div_mod. q has an limbs and r has bn limbs;
+// either may be nullptr, neither may alias a or b. scratch: an+bn+1
+// limbs. Return 0 if b is 0.
+template <typename Limb>
+constexpr int limbs_div_mod(
+	Limb limbs_divmod_q[],
+	Limb limbs_divmod_r[],
+	const Limb limbs_divmod_a[],
+	int limbs_divmod_an,
+	const Limb limbs_divmod_b[],
+	int limbs_divmod_bn,
+	Limb limbs_divmod_scratch[])
+{
+	Limb* limbs_divmod_u = limbs_divmod_scratch;
+	Limb* limbs_divmod_v = limbs_divmod_scratch + limbs_divmod_an + 1;
+	int limbs_divmod_al = limbs_len(limbs_divmod_a, limbs_divmod_an);
+	int limbs_divmod_bl = limbs_len(limbs_divmod_b, limbs_divmod_bn);
+	int limbs_divmod_s = 0;
+
+	if (limbs_divmod_bl == 0)
+	{
+		return 0;
+	}
+
+	if (limbs_divmod_q != nullptr)
+	{
+		for (int limbs_divmod_i = 0; limbs_divmod_i < limbs_divmod_an; limbs_divmod_i++)
+		{
+			limbs_divmod_q[limbs_divmod_i] = 0;
+		}
+	}
+
+	if (limbs_divmod_r != nullptr)
+	{
+		for (int limbs_divmod_i = 0; limbs_divmod_i < limbs_divmod_bn; limbs_divmod_i++)
+		{
+			limbs_divmod_r[limbs_divmod_i] = 0;
+		}
+	}
+
+	if (limbs_divmod_al < limbs_divmod_bl)
+	{
+		for (int limbs_divmod_i = 0; limbs_divmod_r != nullptr && limbs_divmod_i < limbs_divmod_al; limbs_divmod_i++)
+		{
+			limbs_divmod_r[limbs_divmod_i] = limbs_divmod_a[limbs_divmod_i];
+		}
+
+		return 1;
+	}
+
+	if (limbs_divmod_bl == 1)
+	{
+		Limb limbs_divmod_rem = limbs_div_limb(limbs_divmod_q, limbs_divmod_a, limbs_divmod_al, limbs_divmod_b[0]);
+
+		if (limbs_divmod_r != nullptr)
+		{
+			limbs_divmod_r[0] = limbs_divmod_rem;
+		}
+
+		return 1;
+	}
+
+	limbs_divmod_s = limb_clz(limbs_divmod_b[limbs_divmod_bl - 1]);
+	limbs_lshift(limbs_divmod_v, limbs_divmod_b, limbs_divmod_bl, limbs_divmod_s);
+	limbs_divmod_u[limbs_divmod_al] = limbs_lshift(limbs_divmod_u, limbs_divmod_a, limbs_divmod_al, limbs_divmod_s);
+
+	for (int limbs_divmod_j = limbs_divmod_al - limbs_divmod_bl; limbs_divmod_j >= 0; limbs_divmod_j--)
+	{
+		Limb* limbs_divmod_uj = limbs_divmod_u + limbs_divmod_j;
+		Limb limbs_divmod_vt = limbs_divmod_v[limbs_divmod_bl - 1];
+		Limb limbs_divmod_qhat = 0, limbs_divmod_rhat = 0, limbs_divmod_carry = 0;
+
+		if (limbs_divmod_uj[limbs_divmod_bl] == limbs_divmod_vt)
+		{
+			limbs_divmod_qhat = (Limb)~(Limb)0;
+			limbs_divmod_rhat = limb_add(
+				limbs_divmod_carry, limbs_divmod_uj[limbs_divmod_bl - 1], limbs_divmod_vt, (Limb)0);
+		}
+		else
+		{
+			limbs_divmod_qhat = limb_div(
+				limbs_divmod_rhat,
+				limbs_divmod_uj[limbs_divmod_bl],
+				limbs_divmod_uj[limbs_divmod_bl - 1],
+				limbs_divmod_vt);
+		}
+
+		// while qhat*v[bl-2] > (rhat, u[j+bl-2]), qhat is too big
+		while (!limbs_divmod_carry)
+		{
+			Limb limbs_divmod_phi = 0;
+			Limb limbs_divmod_plo = limb_mul(limbs_divmod_phi, limbs_divmod_qhat, limbs_divmod_v[limbs_divmod_bl - 2]);
+
+			if (limbs_divmod_phi < limbs_divmod_rhat ||
+				(limbs_divmod_phi == limbs_divmod_rhat && limbs_divmod_plo <= limbs_divmod_uj[limbs_divmod_bl - 2]))
+			{
+				break;
+			}
+
+			limbs_divmod_qhat = (Limb)(limbs_divmod_qhat - 1);
+			limbs_divmod_rhat = limb_add(limbs_divmod_carry, limbs_divmod_rhat, limbs_divmod_vt, (Limb)0);
+		}
+
+		Limb limbs_divmod_borrow = 0;
+		limbs_divmod_uj[limbs_divmod_bl] = limb_sub(
+			limbs_divmod_borrow,
+			limbs_divmod_uj[limbs_divmod_bl],
+			limbs_mul_limb_sub(limbs_divmod_uj, limbs_divmod_v, limbs_divmod_bl, limbs_divmod_qhat),
+			(Limb)0);
+
+		if (limbs_divmod_borrow)
+		{
+			limbs_divmod_qhat = (Limb)(limbs_divmod_qhat - 1);
+			limbs_divmod_uj[limbs_divmod_bl] = (Limb)(limbs_divmod_uj[limbs_divmod_bl] +
+				limbs_add(limbs_divmod_uj, limbs_divmod_uj, limbs_divmod_v, limbs_divmod_bl));
+		}
+
+		if (limbs_divmod_q != nullptr)
+		{
+			limbs_divmod_q[limbs_divmod_j] = limbs_divmod_qhat;
+		}
+	}
+
+	if (limbs_divmod_r != nullptr)
+	{
+		limbs_rshift(limbs_divmod_r, limbs_divmod_u, limbs_divmod_bl, limbs_divmod_s);
+	}
+
+	return 1;
+}
+
+// uint64 on top of the core: 64/kBits limbs per value
+
+template <typename Limb>
+constexpr void limbs_from_u64(Limb limbs_from_r[], uint64_t limbs_from_x)
+{
+	for (int limbs_from_i = 0; limbs_from_i < 64 / LimbTraits<Limb>::kBits; limbs_from_i++)
+	{
+		limbs_from_r[limbs_from_i] = (Limb)(limbs_from_x >> (limbs_from_i * LimbTraits<Limb>::kBits));
+	}
+}
+
+template <typename Limb>
+constexpr uint64_t limbs_to_u64(const Limb limbs_to_a[])
+{
+	uint64_t limbs_to_x = 0;
+
+	for (int limbs_to_i = 0; limbs_to_i < 64 / LimbTraits<Limb>::kBits; limbs_to_i++)
+	{
+		limbs_to_x = limbs_to_x | ((uint64_t)limbs_to_a[limbs_to_i] << (limbs_to_i * LimbTraits<Limb>::kBits));
+	}
+
+	return limbs_to_x;
+}
+
+// a*b mod m over the full 128-bit product; m must not be 0
+template <typename Limb>
+constexpr uint64_t limb_core_mul_mod(uint64_t limb_mul_mod_a, uint64_t limb_mul_mod_b, uint64_t limb_mul_mod_m)
+{
+	const int limb_mul_mod_k = 64 / LimbTraits<Limb>::kBits;
+	Limb limb_mul_mod_av[64 / LimbTraits<Limb>::kBits] = {};
+	Limb limb_mul_mod_bv[64 / LimbTraits<Limb>::kBits] = {};
+	Limb limb_mul_mod_mv[64 / LimbTraits<Limb>::kBits] = {};
+	Limb limb_mul_mod_rv[64 / LimbTraits<Limb>::kBits] = {};
+	Limb limb_mul_mod_prod[2 * 64 / LimbTraits<Limb>::kBits] = {};
+	Limb limb_mul_mod_scratch[3 * 64 / LimbTraits<Limb>::kBits + 1] = {};
+
+	limbs_from_u64(limb_mul_mod_av, limb_mul_mod_a);
+	limbs_from_u64(limb_mul_mod_bv, limb_mul_mod_b);
+	limbs_from_u64(limb_mul_mod_mv, limb_mul_mod_m);
+
+	limbs_mul(limb_mul_mod_prod, limb_mul_mod_av, limb_mul_mod_k, limb_mul_mod_bv, limb_mul_mod_k);
+	limbs_div_mod(
+		(Limb*)nullptr,
+		limb_mul_mod_rv,
+		limb_mul_mod_prod,
+		2 * limb_mul_mod_k,
+		limb_mul_mod_mv,
+		limb_mul_mod_k,
+		limb_mul_mod_scratch);
+
+	return limbs_to_u64(limb_mul_mod_rv);
+}
+
+template <typename Limb>
+constexpr uint64_t limb_core_exp_mod(uint64_t limb_exp_mod_a, uint64_t limb_exp_mod_e, uint64_t limb_exp_mod_m)
+{
+	uint64_t limb_exp_mod_r = limb_core_mul_mod<Limb>(1, 1, limb_exp_mod_m);
+
+	limb_exp_mod_a = limb_core_mul_mod<Limb>(limb_exp_mod_a, 1, limb_exp_mod_m);
+	while (limb_exp_mod_e)
+	{
+		if (limb_exp_mod_e & 1)
+		{
+			limb_exp_mod_r = limb_core_mul_mod<Limb>(limb_exp_mod_r, limb_exp_mod_a, limb_exp_mod_m);
+		}
+
+		limb_exp_mod_e >>= 1;
+		limb_exp_mod_a = limb_core_mul_mod<Limb>(limb_exp_mod_a, limb_exp_mod_a, limb_exp_mod_m);
+	}
+
+	return limb_exp_mod_r;
+}
+
+// Known answers every instance must reproduce; meant for static_assert.
+template <typename Limb>
+constexpr bool limb_core_self_check()
+{
+	return limb_core_mul_mod<Limb>(0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFC5ull) == 3364 &&
+		limb_core_mul_mod<Limb>(0x123456789ABCDEFull, 0xFEDCBA987654321ull, 0x3FFFFFFFFFFFFFFFull) ==
+			0x226BEC0929B40E9Full &&
+		limb_core_exp_mod<Limb>(2, 0x3FFFFFFFFFFFFFFEull, 0x3FFFFFFFFFFFFFFFull) == 4 &&
+		limb_core_exp_mod<Limb>(3, 1000000006, 1000000007) == 1;
+}
+
+// uint64 in the int[2] layout of unsigned_op (index 0 is the high word)
+template <typename Limb>
+int mul_mod_uint64_limbs(int mul_mod_limbs_out[2], int mul_mod_limbs_a[2], int mul_mod_limbs_b[2], int mul_mod_limbs_m[2])
+{
+	uint64_t mul_mod_limbs_a64 = (uint64_t)(uint32_t)mul_mod_limbs_a[0] << 32 | (uint32_t)mul_mod_limbs_a[1];
+	uint64_t mul_mod_limbs_b64 = (uint64_t)(uint32_t)mul_mod_limbs_b[0] << 32 | (uint32_t)mul_mod_limbs_b[1];
+	uint64_t mul_mod_limbs_m64 = (uint64_t)(uint32_t)mul_mod_limbs_m[0] << 32 | (uint32_t)mul_mod_limbs_m[1];
+	uint64_t mul_mod_limbs_r;
+
+	if (mul_mod_limbs_m64 == 0)
+	{
+		return 0;
+	}
+
+	mul_mod_limbs_r = limb_core_mul_mod<Limb>(mul_mod_limbs_a64, mul_mod_limbs_b64, mul_mod_limbs_m64);
+	mul_mod_limbs_out[0] = (int)(uint32_t)(mul_mod_limbs_r >> 32);
+	mul_mod_limbs_out[1] = (int)(uint32_t)mul_mod_limbs_r;
+
+	return 1;
+}
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef LOCKFREE_QUEUE_H_
+#define LOCKFREE_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Bounded multi-producer multi-consumer queue (Vyukov's array queue).
+// Every cell carries a sequence number telling producers and consumers
+// whose turn it is, so push and pop each cost one CAS on their own index
+// and never block; callers decide how to wait when push or pop fails.
+
+template <typename T>
+struct LockFreeQueueCell
+{
+	std::atomic<size_t> seq;
+	T value;
+};
+
+template <typename T>
+struct LockFreeQueue
+{
+	std::unique_ptr<LockFreeQueueCell<T>[]> cells;
+	size_t mask;
+
+	// producers and consumers spin on different cache lines
+	alignas(64) std::atomic<size_t> enqueue_pos;
+	alignas(64) std::atomic<size_t> dequeue_pos;
+};
+
+// capacity is rounded up to a power of two
+template <typename T>
+int lockfree_queue_init(LockFreeQueue<T> lfq_init_q[1], int lfq_init_capacity)
+{
+	size_t lfq_init_size = 2;
+	size_t lfq_init_i;
+
+	if (lfq_init_capacity <= 0)
+	{
+		return 0;
+	}
+
+	while (lfq_init_size < (size_t)lfq_init_capacity)
+	{
+		lfq_init_size *= 2;
+	}
+
+	lfq_init_q[0].cells.reset(new LockFreeQueueCell<T>[lfq_init_size]);
+	for (lfq_init_i = 0; lfq_init_i < lfq_init_size; lfq_init_i++)
+	{
+		lfq_init_q[0].cells[lfq_init_i].seq.store(lfq_init_i, std::memory_order_relaxed);
+	}
+
+	lfq_init_q[0].mask = lfq_init_size - 1;
+	lfq_init_q[0].enqueue_pos.store(0, std::memory_order_relaxed);
+	lfq_init_q[0].dequeue_pos.store(0, std::memory_order_relaxed);
+
+	return 1;
+}
+
+// Returns 0 if the queue is full.
+template <typename T>
+int lockfree_queue_push(LockFreeQueue<T> lfq_push_q[1], const T& lfq_push_value)
+{
+	LockFreeQueueCell<T>* lfq_push_cell;
+	size_t lfq_push_pos = lfq_push_q[0].enqueue_pos.load(std::memory_order_relaxed);
+	size_t lfq_push_seq;
+
+	while (1)
+	{
+		lfq_push_cell = &lfq_push_q[0].cells[lfq_push_pos & lfq_push_q[0].mask];
+		lfq_push_seq = lfq_push_cell->seq.load(std::memory_order_acquire);
+
+		if (lfq_push_seq == lfq_push_pos)
+		{
+			if (lfq_push_q[0].enqueue_pos.compare_exchange_weak(
+				lfq_push_pos, lfq_push_pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (lfq_push_seq < lfq_push_pos)
+		{
+			return 0;
+		}
+		else
+		{
+			lfq_push_pos = lfq_push_q[0].enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	lfq_push_cell->value = lfq_push_value;
+	lfq_push_cell->seq.store(lfq_push_pos + 1, std::memory_order_release);
+
+	return 1;
+}
+
+// Returns 0 if the queue is empty.
+template <typename T>
+int lockfree_queue_pop(LockFreeQueue<T> lfq_pop_q[1], T lfq_pop_out[1])
+{
+	LockFreeQueueCell<T>* lfq_pop_cell;
+	size_t lfq_pop_pos = lfq_pop_q[0].dequeue_pos.load(std::memory_order_relaxed);
+	size_t lfq_pop_seq;
+
+	while (1)
+	{
+		lfq_pop_cell = &lfq_pop_q[0].cells[lfq_pop_pos & lfq_pop_q[0].mask];
+		lfq_pop_seq = lfq_pop_cell->seq.load(std::memory_order_acquire);
+
+		if (lfq_pop_seq == lfq_pop_pos + 1)
+		{
+			if (lfq_pop_q[0].dequeue_pos.compare_exchange_weak(
+				lfq_pop_pos, lfq_pop_pos + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (lfq_pop_seq < lfq_pop_pos + 1)
+		{
+			return 0;
+		}
+		else
+		{
+			lfq_pop_pos = lfq_pop_q[0].dequeue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	lfq_pop_out[0] = lfq_pop_cell->value;
+	lfq_pop_cell->seq.store(lfq_pop_pos + lfq_pop_q[0].mask + 1, std::memory_order_release);
+
+	return 1;
+}
+
+// Approximate number of queued items; exact only when no push or pop is
+// in flight.
+template <typename T>
+size_t lockfree_queue_size(LockFreeQueue<T> lfq_size_q[1])
+{
+	size_t lfq_size_enq = lfq_size_q[0].enqueue_pos.load(std::memory_order_relaxed);
+	size_t lfq_size_deq = lfq_size_q[0].dequeue_pos.load(std::memory_order_relaxed);
+
+	return lfq_size_enq > lfq_size_deq ? lfq_size_enq - lfq_size_deq : 0;
+}
+
+#endif
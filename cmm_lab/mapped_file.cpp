@@ -0,0 +1,150 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+int mapped_file_open(
+	struct MappedFile mapped_file_open_out[1],
+	const char* mapped_file_open_path,
+	int mapped_file_open_copy_on_write)
+{
+	LARGE_INTEGER mapped_file_open_size;
+	HANDLE mapped_file_open_file, mapped_file_open_mapping;
+	void* mapped_file_open_view = nullptr;
+
+	mapped_file_open_file = CreateFileA(
+		mapped_file_open_path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mapped_file_open_file == INVALID_HANDLE_VALUE)
+	{
+		return 0;
+	}
+
+	if (!GetFileSizeEx(mapped_file_open_file, &mapped_file_open_size))
+	{
+		CloseHandle(mapped_file_open_file);
+		return 0;
+	}
+
+	// Zero-length files cannot be mapped; report them as empty.
+	mapped_file_open_mapping = nullptr;
+	if (mapped_file_open_size.QuadPart > 0)
+	{
+		mapped_file_open_mapping = CreateFileMappingA(
+			mapped_file_open_file, nullptr,
+			mapped_file_open_copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY,
+			0, 0, nullptr);
+		if (!mapped_file_open_mapping)
+		{
+			CloseHandle(mapped_file_open_file);
+			return 0;
+		}
+
+		mapped_file_open_view = MapViewOfFile(
+			mapped_file_open_mapping,
+			mapped_file_open_copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ,
+			0, 0, 0);
+		if (!mapped_file_open_view)
+		{
+			CloseHandle(mapped_file_open_mapping);
+			CloseHandle(mapped_file_open_file);
+			return 0;
+		}
+	}
+
+	mapped_file_open_out[0].data = (unsigned char*)mapped_file_open_view;
+	mapped_file_open_out[0].size = (size_t)mapped_file_open_size.QuadPart;
+	mapped_file_open_out[0].file_handle = mapped_file_open_file;
+	mapped_file_open_out[0].mapping_handle = mapped_file_open_mapping;
+
+	return 1;
+}
+
+int mapped_file_close(struct MappedFile mapped_file_close_file[1])
+{
+	if (mapped_file_close_file[0].data)
+	{
+		UnmapViewOfFile(mapped_file_close_file[0].data);
+	}
+
+	if (mapped_file_close_file[0].mapping_handle)
+	{
+		CloseHandle((HANDLE)mapped_file_close_file[0].mapping_handle);
+	}
+
+	CloseHandle((HANDLE)mapped_file_close_file[0].file_handle);
+
+	mapped_file_close_file[0].data = nullptr;
+	mapped_file_close_file[0].size = 0;
+
+	return 1;
+}
+
+#else
+
+int mapped_file_open(
+	struct MappedFile mapped_file_open_out[1],
+	const char* mapped_file_open_path,
+	int mapped_file_open_copy_on_write)
+{
+	struct stat mapped_file_open_stat;
+	void* mapped_file_open_view = nullptr;
+	int mapped_file_open_fd = open(mapped_file_open_path, O_RDONLY);
+
+	if (mapped_file_open_fd < 0)
+	{
+		return 0;
+	}
+
+	if (fstat(mapped_file_open_fd, &mapped_file_open_stat) != 0)
+	{
+		close(mapped_file_open_fd);
+		return 0;
+	}
+
+	// Zero-length files cannot be mapped; report them as empty.
+	if (mapped_file_open_stat.st_size > 0)
+	{
+		mapped_file_open_view = mmap(
+			nullptr, (size_t)mapped_file_open_stat.st_size,
+			mapped_file_open_copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ,
+			MAP_PRIVATE, mapped_file_open_fd, 0);
+		if (mapped_file_open_view == MAP_FAILED)
+		{
+			close(mapped_file_open_fd);
+			return 0;
+		}
+	}
+
+	mapped_file_open_out[0].data = (unsigned char*)mapped_file_open_view;
+	mapped_file_open_out[0].size = (size_t)mapped_file_open_stat.st_size;
+	mapped_file_open_out[0].fd = mapped_file_open_fd;
+
+	return 1;
+}
+
+int mapped_file_close(struct MappedFile mapped_file_close_file[1])
+{
+	if (mapped_file_close_file[0].data)
+	{
+		munmap(mapped_file_close_file[0].data, mapped_file_close_file[0].size);
+	}
+
+	close(mapped_file_close_file[0].fd);
+
+	mapped_file_close_file[0].data = nullptr;
+	mapped_file_close_file[0].size = 0;
+
+	return 1;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+
+// Read-only (or private copy-on-write) memory mapping of a whole file.
+struct MappedFile
+{
+	unsigned char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#else
+	int fd;
+#endif
+};
+
+// copy_on_write != 0 maps the pages writable; writes stay private to the
+// process and never reach the file. Returns 0 if the file cannot be mapped.
+int mapped_file_open(
+	struct MappedFile mapped_file_open_out[1],
+	const char* mapped_file_open_path,
+	int mapped_file_open_copy_on_write);
+
+int mapped_file_close(struct MappedFile mapped_file_close_file[1]);
+
+#endif
@@ -0,0 +1,354 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "metrics.h"
+
+static const int kMetricsExactBits = 6; // values below 2^6 get their own bucket
+static const int kMetricsHalf = 1 << (kMetricsExactBits - 1); // buckets per power of two above that
+static const int kMetricsMaxBits = 40;
+static const int kMetricsBuckets = (kMetricsMaxBits - kMetricsExactBits + 2) * kMetricsHalf;
+
+struct MetricsShard
+{
+	// written only by the owning thread, so increments are a relaxed load
+	// and store rather than a locked add
+	std::atomic<uint64_t> counts[kMetricsOpCount][kMetricsBuckets];
+	std::atomic<uint64_t> sums[kMetricsOpCount];
+	std::atomic<uint64_t> maxima[kMetricsOpCount];
+};
+
+static std::mutex kMetricsLock;
+static std::vector<struct MetricsShard*> kMetricsShards;
+static std::vector<struct MetricsShard*> kMetricsFreeShards;
+
+// hands the shard back for reuse when the thread exits
+struct MetricsShardHolder
+{
+	struct MetricsShard* shard = nullptr;
+
+	~MetricsShardHolder()
+	{
+		if (shard != nullptr)
+		{
+			std::lock_guard<std::mutex> metrics_holder_guard(kMetricsLock);
+			kMetricsFreeShards.push_back(shard);
+		}
+	}
+};
+
+static thread_local struct MetricsShardHolder kMetricsShard;
+
+static int metrics_msb(uint64_t metrics_msb_v)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long metrics_msb_index;
+
+	_BitScanReverse64(&metrics_msb_index, metrics_msb_v);
+	return (int)metrics_msb_index;
+#elif defined(_MSC_VER)
+	// _BitScanReverse64 is x64/ARM64 only; scan the high word, then the low
+	unsigned long metrics_msb_index;
+
+	if (_BitScanReverse(&metrics_msb_index, (unsigned long)(metrics_msb_v >> 32)))
+	{
+		return 32 + (int)metrics_msb_index;
+	}
+	_BitScanReverse(&metrics_msb_index, (unsigned long)metrics_msb_v);
+	return (int)metrics_msb_index;
+#else
+	return 63 - __builtin_clzll(metrics_msb_v);
+#endif
+}
+
+// b = msb - 5 halvings leave v >> b in [32, 64): bucket b*32 + (v >> b),
+// which continues the exact buckets at 64
+static int metrics_bucket(uint64_t metrics_bucket_v)
+{
+	int metrics_bucket_shift;
+
+	if (metrics_bucket_v < ((uint64_t)1 << kMetricsExactBits))
+	{
+		return (int)metrics_bucket_v;
+	}
+
+	if (metrics_bucket_v >= ((uint64_t)1 << kMetricsMaxBits))
+	{
+		metrics_bucket_v = ((uint64_t)1 << kMetricsMaxBits) - 1;
+	}
+
+	metrics_bucket_shift = metrics_msb(metrics_bucket_v) - (kMetricsExactBits - 1);
+
+	return metrics_bucket_shift * kMetricsHalf + (int)(metrics_bucket_v >> metrics_bucket_shift);
+}
+
+// the largest value counted in the bucket
+static uint64_t metrics_bucket_high(int metrics_bucket_high_index)
+{
+	int metrics_bucket_high_shift;
+
+	if (metrics_bucket_high_index < (1 << kMetricsExactBits))
+	{
+		return (uint64_t)metrics_bucket_high_index;
+	}
+
+	metrics_bucket_high_shift = metrics_bucket_high_index / kMetricsHalf - 1;
+
+	return (((uint64_t)(metrics_bucket_high_index - metrics_bucket_high_shift * kMetricsHalf) + 1)
+		<< metrics_bucket_high_shift) - 1;
+}
+
+static int metrics_add(std::atomic<uint64_t>& metrics_add_counter, uint64_t metrics_add_n)
+{
+	metrics_add_counter.store(
+		metrics_add_counter.load(std::memory_order_relaxed) + metrics_add_n,
+		std::memory_order_relaxed);
+
+	return 1;
+}
+
+const char* metrics_op_name(int metrics_op_name_op)
+{
+	static const char* const kMetricsOpNames[kMetricsOpCount] = {
+		"rsa_keygen",
+		"rsa_keygen_multi",
+		"rsa_pubkey_encryrpt",
+		"rsa_privkey_encryrpt",
+		"rsa_privkey_decryrpt",
+		"rsa_pubkey_decryrpt",
+		"rsa_multi_pubkey_encryrpt",
+		"rsa_multi_privkey_decryrpt",
+		"rsa_verify_batch",
+		"rsa_verify_batch_parallel",
+		"rsa_keygen_pipeline",
+		"rsa_columns_from_keys",
+		"rsa_columns_pubkey_encryrpt",
+		"rsa_columns_privkey_decryrpt",
+		"rsa64_keygen",
+		"rsa64_pubkey_encryrpt",
+		"rsa64_privkey_encryrpt",
+		"rsa64_privkey_decryrpt",
+		"rsa64_pubkey_decryrpt",
+		"rsa_bn_keygen",
+		"rsa_bn_pubkey_encryrpt",
+		"rsa_bn_privkey_encryrpt",
+		"rsa_bn_privkey_decryrpt",
+		"rsa_bn_pubkey_decryrpt",
+		"dh_check_paremeters",
+		"dh_generate_paremeters",
+		"dh_generate_paremeters_cached",
+		"dh_generate_key",
+		"dh_compute_key",
+		"dh64_generate_paremeters",
+		"dh64_generate_key",
+		"dh64_compute_key",
+		"elgamal_pubkey_encryrpt",
+		"elgamal_privkey_decryrpt",
+		"elgamal_pool_encryrpt",
+		"elgamal64_pubkey_encryrpt",
+		"elgamal64_privkey_decryrpt"
+	};
+
+	return kMetricsOpNames[metrics_op_name_op];
+}
+
+int metrics_record(int metrics_record_op, int64_t metrics_record_ns)
+{
+	struct MetricsShard* metrics_record_shard = kMetricsShard.shard;
+	uint64_t metrics_record_v = metrics_record_ns < 0 ? 0 : (uint64_t)metrics_record_ns;
+
+	if (metrics_record_shard == nullptr)
+	{
+		std::lock_guard<std::mutex> metrics_record_guard(kMetricsLock);
+
+		if (kMetricsFreeShards.empty())
+		{
+			metrics_record_shard = new struct MetricsShard();
+			kMetricsShards.push_back(metrics_record_shard);
+		}
+		else
+		{
+			metrics_record_shard = kMetricsFreeShards.back();
+			kMetricsFreeShards.pop_back();
+		}
+
+		kMetricsShard.shard = metrics_record_shard;
+	}
+
+	metrics_add(metrics_record_shard->counts[metrics_record_op][metrics_bucket(metrics_record_v)], 1);
+	metrics_add(metrics_record_shard->sums[metrics_record_op], metrics_record_v);
+	if (metrics_record_v > metrics_record_shard->maxima[metrics_record_op].load(std::memory_order_relaxed))
+	{
+		metrics_record_shard->maxima[metrics_record_op].store(metrics_record_v, std::memory_order_relaxed);
+	}
+
+	return 1;
+}
+
+// smallest bucket high value with at least the given share of the calls
+static uint64_t metrics_percentile(
+	std::vector<uint64_t>& metrics_percentile_counts,
+	uint64_t metrics_percentile_total,
+	double metrics_percentile_share)
+{
+	uint64_t metrics_percentile_rank = (uint64_t)(metrics_percentile_share * metrics_percentile_total);
+	uint64_t metrics_percentile_seen = 0;
+
+	if (metrics_percentile_rank < metrics_percentile_share * metrics_percentile_total)
+	{
+		metrics_percentile_rank++;
+	}
+
+	for (int metrics_percentile_i = 0; metrics_percentile_i < kMetricsBuckets; metrics_percentile_i++)
+	{
+		metrics_percentile_seen += metrics_percentile_counts[metrics_percentile_i];
+		if (metrics_percentile_seen >= metrics_percentile_rank && metrics_percentile_seen > 0)
+		{
+			return metrics_bucket_high(metrics_percentile_i);
+		}
+	}
+
+	return 0;
+}
+
+int metrics_summary(struct MetricsSummary metrics_summary_out[1], int metrics_summary_op)
+{
+	std::vector<uint64_t> metrics_summary_counts(kMetricsBuckets, 0);
+	uint64_t metrics_summary_sum = 0;
+	uint64_t metrics_summary_max = 0;
+	uint64_t metrics_summary_total = 0;
+
+	{
+		std::lock_guard<std::mutex> metrics_summary_guard(kMetricsLock);
+
+		for (struct MetricsShard* metrics_summary_shard : kMetricsShards)
+		{
+			for (int metrics_summary_i = 0; metrics_summary_i < kMetricsBuckets; metrics_summary_i++)
+			{
+				metrics_summary_counts[metrics_summary_i] +=
+					metrics_summary_shard->counts[metrics_summary_op][metrics_summary_i].load(std::memory_order_relaxed);
+			}
+
+			metrics_summary_sum += metrics_summary_shard->sums[metrics_summary_op].load(std::memory_order_relaxed);
+			metrics_summary_max = std::max(
+				metrics_summary_max,
+				metrics_summary_shard->maxima[metrics_summary_op].load(std::memory_order_relaxed));
+		}
+	}
+
+	for (int metrics_summary_i = 0; metrics_summary_i < kMetricsBuckets; metrics_summary_i++)
+	{
+		metrics_summary_total += metrics_summary_counts[metrics_summary_i];
+	}
+
+	metrics_summary_out[0].count = metrics_summary_total;
+	metrics_summary_out[0].sum = metrics_summary_sum;
+	metrics_summary_out[0].mean = metrics_summary_total == 0 ? 0 : (double)metrics_summary_sum / metrics_summary_total;
+	metrics_summary_out[0].p50 = metrics_percentile(metrics_summary_counts, metrics_summary_total, 0.5);
+	metrics_summary_out[0].p99 = metrics_percentile(metrics_summary_counts, metrics_summary_total, 0.99);
+	metrics_summary_out[0].p999 = metrics_percentile(metrics_summary_counts, metrics_summary_total, 0.999);
+	metrics_summary_out[0].max = metrics_summary_max;
+
+	// a percentile is a bucket's upper end, which can pass the largest call
+	metrics_summary_out[0].p50 = std::min(metrics_summary_out[0].p50, metrics_summary_max);
+	metrics_summary_out[0].p99 = std::min(metrics_summary_out[0].p99, metrics_summary_max);
+	metrics_summary_out[0].p999 = std::min(metrics_summary_out[0].p999, metrics_summary_max);
+
+	return 1;
+}
+
+int metrics_reset()
+{
+	std::lock_guard<std::mutex> metrics_reset_guard(kMetricsLock);
+
+	for (struct MetricsShard* metrics_reset_shard : kMetricsShards)
+	{
+		for (int metrics_reset_op = 0; metrics_reset_op < kMetricsOpCount; metrics_reset_op++)
+		{
+			for (int metrics_reset_i = 0; metrics_reset_i < kMetricsBuckets; metrics_reset_i++)
+			{
+				metrics_reset_shard->counts[metrics_reset_op][metrics_reset_i].store(0, std::memory_order_relaxed);
+			}
+
+			metrics_reset_shard->sums[metrics_reset_op].store(0, std::memory_order_relaxed);
+			metrics_reset_shard->maxima[metrics_reset_op].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	return 1;
+}
+
+int metrics_write_prometheus(FILE* metrics_write_file)
+{
+	struct MetricsSummary metrics_write_summary[1];
+
+	fprintf(metrics_write_file,
+		"# HELP cmm_lab_op_latency_seconds Latency of cmm_lab RSA, DH and ElGamal calls.\n"
+		"# TYPE cmm_lab_op_latency_seconds summary\n");
+
+	for (int metrics_write_op = 0; metrics_write_op < kMetricsOpCount; metrics_write_op++)
+	{
+		const char* metrics_write_name = metrics_op_name(metrics_write_op);
+
+		metrics_summary(metrics_write_summary, metrics_write_op);
+		if (metrics_write_summary[0].count == 0)
+		{
+			continue;
+		}
+
+		fprintf(metrics_write_file,
+			"cmm_lab_op_latency_seconds{op=\"%s\",quantile=\"0.5\"} %.9f\n"
+			"cmm_lab_op_latency_seconds{op=\"%s\",quantile=\"0.99\"} %.9f\n"
+			"cmm_lab_op_latency_seconds{op=\"%s\",quantile=\"0.999\"} %.9f\n"
+			"cmm_lab_op_latency_seconds_sum{op=\"%s\"} %.9f\n"
+			"cmm_lab_op_latency_seconds_count{op=\"%s\"} %llu\n",
+			metrics_write_name, metrics_write_summary[0].p50 / 1e9,
+			metrics_write_name, metrics_write_summary[0].p99 / 1e9,
+			metrics_write_name, metrics_write_summary[0].p999 / 1e9,
+			metrics_write_name, metrics_write_summary[0].sum / 1e9,
+			metrics_write_name, (unsigned long long)metrics_write_summary[0].count);
+	}
+
+	return 1;
+}
+
+int metrics_dump(const char* metrics_dump_path)
+{
+	std::string metrics_dump_temp;
+	FILE* metrics_dump_file;
+
+	if (std::string(metrics_dump_path) == "-")
+	{
+		metrics_write_prometheus(stdout);
+		fflush(stdout);
+		return 1;
+	}
+
+	// a scraper reading the file sees the old or the new dump, never half
+	metrics_dump_temp = std::string(metrics_dump_path) + ".tmp";
+	metrics_dump_file = fopen(metrics_dump_temp.c_str(), "w");
+	if (metrics_dump_file == nullptr)
+	{
+		return 0;
+	}
+
+	metrics_write_prometheus(metrics_dump_file);
+	if (fclose(metrics_dump_file) != 0)
+	{
+		remove(metrics_dump_temp.c_str());
+		return 0;
+	}
+
+#ifdef _WIN32
+	// rename does not replace an existing file on Windows
+	remove(metrics_dump_path);
+#endif
+
+	return rename(metrics_dump_temp.c_str(), metrics_dump_path) == 0;
+}
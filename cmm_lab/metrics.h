@@ -0,0 +1,120 @@
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Latency histograms for the public entry points, always on: the rsa_*,
+// dh_* and elgamal_* calls of rsa.h and dh.h, their uint64 (rsa64.h,
+// dh64.h) and bignum (rsa_bn.h) variants, the column calls of rsa_soa.h,
+// rsa_verify_batch_parallel, rsa_keygen_pipeline,
+// dh_generate_paremeters_cached and elgamal_pool_encryrpt. The helpers
+// behind them (exp_mod_chain, the pool's refill thread, ...) are not timed
+// on their own.
+// Buckets are HDR-style: exact below 64 ns, then 32 per power of two, so a
+// reported percentile is within about 3% of the true latency, up to
+// 2^40 ns (about 18 minutes; longer calls count as that).
+//
+// Each thread records into its own shard with plain relaxed stores, so a
+// call costs two clock reads and a few increments. Readers merge all
+// shards. A thread's shard is reused by a later thread once it exits, and
+// its counts are kept, so memory grows with the number of threads alive
+// at once rather than the number ever started.
+
+enum MetricsOp
+{
+	kMetricsRsaKeygen,
+	kMetricsRsaKeygenMulti,
+	kMetricsRsaPubkeyEncrypt,
+	kMetricsRsaPrivkeyEncrypt,
+	kMetricsRsaPrivkeyDecrypt,
+	kMetricsRsaPubkeyDecrypt,
+	kMetricsRsaMultiPubkeyEncrypt,
+	kMetricsRsaMultiPrivkeyDecrypt,
+	kMetricsRsaVerifyBatch,
+	kMetricsRsaVerifyBatchParallel,
+	kMetricsRsaKeygenPipeline,
+	kMetricsRsaColumnsFromKeys,
+	kMetricsRsaColumnsPubkeyEncrypt,
+	kMetricsRsaColumnsPrivkeyDecrypt,
+	kMetricsRsa64Keygen,
+	kMetricsRsa64PubkeyEncrypt,
+	kMetricsRsa64PrivkeyEncrypt,
+	kMetricsRsa64PrivkeyDecrypt,
+	kMetricsRsa64PubkeyDecrypt,
+	kMetricsRsaBnKeygen,
+	kMetricsRsaBnPubkeyEncrypt,
+	kMetricsRsaBnPrivkeyEncrypt,
+	kMetricsRsaBnPrivkeyDecrypt,
+	kMetricsRsaBnPubkeyDecrypt,
+	kMetricsDhCheckParams,
+	kMetricsDhGenerateParams,
+	kMetricsDhGenerateParamsCached,
+	kMetricsDhGenerateKey,
+	kMetricsDhComputeKey,
+	kMetricsDh64GenerateParams,
+	kMetricsDh64GenerateKey,
+	kMetricsDh64ComputeKey,
+	kMetricsElGamalEncrypt,
+	kMetricsElGamalDecrypt,
+	kMetricsElGamalPoolEncrypt,
+	kMetricsElGamal64Encrypt,
+	kMetricsElGamal64Decrypt,
+	kMetricsOpCount
+};
+
+// latencies in ns
+struct MetricsSummary
+{
+	uint64_t count;
+	uint64_t sum;
+	double mean;
+	uint64_t p50;
+	uint64_t p99;
+	uint64_t p999;
+	uint64_t max;
+};
+
+// the entry point's function name
+const char* metrics_op_name(int metrics_op_name_op);
+
+int metrics_record(int metrics_record_op, int64_t metrics_record_ns);
+
+int metrics_summary(struct MetricsSummary metrics_summary_out[1], int metrics_summary_op);
+
+// forget all recorded latencies; calls in flight may still land
+int metrics_reset();
+
+// Prometheus text format: one summary, cmm_lab_op_latency_seconds, with
+// quantiles 0.5, 0.99 and 0.999 per op that has been called
+int metrics_write_prometheus(FILE* metrics_write_file);
+
+// to path, replacing the file; "-" for stdout. Return 0 if it cannot be
+// written
+int metrics_dump(const char* metrics_dump_path);
+
+// records the time until the end of the enclosing block
+struct MetricsTimer
+{
+	int op;
+	std::chrono::steady_clock::time_point begin;
+
+	explicit MetricsTimer(int metrics_timer_op)
+		: op(metrics_timer_op), begin(std::chrono::steady_clock::now())
+	{
+	}
+
+	~MetricsTimer()
+	{
+		metrics_record(op, std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - begin).count());
+	}
+
+	MetricsTimer(const MetricsTimer&) = delete;
+	MetricsTimer& operator=(const MetricsTimer&) = delete;
+};
+
+#define METRICS_TIME(metrics_op) MetricsTimer metrics_timer(metrics_op)
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef MODINT_H_
+#define MODINT_H_
+
+#include <cstdint>
+
+// Arithmetic modulo a prime (or any odd modulus) fixed at compile time,
+// for deployments that always use the same DH prime. Values are kept in
+// Montgomery form x*2^32 mod P; every constant the reduction needs is a
+// constexpr of P, so the compiler folds P into each multiplication
+// instead of dividing by a runtime modulus as mul_mod/exp_mod do.
+// All of it is constexpr and can be checked with static_assert.
+
+// p^-1 mod 2^32 for odd p: Newton's iteration doubles the correct low
+// bits each step, starting from 3 (p*p == 1 mod 8).
+constexpr uint32_t modint_inverse_2_32(uint32_t modint_inv_p)
+{
+	uint32_t modint_inv_x = modint_inv_p;
+
+	// C++14 constexpr functions need every local initialized
+	for (int modint_inv_i = 0; modint_inv_i < 4; modint_inv_i++)
+	{
+		modint_inv_x = modint_inv_x * (2 - modint_inv_p * modint_inv_x);
+	}
+
+	return modint_inv_x;
+}
+
+// 2^64 mod p
+constexpr uint32_t modint_r2(uint32_t modint_r2_p)
+{
+	return (uint32_t)((((uint64_t)1 << 32) % modint_r2_p) * (((uint64_t)1 << 32) % modint_r2_p) % modint_r2_p);
+}
+
+template <uint32_t P>
+struct ModInt
+{
+	static_assert(P % 2 == 1 && P > 1, "Montgomery form needs an odd modulus above 1");
+
+	static constexpr uint32_t kPInv = modint_inverse_2_32(P);
+	static constexpr uint32_t kR2 = modint_r2(P);
+
+	// x * 2^32 mod P
+	uint32_t mont;
+};
+
+template <uint32_t P>
+constexpr uint32_t ModInt<P>::kPInv;
+
+template <uint32_t P>
+constexpr uint32_t ModInt<P>::kR2;
+
+// t * 2^-32 mod P for t < P * 2^32. With m = t * P^-1 mod 2^32, t and m*P
+// agree in their low 32 bits, so (t - m*P) / 2^32 is the difference of the
+// high halves and lies in (-P, P).
+template <uint32_t P>
+constexpr uint32_t modint_redc(uint64_t modint_redc_t)
+{
+	uint32_t modint_redc_m = (uint32_t)modint_redc_t * ModInt<P>::kPInv;
+	uint32_t modint_redc_thi = (uint32_t)(modint_redc_t >> 32);
+	uint32_t modint_redc_mhi = (uint32_t)(((uint64_t)modint_redc_m * P) >> 32);
+
+	return modint_redc_thi >= modint_redc_mhi
+		? modint_redc_thi - modint_redc_mhi
+		: modint_redc_thi - modint_redc_mhi + P;
+}
+
+// any uint32 x; x * 2^64 < P * 2^32 * 2^32 keeps redc's input in range
+template <uint32_t P>
+constexpr ModInt<P> modint_from(uint32_t modint_from_x)
+{
+	return ModInt<P>{ modint_redc<P>((uint64_t)modint_from_x * ModInt<P>::kR2) };
+}
+
+template <uint32_t P>
+constexpr uint32_t modint_value(ModInt<P> modint_value_a)
+{
+	return modint_redc<P>(modint_value_a.mont);
+}
+
+template <uint32_t P>
+constexpr ModInt<P> modint_mul(ModInt<P> modint_mul_a, ModInt<P> modint_mul_b)
+{
+	return ModInt<P>{ modint_redc<P>((uint64_t)modint_mul_a.mont * modint_mul_b.mont) };
+}
+
+template <uint32_t P>
+constexpr ModInt<P> modint_add(ModInt<P> modint_add_a, ModInt<P> modint_add_b)
+{
+	return ModInt<P>{ (uint32_t)(((uint64_t)modint_add_a.mont + modint_add_b.mont) % P) };
+}
+
+template <uint32_t P>
+constexpr ModInt<P> modint_sub(ModInt<P> modint_sub_a, ModInt<P> modint_sub_b)
+{
+	return ModInt<P>{ modint_sub_a.mont >= modint_sub_b.mont
+		? modint_sub_a.mont - modint_sub_b.mont
+		: modint_sub_a.mont - modint_sub_b.mont + P };
+}
+
+template <uint32_t P>
+constexpr ModInt<P> modint_pow(ModInt<P> modint_pow_a, uint32_t modint_pow_e)
+{
+	ModInt<P> modint_pow_r = modint_from<P>(1);
+
+	while (modint_pow_e)
+	{
+		if (modint_pow_e & 1)
+		{
+			modint_pow_r = modint_mul<P>(modint_pow_r, modint_pow_a);
+		}
+
+		modint_pow_e >>= 1;
+		modint_pow_a = modint_mul<P>(modint_pow_a, modint_pow_a);
+	}
+
+	return modint_pow_r;
+}
+
+// exp_mod(a, b, P) with P fixed: the same uint32 result, including the
+// exponent being |b| and b=0 giving 1.
+template <uint32_t P>
+constexpr int exp_mod(int exp_mod_fixed_a, int exp_mod_fixed_b)
+{
+	return exp_mod_fixed_b == 0
+		? 1
+		: (int)modint_value<P>(modint_pow<P>(
+			modint_from<P>((uint32_t)exp_mod_fixed_a),
+			exp_mod_fixed_b < 0 ? 0u - (uint32_t)exp_mod_fixed_b : (uint32_t)exp_mod_fixed_b));
+}
+
+#endif
@@ -0,0 +1,347 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+static const uint32_t kPerfEventTypes[kPerfEventCount] = {
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HW_CACHE,
+	PERF_TYPE_HARDWARE
+};
+
+static const uint64_t kPerfEventConfigs[kPerfEventCount] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+	PERF_COUNT_HW_BRANCH_MISSES,
+	PERF_COUNT_HW_CACHE_L1D |
+		(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+	PERF_COUNT_HW_CACHE_MISSES
+};
+
+static volatile int kPerfCountersSink;
+
+// the group leader: the first of the group's events that opened
+static int perf_counters_leader(struct PerfCounters perf_counters_leader_pc[1], int perf_counters_leader_group)
+{
+	for (int perf_counters_leader_i = 0; perf_counters_leader_i < kPerfEventCount; perf_counters_leader_i++)
+	{
+		if (perf_counters_leader_pc[0].fds[perf_counters_leader_i] >= 0 &&
+			perf_counters_group(perf_counters_leader_pc, perf_counters_leader_i) == perf_counters_leader_group)
+		{
+			return perf_counters_leader_pc[0].fds[perf_counters_leader_i];
+		}
+	}
+
+	return -1;
+}
+
+// open every event into its group for group_count groups
+static int perf_counters_open_groups(struct PerfCounters perf_counters_og_out[1], int perf_counters_og_group_count)
+{
+	int perf_counters_og_count = 0;
+	int perf_counters_og_leaders[kPerfGroupCount] = { -1, -1, -1 };
+
+	perf_counters_og_out[0].group_count = perf_counters_og_group_count;
+
+	for (int perf_counters_og_g = 0; perf_counters_og_g < kPerfGroupCount; perf_counters_og_g++)
+	{
+		perf_counters_og_out[0].time_enabled[perf_counters_og_g] = 0;
+		perf_counters_og_out[0].time_running[perf_counters_og_g] = 0;
+	}
+
+	for (int perf_counters_og_i = 0; perf_counters_og_i < kPerfEventCount; perf_counters_og_i++)
+	{
+		struct perf_event_attr perf_counters_og_attr;
+		int perf_counters_og_g = perf_counters_group(perf_counters_og_out, perf_counters_og_i);
+		int perf_counters_og_leader = perf_counters_og_leaders[perf_counters_og_g];
+
+		memset(&perf_counters_og_attr, 0, sizeof(perf_counters_og_attr));
+		perf_counters_og_attr.size = sizeof(perf_counters_og_attr);
+		perf_counters_og_attr.type = kPerfEventTypes[perf_counters_og_i];
+		perf_counters_og_attr.config = kPerfEventConfigs[perf_counters_og_i];
+		perf_counters_og_attr.read_format = PERF_FORMAT_GROUP |
+			PERF_FORMAT_TOTAL_TIME_ENABLED |
+			PERF_FORMAT_TOTAL_TIME_RUNNING;
+		// members follow the leader, which starts and stops the whole group
+		perf_counters_og_attr.disabled = perf_counters_og_leader < 0;
+		perf_counters_og_attr.exclude_kernel = 1;
+		perf_counters_og_attr.exclude_hv = 1;
+
+		perf_counters_og_out[0].fds[perf_counters_og_i] = (int)syscall(
+			SYS_perf_event_open, &perf_counters_og_attr, 0, -1, perf_counters_og_leader, 0);
+		perf_counters_og_out[0].values[perf_counters_og_i] = 0;
+
+		if (perf_counters_og_out[0].fds[perf_counters_og_i] >= 0)
+		{
+			perf_counters_og_count++;
+			if (perf_counters_og_leader < 0)
+			{
+				perf_counters_og_leaders[perf_counters_og_g] = perf_counters_og_out[0].fds[perf_counters_og_i];
+			}
+		}
+		else
+		{
+			perf_counters_og_out[0].fds[perf_counters_og_i] = -1;
+		}
+	}
+
+	return perf_counters_og_count;
+}
+
+int perf_counters_open(struct PerfCounters perf_counters_open_out[1])
+{
+	int perf_counters_open_count = perf_counters_open_groups(perf_counters_open_out, 1);
+
+	if (perf_counters_open_count == 0)
+	{
+		return 0;
+	}
+
+	// a trial run: a group the PMU cannot hold is never scheduled
+	perf_counters_start(perf_counters_open_out);
+	for (int perf_counters_open_i = 0; perf_counters_open_i < 100000; perf_counters_open_i++)
+	{
+		kPerfCountersSink = perf_counters_open_i;
+	}
+	perf_counters_stop(perf_counters_open_out);
+
+	// pairs if the group never ran, or if they get events it refused
+	if (perf_counters_open_out[0].time_running[0] == 0 || perf_counters_open_count < kPerfEventCount)
+	{
+		int perf_counters_open_usable = perf_counters_open_out[0].time_running[0] == 0 ? 0 : perf_counters_open_count;
+
+		perf_counters_close(perf_counters_open_out);
+		perf_counters_open_count = perf_counters_open_groups(perf_counters_open_out, kPerfGroupCount);
+
+		if (perf_counters_open_count <= perf_counters_open_usable)
+		{
+			perf_counters_close(perf_counters_open_out);
+			perf_counters_open_count = perf_counters_open_groups(perf_counters_open_out, 1);
+		}
+	}
+
+	return perf_counters_open_count;
+}
+
+int perf_counters_close(struct PerfCounters perf_counters_close_pc[1])
+{
+	int perf_counters_close_leaders[kPerfGroupCount];
+
+	for (int perf_counters_close_g = 0; perf_counters_close_g < kPerfGroupCount; perf_counters_close_g++)
+	{
+		perf_counters_close_leaders[perf_counters_close_g] = perf_counters_leader(perf_counters_close_pc, perf_counters_close_g);
+	}
+
+	// the members first, then the leaders
+	for (int perf_counters_close_i = 0; perf_counters_close_i < kPerfEventCount; perf_counters_close_i++)
+	{
+		int perf_counters_close_g = perf_counters_group(perf_counters_close_pc, perf_counters_close_i);
+
+		if (perf_counters_close_pc[0].fds[perf_counters_close_i] >= 0 &&
+			perf_counters_close_pc[0].fds[perf_counters_close_i] != perf_counters_close_leaders[perf_counters_close_g])
+		{
+			close(perf_counters_close_pc[0].fds[perf_counters_close_i]);
+		}
+
+		perf_counters_close_pc[0].fds[perf_counters_close_i] = -1;
+	}
+
+	for (int perf_counters_close_g = 0; perf_counters_close_g < kPerfGroupCount; perf_counters_close_g++)
+	{
+		if (perf_counters_close_leaders[perf_counters_close_g] >= 0)
+		{
+			close(perf_counters_close_leaders[perf_counters_close_g]);
+		}
+	}
+
+	return 1;
+}
+
+int perf_counters_start(struct PerfCounters perf_counters_start_pc[1])
+{
+	for (int perf_counters_start_g = 0; perf_counters_start_g < perf_counters_start_pc[0].group_count; perf_counters_start_g++)
+	{
+		int perf_counters_start_leader = perf_counters_leader(perf_counters_start_pc, perf_counters_start_g);
+
+		if (perf_counters_start_leader >= 0)
+		{
+			ioctl(perf_counters_start_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+			ioctl(perf_counters_start_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		}
+	}
+
+	return 1;
+}
+
+int perf_counters_stop(struct PerfCounters perf_counters_stop_pc[1])
+{
+	int perf_counters_stop_leaders[kPerfGroupCount];
+	int perf_counters_stop_ok = 1;
+
+	// disable every group before reading any, so they cover the same window
+	for (int perf_counters_stop_g = 0; perf_counters_stop_g < kPerfGroupCount; perf_counters_stop_g++)
+	{
+		perf_counters_stop_leaders[perf_counters_stop_g] = perf_counters_stop_g < perf_counters_stop_pc[0].group_count
+			? perf_counters_leader(perf_counters_stop_pc, perf_counters_stop_g)
+			: -1;
+		perf_counters_stop_pc[0].time_enabled[perf_counters_stop_g] = 0;
+		perf_counters_stop_pc[0].time_running[perf_counters_stop_g] = 0;
+
+		if (perf_counters_stop_leaders[perf_counters_stop_g] >= 0)
+		{
+			ioctl(perf_counters_stop_leaders[perf_counters_stop_g], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		}
+	}
+
+	for (int perf_counters_stop_i = 0; perf_counters_stop_i < kPerfEventCount; perf_counters_stop_i++)
+	{
+		perf_counters_stop_pc[0].values[perf_counters_stop_i] = 0;
+	}
+
+	for (int perf_counters_stop_g = 0; perf_counters_stop_g < kPerfGroupCount; perf_counters_stop_g++)
+	{
+		// nr, time_enabled, time_running, then one value per member in the
+		// order they joined, which is event order
+		uint64_t perf_counters_stop_buf[3 + kPerfEventCount];
+		uint64_t perf_counters_stop_enabled, perf_counters_stop_running;
+		int perf_counters_stop_member = 0;
+
+		if (perf_counters_stop_leaders[perf_counters_stop_g] < 0)
+		{
+			continue;
+		}
+
+		if (read(perf_counters_stop_leaders[perf_counters_stop_g], perf_counters_stop_buf, sizeof(perf_counters_stop_buf)) <
+			(ssize_t)(3 * sizeof(uint64_t)))
+		{
+			perf_counters_stop_ok = 0;
+			continue;
+		}
+
+		perf_counters_stop_enabled = perf_counters_stop_buf[1];
+		perf_counters_stop_running = perf_counters_stop_buf[2];
+		perf_counters_stop_pc[0].time_enabled[perf_counters_stop_g] = perf_counters_stop_enabled;
+		perf_counters_stop_pc[0].time_running[perf_counters_stop_g] = perf_counters_stop_running;
+
+		if (perf_counters_stop_running == 0)
+		{
+			perf_counters_stop_ok = 0;
+			continue;
+		}
+
+		for (int perf_counters_stop_i = 0; perf_counters_stop_i < kPerfEventCount; perf_counters_stop_i++)
+		{
+			if (perf_counters_stop_pc[0].fds[perf_counters_stop_i] >= 0 &&
+				perf_counters_group(perf_counters_stop_pc, perf_counters_stop_i) == perf_counters_stop_g &&
+				(uint64_t)perf_counters_stop_member < perf_counters_stop_buf[0])
+			{
+				// scaled from the time the group ran to the time it was enabled
+				perf_counters_stop_pc[0].values[perf_counters_stop_i] = (uint64_t)(
+					(double)perf_counters_stop_buf[3 + perf_counters_stop_member] *
+					perf_counters_stop_enabled / perf_counters_stop_running);
+				perf_counters_stop_member++;
+			}
+		}
+	}
+
+	return perf_counters_stop_ok;
+}
+
+#else
+
+int perf_counters_open(struct PerfCounters perf_counters_open_out[1])
+{
+	for (int perf_counters_open_i = 0; perf_counters_open_i < kPerfEventCount; perf_counters_open_i++)
+	{
+		perf_counters_open_out[0].fds[perf_counters_open_i] = -1;
+		perf_counters_open_out[0].values[perf_counters_open_i] = 0;
+	}
+
+	perf_counters_open_out[0].group_count = 1;
+	for (int perf_counters_open_g = 0; perf_counters_open_g < kPerfGroupCount; perf_counters_open_g++)
+	{
+		perf_counters_open_out[0].time_enabled[perf_counters_open_g] = 0;
+		perf_counters_open_out[0].time_running[perf_counters_open_g] = 0;
+	}
+
+	return 0;
+}
+
+int perf_counters_close(struct PerfCounters perf_counters_close_pc[1])
+{
+	return 1;
+}
+
+int perf_counters_start(struct PerfCounters perf_counters_start_pc[1])
+{
+	return 1;
+}
+
+int perf_counters_stop(struct PerfCounters perf_counters_stop_pc[1])
+{
+	return 1;
+}
+
+#endif
+
+int perf_counters_available(struct PerfCounters perf_counters_available_pc[1], int perf_counters_available_event)
+{
+	return perf_counters_available_pc[0].fds[perf_counters_available_event] >= 0 &&
+		perf_counters_available_pc[0].time_running[
+			perf_counters_group(perf_counters_available_pc, perf_counters_available_event)] > 0;
+}
+
+// the pairs follow event order: {cycles, instructions}, {branches,
+// branch-misses}, {l1d-misses, llc-misses}
+int perf_counters_group(struct PerfCounters perf_counters_group_pc[1], int perf_counters_group_event)
+{
+	return perf_counters_group_pc[0].group_count == 1 ? 0 : perf_counters_group_event / 2;
+}
+
+double perf_counters_running_ratio(struct PerfCounters perf_counters_ratio_pc[1], int perf_counters_ratio_group)
+{
+	int perf_counters_ratio_open = 0;
+
+	for (int perf_counters_ratio_i = 0; perf_counters_ratio_i < kPerfEventCount; perf_counters_ratio_i++)
+	{
+		if (perf_counters_ratio_pc[0].fds[perf_counters_ratio_i] >= 0 &&
+			perf_counters_group(perf_counters_ratio_pc, perf_counters_ratio_i) == perf_counters_ratio_group)
+		{
+			perf_counters_ratio_open = 1;
+		}
+	}
+
+	if (!perf_counters_ratio_open || perf_counters_ratio_pc[0].time_enabled[perf_counters_ratio_group] == 0)
+	{
+		return -1;
+	}
+
+	return (double)perf_counters_ratio_pc[0].time_running[perf_counters_ratio_group] /
+		perf_counters_ratio_pc[0].time_enabled[perf_counters_ratio_group];
+}
+
+const char* perf_event_name(int perf_event_name_event)
+{
+	static const char* const kPerfEventNames[kPerfEventCount] = {
+		"cycles",
+		"instructions",
+		"branches",
+		"branch-misses",
+		"l1d-misses",
+		"llc-misses"
+	};
+
+	return kPerfEventNames[perf_event_name_event];
+}
@@ -0,0 +1,72 @@
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <cstdint>
+
+// Hardware event counts for the calling thread, user mode only, through
+// perf_event_open on Linux. The events are opened as one group, so the
+// kernel schedules them onto the PMU together and every count covers the
+// same slice of time; ratios such as IPC then compare like with like. An
+// event the CPU or kernel cannot count (no PMU in a VM,
+// perf_event_paranoid, other platforms) is left out of the group and
+// marked unavailable, and the rest still work.
+//
+// A PMU with fewer free counters than the group needs refuses some of its
+// events, or accepts them and never schedules the group at all. open()
+// checks for both with a short trial run and then falls back to three pair
+// groups, {cycles, instructions}, {branches, branch-misses} and
+// {l1d-misses, llc-misses}, which the kernel multiplexes: each pair still
+// shares its slice of time, so IPC and the miss rate stay consistent, but
+// the pairs cover different slices. Counts are scaled up from the time
+// their group ran to the whole window; perf_counters_running_ratio
+// reports that share per group. An event whose group never ran reads as
+// unavailable.
+
+enum PerfEvent
+{
+	kPerfCycles,
+	kPerfInstructions,
+	kPerfBranches,
+	kPerfBranchMisses,
+	kPerfL1dMisses,
+	kPerfLlcMisses,
+	kPerfEventCount
+};
+
+static const int kPerfGroupCount = 3; // groups after the fallback to pairs
+
+struct PerfCounters
+{
+	int fds[kPerfEventCount]; // -1 if unavailable
+	uint64_t values[kPerfEventCount]; // counts between start and stop
+	int group_count; // 1 if all events form one group, kPerfGroupCount if split into pairs
+	uint64_t time_enabled[kPerfGroupCount]; // ns each group was enabled between start and stop
+	uint64_t time_running[kPerfGroupCount]; // ns of that it was counting; 0 if never scheduled
+};
+
+// Return the number of events that could be opened
+int perf_counters_open(struct PerfCounters perf_counters_open_out[1]);
+
+int perf_counters_close(struct PerfCounters perf_counters_close_pc[1]);
+
+// reset and enable every open event
+int perf_counters_start(struct PerfCounters perf_counters_start_pc[1]);
+
+// disable and read into values; unavailable events read as 0. Return 0
+// if events were open but some group was never scheduled.
+int perf_counters_stop(struct PerfCounters perf_counters_stop_pc[1]);
+
+// 1 if the event was opened and counted during the last start/stop
+int perf_counters_available(struct PerfCounters perf_counters_available_pc[1], int perf_counters_available_event);
+
+// the group (below group_count) the event belongs to
+int perf_counters_group(struct PerfCounters perf_counters_group_pc[1], int perf_counters_group_event);
+
+// time_running / time_enabled of the group over the last start/stop: 1
+// when it counted throughout, less when it was multiplexed. -1 if none of
+// its events opened or it was never enabled.
+double perf_counters_running_ratio(struct PerfCounters perf_counters_ratio_pc[1], int perf_counters_ratio_group);
+
+const char* perf_event_name(int perf_event_name_event);
+
+#endif
@@ -0,0 +1,189 @@
+#include <cstdio>
+
+#include "profile.h"
+
+#ifdef CMM_LAB_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ProfileSite
+{
+	const char* name;
+	int kind;
+};
+
+struct ProfileApi
+{
+	std::string name;
+	uint64_t calls;
+	uint64_t counts[kProfileMaxSites];
+};
+
+thread_local uint64_t kProfileCounts[kProfileMaxSites];
+
+static thread_local int kProfileDepth;
+
+// sites are appended under the lock and never change once counted
+static std::mutex kProfileLock;
+static struct ProfileSite kProfileSites[kProfileMaxSites];
+static std::atomic<int> kProfileSiteCount(0);
+
+// in first-call order
+static std::vector<struct ProfileApi> kProfileApis;
+
+int profile_register(const char* profile_register_name, int profile_register_kind)
+{
+	std::lock_guard<std::mutex> profile_register_guard(kProfileLock);
+	int profile_register_count = kProfileSiteCount.load(std::memory_order_relaxed);
+
+	for (int profile_register_i = 0; profile_register_i < profile_register_count; profile_register_i++)
+	{
+		if (kProfileSites[profile_register_i].kind == profile_register_kind &&
+			strcmp(kProfileSites[profile_register_i].name, profile_register_name) == 0)
+		{
+			return profile_register_i;
+		}
+	}
+
+	if (profile_register_count == kProfileMaxSites)
+	{
+		return kProfileMaxSites - 1;
+	}
+
+	if (profile_register_count == kProfileMaxSites - 1)
+	{
+		kProfileSites[profile_register_count].name = "(other sites)";
+		kProfileSites[profile_register_count].kind = kProfileCall;
+	}
+	else
+	{
+		kProfileSites[profile_register_count].name = profile_register_name;
+		kProfileSites[profile_register_count].kind = profile_register_kind;
+	}
+
+	kProfileSiteCount.store(profile_register_count + 1, std::memory_order_release);
+
+	return profile_register_count;
+}
+
+ProfileApiScope::ProfileApiScope(const char* profile_api_name)
+	: name(profile_api_name), outermost(kProfileDepth == 0), sites(0)
+{
+	kProfileDepth++;
+
+	if (outermost)
+	{
+		sites = kProfileSiteCount.load(std::memory_order_acquire);
+		std::copy(kProfileCounts, kProfileCounts + sites, snapshot);
+	}
+}
+
+ProfileApiScope::~ProfileApiScope()
+{
+	kProfileDepth--;
+
+	if (!outermost)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> profile_api_guard(kProfileLock);
+	int profile_api_count = kProfileSiteCount.load(std::memory_order_relaxed);
+	std::vector<struct ProfileApi>::iterator profile_api_it = std::find_if(
+		kProfileApis.begin(), kProfileApis.end(),
+		[this](const struct ProfileApi& profile_api_candidate) { return profile_api_candidate.name == name; });
+
+	if (profile_api_it == kProfileApis.end())
+	{
+		kProfileApis.emplace_back();
+		profile_api_it = kProfileApis.end() - 1;
+		profile_api_it->name = name;
+		profile_api_it->calls = 0;
+		std::fill(profile_api_it->counts, profile_api_it->counts + kProfileMaxSites, 0);
+	}
+
+	profile_api_it->calls++;
+	for (int profile_api_i = 0; profile_api_i < profile_api_count; profile_api_i++)
+	{
+		profile_api_it->counts[profile_api_i] +=
+			kProfileCounts[profile_api_i] - (profile_api_i < sites ? snapshot[profile_api_i] : 0);
+	}
+}
+
+int profile_enabled()
+{
+	return 1;
+}
+
+int profile_reset()
+{
+	std::lock_guard<std::mutex> profile_reset_guard(kProfileLock);
+
+	kProfileApis.clear();
+
+	return 1;
+}
+
+int profile_print()
+{
+	std::lock_guard<std::mutex> profile_print_guard(kProfileLock);
+	int profile_print_count = kProfileSiteCount.load(std::memory_order_relaxed);
+
+	for (struct ProfileApi& profile_print_api : kProfileApis)
+	{
+		std::vector<int> profile_print_order;
+
+		for (int profile_print_i = 0; profile_print_i < profile_print_count; profile_print_i++)
+		{
+			if (profile_print_api.counts[profile_print_i] != 0)
+			{
+				profile_print_order.push_back(profile_print_i);
+			}
+		}
+
+		std::sort(profile_print_order.begin(), profile_print_order.end(),
+			[&profile_print_api](int profile_print_a, int profile_print_b)
+			{
+				return profile_print_api.counts[profile_print_a] > profile_print_api.counts[profile_print_b];
+			});
+
+		printf("one %s (mean of %llu calls):\n",
+			profile_print_api.name.c_str(),
+			(unsigned long long)profile_print_api.calls);
+
+		for (int profile_print_site : profile_print_order)
+		{
+			printf("  %14.1f %-10s %s\n",
+				(double)profile_print_api.counts[profile_print_site] / profile_print_api.calls,
+				kProfileSites[profile_print_site].kind == kProfileCall ? "calls" : "iterations",
+				kProfileSites[profile_print_site].name);
+		}
+	}
+
+	return 1;
+}
+
+#else
+
+int profile_enabled()
+{
+	return 0;
+}
+
+int profile_reset()
+{
+	return 1;
+}
+
+int profile_print()
+{
+	printf("profiling is off; rebuild with CMM_LAB_PROFILE defined\n");
+	return 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <cstdint>
+
+// Call and loop-iteration counts for the primitives, attributed to the
+// top-level API (rsa_keygen, dh_compute_key, ...) that caused them, so a
+// routine's cost in IR steps can be traced to the primitives it spends
+// them in. Only built when CMM_LAB_PROFILE is defined (-DCMM_LAB_PROFILE,
+// or /D in the project's preprocessor definitions); otherwise the macros
+// expand to nothing and the instrumented code is unchanged.
+//
+// PROFILE_CALL(name) at the top of a function counts a call.
+// PROFILE_LOOP(name) at the top of a loop body counts an iteration.
+// PROFILE_API(name) at the top of a top-level function opens a scope:
+// counts made on the thread until it returns are added to that API. A
+// scope inside another one (rsa_keygen encrypting a test message) counts
+// toward the outer scope only.
+
+enum ProfileKind
+{
+	kProfileCall,
+	kProfileLoop
+};
+
+static const int kProfileMaxSites = 256;
+
+// Return 1 if the build counts
+int profile_enabled();
+
+// forget all counts
+int profile_reset();
+
+// per API: its number of calls, then each primitive's calls and loop
+// iterations per API call, most frequent first
+int profile_print();
+
+#ifdef CMM_LAB_PROFILE
+
+// index of the (name, kind) counter; the last index absorbs sites past
+// kProfileMaxSites
+int profile_register(const char* profile_register_name, int profile_register_kind);
+
+extern thread_local uint64_t kProfileCounts[kProfileMaxSites];
+
+struct ProfileApiScope
+{
+	const char* name;
+	int outermost;
+	int sites; // sites registered at entry; later ones started from 0
+	uint64_t snapshot[kProfileMaxSites];
+
+	explicit ProfileApiScope(const char* profile_api_name);
+	~ProfileApiScope();
+
+	ProfileApiScope(const ProfileApiScope&) = delete;
+	ProfileApiScope& operator=(const ProfileApiScope&) = delete;
+};
+
+#define PROFILE_COUNT(profile_name, profile_kind) \
+	do \
+	{ \
+		static const int kProfileSite = profile_register(profile_name, profile_kind); \
+		kProfileCounts[kProfileSite]++; \
+	} while (0)
+
+#define PROFILE_CALL(profile_name) PROFILE_COUNT(profile_name, kProfileCall)
+#define PROFILE_LOOP(profile_name) PROFILE_COUNT(profile_name, kProfileLoop)
+#define PROFILE_API(profile_name) ProfileApiScope profile_api_scope(profile_name)
+
+#else
+
+#define PROFILE_CALL(profile_name) ((void)0)
+#define PROFILE_LOOP(profile_name) ((void)0)
+#define PROFILE_API(profile_name) ((void)0)
+
+#endif
+
+#endif
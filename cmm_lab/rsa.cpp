@@ -1,7 +1,15 @@
 #include "rsa.h"
+#include "ct_op.h"
+#include "metrics.h"
+#include "profile.h"
+#include "trace.h"
 
 int rsa_keygen(struct RSA rsa_keygen_rsa[1], int rsa_keygen_bits, int rsa_keygen_e)
 {
+	PROFILE_API("rsa_keygen");
+	METRICS_TIME(kMetricsRsaKeygen);
+	TRACE_SPAN_ARG("rsa_keygen", "bits", rsa_keygen_bits);
+
 	int rsa_keygen_primes = 2;
 	int rsa_keygen_r0,
 		rsa_keygen_r1,
@@ -57,6 +65,8 @@ int rsa_keygen(struct RSA rsa_keygen_rsa[1], int rsa_keygen_bits, int rsa_keygen
 			rsa_keygen_goto_redo = 1;
 			while (rsa_keygen_loop_inner && rsa_keygen_goto_redo)
 			{
+				TraceSpan rsa_keygen_redo_span("rsa_keygen prime", "index", rsa_keygen_i);
+
 				rsa_keygen_goto_redo = 0;
 
 				if (!generate_prime(rsa_keygen_prime_out, rsa_keygen_bitsr[rsa_keygen_i], 0, -1, -1))
@@ -147,11 +157,180 @@ int rsa_keygen(struct RSA rsa_keygen_rsa[1], int rsa_keygen_bits, int rsa_keygen
 	return 1;
 }
 
+int rsa_keygen_multi(
+	struct RSAMultiPrime rsa_keygenm_rsa[1],
+	int rsa_keygenm_bits,
+	int rsa_keygenm_e,
+	int rsa_keygenm_primes)
+{
+	PROFILE_API("rsa_keygen_multi");
+	METRICS_TIME(kMetricsRsaKeygenMulti);
+
+	int rsa_keygenm_bitsr[4];
+	int rsa_keygenm_quo, rsa_keygenm_rmd;
+	int rsa_keygenm_i, rsa_keygenm_j;
+	int rsa_keygenm_prime, rsa_keygenm_prime_out[1];
+	int rsa_keygenm_inv[1];
+	int rsa_keygenm_tmp, rsa_keygenm_phi, rsa_keygenm_prod, rsa_keygenm_r;
+	int rsa_keygenm_accepted;
+	int rsa_keygenm_goto_redo = 1;
+
+	if (mod(rsa_keygenm_e, 2) == 0 || rsa_keygenm_e <= 1)
+	{
+		return 0;
+	}
+
+	if (rsa_keygenm_primes < 2 || rsa_keygenm_primes > 4 || rsa_keygenm_bits > 31)
+	{
+		return 0;
+	}
+
+	rsa_keygenm_quo = rsa_keygenm_bits / rsa_keygenm_primes;
+	rsa_keygenm_rmd = mod(rsa_keygenm_bits, rsa_keygenm_primes);
+
+	rsa_keygenm_i = 0;
+	while (rsa_keygenm_i < rsa_keygenm_primes)
+	{
+		if (rsa_keygenm_i < rsa_keygenm_rmd)
+		{
+			rsa_keygenm_bitsr[rsa_keygenm_i] = rsa_keygenm_quo + 1;
+		}
+		else
+		{
+			rsa_keygenm_bitsr[rsa_keygenm_i] = rsa_keygenm_quo;
+		}
+
+		rsa_keygenm_i = rsa_keygenm_i + 1;
+	}
+
+	rsa_keygenm_rsa[0].e = rsa_keygenm_e;
+	rsa_keygenm_rsa[0].count = rsa_keygenm_primes;
+
+	// Each prime has its top two bits set, which pins the length of a
+	// product of two; with three or four the product can come out a bit
+	// or two short, and then every prime is drawn again.
+	while (rsa_keygenm_goto_redo)
+	{
+		rsa_keygenm_goto_redo = 0;
+
+		rsa_keygenm_i = 0;
+		while (rsa_keygenm_i < rsa_keygenm_primes)
+		{
+			rsa_keygenm_accepted = 0;
+			while (!rsa_keygenm_accepted)
+			{
+				if (!generate_prime(rsa_keygenm_prime_out, rsa_keygenm_bitsr[rsa_keygenm_i], 0, -1, -1))
+				{
+					return 0;
+				}
+
+				rsa_keygenm_prime = rsa_keygenm_prime_out[0];
+				rsa_keygenm_accepted = 1;
+
+				rsa_keygenm_j = 0;
+				while (rsa_keygenm_accepted && rsa_keygenm_j < rsa_keygenm_i)
+				{
+					if (rsa_keygenm_prime == rsa_keygenm_rsa[0].primes[rsa_keygenm_j])
+					{
+						rsa_keygenm_accepted = 0;
+					}
+
+					rsa_keygenm_j = rsa_keygenm_j + 1;
+				}
+
+				if (rsa_keygenm_accepted &&
+					!inverse_mod(rsa_keygenm_inv, rsa_keygenm_prime - 1, rsa_keygenm_e))
+				{
+					rsa_keygenm_accepted = 0;
+				}
+			}
+
+			rsa_keygenm_rsa[0].primes[rsa_keygenm_i] = rsa_keygenm_prime;
+			rsa_keygenm_i = rsa_keygenm_i + 1;
+		}
+
+		rsa_keygenm_rsa[0].n = rsa_keygenm_rsa[0].primes[0];
+		rsa_keygenm_i = 1;
+		while (rsa_keygenm_i < rsa_keygenm_primes)
+		{
+			rsa_keygenm_rsa[0].n = rsa_keygenm_rsa[0].n * rsa_keygenm_rsa[0].primes[rsa_keygenm_i];
+			rsa_keygenm_i = rsa_keygenm_i + 1;
+		}
+
+		if (get_bits_uint32(rsa_keygenm_rsa[0].n) != rsa_keygenm_bits)
+		{
+			rsa_keygenm_goto_redo = 1;
+		}
+	}
+
+	if (rsa_keygenm_rsa[0].primes[0] < rsa_keygenm_rsa[0].primes[1])
+	{
+		rsa_keygenm_tmp = rsa_keygenm_rsa[0].primes[0];
+		rsa_keygenm_rsa[0].primes[0] = rsa_keygenm_rsa[0].primes[1];
+		rsa_keygenm_rsa[0].primes[1] = rsa_keygenm_tmp;
+	}
+
+	rsa_keygenm_phi = 1;
+	rsa_keygenm_i = 0;
+	while (rsa_keygenm_i < rsa_keygenm_primes)
+	{
+		rsa_keygenm_phi = rsa_keygenm_phi * (rsa_keygenm_rsa[0].primes[rsa_keygenm_i] - 1);
+		rsa_keygenm_i = rsa_keygenm_i + 1;
+	}
+
+	if (!inverse_mod(rsa_keygenm_inv, rsa_keygenm_e, rsa_keygenm_phi))
+	{
+		return 0;
+	}
+
+	rsa_keygenm_rsa[0].d = rsa_keygenm_inv[0];
+
+	rsa_keygenm_i = 0;
+	while (rsa_keygenm_i < rsa_keygenm_primes)
+	{
+		rsa_keygenm_rsa[0].exps[rsa_keygenm_i] = mod(
+			rsa_keygenm_rsa[0].d, rsa_keygenm_rsa[0].primes[rsa_keygenm_i] - 1);
+		rsa_keygenm_rsa[0].coeffs[rsa_keygenm_i] = 0;
+		rsa_keygenm_i = rsa_keygenm_i + 1;
+	}
+
+	// coeffs[i] inverts the product of the primes before r_(i+1)
+	rsa_keygenm_prod = rsa_keygenm_rsa[0].primes[0];
+	rsa_keygenm_i = 1;
+	while (rsa_keygenm_i < rsa_keygenm_primes)
+	{
+		if (rsa_keygenm_i == 1)
+		{
+			rsa_keygenm_tmp = rsa_keygenm_rsa[0].primes[1];
+			rsa_keygenm_r = rsa_keygenm_rsa[0].primes[0];
+		}
+		else
+		{
+			rsa_keygenm_prod = rsa_keygenm_prod * rsa_keygenm_rsa[0].primes[rsa_keygenm_i - 1];
+			rsa_keygenm_tmp = mod(rsa_keygenm_prod, rsa_keygenm_rsa[0].primes[rsa_keygenm_i]);
+			rsa_keygenm_r = rsa_keygenm_rsa[0].primes[rsa_keygenm_i];
+		}
+
+		if (!inverse_mod(rsa_keygenm_inv, rsa_keygenm_tmp, rsa_keygenm_r))
+		{
+			return 0;
+		}
+
+		rsa_keygenm_rsa[0].coeffs[rsa_keygenm_i] = rsa_keygenm_inv[0];
+		rsa_keygenm_i = rsa_keygenm_i + 1;
+	}
+
+	return 1;
+}
+
 int rsa_pubkey_encryrpt(
 	int rsa_pubkenc_c_out[1],
 	struct RSA rsa_pubkenc_rsa[1],
 	int rsa_pubkenc_p)
 {
+	PROFILE_API("rsa_pubkey_encryrpt");
+	METRICS_TIME(kMetricsRsaPubkeyEncrypt);
+
 	int rsa_pubkenc_c;
 
 	if (rsa_pubkenc_rsa[0].n <= rsa_pubkenc_rsa[0].e ||
@@ -172,6 +351,9 @@ int rsa_privkey_encryrpt(
 	struct RSA rsa_privkenc_rsa[1],
 	int rsa_privkenc_p)
 {
+	PROFILE_API("rsa_privkey_encryrpt");
+	METRICS_TIME(kMetricsRsaPrivkeyEncrypt);
+
 	int rsa_privkenc_c;
 
 	if (cmp_uint32(rsa_privkenc_p, rsa_privkenc_rsa[0].n) >= 0)
@@ -179,7 +361,7 @@ int rsa_privkey_encryrpt(
 		return 0;
 	}
 
-	rsa_privkenc_c = exp_mod(
+	rsa_privkenc_c = exp_mod_secret(
 		rsa_privkenc_p, rsa_privkenc_rsa[0].d, rsa_privkenc_rsa[0].n);
 	rsa_privkenc_c_out[0] = rsa_privkenc_c;
 
@@ -191,6 +373,9 @@ int rsa_privkey_decryrpt(
 	struct RSA rsa_privkdec_rsa[1],
 	int rsa_privkdec_c)
 {
+	PROFILE_API("rsa_privkey_decryrpt");
+	METRICS_TIME(kMetricsRsaPrivkeyDecrypt);
+
 	int rsa_privkdec_p;
 
 	if (cmp_uint32(rsa_privkdec_c, rsa_privkdec_rsa[0].n) >= 0)
@@ -198,7 +383,7 @@ int rsa_privkey_decryrpt(
 		return 0;
 	}
 
-	rsa_privkdec_p = exp_mod(
+	rsa_privkdec_p = exp_mod_secret(
 		rsa_privkdec_c, rsa_privkdec_rsa[0].d, rsa_privkdec_rsa[0].n);
 	rsa_privkdec_p_out[0] = rsa_privkdec_p;
 
@@ -210,6 +395,9 @@ int rsa_pubkey_decryrpt(
 	struct RSA rsa_pubkdec_rsa[1],
 	int rsa_pubkdec_c)
 {
+	PROFILE_API("rsa_pubkey_decryrpt");
+	METRICS_TIME(kMetricsRsaPubkeyDecrypt);
+
 	int rsa_pubkdec_p;
 
 	if (rsa_pubkdec_rsa[0].n <= rsa_pubkdec_rsa[0].e ||
@@ -222,5 +410,177 @@ int rsa_pubkey_decryrpt(
 		rsa_pubkdec_c, rsa_pubkdec_rsa[0].e, rsa_pubkdec_rsa[0].n);
 	rsa_pubkdec_p_out[0] = rsa_pubkdec_p;
 
+	return 1;
+}
+
+int rsa_multi_pubkey_encryrpt(
+	int rsa_multi_pubkenc_c_out[1],
+	struct RSAMultiPrime rsa_multi_pubkenc_rsa[1],
+	int rsa_multi_pubkenc_p)
+{
+	PROFILE_API("rsa_multi_pubkey_encryrpt");
+	METRICS_TIME(kMetricsRsaMultiPubkeyEncrypt);
+
+	if (rsa_multi_pubkenc_rsa[0].n <= rsa_multi_pubkenc_rsa[0].e ||
+		cmp_uint32(rsa_multi_pubkenc_p, rsa_multi_pubkenc_rsa[0].n) >= 0)
+	{
+		return 0;
+	}
+
+	rsa_multi_pubkenc_c_out[0] = exp_mod(
+		rsa_multi_pubkenc_p, rsa_multi_pubkenc_rsa[0].e, rsa_multi_pubkenc_rsa[0].n);
+
+	return 1;
+}
+
+int rsa_multi_privkey_decryrpt(
+	int rsa_multi_privkdec_p_out[1],
+	struct RSAMultiPrime rsa_multi_privkdec_rsa[1],
+	int rsa_multi_privkdec_c)
+{
+	PROFILE_API("rsa_multi_privkey_decryrpt");
+	METRICS_TIME(kMetricsRsaMultiPrivkeyDecrypt);
+
+	int rsa_multi_privkdec_m[4];
+	int rsa_multi_privkdec_i;
+	int rsa_multi_privkdec_h, rsa_multi_privkdec_x, rsa_multi_privkdec_r, rsa_multi_privkdec_prime;
+
+	if (cmp_uint32(rsa_multi_privkdec_c, rsa_multi_privkdec_rsa[0].n) >= 0)
+	{
+		return 0;
+	}
+
+	// m_i = c^d_i mod r_i, each on a modulus a fraction of n's size
+	rsa_multi_privkdec_i = 0;
+	while (rsa_multi_privkdec_i < rsa_multi_privkdec_rsa[0].count)
+	{
+		rsa_multi_privkdec_prime = rsa_multi_privkdec_rsa[0].primes[rsa_multi_privkdec_i];
+		rsa_multi_privkdec_m[rsa_multi_privkdec_i] = exp_mod_secret(
+			mod_uint32(rsa_multi_privkdec_c, rsa_multi_privkdec_prime),
+			rsa_multi_privkdec_rsa[0].exps[rsa_multi_privkdec_i],
+			rsa_multi_privkdec_prime);
+		rsa_multi_privkdec_i = rsa_multi_privkdec_i + 1;
+	}
+
+	// h = (m_1 - m_2) * qInv mod p, m = m_2 + q * h
+	rsa_multi_privkdec_h = mul_mod_secret(
+		nnmod(rsa_multi_privkdec_m[0] - rsa_multi_privkdec_m[1], rsa_multi_privkdec_rsa[0].primes[0]),
+		rsa_multi_privkdec_rsa[0].coeffs[1],
+		rsa_multi_privkdec_rsa[0].primes[0]);
+	rsa_multi_privkdec_x = rsa_multi_privkdec_m[1] + rsa_multi_privkdec_rsa[0].primes[1] * rsa_multi_privkdec_h;
+
+	// Garner's steps for the additional primes:
+	// R = r_1 * ... * r_(i-1), h = (m_i - m) * t_i mod r_i, m = m + R * h
+	rsa_multi_privkdec_r = rsa_multi_privkdec_rsa[0].primes[0];
+	rsa_multi_privkdec_i = 2;
+	while (rsa_multi_privkdec_i < rsa_multi_privkdec_rsa[0].count)
+	{
+		rsa_multi_privkdec_prime = rsa_multi_privkdec_rsa[0].primes[rsa_multi_privkdec_i];
+		rsa_multi_privkdec_r = rsa_multi_privkdec_r * rsa_multi_privkdec_rsa[0].primes[rsa_multi_privkdec_i - 1];
+		rsa_multi_privkdec_h = mul_mod_secret(
+			nnmod(
+				rsa_multi_privkdec_m[rsa_multi_privkdec_i] - mod(rsa_multi_privkdec_x, rsa_multi_privkdec_prime),
+				rsa_multi_privkdec_prime),
+			rsa_multi_privkdec_rsa[0].coeffs[rsa_multi_privkdec_i],
+			rsa_multi_privkdec_prime);
+		rsa_multi_privkdec_x = rsa_multi_privkdec_x + rsa_multi_privkdec_r * rsa_multi_privkdec_h;
+		rsa_multi_privkdec_i = rsa_multi_privkdec_i + 1;
+	}
+
+	rsa_multi_privkdec_p_out[0] = rsa_multi_privkdec_x;
+
+	return 1;
+}
+
+// e must be >1
+int rsa_compile_exp_chain(struct RSAExpChain rsa_expchain_out[1], int rsa_expchain_e)
+{
+	int rsa_expchain_bit;
+
+	if (rsa_expchain_e <= 1)
+	{
+		return 0;
+	}
+
+	rsa_expchain_out[0].e = rsa_expchain_e;
+	rsa_expchain_out[0].len = 0;
+
+	// left-to-right binary chain, optimal for the usual 3 and 65537
+	rsa_expchain_bit = get_bits_uint32(rsa_expchain_e) - 2;
+	while (rsa_expchain_bit >= 0)
+	{
+		rsa_expchain_out[0].ops[rsa_expchain_out[0].len] =
+			is_bit_set(rsa_expchain_e, rsa_expchain_bit);
+		rsa_expchain_out[0].len = rsa_expchain_out[0].len + 1;
+		rsa_expchain_bit = rsa_expchain_bit - 1;
+	}
+
+	return 1;
+}
+
+int exp_mod_chain(
+	int exp_mod_chain_a,
+	struct RSAExpChain exp_mod_chain_chain[1],
+	int exp_mod_chain_p)
+{
+	int exp_mod_chain_i = 0;
+	int exp_mod_chain_x = mod_uint32(exp_mod_chain_a, exp_mod_chain_p);
+	int exp_mod_chain_base = exp_mod_chain_x;
+
+	while (exp_mod_chain_i < exp_mod_chain_chain[0].len)
+	{
+		exp_mod_chain_x = mul_mod(exp_mod_chain_x, exp_mod_chain_x, exp_mod_chain_p);
+
+		if (exp_mod_chain_chain[0].ops[exp_mod_chain_i])
+		{
+			exp_mod_chain_x = mul_mod(exp_mod_chain_x, exp_mod_chain_base, exp_mod_chain_p);
+		}
+
+		exp_mod_chain_i = exp_mod_chain_i + 1;
+	}
+
+	return exp_mod_chain_x;
+}
+
+// Verifies signatures [begin, end) under one key; ok_out[i] is 1 if
+// (signatures[i]^e) mod n == messages[i], otherwise 0.
+// chain must be compiled from rsa's e.
+int rsa_verify_batch(
+	int rsa_verifyb_ok_out[],
+	struct RSA rsa_verifyb_rsa[1],
+	struct RSAExpChain rsa_verifyb_chain[1],
+	int rsa_verifyb_messages[],
+	int rsa_verifyb_signatures[],
+	int rsa_verifyb_begin,
+	int rsa_verifyb_end)
+{
+	PROFILE_API("rsa_verify_batch");
+	METRICS_TIME(kMetricsRsaVerifyBatch);
+
+	int rsa_verifyb_i = rsa_verifyb_begin;
+	int rsa_verifyb_n = rsa_verifyb_rsa[0].n;
+
+	if (rsa_verifyb_n <= rsa_verifyb_rsa[0].e ||
+		rsa_verifyb_chain[0].e != rsa_verifyb_rsa[0].e)
+	{
+		return 0;
+	}
+
+	while (rsa_verifyb_i < rsa_verifyb_end)
+	{
+		rsa_verifyb_ok_out[rsa_verifyb_i] = 0;
+
+		if (cmp_uint32(rsa_verifyb_signatures[rsa_verifyb_i], rsa_verifyb_n) < 0 &&
+			exp_mod_chain(
+				rsa_verifyb_signatures[rsa_verifyb_i],
+				rsa_verifyb_chain,
+				rsa_verifyb_n) == rsa_verifyb_messages[rsa_verifyb_i])
+		{
+			rsa_verifyb_ok_out[rsa_verifyb_i] = 1;
+		}
+
+		rsa_verifyb_i = rsa_verifyb_i + 1;
+	}
+
 	return 1;
 }
\ No newline at end of file
@@ -14,8 +14,50 @@ struct RSA
 	int q;
 };
 
+// Precompiled exponentiation chain for a fixed public exponent.
+// ops[i] is 1 if step i squares and then multiplies by the base,
+// 0 if it only squares; the leading bit of e is implicit.
+struct RSAExpChain
+{
+	int e;
+	int len;
+	int ops[32];
+};
+
+// RFC 8017 multi-prime key with count primes r_1..r_count (2 to 4).
+// exps[i] = d mod (r_i - 1). coeffs[1] = qInv = r_2^-1 mod r_1 and
+// coeffs[i] = (r_1*...*r_i)^-1 mod r_(i+1) for i >= 2; coeffs[0] is 0.
+struct RSAMultiPrime
+{
+	int n;
+	int e;
+	int d;
+	int count;
+	int primes[4];
+	int exps[4];
+	int coeffs[4];
+};
+
 int rsa_keygen(struct RSA rsa_keygen_rsa[1], int rsa_keygen_bits, int rsa_keygen_e);
 
+// bits must be <=31; n is exactly bits long
+int rsa_keygen_multi(
+	struct RSAMultiPrime rsa_keygenm_rsa[1],
+	int rsa_keygenm_bits,
+	int rsa_keygenm_e,
+	int rsa_keygenm_primes);
+
+int rsa_multi_pubkey_encryrpt(
+	int rsa_multi_pubkenc_c_out[1],
+	struct RSAMultiPrime rsa_multi_pubkenc_rsa[1],
+	int rsa_multi_pubkenc_p);
+
+// CRT decryption (RFC 8017 RSADP, second form)
+int rsa_multi_privkey_decryrpt(
+	int rsa_multi_privkdec_p_out[1],
+	struct RSAMultiPrime rsa_multi_privkdec_rsa[1],
+	int rsa_multi_privkdec_c);
+
 int rsa_pubkey_encryrpt(
 	int rsa_pubkenc_c_out[1],
 	struct RSA rsa_pubkenc_rsa[1],
@@ -36,4 +78,20 @@ int rsa_pubkey_decryrpt(
 	struct RSA rsa_pubkdec_rsa[1],
 	int rsa_pubkdec_c);
 
+int rsa_compile_exp_chain(struct RSAExpChain rsa_expchain_out[1], int rsa_expchain_e);
+
+int exp_mod_chain(
+	int exp_mod_chain_a,
+	struct RSAExpChain exp_mod_chain_chain[1],
+	int exp_mod_chain_p);
+
+int rsa_verify_batch(
+	int rsa_verifyb_ok_out[],
+	struct RSA rsa_verifyb_rsa[1],
+	struct RSAExpChain rsa_verifyb_chain[1],
+	int rsa_verifyb_messages[],
+	int rsa_verifyb_signatures[],
+	int rsa_verifyb_begin,
+	int rsa_verifyb_end);
+
 #endif
\ No newline at end of file
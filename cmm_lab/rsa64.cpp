@@ -0,0 +1,158 @@
+#include "rsa64.h"
+#include "metrics.h"
+
+// Same prime selection as rsa_keygen; only n, phi and d need 64 bits.
+int rsa64_keygen(struct RSA64 rsa64_keygen_rsa[1], int rsa64_keygen_bits, int rsa64_keygen_e)
+{
+	METRICS_TIME(kMetricsRsa64Keygen);
+
+	int rsa64_keygen_bitsr[2];
+	int rsa64_keygen_primes[2];
+	int rsa64_keygen_prime_out[1];
+	int rsa64_keygen_inv[1];
+	int rsa64_keygen_phi[2], rsa64_keygen_e64[2];
+	int rsa64_keygen_i, rsa64_keygen_tmp;
+	int rsa64_keygen_accepted;
+
+	if (mod(rsa64_keygen_e, 2) == 0 || rsa64_keygen_e <= 1)
+	{
+		return 0;
+	}
+
+	if (rsa64_keygen_bits < 4 || rsa64_keygen_bits > 62)
+	{
+		return 0;
+	}
+
+	rsa64_keygen_bitsr[0] = rsa64_keygen_bits / 2 + mod(rsa64_keygen_bits, 2);
+	rsa64_keygen_bitsr[1] = rsa64_keygen_bits / 2;
+
+	rsa64_keygen_i = 0;
+	while (rsa64_keygen_i < 2)
+	{
+		rsa64_keygen_accepted = 0;
+		while (!rsa64_keygen_accepted)
+		{
+			if (!generate_prime(rsa64_keygen_prime_out, rsa64_keygen_bitsr[rsa64_keygen_i], 0, -1, -1))
+			{
+				return 0;
+			}
+
+			rsa64_keygen_primes[rsa64_keygen_i] = rsa64_keygen_prime_out[0];
+			rsa64_keygen_accepted = 1;
+
+			if (rsa64_keygen_i == 1 && rsa64_keygen_primes[1] == rsa64_keygen_primes[0])
+			{
+				rsa64_keygen_accepted = 0;
+			}
+
+			if (rsa64_keygen_accepted &&
+				!inverse_mod(rsa64_keygen_inv, rsa64_keygen_primes[rsa64_keygen_i] - 1, rsa64_keygen_e))
+			{
+				rsa64_keygen_accepted = 0;
+			}
+		}
+
+		rsa64_keygen_i = rsa64_keygen_i + 1;
+	}
+
+	if (rsa64_keygen_primes[0] < rsa64_keygen_primes[1])
+	{
+		rsa64_keygen_tmp = rsa64_keygen_primes[0];
+		rsa64_keygen_primes[0] = rsa64_keygen_primes[1];
+		rsa64_keygen_primes[1] = rsa64_keygen_tmp;
+	}
+
+	rsa64_keygen_rsa[0].p[0] = 0;
+	rsa64_keygen_rsa[0].p[1] = rsa64_keygen_primes[0];
+	rsa64_keygen_rsa[0].q[0] = 0;
+	rsa64_keygen_rsa[0].q[1] = rsa64_keygen_primes[1];
+	rsa64_keygen_rsa[0].e[0] = 0;
+	rsa64_keygen_rsa[0].e[1] = rsa64_keygen_e;
+
+	mul_uint32(rsa64_keygen_rsa[0].n, rsa64_keygen_primes[0], rsa64_keygen_primes[1]);
+	mul_uint32(rsa64_keygen_phi, rsa64_keygen_primes[0] - 1, rsa64_keygen_primes[1] - 1);
+
+	rsa64_keygen_e64[0] = 0;
+	rsa64_keygen_e64[1] = rsa64_keygen_e;
+	if (!inverse_mod_uint64(rsa64_keygen_rsa[0].d, rsa64_keygen_e64, rsa64_keygen_phi))
+	{
+		return 0;
+	}
+
+	return 1;
+}
+
+int rsa64_pubkey_encryrpt(
+	int rsa64_pubkenc_c_out[2],
+	struct RSA64 rsa64_pubkenc_rsa[1],
+	int rsa64_pubkenc_p[2])
+{
+	METRICS_TIME(kMetricsRsa64PubkeyEncrypt);
+
+	if (cmp_uint64(rsa64_pubkenc_rsa[0].n, rsa64_pubkenc_rsa[0].e) <= 0 ||
+		cmp_uint64(rsa64_pubkenc_p, rsa64_pubkenc_rsa[0].n) >= 0)
+	{
+		return 0;
+	}
+
+	exp_mod_uint64(
+		rsa64_pubkenc_c_out, rsa64_pubkenc_p, rsa64_pubkenc_rsa[0].e, rsa64_pubkenc_rsa[0].n);
+
+	return 1;
+}
+
+int rsa64_privkey_encryrpt(
+	int rsa64_privkenc_c_out[2],
+	struct RSA64 rsa64_privkenc_rsa[1],
+	int rsa64_privkenc_p[2])
+{
+	METRICS_TIME(kMetricsRsa64PrivkeyEncrypt);
+
+	if (cmp_uint64(rsa64_privkenc_p, rsa64_privkenc_rsa[0].n) >= 0)
+	{
+		return 0;
+	}
+
+	exp_mod_uint64(
+		rsa64_privkenc_c_out, rsa64_privkenc_p, rsa64_privkenc_rsa[0].d, rsa64_privkenc_rsa[0].n);
+
+	return 1;
+}
+
+int rsa64_privkey_decryrpt(
+	int rsa64_privkdec_p_out[2],
+	struct RSA64 rsa64_privkdec_rsa[1],
+	int rsa64_privkdec_c[2])
+{
+	METRICS_TIME(kMetricsRsa64PrivkeyDecrypt);
+
+	if (cmp_uint64(rsa64_privkdec_c, rsa64_privkdec_rsa[0].n) >= 0)
+	{
+		return 0;
+	}
+
+	exp_mod_uint64(
+		rsa64_privkdec_p_out, rsa64_privkdec_c, rsa64_privkdec_rsa[0].d, rsa64_privkdec_rsa[0].n);
+
+	return 1;
+}
+
+int rsa64_pubkey_decryrpt(
+	int rsa64_pubkdec_p_out[2],
+	struct RSA64 rsa64_pubkdec_rsa[1],
+	int rsa64_pubkdec_c[2])
+{
+	METRICS_TIME(kMetricsRsa64PubkeyDecrypt);
+
+	if (cmp_uint64(rsa64_pubkdec_rsa[0].n, rsa64_pubkdec_rsa[0].e) <= 0 ||
+		cmp_uint64(rsa64_pubkdec_c, rsa64_pubkdec_rsa[0].n) >= 0)
+	{
+		return 0;
+	}
+
+	exp_mod_uint64(
+		rsa64_pubkdec_p_out, rsa64_pubkdec_c, rsa64_pubkdec_rsa[0].e, rsa64_pubkdec_rsa[0].n);
+
+	return 1;
+}
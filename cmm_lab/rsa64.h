@@ -0,0 +1,42 @@
+#ifndef RSA64_H_
+#define RSA64_H_
+
+#include "common.h"
+#include "unsigned_op.h"
+#include "crypto_core64.h"
+
+// RSA with moduli of up to 62 bits. Values are uint64 stored as int[2],
+// high word first; p and q are at most 31 bits each.
+struct RSA64
+{
+	int n[2];
+	int e[2];
+	int d[2];
+	int p[2];
+	int q[2];
+};
+
+// bits must be >=4 and <=62
+int rsa64_keygen(struct RSA64 rsa64_keygen_rsa[1], int rsa64_keygen_bits, int rsa64_keygen_e);
+
+int rsa64_pubkey_encryrpt(
+	int rsa64_pubkenc_c_out[2],
+	struct RSA64 rsa64_pubkenc_rsa[1],
+	int rsa64_pubkenc_p[2]);
+
+int rsa64_privkey_encryrpt(
+	int rsa64_privkenc_c_out[2],
+	struct RSA64 rsa64_privkenc_rsa[1],
+	int rsa64_privkenc_p[2]);
+
+int rsa64_privkey_decryrpt(
+	int rsa64_privkdec_p_out[2],
+	struct RSA64 rsa64_privkdec_rsa[1],
+	int rsa64_privkdec_c[2]);
+
+int rsa64_pubkey_decryrpt(
+	int rsa64_pubkdec_p_out[2],
+	struct RSA64 rsa64_pubkdec_rsa[1],
+	int rsa64_pubkdec_c[2]);
+
+#endif
@@ -0,0 +1,77 @@
+#include <thread>
+#include <vector>
+
+#include "rsa_batch.h"
+#include "metrics.h"
+
+int rsa_verify_batch_parallel(
+	int rsa_verifybp_ok_out[],
+	struct RSA rsa_verifybp_rsa[1],
+	int rsa_verifybp_messages[],
+	int rsa_verifybp_signatures[],
+	int rsa_verifybp_count,
+	int rsa_verifybp_thread_count)
+{
+	METRICS_TIME(kMetricsRsaVerifyBatchParallel);
+
+	struct RSAExpChain rsa_verifybp_chain[1];
+	std::vector<std::thread> rsa_verifybp_threads;
+	int rsa_verifybp_i, rsa_verifybp_begin, rsa_verifybp_end;
+
+	if (rsa_verifybp_count < 0 ||
+		rsa_verifybp_rsa[0].n <= rsa_verifybp_rsa[0].e ||
+		!rsa_compile_exp_chain(rsa_verifybp_chain, rsa_verifybp_rsa[0].e))
+	{
+		return 0;
+	}
+
+	if (rsa_verifybp_thread_count <= 0)
+	{
+		rsa_verifybp_thread_count = (int)std::thread::hardware_concurrency();
+	}
+
+	if (rsa_verifybp_thread_count > rsa_verifybp_count)
+	{
+		rsa_verifybp_thread_count = rsa_verifybp_count;
+	}
+
+	if (rsa_verifybp_thread_count <= 1)
+	{
+		return rsa_verify_batch(
+			rsa_verifybp_ok_out,
+			rsa_verifybp_rsa,
+			rsa_verifybp_chain,
+			rsa_verifybp_messages,
+			rsa_verifybp_signatures,
+			0,
+			rsa_verifybp_count);
+	}
+
+	// Each thread owns a disjoint slice of ok_out; the key, chain and the
+	// kTwoPowers table are only read.
+	rsa_verifybp_i = 0;
+	while (rsa_verifybp_i < rsa_verifybp_thread_count)
+	{
+		rsa_verifybp_begin = (int)((long long)rsa_verifybp_count * rsa_verifybp_i / rsa_verifybp_thread_count);
+		rsa_verifybp_end = (int)((long long)rsa_verifybp_count * (rsa_verifybp_i + 1) / rsa_verifybp_thread_count);
+
+		rsa_verifybp_threads.emplace_back(
+			rsa_verify_batch,
+			rsa_verifybp_ok_out,
+			rsa_verifybp_rsa,
+			rsa_verifybp_chain,
+			rsa_verifybp_messages,
+			rsa_verifybp_signatures,
+			rsa_verifybp_begin,
+			rsa_verifybp_end);
+
+		rsa_verifybp_i = rsa_verifybp_i + 1;
+	}
+
+	for (std::thread& rsa_verifybp_thread : rsa_verifybp_threads)
+	{
+		rsa_verifybp_thread.join();
+	}
+
+	return 1;
+}
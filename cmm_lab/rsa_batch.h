@@ -0,0 +1,17 @@
+#ifndef RSA_BATCH_H_
+#define RSA_BATCH_H_
+
+#include "rsa.h"
+
+// Verifies count (message, signature) pairs under one key, splitting the
+// batch into contiguous ranges over thread_count threads (<=0 means one per
+// hardware thread). ok_out[i] receives the result for pair i.
+int rsa_verify_batch_parallel(
+	int rsa_verifybp_ok_out[],
+	struct RSA rsa_verifybp_rsa[1],
+	int rsa_verifybp_messages[],
+	int rsa_verifybp_signatures[],
+	int rsa_verifybp_count,
+	int rsa_verifybp_thread_count);
+
+#endif
@@ -0,0 +1,228 @@
+#include "rsa_bn.h"
+#include "metrics.h"
+
+// Same prime selection as rsa_keygen. d = e^-1 mod phi is found without a
+// multi-precision inverse: with k = -phi^-1 mod e, k*phi+1 is a multiple
+// of e and d = (k*phi+1)/e.
+int rsa_bn_keygen(
+	struct RSABn rsa_bn_keygen_rsa[1],
+	int rsa_bn_keygen_bits,
+	int rsa_bn_keygen_e,
+	int rsa_bn_keygen_scratch[])
+{
+	METRICS_TIME(kMetricsRsaBnKeygen);
+
+	int rsa_bn_keygen_limbs = (rsa_bn_keygen_bits + 31) / 32;
+	int* rsa_bn_keygen_prime = rsa_bn_keygen_scratch;
+	int* rsa_bn_keygen_prod = rsa_bn_keygen_scratch + rsa_bn_keygen_limbs;
+	int* rsa_bn_keygen_pm1 = rsa_bn_keygen_scratch + 3 * rsa_bn_keygen_limbs;
+	int* rsa_bn_keygen_qm1 = rsa_bn_keygen_scratch + 4 * rsa_bn_keygen_limbs;
+	int* rsa_bn_keygen_tmp = rsa_bn_keygen_scratch + 5 * rsa_bn_keygen_limbs;
+	int rsa_bn_keygen_bitsr[2];
+	int rsa_bn_keygen_inv[1];
+	int rsa_bn_keygen_i, rsa_bn_keygen_k, rsa_bn_keygen_plimbs;
+	int rsa_bn_keygen_accepted;
+
+	if (mod(rsa_bn_keygen_e, 2) == 0 || rsa_bn_keygen_e <= 1)
+	{
+		return 0;
+	}
+
+	if (rsa_bn_keygen_bits < 128 || rsa_bn_keygen_bits > 32 * kBnMaxLimbs)
+	{
+		return 0;
+	}
+
+	rsa_bn_keygen_bitsr[0] = rsa_bn_keygen_bits / 2 + mod(rsa_bn_keygen_bits, 2);
+	rsa_bn_keygen_bitsr[1] = rsa_bn_keygen_bits / 2;
+
+	rsa_bn_keygen_rsa[0].limbs = rsa_bn_keygen_limbs;
+	rsa_bn_keygen_rsa[0].e = rsa_bn_keygen_e;
+
+	rsa_bn_keygen_i = 0;
+	while (rsa_bn_keygen_i < 2)
+	{
+		rsa_bn_keygen_accepted = 0;
+		while (!rsa_bn_keygen_accepted)
+		{
+			// searched at its own width, then zero-padded to limbs limbs
+			rsa_bn_keygen_plimbs = (rsa_bn_keygen_bitsr[rsa_bn_keygen_i] + 31) / 32;
+			bn_zero(rsa_bn_keygen_prime, rsa_bn_keygen_limbs);
+			if (!bn_generate_prime(
+					rsa_bn_keygen_prime,
+					rsa_bn_keygen_plimbs,
+					rsa_bn_keygen_bitsr[rsa_bn_keygen_i],
+					rsa_bn_keygen_tmp))
+			{
+				return 0;
+			}
+
+			rsa_bn_keygen_accepted = 1;
+
+			if (rsa_bn_keygen_i == 1 &&
+				bn_cmp(rsa_bn_keygen_prime, rsa_bn_keygen_rsa[0].p, rsa_bn_keygen_limbs) == 0)
+			{
+				rsa_bn_keygen_accepted = 0;
+			}
+
+			// gcd(prime-1, e) must be 1
+			if (rsa_bn_keygen_accepted)
+			{
+				bn_sub_word(rsa_bn_keygen_pm1, rsa_bn_keygen_prime, rsa_bn_keygen_limbs, 1);
+				if (!inverse_mod(
+						rsa_bn_keygen_inv,
+						bn_div_word(nullptr, rsa_bn_keygen_pm1, rsa_bn_keygen_limbs, rsa_bn_keygen_e),
+						rsa_bn_keygen_e))
+				{
+					rsa_bn_keygen_accepted = 0;
+				}
+			}
+		}
+
+		if (rsa_bn_keygen_i == 0)
+		{
+			bn_copy(rsa_bn_keygen_rsa[0].p, rsa_bn_keygen_prime, rsa_bn_keygen_limbs);
+		}
+		else
+		{
+			bn_copy(rsa_bn_keygen_rsa[0].q, rsa_bn_keygen_prime, rsa_bn_keygen_limbs);
+		}
+
+		rsa_bn_keygen_i = rsa_bn_keygen_i + 1;
+	}
+
+	if (bn_cmp(rsa_bn_keygen_rsa[0].p, rsa_bn_keygen_rsa[0].q, rsa_bn_keygen_limbs) < 0)
+	{
+		bn_copy(rsa_bn_keygen_prime, rsa_bn_keygen_rsa[0].p, rsa_bn_keygen_limbs);
+		bn_copy(rsa_bn_keygen_rsa[0].p, rsa_bn_keygen_rsa[0].q, rsa_bn_keygen_limbs);
+		bn_copy(rsa_bn_keygen_rsa[0].q, rsa_bn_keygen_prime, rsa_bn_keygen_limbs);
+	}
+
+	// n and phi fit in limbs limbs; the upper halves of the products are 0
+	bn_mul(
+		rsa_bn_keygen_prod,
+		rsa_bn_keygen_rsa[0].p,
+		rsa_bn_keygen_limbs,
+		rsa_bn_keygen_rsa[0].q,
+		rsa_bn_keygen_limbs);
+	bn_copy(rsa_bn_keygen_rsa[0].n, rsa_bn_keygen_prod, rsa_bn_keygen_limbs);
+
+	bn_sub_word(rsa_bn_keygen_pm1, rsa_bn_keygen_rsa[0].p, rsa_bn_keygen_limbs, 1);
+	bn_sub_word(rsa_bn_keygen_qm1, rsa_bn_keygen_rsa[0].q, rsa_bn_keygen_limbs, 1);
+	bn_mul(rsa_bn_keygen_prod, rsa_bn_keygen_pm1, rsa_bn_keygen_limbs, rsa_bn_keygen_qm1, rsa_bn_keygen_limbs);
+
+	if (!inverse_mod(
+			rsa_bn_keygen_inv,
+			bn_div_word(nullptr, rsa_bn_keygen_prod, rsa_bn_keygen_limbs, rsa_bn_keygen_e),
+			rsa_bn_keygen_e))
+	{
+		return 0;
+	}
+
+	rsa_bn_keygen_k = rsa_bn_keygen_e - rsa_bn_keygen_inv[0];
+
+	// d = (k*phi + 1) / e, computed in place over limbs+1 limbs
+	rsa_bn_keygen_prod[rsa_bn_keygen_limbs] = 0;
+	bn_zero(rsa_bn_keygen_rsa[0].d, rsa_bn_keygen_limbs);
+	rsa_bn_keygen_prod[rsa_bn_keygen_limbs] = bn_mul_word_add(
+		rsa_bn_keygen_rsa[0].d, rsa_bn_keygen_prod, rsa_bn_keygen_limbs, rsa_bn_keygen_k);
+	bn_copy(rsa_bn_keygen_prod, rsa_bn_keygen_rsa[0].d, rsa_bn_keygen_limbs);
+	bn_add_word(rsa_bn_keygen_prod, rsa_bn_keygen_prod, rsa_bn_keygen_limbs + 1, 1);
+	bn_div_word(rsa_bn_keygen_prod, rsa_bn_keygen_prod, rsa_bn_keygen_limbs + 1, rsa_bn_keygen_e);
+	bn_copy(rsa_bn_keygen_rsa[0].d, rsa_bn_keygen_prod, rsa_bn_keygen_limbs);
+
+	return 1;
+}
+
+// c = p^e mod n; e has one limb
+static int rsa_bn_public(
+	int rsa_bn_public_out[],
+	struct RSABn rsa_bn_public_rsa[1],
+	int rsa_bn_public_in[],
+	int rsa_bn_public_scratch[])
+{
+	if (bn_len(rsa_bn_public_rsa[0].n, rsa_bn_public_rsa[0].limbs) <= 1 &&
+		cmp_uint32(rsa_bn_public_rsa[0].n[0], rsa_bn_public_rsa[0].e) <= 0)
+	{
+		return 0;
+	}
+
+	if (bn_cmp(rsa_bn_public_in, rsa_bn_public_rsa[0].n, rsa_bn_public_rsa[0].limbs) >= 0)
+	{
+		return 0;
+	}
+
+	return bn_exp_mod(
+		rsa_bn_public_out,
+		rsa_bn_public_in,
+		&rsa_bn_public_rsa[0].e,
+		1,
+		rsa_bn_public_rsa[0].n,
+		rsa_bn_public_rsa[0].limbs,
+		rsa_bn_public_scratch);
+}
+
+static int rsa_bn_private(
+	int rsa_bn_private_out[],
+	struct RSABn rsa_bn_private_rsa[1],
+	int rsa_bn_private_in[],
+	int rsa_bn_private_scratch[])
+{
+	if (bn_cmp(rsa_bn_private_in, rsa_bn_private_rsa[0].n, rsa_bn_private_rsa[0].limbs) >= 0)
+	{
+		return 0;
+	}
+
+	return bn_exp_mod(
+		rsa_bn_private_out,
+		rsa_bn_private_in,
+		rsa_bn_private_rsa[0].d,
+		rsa_bn_private_rsa[0].limbs,
+		rsa_bn_private_rsa[0].n,
+		rsa_bn_private_rsa[0].limbs,
+		rsa_bn_private_scratch);
+}
+
+int rsa_bn_pubkey_encryrpt(
+	int rsa_bn_pubkenc_c_out[],
+	struct RSABn rsa_bn_pubkenc_rsa[1],
+	int rsa_bn_pubkenc_p[],
+	int rsa_bn_pubkenc_scratch[])
+{
+	METRICS_TIME(kMetricsRsaBnPubkeyEncrypt);
+
+	return rsa_bn_public(rsa_bn_pubkenc_c_out, rsa_bn_pubkenc_rsa, rsa_bn_pubkenc_p, rsa_bn_pubkenc_scratch);
+}
+
+int rsa_bn_privkey_encryrpt(
+	int rsa_bn_privkenc_c_out[],
+	struct RSABn rsa_bn_privkenc_rsa[1],
+	int rsa_bn_privkenc_p[],
+	int rsa_bn_privkenc_scratch[])
+{
+	METRICS_TIME(kMetricsRsaBnPrivkeyEncrypt);
+
+	return rsa_bn_private(rsa_bn_privkenc_c_out, rsa_bn_privkenc_rsa, rsa_bn_privkenc_p, rsa_bn_privkenc_scratch);
+}
+
+int rsa_bn_privkey_decryrpt(
+	int rsa_bn_privkdec_p_out[],
+	struct RSABn rsa_bn_privkdec_rsa[1],
+	int rsa_bn_privkdec_c[],
+	int rsa_bn_privkdec_scratch[])
+{
+	METRICS_TIME(kMetricsRsaBnPrivkeyDecrypt);
+
+	return rsa_bn_private(rsa_bn_privkdec_p_out, rsa_bn_privkdec_rsa, rsa_bn_privkdec_c, rsa_bn_privkdec_scratch);
+}
+
+int rsa_bn_pubkey_decryrpt(
+	int rsa_bn_pubkdec_p_out[],
+	struct RSABn rsa_bn_pubkdec_rsa[1],
+	int rsa_bn_pubkdec_c[],
+	int rsa_bn_pubkdec_scratch[])
+{
+	METRICS_TIME(kMetricsRsaBnPubkeyDecrypt);
+
+	return rsa_bn_public(rsa_bn_pubkdec_p_out, rsa_bn_pubkdec_rsa, rsa_bn_pubkdec_c, rsa_bn_pubkdec_scratch);
+}
@@ -0,0 +1,51 @@
+#ifndef RSA_BN_H_
+#define RSA_BN_H_
+
+#include "common.h"
+#include "bignum.h"
+
+// RSA with 64- to 2048-bit moduli. Every number is limbs limbs long
+// (least significant first) and zero-padded; e is a single limb as in
+// rsa_keygen. scratch must hold kBnScratchLimbs limbs.
+struct RSABn
+{
+	int limbs;
+	int e;
+	int n[kBnMaxLimbs];
+	int d[kBnMaxLimbs];
+	int p[kBnMaxLimbs];
+	int q[kBnMaxLimbs];
+};
+
+// bits must be >=128 and <=32*kBnMaxLimbs; n is exactly bits long
+int rsa_bn_keygen(
+	struct RSABn rsa_bn_keygen_rsa[1],
+	int rsa_bn_keygen_bits,
+	int rsa_bn_keygen_e,
+	int rsa_bn_keygen_scratch[]);
+
+int rsa_bn_pubkey_encryrpt(
+	int rsa_bn_pubkenc_c_out[],
+	struct RSABn rsa_bn_pubkenc_rsa[1],
+	int rsa_bn_pubkenc_p[],
+	int rsa_bn_pubkenc_scratch[]);
+
+int rsa_bn_privkey_encryrpt(
+	int rsa_bn_privkenc_c_out[],
+	struct RSABn rsa_bn_privkenc_rsa[1],
+	int rsa_bn_privkenc_p[],
+	int rsa_bn_privkenc_scratch[]);
+
+int rsa_bn_privkey_decryrpt(
+	int rsa_bn_privkdec_p_out[],
+	struct RSABn rsa_bn_privkdec_rsa[1],
+	int rsa_bn_privkdec_c[],
+	int rsa_bn_privkdec_scratch[]);
+
+int rsa_bn_pubkey_decryrpt(
+	int rsa_bn_pubkdec_p_out[],
+	struct RSABn rsa_bn_pubkdec_rsa[1],
+	int rsa_bn_pubkdec_c[],
+	int rsa_bn_pubkdec_scratch[]);
+
+#endif
@@ -0,0 +1,311 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "lockfree_queue.h"
+#include "metrics.h"
+#include "rsa_pipeline.h"
+
+struct RSAPipeline
+{
+	struct RSAPipelineConfig config;
+
+	// prime sizes as rsa_keygen splits bits; one queue when they are equal
+	int bits[2];
+	int classes;
+
+	LockFreeQueue<int> primes[2];
+	LockFreeQueue<struct RSA> keys;
+
+	std::atomic<bool> stopping;
+	std::atomic<bool> failed;
+
+	std::atomic<long long> primes_found;
+	std::atomic<long long> primes_rejected;
+	long long pairs_rejected;
+	long long keys_written;
+
+	// each slot is written only by its own thread
+	std::vector<std::chrono::steady_clock::duration> finder_busy;
+	std::chrono::steady_clock::duration pairing_busy;
+	std::chrono::steady_clock::duration output_busy;
+};
+
+static void rsa_pipeline_fail(struct RSAPipeline* rsa_pipeline_fail_pipe)
+{
+	rsa_pipeline_fail_pipe->failed.store(true);
+	rsa_pipeline_fail_pipe->stopping.store(true);
+}
+
+static void rsa_pipeline_finder(struct RSAPipeline* rsa_finder_pipe, int rsa_finder_index)
+{
+	std::chrono::steady_clock::time_point rsa_finder_begin;
+	int rsa_finder_class = 0;
+	int rsa_finder_prime[1], rsa_finder_inv[1];
+
+	srand32(rsa_finder_pipe->config.seed + rsa_finder_index);
+
+	while (!rsa_finder_pipe->stopping.load(std::memory_order_relaxed))
+	{
+		// feed whichever size the pairing stage is shorter of
+		if (rsa_finder_pipe->classes == 2)
+		{
+			rsa_finder_class =
+				lockfree_queue_size(&rsa_finder_pipe->primes[0]) <= lockfree_queue_size(&rsa_finder_pipe->primes[1])
+				? 0
+				: 1;
+		}
+
+		rsa_finder_begin = std::chrono::steady_clock::now();
+
+		if (!generate_prime(rsa_finder_prime, rsa_finder_pipe->bits[rsa_finder_class], 0, -1, -1))
+		{
+			rsa_pipeline_fail(rsa_finder_pipe);
+			return;
+		}
+
+		rsa_finder_pipe->primes_found++;
+
+		if (!inverse_mod(rsa_finder_inv, rsa_finder_prime[0] - 1, rsa_finder_pipe->config.e))
+		{
+			rsa_finder_pipe->primes_rejected++;
+			rsa_finder_pipe->finder_busy[rsa_finder_index] += std::chrono::steady_clock::now() - rsa_finder_begin;
+			continue;
+		}
+
+		rsa_finder_pipe->finder_busy[rsa_finder_index] += std::chrono::steady_clock::now() - rsa_finder_begin;
+
+		while (!lockfree_queue_push(&rsa_finder_pipe->primes[rsa_finder_class], rsa_finder_prime[0]))
+		{
+			if (rsa_finder_pipe->stopping.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			std::this_thread::yield();
+		}
+	}
+}
+
+static int rsa_pipeline_take_prime(struct RSAPipeline* rsa_take_pipe, int rsa_take_class, int rsa_take_out[1])
+{
+	while (!lockfree_queue_pop(&rsa_take_pipe->primes[rsa_take_class], rsa_take_out))
+	{
+		if (rsa_take_pipe->stopping.load(std::memory_order_relaxed))
+		{
+			return 0;
+		}
+
+		std::this_thread::yield();
+	}
+
+	return 1;
+}
+
+static void rsa_pipeline_pairing(struct RSAPipeline* rsa_pairing_pipe)
+{
+	std::chrono::steady_clock::time_point rsa_pairing_begin;
+	struct RSA rsa_pairing_key;
+	long long rsa_pairing_made = 0;
+	int rsa_pairing_p[1], rsa_pairing_q[1], rsa_pairing_inv[1];
+	int rsa_pairing_tmp;
+
+	rsa_pairing_key.e = rsa_pairing_pipe->config.e;
+
+	while (rsa_pairing_made < rsa_pairing_pipe->config.keys)
+	{
+		if (!rsa_pipeline_take_prime(rsa_pairing_pipe, 0, rsa_pairing_p) ||
+			!rsa_pipeline_take_prime(rsa_pairing_pipe, rsa_pairing_pipe->classes - 1, rsa_pairing_q))
+		{
+			return;
+		}
+
+		rsa_pairing_begin = std::chrono::steady_clock::now();
+
+		// rsa_keygen redraws q when it repeats p; keep p and wait for the next q
+		while (rsa_pairing_p[0] == rsa_pairing_q[0])
+		{
+			rsa_pairing_pipe->pairs_rejected++;
+			rsa_pairing_pipe->pairing_busy += std::chrono::steady_clock::now() - rsa_pairing_begin;
+
+			if (!rsa_pipeline_take_prime(rsa_pairing_pipe, rsa_pairing_pipe->classes - 1, rsa_pairing_q))
+			{
+				return;
+			}
+
+			rsa_pairing_begin = std::chrono::steady_clock::now();
+		}
+
+		if (rsa_pairing_p[0] < rsa_pairing_q[0])
+		{
+			rsa_pairing_tmp = rsa_pairing_p[0];
+			rsa_pairing_p[0] = rsa_pairing_q[0];
+			rsa_pairing_q[0] = rsa_pairing_tmp;
+		}
+
+		if (!inverse_mod(
+			rsa_pairing_inv,
+			rsa_pairing_pipe->config.e,
+			(int)((unsigned)(rsa_pairing_p[0] - 1) * (unsigned)(rsa_pairing_q[0] - 1))))
+		{
+			// rsa_keygen gives up here too
+			rsa_pipeline_fail(rsa_pairing_pipe);
+			return;
+		}
+
+		rsa_pairing_key.n = (int)((unsigned)rsa_pairing_p[0] * (unsigned)rsa_pairing_q[0]);
+		rsa_pairing_key.d = rsa_pairing_inv[0];
+		rsa_pairing_key.p = rsa_pairing_p[0];
+		rsa_pairing_key.q = rsa_pairing_q[0];
+
+		rsa_pairing_pipe->pairing_busy += std::chrono::steady_clock::now() - rsa_pairing_begin;
+
+		while (!lockfree_queue_push(&rsa_pairing_pipe->keys, rsa_pairing_key))
+		{
+			if (rsa_pairing_pipe->stopping.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			std::this_thread::yield();
+		}
+
+		rsa_pairing_made++;
+	}
+
+	// every key is queued; the finders can go
+	rsa_pairing_pipe->stopping.store(true);
+}
+
+static void rsa_pipeline_output(struct RSAPipeline* rsa_output_pipe)
+{
+	std::chrono::steady_clock::time_point rsa_output_begin;
+	struct RSA rsa_output_key[1];
+
+	while (rsa_output_pipe->keys_written < rsa_output_pipe->config.keys)
+	{
+		// after a failure nothing more will arrive; after a normal stop the
+		// remaining keys are still queued
+		while (!lockfree_queue_pop(&rsa_output_pipe->keys, rsa_output_key))
+		{
+			if (rsa_output_pipe->failed.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+
+			std::this_thread::yield();
+		}
+
+		rsa_output_begin = std::chrono::steady_clock::now();
+
+		if (rsa_output_pipe->config.writer != nullptr &&
+			!keystore_writer_append_rsa(rsa_output_pipe->config.writer, rsa_output_key))
+		{
+			rsa_pipeline_fail(rsa_output_pipe);
+			return;
+		}
+
+		if (rsa_output_pipe->config.keys_out != nullptr)
+		{
+			rsa_output_pipe->config.keys_out[rsa_output_pipe->keys_written] = rsa_output_key[0];
+		}
+
+		rsa_output_pipe->keys_written++;
+		rsa_output_pipe->output_busy += std::chrono::steady_clock::now() - rsa_output_begin;
+	}
+}
+
+static void rsa_pipeline_stage_stats(
+	struct RSAPipelineStageStats rsa_stage_stats_out[1],
+	int rsa_stage_stats_threads,
+	std::chrono::steady_clock::duration rsa_stage_stats_busy,
+	double rsa_stage_stats_wall_s)
+{
+	rsa_stage_stats_out[0].threads = rsa_stage_stats_threads;
+	rsa_stage_stats_out[0].busy_s = std::chrono::duration<double>(rsa_stage_stats_busy).count();
+	rsa_stage_stats_out[0].utilization = rsa_stage_stats_wall_s > 0
+		? rsa_stage_stats_out[0].busy_s / (rsa_stage_stats_threads * rsa_stage_stats_wall_s)
+		: 0;
+}
+
+int rsa_keygen_pipeline(
+	struct RSAPipelineStats rsa_pipeline_stats_out[1],
+	struct RSAPipelineConfig rsa_pipeline_config[1])
+{
+	METRICS_TIME(kMetricsRsaKeygenPipeline);
+
+	struct RSAPipeline rsa_pipeline_pipe;
+	std::vector<std::thread> rsa_pipeline_finders;
+	std::thread rsa_pipeline_pairing_thread, rsa_pipeline_output_thread;
+	std::chrono::steady_clock::time_point rsa_pipeline_begin;
+	std::chrono::steady_clock::duration rsa_pipeline_finder_busy = std::chrono::steady_clock::duration::zero();
+	double rsa_pipeline_wall_s;
+	int rsa_pipeline_i;
+
+	if (mod(rsa_pipeline_config[0].e, 2) == 0 || rsa_pipeline_config[0].e <= 1 ||
+		rsa_pipeline_config[0].keys < 0 ||
+		rsa_pipeline_config[0].finder_threads <= 0)
+	{
+		return 0;
+	}
+
+	rsa_pipeline_pipe.config = rsa_pipeline_config[0];
+	rsa_pipeline_pipe.bits[0] = rsa_pipeline_config[0].bits / 2 + mod(rsa_pipeline_config[0].bits, 2);
+	rsa_pipeline_pipe.bits[1] = rsa_pipeline_config[0].bits / 2;
+	rsa_pipeline_pipe.classes = rsa_pipeline_pipe.bits[0] == rsa_pipeline_pipe.bits[1] ? 1 : 2;
+
+	if (!lockfree_queue_init(&rsa_pipeline_pipe.primes[0], rsa_pipeline_config[0].queue_capacity) ||
+		!lockfree_queue_init(&rsa_pipeline_pipe.primes[1], rsa_pipeline_config[0].queue_capacity) ||
+		!lockfree_queue_init(&rsa_pipeline_pipe.keys, rsa_pipeline_config[0].queue_capacity))
+	{
+		return 0;
+	}
+
+	rsa_pipeline_pipe.stopping.store(rsa_pipeline_config[0].keys == 0);
+	rsa_pipeline_pipe.failed.store(false);
+	rsa_pipeline_pipe.primes_found.store(0);
+	rsa_pipeline_pipe.primes_rejected.store(0);
+	rsa_pipeline_pipe.pairs_rejected = 0;
+	rsa_pipeline_pipe.keys_written = 0;
+	rsa_pipeline_pipe.finder_busy.assign(
+		rsa_pipeline_config[0].finder_threads, std::chrono::steady_clock::duration::zero());
+	rsa_pipeline_pipe.pairing_busy = std::chrono::steady_clock::duration::zero();
+	rsa_pipeline_pipe.output_busy = std::chrono::steady_clock::duration::zero();
+
+	rsa_pipeline_begin = std::chrono::steady_clock::now();
+
+	for (rsa_pipeline_i = 0; rsa_pipeline_i < rsa_pipeline_config[0].finder_threads; rsa_pipeline_i++)
+	{
+		rsa_pipeline_finders.emplace_back(rsa_pipeline_finder, &rsa_pipeline_pipe, rsa_pipeline_i);
+	}
+
+	rsa_pipeline_pairing_thread = std::thread(rsa_pipeline_pairing, &rsa_pipeline_pipe);
+	rsa_pipeline_output_thread = std::thread(rsa_pipeline_output, &rsa_pipeline_pipe);
+
+	rsa_pipeline_output_thread.join();
+	rsa_pipeline_pairing_thread.join();
+	for (rsa_pipeline_i = 0; rsa_pipeline_i < rsa_pipeline_config[0].finder_threads; rsa_pipeline_i++)
+	{
+		rsa_pipeline_finders[rsa_pipeline_i].join();
+		rsa_pipeline_finder_busy += rsa_pipeline_pipe.finder_busy[rsa_pipeline_i];
+	}
+
+	rsa_pipeline_wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - rsa_pipeline_begin).count();
+
+	rsa_pipeline_stats_out[0].keys = rsa_pipeline_pipe.keys_written;
+	rsa_pipeline_stats_out[0].seconds = rsa_pipeline_wall_s;
+	rsa_pipeline_stats_out[0].keys_per_s = rsa_pipeline_wall_s > 0 ? rsa_pipeline_pipe.keys_written / rsa_pipeline_wall_s : 0;
+	rsa_pipeline_stats_out[0].primes = rsa_pipeline_pipe.primes_found.load();
+	rsa_pipeline_stats_out[0].primes_rejected = rsa_pipeline_pipe.primes_rejected.load();
+	rsa_pipeline_stats_out[0].pairs_rejected = rsa_pipeline_pipe.pairs_rejected;
+
+	rsa_pipeline_stage_stats(
+		&rsa_pipeline_stats_out[0].finder,
+		rsa_pipeline_config[0].finder_threads,
+		rsa_pipeline_finder_busy,
+		rsa_pipeline_wall_s);
+	rsa_pipeline_stage_stats(&rsa_pipeline_stats_out[0].pairing, 1, rsa_pipeline_pipe.pairing_busy, rsa_pipeline_wall_s);
+	rsa_pipeline_stage_stats(&rsa_pipeline_stats_out[0].output, 1, rsa_pipeline_pipe.output_busy, rsa_pipeline_wall_s);
+
+	return !rsa_pipeline_pipe.failed.load();
+}
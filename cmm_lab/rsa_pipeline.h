@@ -0,0 +1,62 @@
+#ifndef RSA_PIPELINE_H_
+#define RSA_PIPELINE_H_
+
+#include "keystore.h"
+#include "rsa.h"
+
+// Bulk RSA key generation as a three-stage pipeline:
+//   prime finders  finder_threads threads running generate_prime; primes
+//                  rsa_keygen would retry on (gcd(prime-1, e) != 1) are
+//                  dropped here
+//   pairing        one thread taking (p, q) off the prime queues, dropping
+//                  p == q and computing n and d exactly as rsa_keygen does;
+//                  it fails where rsa_keygen would return 0
+//   output         one thread appending finished keys to a keystore writer
+//                  and/or keys_out
+// Stages are connected by lock-free bounded queues and poll them with
+// yields when empty or full.
+
+struct RSAPipelineConfig
+{
+	int bits;
+	int e;
+	long long keys;
+	int finder_threads;
+	// per queue; rounded up to a power of two
+	int queue_capacity;
+	// finder i seeds its rand32 stream with seed + i
+	int seed;
+	// either may be nullptr
+	struct KeyStoreWriter* writer;
+	struct RSA* keys_out;
+};
+
+struct RSAPipelineStageStats
+{
+	int threads;
+	// summed over the stage's threads
+	double busy_s;
+	// busy_s / (threads * wall time)
+	double utilization;
+};
+
+struct RSAPipelineStats
+{
+	long long keys;
+	double seconds;
+	double keys_per_s;
+
+	long long primes;
+	long long primes_rejected;
+	long long pairs_rejected;
+
+	struct RSAPipelineStageStats finder;
+	struct RSAPipelineStageStats pairing;
+	struct RSAPipelineStageStats output;
+};
+
+int rsa_keygen_pipeline(
+	struct RSAPipelineStats rsa_pipeline_stats_out[1],
+	struct RSAPipelineConfig rsa_pipeline_config[1]);
+
+#endif
@@ -0,0 +1,93 @@
+#include "rsa_soa.h"
+#include "ct_op.h"
+#include "metrics.h"
+
+int rsa_columns_from_keys(
+	struct RSAColumns rsa_cols_from_out[1],
+	struct RSA rsa_cols_from_keys[],
+	int rsa_cols_from_count)
+{
+	METRICS_TIME(kMetricsRsaColumnsFromKeys);
+
+	int rsa_cols_from_i;
+
+	rsa_cols_from_out[0].n.resize(rsa_cols_from_count);
+	rsa_cols_from_out[0].e.resize(rsa_cols_from_count);
+	rsa_cols_from_out[0].d.resize(rsa_cols_from_count);
+	rsa_cols_from_out[0].p.resize(rsa_cols_from_count);
+	rsa_cols_from_out[0].q.resize(rsa_cols_from_count);
+
+	for (rsa_cols_from_i = 0; rsa_cols_from_i < rsa_cols_from_count; rsa_cols_from_i++)
+	{
+		rsa_cols_from_out[0].n[rsa_cols_from_i] = rsa_cols_from_keys[rsa_cols_from_i].n;
+		rsa_cols_from_out[0].e[rsa_cols_from_i] = rsa_cols_from_keys[rsa_cols_from_i].e;
+		rsa_cols_from_out[0].d[rsa_cols_from_i] = rsa_cols_from_keys[rsa_cols_from_i].d;
+		rsa_cols_from_out[0].p[rsa_cols_from_i] = rsa_cols_from_keys[rsa_cols_from_i].p;
+		rsa_cols_from_out[0].q[rsa_cols_from_i] = rsa_cols_from_keys[rsa_cols_from_i].q;
+	}
+
+	return 1;
+}
+
+int rsa_columns_pubkey_encryrpt(
+	int rsa_cols_pubkenc_c_out[],
+	struct RSAColumns rsa_cols_pubkenc_cols[1],
+	int rsa_cols_pubkenc_p)
+{
+	METRICS_TIME(kMetricsRsaColumnsPubkeyEncrypt);
+
+	const int* rsa_cols_pubkenc_n = rsa_cols_pubkenc_cols[0].n.data();
+	const int* rsa_cols_pubkenc_e = rsa_cols_pubkenc_cols[0].e.data();
+	int rsa_cols_pubkenc_count = (int)rsa_cols_pubkenc_cols[0].n.size();
+	int rsa_cols_pubkenc_rejected = 0;
+	int rsa_cols_pubkenc_i;
+
+	for (rsa_cols_pubkenc_i = 0; rsa_cols_pubkenc_i < rsa_cols_pubkenc_count; rsa_cols_pubkenc_i++)
+	{
+		if (rsa_cols_pubkenc_n[rsa_cols_pubkenc_i] <= rsa_cols_pubkenc_e[rsa_cols_pubkenc_i] ||
+			cmp_uint32(rsa_cols_pubkenc_p, rsa_cols_pubkenc_n[rsa_cols_pubkenc_i]) >= 0)
+		{
+			rsa_cols_pubkenc_c_out[rsa_cols_pubkenc_i] = 0;
+			rsa_cols_pubkenc_rejected++;
+			continue;
+		}
+
+		rsa_cols_pubkenc_c_out[rsa_cols_pubkenc_i] = exp_mod(
+			rsa_cols_pubkenc_p,
+			rsa_cols_pubkenc_e[rsa_cols_pubkenc_i],
+			rsa_cols_pubkenc_n[rsa_cols_pubkenc_i]);
+	}
+
+	return rsa_cols_pubkenc_rejected;
+}
+
+int rsa_columns_privkey_decryrpt(
+	int rsa_cols_privkdec_p_out[],
+	struct RSAColumns rsa_cols_privkdec_cols[1],
+	int rsa_cols_privkdec_c[])
+{
+	METRICS_TIME(kMetricsRsaColumnsPrivkeyDecrypt);
+
+	const int* rsa_cols_privkdec_n = rsa_cols_privkdec_cols[0].n.data();
+	const int* rsa_cols_privkdec_d = rsa_cols_privkdec_cols[0].d.data();
+	int rsa_cols_privkdec_count = (int)rsa_cols_privkdec_cols[0].n.size();
+	int rsa_cols_privkdec_rejected = 0;
+	int rsa_cols_privkdec_i;
+
+	for (rsa_cols_privkdec_i = 0; rsa_cols_privkdec_i < rsa_cols_privkdec_count; rsa_cols_privkdec_i++)
+	{
+		if (cmp_uint32(rsa_cols_privkdec_c[rsa_cols_privkdec_i], rsa_cols_privkdec_n[rsa_cols_privkdec_i]) >= 0)
+		{
+			rsa_cols_privkdec_p_out[rsa_cols_privkdec_i] = 0;
+			rsa_cols_privkdec_rejected++;
+			continue;
+		}
+
+		rsa_cols_privkdec_p_out[rsa_cols_privkdec_i] = exp_mod_secret(
+			rsa_cols_privkdec_c[rsa_cols_privkdec_i],
+			rsa_cols_privkdec_d[rsa_cols_privkdec_i],
+			rsa_cols_privkdec_n[rsa_cols_privkdec_i]);
+	}
+
+	return rsa_cols_privkdec_rejected;
+}
@@ -0,0 +1,39 @@
+#ifndef RSA_SOA_H_
+#define RSA_SOA_H_
+
+#include <vector>
+
+#include "rsa.h"
+
+// Struct-of-arrays RSA keys. Batch kernels walk only the columns they
+// need (n and e to encrypt, n and d to decrypt) sequentially, instead of
+// striding over whole struct RSA records.
+struct RSAColumns
+{
+	std::vector<int> n;
+	std::vector<int> e;
+	std::vector<int> d;
+	std::vector<int> p;
+	std::vector<int> q;
+};
+
+int rsa_columns_from_keys(
+	struct RSAColumns rsa_cols_from_out[1],
+	struct RSA rsa_cols_from_keys[],
+	int rsa_cols_from_count);
+
+// c_out[i] = m encrypted under key i. Keys rsa_pubkey_encryrpt would
+// reject get 0; the return value is the number of such keys.
+int rsa_columns_pubkey_encryrpt(
+	int rsa_cols_pubkenc_c_out[],
+	struct RSAColumns rsa_cols_pubkenc_cols[1],
+	int rsa_cols_pubkenc_p);
+
+// p_out[i] = c[i] decrypted with key i. Ciphertexts rsa_privkey_decryrpt
+// would reject get 0; the return value is the number of such entries.
+int rsa_columns_privkey_decryrpt(
+	int rsa_cols_privkdec_p_out[],
+	struct RSAColumns rsa_cols_privkdec_cols[1],
+	int rsa_cols_privkdec_c[]);
+
+#endif
@@ -0,0 +1,208 @@
+#include "safe_prime_table.h"
+#include "crypto_core.h"
+
+#include "safe_prime_table.inc"
+
+// Compile-time check of the embedded table, with plain uint64 arithmetic:
+// Miller-Rabin with bases 2, 7 and 61 is exact for 32-bit numbers.
+
+static constexpr unsigned long long safe_prime_table_pow_mod(
+	unsigned long long safe_prime_pow_b,
+	unsigned long long safe_prime_pow_e,
+	unsigned long long safe_prime_pow_m)
+{
+	unsigned long long safe_prime_pow_r = 1;
+
+	safe_prime_pow_b %= safe_prime_pow_m;
+	while (safe_prime_pow_e)
+	{
+		if (safe_prime_pow_e & 1)
+		{
+			safe_prime_pow_r = safe_prime_pow_r * safe_prime_pow_b % safe_prime_pow_m;
+		}
+
+		safe_prime_pow_b = safe_prime_pow_b * safe_prime_pow_b % safe_prime_pow_m;
+		safe_prime_pow_e >>= 1;
+	}
+
+	return safe_prime_pow_r;
+}
+
+static constexpr bool safe_prime_table_witness(unsigned long long safe_prime_wit_n, unsigned long long safe_prime_wit_b)
+{
+	unsigned long long safe_prime_wit_m = safe_prime_wit_n - 1;
+	unsigned long long safe_prime_wit_z = 0;
+	int safe_prime_wit_a = 0;
+
+	if (safe_prime_wit_b % safe_prime_wit_n == 0)
+	{
+		return false;
+	}
+
+	while (safe_prime_wit_m % 2 == 0)
+	{
+		safe_prime_wit_m /= 2;
+		safe_prime_wit_a++;
+	}
+
+	safe_prime_wit_z = safe_prime_table_pow_mod(safe_prime_wit_b, safe_prime_wit_m, safe_prime_wit_n);
+	if (safe_prime_wit_z == 1 || safe_prime_wit_z == safe_prime_wit_n - 1)
+	{
+		return false;
+	}
+
+	while (--safe_prime_wit_a > 0)
+	{
+		safe_prime_wit_z = safe_prime_wit_z * safe_prime_wit_z % safe_prime_wit_n;
+		if (safe_prime_wit_z == safe_prime_wit_n - 1)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static constexpr bool safe_prime_table_is_prime(unsigned long long safe_prime_isp_n)
+{
+	return safe_prime_isp_n == 2 || safe_prime_isp_n == 3 ||
+		(safe_prime_isp_n > 3 && safe_prime_isp_n % 2 == 1 &&
+			!safe_prime_table_witness(safe_prime_isp_n, 2) &&
+			!safe_prime_table_witness(safe_prime_isp_n, 7) &&
+			!safe_prime_table_witness(safe_prime_isp_n, 61));
+}
+
+static constexpr bool safe_prime_table_valid()
+{
+	int safe_prime_valid_i = 0, safe_prime_valid_j = 0;
+	unsigned long long safe_prime_valid_p = 0;
+
+	for (safe_prime_valid_i = 0;
+		safe_prime_valid_i < (int)(sizeof(kSafePrimeTable) / sizeof(kSafePrimeTable[0]));
+		safe_prime_valid_i++)
+	{
+		const SafePrimeTableRow& safe_prime_valid_row = kSafePrimeTable[safe_prime_valid_i];
+
+		if (safe_prime_valid_row.count < 1 || safe_prime_valid_row.count > kSafePrimeTableWidth)
+		{
+			return false;
+		}
+
+		for (safe_prime_valid_j = 0; safe_prime_valid_j < safe_prime_valid_row.count; safe_prime_valid_j++)
+		{
+			safe_prime_valid_p = (unsigned long long)safe_prime_valid_row.primes[safe_prime_valid_j];
+
+			if (safe_prime_valid_p >> (safe_prime_valid_row.bits - 1) != 1 ||
+				safe_prime_valid_p % safe_prime_valid_row.add != (unsigned long long)safe_prime_valid_row.rem ||
+				!safe_prime_table_is_prime(safe_prime_valid_p) ||
+				!safe_prime_table_is_prime((safe_prime_valid_p - 1) / 2))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static_assert(safe_prime_table_valid(), "safe_prime_table.inc contains an invalid entry");
+
+int safe_prime_table_pick(
+	int safe_prime_pick_out[1],
+	int safe_prime_pick_bits,
+	int safe_prime_pick_add,
+	int safe_prime_pick_rem)
+{
+	int safe_prime_pick_i = 0;
+	int safe_prime_pick_index[1];
+
+	while (safe_prime_pick_i < (int)(sizeof(kSafePrimeTable) / sizeof(kSafePrimeTable[0])))
+	{
+		if (kSafePrimeTable[safe_prime_pick_i].bits == safe_prime_pick_bits &&
+			kSafePrimeTable[safe_prime_pick_i].add == safe_prime_pick_add &&
+			kSafePrimeTable[safe_prime_pick_i].rem == safe_prime_pick_rem)
+		{
+			if (!rand_range(safe_prime_pick_index, kSafePrimeTable[safe_prime_pick_i].count))
+			{
+				return 0;
+			}
+
+			safe_prime_pick_out[0] = kSafePrimeTable[safe_prime_pick_i].primes[safe_prime_pick_index[0]];
+			return 1;
+		}
+
+		safe_prime_pick_i = safe_prime_pick_i + 1;
+	}
+
+	return 0;
+}
+
+int safe_prime_table_generate(FILE* safe_prime_gen_out)
+{
+	// the (add, rem) pairs of dh_generator_congruence
+	static const int kCongruences[3][2] = { { 24, 23 }, { 60, 59 }, { 12, 11 } };
+
+	int safe_prime_gen_c, safe_prime_gen_bits, safe_prime_gen_count, safe_prime_gen_i;
+	int safe_prime_gen_found[kSafePrimeTableWidth];
+	int safe_prime_gen_is_prime[1];
+	long long safe_prime_gen_p, safe_prime_gen_low;
+
+	fprintf(safe_prime_gen_out,
+		"// Generated by `cmm_lab gen-safe-prime-table`. Do not edit.\n"
+		"// The largest safe primes of each length in each congruence class.\n\n"
+		"static constexpr SafePrimeTableRow kSafePrimeTable[] =\n{\n");
+
+	for (safe_prime_gen_c = 0; safe_prime_gen_c < 3; safe_prime_gen_c++)
+	{
+		for (safe_prime_gen_bits = 2; safe_prime_gen_bits <= 31; safe_prime_gen_bits++)
+		{
+			safe_prime_gen_low = 1LL << (safe_prime_gen_bits - 1);
+
+			// largest candidate below 2^bits in the congruence class
+			safe_prime_gen_p = (1LL << safe_prime_gen_bits) - 1;
+			safe_prime_gen_p -= ((safe_prime_gen_p - kCongruences[safe_prime_gen_c][1]) %
+				kCongruences[safe_prime_gen_c][0] + kCongruences[safe_prime_gen_c][0]) %
+				kCongruences[safe_prime_gen_c][0];
+
+			safe_prime_gen_count = 0;
+			while (safe_prime_gen_count < kSafePrimeTableWidth && safe_prime_gen_p >= safe_prime_gen_low)
+			{
+				is_prime_deterministic(safe_prime_gen_is_prime, (int)safe_prime_gen_p);
+				if (safe_prime_gen_is_prime[0])
+				{
+					is_prime_deterministic(safe_prime_gen_is_prime, (int)((safe_prime_gen_p - 1) / 2));
+					if (safe_prime_gen_is_prime[0])
+					{
+						safe_prime_gen_found[safe_prime_gen_count++] = (int)safe_prime_gen_p;
+					}
+				}
+
+				safe_prime_gen_p -= kCongruences[safe_prime_gen_c][0];
+			}
+
+			if (!safe_prime_gen_count)
+			{
+				continue;
+			}
+
+			fprintf(safe_prime_gen_out, "\t{ %d, %d, %d, %d, { ",
+				kCongruences[safe_prime_gen_c][0],
+				kCongruences[safe_prime_gen_c][1],
+				safe_prime_gen_bits,
+				safe_prime_gen_count);
+
+			for (safe_prime_gen_i = 0; safe_prime_gen_i < safe_prime_gen_count; safe_prime_gen_i++)
+			{
+				fprintf(safe_prime_gen_out, "%s%d",
+					safe_prime_gen_i ? ", " : "",
+					safe_prime_gen_found[safe_prime_gen_i]);
+			}
+
+			fprintf(safe_prime_gen_out, " } },\n");
+		}
+	}
+
+	fprintf(safe_prime_gen_out, "};\n");
+
+	return 1;
+}
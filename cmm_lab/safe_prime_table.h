@@ -0,0 +1,35 @@
+#ifndef SAFE_PRIME_TABLE_H_
+#define SAFE_PRIME_TABLE_H_
+
+#include <cstdio>
+
+// Precomputed safe primes p (q = (p-1)/2 also prime) of exactly `bits`
+// bits with p = rem (mod add), for the congruences dh_generator_congruence
+// uses. The data lives in safe_prime_table.inc, which is generated by
+// `cmm_lab gen-safe-prime-table > safe_prime_table.inc` and re-verified
+// by a static_assert whenever it is compiled.
+
+static const int kSafePrimeTableWidth = 4;
+
+struct SafePrimeTableRow
+{
+	int add;
+	int rem;
+	int bits;
+	int count;
+	int primes[kSafePrimeTableWidth];
+};
+
+// Pick one of the table's primes for (bits, add, rem) with rand_range.
+// Return 0 if the table has none.
+int safe_prime_table_pick(
+	int safe_prime_pick_out[1],
+	int safe_prime_pick_bits,
+	int safe_prime_pick_add,
+	int safe_prime_pick_rem);
+
+// Search every supported (bits, congruence) pair and write the table
+// source to out.
+int safe_prime_table_generate(FILE* safe_prime_gen_out);
+
+#endif
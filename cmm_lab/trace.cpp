@@ -0,0 +1,199 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "trace.h"
+
+struct TraceEvent
+{
+	// 2*index+1 while the owner writes event number index, 2*index+2 once done
+	std::atomic<uint64_t> seq;
+	std::atomic<const char*> name;
+	std::atomic<const char*> arg_name;
+	std::atomic<int> arg;
+	std::atomic<int64_t> begin;
+	std::atomic<int64_t> end;
+};
+
+struct TraceBuffer
+{
+	int tid;
+	std::atomic<uint64_t> head; // events ever recorded
+	struct TraceEvent events[kTraceRingSize];
+};
+
+std::atomic<int> kTraceEnabled(0);
+
+static const std::chrono::steady_clock::time_point kTraceEpoch = std::chrono::steady_clock::now();
+static std::atomic<int64_t> kTraceStart(0);
+
+// every buffer ever handed out, never freed so the export can read
+// finished threads; those whose thread has exited wait in the free list
+static std::mutex kTraceLock;
+static std::vector<struct TraceBuffer*> kTraceBuffers;
+static std::vector<struct TraceBuffer*> kTraceFreeBuffers;
+
+// hands the buffer back for reuse when the thread exits
+struct TraceBufferHolder
+{
+	struct TraceBuffer* buffer = nullptr;
+
+	~TraceBufferHolder()
+	{
+		if (buffer != nullptr)
+		{
+			std::lock_guard<std::mutex> trace_holder_guard(kTraceLock);
+			kTraceFreeBuffers.push_back(buffer);
+		}
+	}
+};
+
+static thread_local struct TraceBufferHolder kTraceBuffer;
+
+int trace_enable(int trace_enable_on)
+{
+	if (trace_enable_on)
+	{
+		kTraceStart.store(trace_now(), std::memory_order_relaxed);
+	}
+
+	kTraceEnabled.store(trace_enable_on != 0, std::memory_order_relaxed);
+
+	return 1;
+}
+
+int64_t trace_now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - kTraceEpoch).count();
+}
+
+int trace_record(
+	const char* trace_record_name,
+	const char* trace_record_arg_name,
+	int trace_record_arg,
+	int64_t trace_record_begin,
+	int64_t trace_record_end)
+{
+	struct TraceBuffer* trace_record_buffer = kTraceBuffer.buffer;
+
+	if (trace_record_buffer == nullptr)
+	{
+		std::lock_guard<std::mutex> trace_record_guard(kTraceLock);
+
+		// a reused buffer keeps its tid and its events, and appends after them
+		if (kTraceFreeBuffers.empty())
+		{
+			trace_record_buffer = new struct TraceBuffer();
+			kTraceBuffers.push_back(trace_record_buffer);
+			trace_record_buffer->tid = (int)kTraceBuffers.size();
+		}
+		else
+		{
+			trace_record_buffer = kTraceFreeBuffers.back();
+			kTraceFreeBuffers.pop_back();
+		}
+
+		kTraceBuffer.buffer = trace_record_buffer;
+	}
+
+	uint64_t trace_record_index = trace_record_buffer->head.load(std::memory_order_relaxed);
+	struct TraceEvent& trace_record_event = trace_record_buffer->events[trace_record_index % kTraceRingSize];
+
+	trace_record_event.seq.store(2 * trace_record_index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	trace_record_event.name.store(trace_record_name, std::memory_order_relaxed);
+	trace_record_event.arg_name.store(trace_record_arg_name, std::memory_order_relaxed);
+	trace_record_event.arg.store(trace_record_arg, std::memory_order_relaxed);
+	trace_record_event.begin.store(trace_record_begin, std::memory_order_relaxed);
+	trace_record_event.end.store(trace_record_end, std::memory_order_relaxed);
+
+	trace_record_event.seq.store(2 * trace_record_index + 2, std::memory_order_release);
+	trace_record_buffer->head.store(trace_record_index + 1, std::memory_order_release);
+
+	return 1;
+}
+
+int trace_write_chrome(const char* trace_write_path)
+{
+	FILE* trace_write_file = fopen(trace_write_path, "w");
+	int64_t trace_write_start = kTraceStart.load(std::memory_order_relaxed);
+	uint64_t trace_write_dropped = 0;
+	const char* trace_write_separator = "";
+
+	if (trace_write_file == nullptr)
+	{
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> trace_write_guard(kTraceLock);
+
+	fprintf(trace_write_file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+	for (struct TraceBuffer* trace_write_buffer : kTraceBuffers)
+	{
+		uint64_t trace_write_head = trace_write_buffer->head.load(std::memory_order_acquire);
+		uint64_t trace_write_first = trace_write_head > (uint64_t)kTraceRingSize
+			? trace_write_head - kTraceRingSize
+			: 0;
+
+		trace_write_dropped += trace_write_first;
+
+		fprintf(trace_write_file,
+			"%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+			trace_write_separator,
+			trace_write_buffer->tid,
+			trace_write_buffer->tid);
+		trace_write_separator = ",";
+
+		for (uint64_t trace_write_i = trace_write_first; trace_write_i < trace_write_head; trace_write_i++)
+		{
+			struct TraceEvent& trace_write_event = trace_write_buffer->events[trace_write_i % kTraceRingSize];
+			uint64_t trace_write_seq = trace_write_event.seq.load(std::memory_order_acquire);
+			const char* trace_write_name = trace_write_event.name.load(std::memory_order_relaxed);
+			const char* trace_write_arg_name = trace_write_event.arg_name.load(std::memory_order_relaxed);
+			int trace_write_arg = trace_write_event.arg.load(std::memory_order_relaxed);
+			int64_t trace_write_begin = trace_write_event.begin.load(std::memory_order_relaxed);
+			int64_t trace_write_end = trace_write_event.end.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// overwritten since head was read
+			if (trace_write_seq != 2 * trace_write_i + 2 ||
+				trace_write_event.seq.load(std::memory_order_relaxed) != trace_write_seq)
+			{
+				trace_write_dropped++;
+				continue;
+			}
+
+			if (trace_write_begin < trace_write_start)
+			{
+				continue;
+			}
+
+			// span names are identifiers and phrases, so they need no escaping
+			fprintf(trace_write_file,
+				",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+				trace_write_name,
+				trace_write_buffer->tid,
+				trace_write_begin / 1000.0,
+				(trace_write_end - trace_write_begin) / 1000.0);
+
+			if (trace_write_arg_name != nullptr)
+			{
+				fprintf(trace_write_file, ", \"args\": {\"%s\": %d}", trace_write_arg_name, trace_write_arg);
+			}
+
+			fprintf(trace_write_file, "}");
+		}
+	}
+
+	fprintf(trace_write_file,
+		"\n], \"otherData\": {\"dropped_events\": %llu}}\n",
+		(unsigned long long)trace_write_dropped);
+	fclose(trace_write_file);
+
+	return 1;
+}
@@ -0,0 +1,85 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+
+// Timed spans around the phases of the long-running operations (prime
+// candidate draw, sieve, Miller-Rabin rounds, inverse, exponentiation),
+// written as Chrome trace JSON for chrome://tracing or Perfetto.
+//
+// Tracing is switched on at run time. While it is off a span costs one
+// relaxed load. While it is on, a span records one event into its thread's
+// ring buffer when it ends. Only the owning thread writes a buffer, so
+// recording takes no lock; each slot carries a sequence number that lets
+// the exporter skip a slot being overwritten while it reads. A full ring
+// overwrites its oldest events. Buffers outlive their threads, so spans
+// from finished worker threads are still exported. When a thread exits its
+// buffer is handed to the next new thread, which keeps the tid and appends
+// after the old events, so memory grows with the number of threads alive
+// at once rather than the number ever started.
+
+static const int kTraceRingSize = 1 << 14; // events per thread
+
+// 1 while spans are being recorded
+extern std::atomic<int> kTraceEnabled;
+
+// Turning tracing on also drops everything recorded before.
+int trace_enable(int trace_enable_on);
+
+// nanoseconds on the trace clock
+int64_t trace_now();
+
+int trace_record(
+	const char* trace_record_name,
+	const char* trace_record_arg_name,
+	int trace_record_arg,
+	int64_t trace_record_begin,
+	int64_t trace_record_end);
+
+// Return 0 if the file cannot be written
+int trace_write_chrome(const char* trace_write_path);
+
+// Names must be string literals (or otherwise live until the export); the
+// argument is shown in the trace only if arg_name is not nullptr.
+struct TraceSpan
+{
+	const char* name;
+	const char* arg_name;
+	int arg;
+	int64_t begin; // -1 if not recording
+
+	explicit TraceSpan(const char* trace_span_name, const char* trace_span_arg_name = nullptr, int trace_span_arg = 0)
+		: name(trace_span_name),
+		arg_name(trace_span_arg_name),
+		arg(trace_span_arg),
+		begin(kTraceEnabled.load(std::memory_order_relaxed) ? trace_now() : -1)
+	{
+	}
+
+	~TraceSpan()
+	{
+		end();
+	}
+
+	// end the span early; later calls do nothing
+	int end()
+	{
+		if (begin >= 0)
+		{
+			trace_record(name, arg_name, arg, begin, trace_now());
+			begin = -1;
+		}
+
+		return 1;
+	}
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// a span over the rest of the enclosing block
+#define TRACE_SPAN(trace_name) TraceSpan trace_span(trace_name)
+#define TRACE_SPAN_ARG(trace_name, trace_arg_name, trace_arg) TraceSpan trace_span(trace_name, trace_arg_name, trace_arg)
+
+#endif
@@ -1,4 +1,5 @@
 #include "unsigned_op.h"
+#include "profile.h"
 
 int kTwoPowers[32];
 
@@ -21,6 +22,8 @@ int init_two_powers()
 
 int rshift_uint32(int rshift_uint32_x, int rshift_uint32_usr_a)
 {
+	PROFILE_CALL("rshift_uint32");
+
 	if (rshift_uint32_usr_a >= 32 ||
 		(rshift_uint32_x >= 0 && rshift_uint32_usr_a == 31))
 	{
@@ -44,6 +47,8 @@ int rshift_uint32(int rshift_uint32_x, int rshift_uint32_usr_a)
 
 int lshift_uint32(int lshift_uint32_x, int lshift_uint32_a)
 {
+	PROFILE_CALL("lshift_uint32");
+
 	if (lshift_uint32_a >= 32)
 	{
 		return 0;
@@ -54,45 +59,49 @@ int lshift_uint32(int lshift_uint32_x, int lshift_uint32_a)
 
 int get_bits_uint32(int get_bits_uint32_a)
 {
+	PROFILE_CALL("get_bits_uint32");
+
 	int get_bits_uint32_bits = 0;
 	while (rshift_uint32(get_bits_uint32_a, get_bits_uint32_bits))
 	{
+		PROFILE_LOOP("get_bits_uint32");
+
 		get_bits_uint32_bits = get_bits_uint32_bits + 1;
 	}
 
 	return get_bits_uint32_bits;
 }
 
+// The comparisons and carries below run in every iteration of the
+// multiplication and division loops, so they avoid branches: a relational
+// operator yields 0 or 1, and everything else is arithmetic on those bits.
+// unsigned_op_ref keeps the branching versions.
+
+// 1 if a < b as uint32, else 0. The signed comparison is right when the
+// sign bits agree and inverted when they differ, so xor the two.
+int lt_uint32(int lt_uint32_a, int lt_uint32_b)
+{
+	PROFILE_CALL("lt_uint32");
+
+	int lt_uint32_sa = lt_uint32_a < 0;
+	int lt_uint32_sb = lt_uint32_b < 0;
+	int lt_uint32_signed = lt_uint32_a < lt_uint32_b;
+	int lt_uint32_differ = lt_uint32_sa + lt_uint32_sb - 2 * lt_uint32_sa * lt_uint32_sb;
+
+	return lt_uint32_signed + lt_uint32_differ - 2 * lt_uint32_signed * lt_uint32_differ;
+}
+
 int cmp_uint32(int cmp_uint32_a, int cmp_uint32_b)
 {
-	if ((cmp_uint32_a < 0 && cmp_uint32_b < 0) ||
-		(cmp_uint32_a >= 0 && cmp_uint32_b >= 0))
-	{
-		if (cmp_uint32_a > cmp_uint32_b)
-		{
-			return 1;
-		}
-		else if (cmp_uint32_a < cmp_uint32_b)
-		{
-			return -1;
-		}
-		else
-		{
-			return 0;
-		}
-	}
-	else if (cmp_uint32_a < 0 && cmp_uint32_b >= 0)
-	{
-		return 1;
-	}
-	else if (cmp_uint32_b < 0 && cmp_uint32_a >= 0)
-	{
-		return -1;
-	}
+	PROFILE_CALL("cmp_uint32");
+
+	return lt_uint32(cmp_uint32_b, cmp_uint32_a) - lt_uint32(cmp_uint32_a, cmp_uint32_b);
 }
 
 int neg_uint32(int neg_uint32_a)
 {
+	PROFILE_CALL("neg_uint32");
+
 	return -1 - neg_uint32_a + 1;
 }
 
@@ -101,17 +110,20 @@ int add_full_uint32(
 	int add_full_uint32_a,
 	int add_full_uint32_b)
 {
-	int add_full_uint32_dist_a = -1 - add_full_uint32_a;
-	if (cmp_uint32(add_full_uint32_dist_a, add_full_uint32_b) < 0)
-	{
-		add_full_uint32_carry_out[0] = 1;
-	}
-	else
-	{
-		add_full_uint32_carry_out[0] = 0;
-	}
+	PROFILE_CALL("add_full_uint32");
+
+	int add_full_uint32_sum = add_full_uint32_a + add_full_uint32_b;
+	int add_full_uint32_sa = add_full_uint32_a < 0;
+	int add_full_uint32_sb = add_full_uint32_b < 0;
+	int add_full_uint32_ns = add_full_uint32_sum >= 0;
+
+	// the carry out of bit 31 is the majority of a31, b31 and ~sum31
+	add_full_uint32_carry_out[0] = add_full_uint32_sa * add_full_uint32_sb +
+		add_full_uint32_sa * add_full_uint32_ns +
+		add_full_uint32_sb * add_full_uint32_ns -
+		2 * add_full_uint32_sa * add_full_uint32_sb * add_full_uint32_ns;
 
-	return add_full_uint32_a + add_full_uint32_b;
+	return add_full_uint32_sum;
 }
 
 int sub_full_uint32(
@@ -119,20 +131,26 @@ int sub_full_uint32(
 	int sub_full_uint32_a,
 	int sub_full_uint32_b)
 {
-	if (cmp_uint32(sub_full_uint32_a, sub_full_uint32_b) < 0)
-	{
-		sub_full_uint32_borrow_out[0] = 1;
-	}
-	else
-	{
-		sub_full_uint32_borrow_out[0] = 0;
-	}
+	PROFILE_CALL("sub_full_uint32");
 
-	return sub_full_uint32_a - sub_full_uint32_b;
+	int sub_full_uint32_diff = sub_full_uint32_a - sub_full_uint32_b;
+	int sub_full_uint32_na = sub_full_uint32_a >= 0;
+	int sub_full_uint32_sb = sub_full_uint32_b < 0;
+	int sub_full_uint32_sd = sub_full_uint32_diff < 0;
+
+	// the borrow out of bit 31 is the majority of ~a31, b31 and diff31
+	sub_full_uint32_borrow_out[0] = sub_full_uint32_na * sub_full_uint32_sb +
+		sub_full_uint32_na * sub_full_uint32_sd +
+		sub_full_uint32_sb * sub_full_uint32_sd -
+		2 * sub_full_uint32_na * sub_full_uint32_sb * sub_full_uint32_sd;
+
+	return sub_full_uint32_diff;
 }
 
 int mul_uint32(int mul_uint32_uint64_out[2], int mul_uint32_a, int mul_uint32_b)
 {
+	PROFILE_CALL("mul_uint32");
+
 	// a=ah al=(ah<<16)+al
 	// b=bh bl=(bh<<16)+bl
 	// a*b=((ah*bh)<<32)+((ah*bl)<<16)+((al*bh)<<16)+(al*bl)
@@ -190,6 +208,8 @@ int div_mod_uint32(
 	int div_mod_uint32_a,
 	int div_mod_uint32_b)
 {
+	PROFILE_CALL("div_mod_uint32");
+
 	// Calculate division with pen-and-paper method
 	int div_mod_uint32_i;
 	int div_mod_uint32_a_bits, div_mod_uint32_b_bits;
@@ -212,6 +232,8 @@ int div_mod_uint32(
 	div_mod_uint32_i = div_mod_uint32_a_bits - div_mod_uint32_b_bits;
 	while (div_mod_uint32_i >= 0)
 	{
+		PROFILE_LOOP("div_mod_uint32");
+
 		div_mod_uint32_result = div_mod_uint32_result * 2;
 
 		if (cmp_uint32(div_mod_uint32_rem, div_mod_uint32_b) >= 0)
@@ -236,12 +258,16 @@ int div_mod_uint32(
 
 int div_uint32(int div_uint32_a, int div_uint32_b)
 {
+	PROFILE_CALL("div_uint32");
+
 	int div_uint32_rem[1];
 	return div_mod_uint32(div_uint32_rem, div_uint32_a, div_uint32_b);
 }
 
 int mod_uint32(int mod_uint32_a, int mod_uint32_b)
 {
+	PROFILE_CALL("mod_uint32");
+
 	int mod_uint32_rem[1];
 	div_mod_uint32(mod_uint32_rem, mod_uint32_a, mod_uint32_b);
 	return mod_uint32_rem[0];
@@ -251,6 +277,8 @@ int mod_uint32(int mod_uint32_a, int mod_uint32_b)
 
 int rshift_uint64(int rshift_uint64_out[2], int rshift_uint64_x[2], int rshift_uint64_a)
 {
+	PROFILE_CALL("rshift_uint64");
+
 	int rshift_uint64_xh = rshift_uint64_x[0];
 	int rshift_uint64_xl = rshift_uint64_x[1];
 	if (rshift_uint64_a >= 64 ||
@@ -281,6 +309,8 @@ int rshift_uint64(int rshift_uint64_out[2], int rshift_uint64_x[2], int rshift_u
 
 int lshift_uint64(int lshift_uint64_out[2], int lshift_uint64_x[2], int lshift_uint64_a)
 {
+	PROFILE_CALL("lshift_uint64");
+
 	if (lshift_uint64_a >= 64)
 	{
 		lshift_uint64_out[0] = 0;
@@ -305,6 +335,8 @@ int lshift_uint64(int lshift_uint64_out[2], int lshift_uint64_x[2], int lshift_u
 
 int get_bits_uint64(int get_bits_uint64_a[2])
 {
+	PROFILE_CALL("get_bits_uint64");
+
 	int get_bits_uint64_bits = 0;
 	int get_bits_uint64_shifted[2];
 
@@ -312,6 +344,8 @@ int get_bits_uint64(int get_bits_uint64_a[2])
 
 	while (get_bits_uint64_shifted[0] || get_bits_uint64_shifted[1])
 	{
+		PROFILE_LOOP("get_bits_uint64");
+
 		get_bits_uint64_bits = get_bits_uint64_bits + 1;
 		rshift_uint64(get_bits_uint64_shifted, get_bits_uint64_a, get_bits_uint64_bits);
 	}
@@ -321,13 +355,13 @@ int get_bits_uint64(int get_bits_uint64_a[2])
 
 int cmp_uint64(int cmp_uint64_a[2], int cmp_uint64_b[2])
 {
-	int cmp_uint64_result = cmp_uint32(cmp_uint64_a[0], cmp_uint64_b[0]);
-	if (cmp_uint64_result)
-	{
-		return cmp_uint64_result;
-	}
+	PROFILE_CALL("cmp_uint64");
+
+	int cmp_uint64_high = cmp_uint32(cmp_uint64_a[0], cmp_uint64_b[0]);
+	int cmp_uint64_low = cmp_uint32(cmp_uint64_a[1], cmp_uint64_b[1]);
 
-	return cmp_uint32(cmp_uint64_a[1], cmp_uint64_b[1]);
+	// the low words decide only when the high words are equal
+	return cmp_uint64_high + (1 - cmp_uint64_high * cmp_uint64_high) * cmp_uint64_low;
 }
 
 int add_full_uint64(
@@ -336,6 +370,8 @@ int add_full_uint64(
 	int add_full_uint64_a[2],
 	int add_full_uint64_b[2])
 {
+	PROFILE_CALL("add_full_uint64");
+
 	int add_full_uint64_low_carry[1];
 	int add_full_uint64_high_carry[1];
 	add_full_uint64_out[1] = add_full_uint32(
@@ -351,6 +387,8 @@ int add_full_uint64(
 
 int add_uint64(int add_uint64_out[2], int add_uint64_a[2], int add_uint64_b[2])
 {
+	PROFILE_CALL("add_uint64");
+
 	int add_uint64_low_carry[1];
 	add_uint64_out[1] = add_full_uint32(
 		add_uint64_low_carry, add_uint64_a[1], add_uint64_b[1]);
@@ -360,6 +398,8 @@ int add_uint64(int add_uint64_out[2], int add_uint64_a[2], int add_uint64_b[2])
 
 int neg_uint64(int neg_uint64_out[2], int neg_uint64_a[2])
 {
+	PROFILE_CALL("neg_uint64");
+
 	int neg_uint64_inv[2];
 	int neg_uint64_one[2];
 
@@ -380,6 +420,8 @@ int sub_full_uint64(
 	int sub_full_uint64_a[2],
 	int sub_full_uint64_b[2])
 {
+	PROFILE_CALL("sub_full_uint64");
+
 	int sub_full_uint64_neg_b[2];
 
 	if (cmp_uint64(sub_full_uint64_a, sub_full_uint64_b) < 0)
@@ -400,6 +442,8 @@ int sub_full_uint64(
 
 int sub_uint64(int sub_uint64_out[2], int sub_uint64_a[2], int sub_uint64_b[2])
 {
+	PROFILE_CALL("sub_uint64");
+
 	int sub_uint64_neg_b[2];
 
 	neg_uint64(sub_uint64_neg_b, sub_uint64_b);
@@ -411,6 +455,8 @@ int sub_uint64(int sub_uint64_out[2], int sub_uint64_a[2], int sub_uint64_b[2])
 
 int mul_uint64(int mul_uint64_out[2], int mul_uint64_a[2], int mul_uint64_b[2])
 {
+	PROFILE_CALL("mul_uint64");
+
 	// a=ah al=(ah<<32)+al
 	// b=bh bl=(bh<<32)+bl
 	// a*b=((ah*bh)<<64)+((ah*bl)<<32)+((al*bh)<<32)+(al*bl)
@@ -457,6 +503,8 @@ int div_mod_uint64(
 	int div_mod_uint64_a[2],
 	int div_mod_uint64_b[2])
 {
+	PROFILE_CALL("div_mod_uint64");
+
 	int div_mod_uint64_i;
 	int div_mod_uint64_a_bits, div_mod_uint64_b_bits;
 	int div_mod_uint64_slb[2];
@@ -493,6 +541,8 @@ int div_mod_uint64(
 	div_mod_uint64_i = div_mod_uint64_a_bits - div_mod_uint64_b_bits;
 	while (div_mod_uint64_i >= 0)
 	{
+		PROFILE_LOOP("div_mod_uint64");
+
 		lshift_uint64(div_mod_uint64_result, div_mod_uint64_result, 1);
 
 		if (cmp_uint64(div_mod_uint64_rem, div_mod_uint64_slb) >= 0)
@@ -520,6 +570,8 @@ int div_mod_uint64(
 
 int div_uint64(int div_uint64_out[2], int div_uint64_a[2], int div_uint64_b[2])
 {
+	PROFILE_CALL("div_uint64");
+
 	int div_uint64_rem[2];
 	div_mod_uint64(div_uint64_out, div_uint64_rem, div_uint64_a, div_uint64_b);
 	return 0;
@@ -527,7 +579,116 @@ int div_uint64(int div_uint64_out[2], int div_uint64_a[2], int div_uint64_b[2])
 
 int mod_uint64(int mod_uint64_out[2], int mod_uint64_a[2], int mod_uint64_b[2])
 {
+	PROFILE_CALL("mod_uint64");
+
 	int mod_uint64_quot[2];
 	div_mod_uint64(mod_uint64_quot, mod_uint64_out, mod_uint64_a, mod_uint64_b);
 	return 0;
 }
+
+// uint128 operations
+
+int mul_full_uint64(
+	int mul_full_uint64_hi_out[2],
+	int mul_full_uint64_lo_out[2],
+	int mul_full_uint64_a[2],
+	int mul_full_uint64_b[2])
+{
+	PROFILE_CALL("mul_full_uint64");
+
+	// Same split as mul_uint64, keeping the upper half:
+	// (a*b)_l=(al*bl)+(mid<<32) with carry C
+	// (a*b)_h=(ah*bh)+(mid>>32)+C, mid=(ah*bl)+(al*bh)
+	// mid itself can carry out of 64 bits; that carry is worth 2^96,
+	// bit 32 of (a*b)_h.
+
+	int mul_full_uint64_albl[2];
+	int mul_full_uint64_ahbl[2];
+	int mul_full_uint64_albh[2];
+	int mul_full_uint64_ahbh[2];
+	int mul_full_uint64_mid[2];
+	int mul_full_uint64_mid_carry[1];
+	int mul_full_uint64_shifted[2];
+	int mul_full_uint64_lo[2];
+	int mul_full_uint64_lo_carry[1];
+	int mul_full_uint64_hi[2];
+
+	mul_uint32(mul_full_uint64_albl, mul_full_uint64_a[1], mul_full_uint64_b[1]);
+	mul_uint32(mul_full_uint64_ahbl, mul_full_uint64_a[0], mul_full_uint64_b[1]);
+	mul_uint32(mul_full_uint64_albh, mul_full_uint64_a[1], mul_full_uint64_b[0]);
+	mul_uint32(mul_full_uint64_ahbh, mul_full_uint64_a[0], mul_full_uint64_b[0]);
+
+	add_full_uint64(mul_full_uint64_mid, mul_full_uint64_mid_carry, mul_full_uint64_ahbl, mul_full_uint64_albh);
+
+	lshift_uint64(mul_full_uint64_shifted, mul_full_uint64_mid, 32);
+	add_full_uint64(mul_full_uint64_lo, mul_full_uint64_lo_carry, mul_full_uint64_albl, mul_full_uint64_shifted);
+
+	rshift_uint64(mul_full_uint64_shifted, mul_full_uint64_mid, 32);
+	mul_full_uint64_shifted[0] = mul_full_uint64_shifted[0] + mul_full_uint64_mid_carry[0];
+	add_uint64(mul_full_uint64_hi, mul_full_uint64_ahbh, mul_full_uint64_shifted);
+
+	mul_full_uint64_shifted[0] = 0;
+	mul_full_uint64_shifted[1] = mul_full_uint64_lo_carry[0];
+	add_uint64(mul_full_uint64_hi, mul_full_uint64_hi, mul_full_uint64_shifted);
+
+	mul_full_uint64_hi_out[0] = mul_full_uint64_hi[0];
+	mul_full_uint64_hi_out[1] = mul_full_uint64_hi[1];
+	mul_full_uint64_lo_out[0] = mul_full_uint64_lo[0];
+	mul_full_uint64_lo_out[1] = mul_full_uint64_lo[1];
+
+	return 0;
+}
+
+// hi must be below m, which holds for the product of two values below m
+int mod_uint128(
+	int mod_uint128_out[2],
+	int mod_uint128_hi[2],
+	int mod_uint128_lo[2],
+	int mod_uint128_m[2])
+{
+	PROFILE_CALL("mod_uint128");
+
+	int mod_uint128_rem[2];
+	int mod_uint128_i = 63;
+	int mod_uint128_word, mod_uint128_shift, mod_uint128_top;
+
+	mod_uint128_rem[0] = mod_uint128_hi[0];
+	mod_uint128_rem[1] = mod_uint128_hi[1];
+
+	// shift the bits of lo into rem one at a time, most significant first
+	while (mod_uint128_i >= 0)
+	{
+		PROFILE_LOOP("mod_uint128");
+
+		if (mod_uint128_i >= 32)
+		{
+			mod_uint128_word = mod_uint128_lo[0];
+			mod_uint128_shift = mod_uint128_i - 32;
+		}
+		else
+		{
+			mod_uint128_word = mod_uint128_lo[1];
+			mod_uint128_shift = mod_uint128_i;
+		}
+
+		mod_uint128_top = mod_uint128_rem[0] < 0;
+
+		lshift_uint64(mod_uint128_rem, mod_uint128_rem, 1);
+		mod_uint128_rem[1] = mod_uint128_rem[1] +
+			rshift_uint32(mod_uint128_word, mod_uint128_shift) -
+			rshift_uint32(mod_uint128_word, mod_uint128_shift + 1) * 2;
+
+		// rem < 2m, and with the bit shifted out the true value is rem + 2^64
+		if (mod_uint128_top || cmp_uint64(mod_uint128_rem, mod_uint128_m) >= 0)
+		{
+			sub_uint64(mod_uint128_rem, mod_uint128_rem, mod_uint128_m);
+		}
+
+		mod_uint128_i = mod_uint128_i - 1;
+	}
+
+	mod_uint128_out[0] = mod_uint128_rem[0];
+	mod_uint128_out[1] = mod_uint128_rem[1];
+
+	return 0;
+}
@@ -15,6 +15,9 @@ int lshift_uint32(int lshift_uint32_x, int lshift_uint32_a);
 
 int get_bits_uint32(int get_bits_uint32_a);
 
+// 1 if a < b as uint32, else 0
+int lt_uint32(int lt_uint32_a, int lt_uint32_b);
+
 int cmp_uint32(int cmp_uint32_a, int cmp_uint32_b);
 
 int neg_uint32(int neg_uint32_a);
@@ -80,4 +83,19 @@ int div_uint64(int div_uint64_out[2], int div_uint64_a[2], int div_uint64_b[2]);
 
 int mod_uint64(int mod_uint64_out[2], int mod_uint64_a[2], int mod_uint64_b[2]);
 
+// uint128 operations, as a pair of uint64 halves
+
+int mul_full_uint64(
+	int mul_full_uint64_hi_out[2],
+	int mul_full_uint64_lo_out[2],
+	int mul_full_uint64_a[2],
+	int mul_full_uint64_b[2]);
+
+// (hi:lo) mod m; hi must be below m
+int mod_uint128(
+	int mod_uint128_out[2],
+	int mod_uint128_hi[2],
+	int mod_uint128_lo[2],
+	int mod_uint128_m[2]);
+
 #endif
\ No newline at end of file
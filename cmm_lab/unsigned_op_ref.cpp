@@ -0,0 +1,75 @@
+#include "unsigned_op_ref.h"
+
+int cmp_uint32_ref(int cmp_uint32_ref_a, int cmp_uint32_ref_b)
+{
+	if ((cmp_uint32_ref_a < 0 && cmp_uint32_ref_b < 0) ||
+		(cmp_uint32_ref_a >= 0 && cmp_uint32_ref_b >= 0))
+	{
+		if (cmp_uint32_ref_a > cmp_uint32_ref_b)
+		{
+			return 1;
+		}
+		else if (cmp_uint32_ref_a < cmp_uint32_ref_b)
+		{
+			return -1;
+		}
+		else
+		{
+			return 0;
+		}
+	}
+	else if (cmp_uint32_ref_a < 0 && cmp_uint32_ref_b >= 0)
+	{
+		return 1;
+	}
+	else if (cmp_uint32_ref_b < 0 && cmp_uint32_ref_a >= 0)
+	{
+		return -1;
+	}
+}
+
+int add_full_uint32_ref(
+	int add_full_uint32_ref_carry_out[1],
+	int add_full_uint32_ref_a,
+	int add_full_uint32_ref_b)
+{
+	int add_full_uint32_ref_dist_a = -1 - add_full_uint32_ref_a;
+	if (cmp_uint32_ref(add_full_uint32_ref_dist_a, add_full_uint32_ref_b) < 0)
+	{
+		add_full_uint32_ref_carry_out[0] = 1;
+	}
+	else
+	{
+		add_full_uint32_ref_carry_out[0] = 0;
+	}
+
+	return add_full_uint32_ref_a + add_full_uint32_ref_b;
+}
+
+int sub_full_uint32_ref(
+	int sub_full_uint32_ref_borrow_out[1],
+	int sub_full_uint32_ref_a,
+	int sub_full_uint32_ref_b)
+{
+	if (cmp_uint32_ref(sub_full_uint32_ref_a, sub_full_uint32_ref_b) < 0)
+	{
+		sub_full_uint32_ref_borrow_out[0] = 1;
+	}
+	else
+	{
+		sub_full_uint32_ref_borrow_out[0] = 0;
+	}
+
+	return sub_full_uint32_ref_a - sub_full_uint32_ref_b;
+}
+
+int cmp_uint64_ref(int cmp_uint64_ref_a[2], int cmp_uint64_ref_b[2])
+{
+	int cmp_uint64_ref_result = cmp_uint32_ref(cmp_uint64_ref_a[0], cmp_uint64_ref_b[0]);
+	if (cmp_uint64_ref_result)
+	{
+		return cmp_uint64_ref_result;
+	}
+
+	return cmp_uint32_ref(cmp_uint64_ref_a[1], cmp_uint64_ref_b[1]);
+}
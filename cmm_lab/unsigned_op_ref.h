@@ -0,0 +1,22 @@
+#ifndef UNSIGNED_OP_REF_H_
+#define UNSIGNED_OP_REF_H_
+
+// The original branching versions of the unsigned_op comparisons and
+// carries, kept as the reference the branch-free ones are checked and
+// benchmarked against. Same contracts as in unsigned_op.h.
+
+int cmp_uint32_ref(int cmp_uint32_ref_a, int cmp_uint32_ref_b);
+
+int add_full_uint32_ref(
+	int add_full_uint32_ref_carry_out[1],
+	int add_full_uint32_ref_a,
+	int add_full_uint32_ref_b);
+
+int sub_full_uint32_ref(
+	int sub_full_uint32_ref_borrow_out[1],
+	int sub_full_uint32_ref_a,
+	int sub_full_uint32_ref_b);
+
+int cmp_uint64_ref(int cmp_uint64_ref_a[2], int cmp_uint64_ref_b[2]);
+
+#endif